@@ -29,6 +29,7 @@
 #include "framework/endianness.h"
 #include "helpers/ring.h"
 #include "latency/packet_latency.h"
+#include "latency/stage_latency.h"
 #include "main/analyzer.h"
 #include "main/snort_config.h"
 #include "main/thread.h"
@@ -91,8 +92,9 @@ void DetectionEngine::thread_init()
         else
         {
             // If the search method is not async capable then offloaded searches will be performed
-            // in a separate processing thread that the RegexOffload instance needs to create.
-            offloader = RegexOffload::get_offloader(sc->offload_threads, true);
+            // in a separate processing thread that the RegexOffload instance needs to create or
+            // by the workers shared by all packet threads if offload_pool is set.
+            offloader = RegexOffload::get_offloader(sc->offload_threads, true, sc->offload_pool);
         }
     }
 }
@@ -618,8 +620,10 @@ bool DetectionEngine::detect(Packet* p, bool offload_ok)
     case PktType::USER:
         if ( offload_ok and p->flow )
             return offload(p);
-
-        fp_full(p);
+        {
+            StageLatency::Context stage_latency_ctx(StageLatency::DETECTION);
+            fp_full(p);
+        }
         break;
 
     default:
@@ -752,6 +756,7 @@ int DetectionEngine::log_events(Packet* p)
 {
     // cppcheck-suppress unreadVariable
     Profile profile(eventqPerfStats);
+    StageLatency::Context stage_latency_ctx(StageLatency::LOGGING);
     SF_EVENTQ* pq = p->context->equeue;
     sfeventq_action(pq, ::log_events, (void*)p);
     return 0;
@@ -93,6 +93,9 @@ static const Parameter detection_params[] =
     { "offload_limit", Parameter::PT_INT, "0:max32", "99999",
       "minimum sizeof PDU to offload fast pattern search (defaults to disabled)" },
 
+    { "offload_pool", Parameter::PT_BOOL, nullptr, "false",
+      "run offloaded fast pattern searches on workers shared by all packet threads" },
+
     { "offload_threads", Parameter::PT_INT, "0:max32", "0",
       "maximum number of simultaneous offloads (defaults to disabled)" },
 
@@ -193,7 +196,7 @@ bool DetectionModule::end(const char* fqn, int idx, SnortConfig* sc)
         return add_service_extension(sc);
     }
 
-    if ( sc->offload_threads and ThreadConfig::get_instance_max() != 1 )
+    if ( sc->offload_threads and !sc->offload_pool and ThreadConfig::get_instance_max() != 1 )
         ParseError("You can not enable experimental offload with more than one packet thread.");
 
     return true;
@@ -218,6 +221,9 @@ bool DetectionModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("offload_limit") )
         sc->offload_limit = v.get_uint32();
 
+    else if ( v.is("offload_pool") )
+        sc->offload_pool = v.get_bool();
+
     else if ( v.is("offload_threads") )
         sc->offload_threads = v.get_uint32();
 
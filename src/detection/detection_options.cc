@@ -738,6 +738,7 @@ static void detection_option_node_update_otn_stats(detection_option_tree_node_t*
         local_stats.elapsed += stats->elapsed;
         local_stats.elapsed_match += stats->elapsed_match;
         local_stats.elapsed_no_match += stats->elapsed_no_match;
+        local_stats.counts += stats->counts;
 
         if (stats->checks > local_stats.checks)
             local_stats.checks = stats->checks;
@@ -755,6 +756,7 @@ static void detection_option_node_update_otn_stats(detection_option_tree_node_t*
         state.elapsed = local_stats.elapsed;
         state.elapsed_match = local_stats.elapsed_match;
         state.elapsed_no_match = local_stats.elapsed_no_match;
+        state.counts = local_stats.counts;
 
         if (local_stats.checks > state.checks)
             state.checks = local_stats.checks;
@@ -771,6 +773,7 @@ static void detection_option_node_update_otn_stats(detection_option_tree_node_t*
         totals.elapsed += state.elapsed;
         totals.elapsed_match += state.elapsed_match;
         totals.elapsed_no_match += state.elapsed_no_match;
+        totals.counts += state.counts;
         totals.checks += state.checks;
         totals.latency_timeouts += state.latency_timeouts;
         totals.latency_suspends += state.latency_suspends;
@@ -34,6 +34,7 @@
 #include <sys/time.h>
 
 #include "detection/rule_option_types.h"
+#include "profiler/perf_counters.h"
 #include "time/clock_defs.h"
 #include "trace/trace_api.h"
 
@@ -74,6 +75,7 @@ struct dot_node_state_t
     hr_duration elapsed_no_match;
     uint64_t checks;
     uint64_t disables;
+    PerfCounts counts;
 
     unsigned latency_timeouts;
     unsigned latency_suspends;
@@ -95,6 +97,7 @@ struct dot_node_state_t
     {
         elapsed = elapsed_match = elapsed_no_match = 0_ticks;
         checks = disables = 0;
+        counts.reset();
         latency_suspends = latency_timeouts = 0;
     }
 };
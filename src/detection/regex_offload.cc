@@ -41,6 +41,7 @@
 #include "main/thread.h"
 #include "main/thread_config.h"
 #include "managers/module_manager.h"
+#include "protocols/packet.h"
 #include "utils/stats.h"
 
 using namespace snort;
@@ -65,8 +66,21 @@ struct RegexRequest
     bool go = true;
 };
 
-RegexOffload* RegexOffload::get_offloader(unsigned max, bool async)
+#ifdef REG_TEST
+// make the packet thread wait for results to get predictable behavior
+static void wait_for_search(RegexRequest* req)
+{
+    std::unique_lock<std::mutex> sync_lock(req->sync_mutex);
+    while ( req->offload and req->sync_cond.wait_for(sync_lock, std::chrono::seconds(1))
+        == std::cv_status::timeout );
+}
+#endif
+
+RegexOffload* RegexOffload::get_offloader(unsigned max, bool async, bool pooled)
 {
+    if ( async and pooled and max )
+        return new PooledRegexOffload(max);
+
     if ( async )
         return new ThreadRegexOffload(max);
 
@@ -104,6 +118,46 @@ bool RegexOffload::on_hold(const Flow* f) const
     return std::any_of(busy.cbegin(), busy.cend(), [f](const RegexRequest* req){ return req->packet->flow == f; });
 }
 
+// run the search for the request in a worker thread
+static void search(RegexRequest* req)
+{
+    assert(req->packet);
+    assert(req->packet->is_offloaded());
+    assert(req->packet->context->searches.items.size() > 0);
+
+    SnortConfig::set_conf(req->packet->context->conf);
+    IpsContext* c = req->packet->context;
+    Mpse::MpseRespType resp_ret;
+
+    c->searches.offload_search();
+
+    do
+    {
+        resp_ret = c->searches.receive_offload_responses();
+    }
+    while (resp_ret == Mpse::MPSE_RESP_NOT_COMPLETE);
+
+    if (resp_ret == Mpse::MPSE_RESP_COMPLETE_FAIL)
+    {
+        if (c->searches.can_fallback())
+        {
+            c->searches.search_sync();
+            pc.offload_fallback++;
+        }
+        pc.offload_failures++;
+    }
+
+    c->searches.items.clear();
+    req->offload = false;
+
+#ifdef REG_TEST
+    {
+        std::unique_lock<std::mutex> lock(req->sync_mutex);
+        req->sync_cond.notify_one();
+    }
+#endif
+}
+
 //--------------------------------------------------------------------------
 // synchronous (ie non) offload implementation
 //--------------------------------------------------------------------------
@@ -230,17 +284,18 @@ void ThreadRegexOffload::put(Packet* p)
     }
 
 #ifdef REG_TEST
-    {
-        std::unique_lock<std::mutex> sync_lock(req->sync_mutex);
-        while ( req->offload and req->sync_cond.wait_for(sync_lock, std::chrono::seconds(1))
-            == std::cv_status::timeout );
-    }
+    wait_for_search(req);
 #endif
 }
 
 bool ThreadRegexOffload::get(Packet*& p)
 {
     Profile profile(mpsePerfStats);
+    return get_done(p);
+}
+
+bool RegexOffload::get_done(Packet*& p)
+{
     assert(!busy.empty());
 
     for ( auto i = busy.begin(); i != busy.end(); i++ )
@@ -283,47 +338,437 @@ void ThreadRegexOffload::worker(
                 continue;
         }
 
-        assert(req->packet);
-        assert(req->packet->is_offloaded());
-        assert(req->packet->context->searches.items.size() > 0);
+        search(req);
+    }
+    ModuleManager::accumulate_module("search_engine");
+    ModuleManager::accumulate_module("detection");
 
-        SnortConfig::set_conf(req->packet->context->conf);
-        IpsContext* c = req->packet->context;
-        Mpse::MpseRespType resp_ret;
+    // FIXIT-M break this over-coupling. In reality we shouldn't be evaluating latency in offload.
+    PacketLatency::tterm();
+    RuleLatency::tterm();
+}
 
-        c->searches.offload_search();
+//--------------------------------------------------------------------------
+// pooled (shared threads) offload implementation
+//--------------------------------------------------------------------------
 
-        do
-        {
-            resp_ret = c->searches.receive_offload_responses();
-        }
-        while (resp_ret == Mpse::MPSE_RESP_NOT_COMPLETE);
+// single producer single consumer ring of requests; the producer is one
+// packet thread and the consumer is one pool worker
+class RequestRing
+{
+public:
+    RequestRing(unsigned size)
+    {
+        unsigned n = 1;
 
-        if (resp_ret == Mpse::MPSE_RESP_COMPLETE_FAIL)
+        while ( n < size )
+            n <<= 1;
+
+        mask = n - 1;
+        slots = new RegexRequest*[n];
+    }
+
+    ~RequestRing()
+    { delete[] slots; }
+
+    bool push(RegexRequest* req)
+    {
+        unsigned h = head.load(std::memory_order_relaxed);
+
+        if ( h - tail.load(std::memory_order_acquire) > mask )
+            return false;
+
+        slots[h & mask] = req;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    RegexRequest* pop()
+    {
+        unsigned t = tail.load(std::memory_order_relaxed);
+
+        if ( t == head.load(std::memory_order_acquire) )
+            return nullptr;
+
+        RegexRequest* req = slots[t & mask];
+        tail.store(t + 1, std::memory_order_release);
+        return req;
+    }
+
+private:
+    RegexRequest** slots;
+    unsigned mask;
+
+    // keep the producer and consumer indices on separate cache lines
+    std::atomic<unsigned> head { 0 };
+    char pad[64];
+    std::atomic<unsigned> tail { 0 };
+};
+
+// the pool is started by the first packet thread to use it and stopped by
+// the last one; there is a ring from each packet thread to each worker
+class RegexPool
+{
+public:
+    typedef void (*Work)(RegexRequest*);
+
+    static RegexPool* acquire(unsigned depth);
+    static void release();
+
+    // each worker polls one ring per source and calls work on each request
+    RegexPool(unsigned workers, unsigned sources, unsigned depth, Work = search);
+    ~RegexPool();
+
+    void put(unsigned source, unsigned worker, RegexRequest* req)
+    {
+        bool ok = rings[worker * num_sources + source]->push(req);
+        assert(ok);
+        UNUSED(ok);
+    }
+
+    unsigned get_workers() const
+    { return threads.size(); }
+
+private:
+    static void worker(RegexPool*, const SnortConfig*, unsigned id);
+
+    // empty polls before a worker starts sleeping between polls
+    static const unsigned busy_polls = 1024;
+
+    std::vector<std::thread*> threads;
+    std::vector<RequestRing*> rings;
+    unsigned num_sources;
+    Work work;
+    std::atomic<bool> go { true };
+
+    static std::mutex mutex;
+    static RegexPool* pool;
+    static unsigned users;
+};
+
+std::mutex RegexPool::mutex;
+RegexPool* RegexPool::pool = nullptr;
+unsigned RegexPool::users = 0;
+
+RegexPool::RegexPool(unsigned workers, unsigned sources, unsigned depth, Work w)
+{
+    num_sources = sources;
+    work = w;
+
+    for ( unsigned i = 0; i < workers * num_sources; ++i )
+        rings.emplace_back(new RequestRing(depth));
+
+    const SnortConfig* sc = SnortConfig::get_conf();
+
+    for ( unsigned i = 0; i < workers; ++i )
+        threads.emplace_back(new std::thread(worker, this, sc, i));
+}
+
+RegexPool::~RegexPool()
+{
+    go = false;
+
+    for ( auto* t : threads )
+    {
+        t->join();
+        delete t;
+    }
+
+    for ( auto* r : rings )
+        delete r;
+}
+
+RegexPool* RegexPool::acquire(unsigned depth)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if ( !pool )
+        pool = new RegexPool(SnortConfig::get_conf()->offload_threads,
+            ThreadConfig::get_instance_max(), depth);
+
+    ++users;
+    return pool;
+}
+
+void RegexPool::release()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(users > 0);
+
+    if ( --users == 0 )
+    {
+        delete pool;
+        pool = nullptr;
+    }
+}
+
+void RegexPool::worker(RegexPool* rp, const SnortConfig* initial_config, unsigned id)
+{
+    set_instance_id(ThreadConfig::get_instance_max() + id);
+    SnortConfig::set_conf(initial_config);
+
+    unsigned empty_polls = 0;
+
+    while ( rp->go.load(std::memory_order_relaxed) )
+    {
+        bool found = false;
+
+        for ( unsigned i = 0; i < rp->num_sources; ++i )
         {
-            if (c->searches.can_fallback())
+            RequestRing* ring = rp->rings[id * rp->num_sources + i];
+
+            while ( RegexRequest* req = ring->pop() )
             {
-                c->searches.search_sync();
-                pc.offload_fallback++;
+                rp->work(req);
+                found = true;
             }
-            pc.offload_failures++;
         }
 
-        c->searches.items.clear();
-        req->offload = false;
+        if ( found )
+            empty_polls = 0;
 
-#ifdef REG_TEST
-        {
-            std::unique_lock<std::mutex> lock(req->sync_mutex);
-            req->sync_cond.notify_one();
-        }
-#endif
+        else if ( ++empty_polls > busy_polls )
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
     }
     ModuleManager::accumulate_module("search_engine");
     ModuleManager::accumulate_module("detection");
 
-    // FIXIT-M break this over-coupling. In reality we shouldn't be evaluating latency in offload.
     PacketLatency::tterm();
     RuleLatency::tterm();
 }
 
+PooledRegexOffload::PooledRegexOffload(unsigned max) : RegexOffload(max)
+{
+    // at most max requests are outstanding so the rings never fill
+    pool = RegexPool::acquire(max);
+    source = get_instance_id();
+    assert(source < ThreadConfig::get_instance_max());
+}
+
+PooledRegexOffload::~PooledRegexOffload()
+{
+    RegexPool::release();
+}
+
+// keep a flow's searches on one worker; flows are allocated at aligned
+// addresses so the low bits are mixed in with a multiplicative hash
+unsigned PooledRegexOffload::get_worker(const Flow* f) const
+{
+    uint64_t h = (uint64_t)(uintptr_t)f * 0x9E3779B97F4A7C15ull;
+    return (h >> 32) % pool->get_workers();
+}
+
+void PooledRegexOffload::put(Packet* p)
+{
+    // cppcheck-suppress unreadVariable
+    Profile profile(mpsePerfStats);
+
+    assert(p);
+    assert(!idle.empty());
+    assert(p->context->searches.items.size() > 0);
+
+    RegexRequest* req = idle.front();
+    idle.pop_front();
+
+    busy.emplace_back(req);
+    p->context->regex_req_it = std::prev(busy.end());
+
+    req->packet = p;
+    req->offload = true;
+
+    pool->put(source, get_worker(p->flow), req);
+
+#ifdef REG_TEST
+    wait_for_search(req);
+#endif
+}
+
+bool PooledRegexOffload::get(Packet*& p)
+{
+    Profile profile(mpsePerfStats);
+    return get_done(p);
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+
+// the rings only pass pointers along so the tests use sequence numbers
+static RegexRequest* as_req(uintptr_t n)
+{ return reinterpret_cast<RegexRequest*>(n); }
+
+static uintptr_t as_num(RegexRequest* req)
+{ return reinterpret_cast<uintptr_t>(req); }
+
+TEST_CASE("RequestRing push pop order", "[RequestRing]")
+{
+    // size is rounded up to a power of 2
+    RequestRing ring(5);
+
+    CHECK(ring.pop() == nullptr);
+
+    for ( uintptr_t i = 1; i <= 8; ++i )
+        CHECK(ring.push(as_req(i)));
+
+    CHECK(!ring.push(as_req(9)));
+
+    for ( uintptr_t i = 1; i <= 8; ++i )
+        CHECK(as_num(ring.pop()) == i);
+
+    CHECK(ring.pop() == nullptr);
+}
+
+TEST_CASE("RequestRing wraparound", "[RequestRing]")
+{
+    RequestRing ring(4);
+    uintptr_t in = 1, out = 1;
+
+    // uneven batches walk the head and tail across the end of the slots
+    for ( unsigned i = 0; i < 1000; ++i )
+    {
+        unsigned n = 1 + i % 4;
+
+        for ( unsigned j = 0; j < n; ++j )
+            CHECK(ring.push(as_req(in++)));
+
+        if ( n == 4 )
+            CHECK(!ring.push(as_req(in)));
+
+        for ( unsigned j = 0; j < n; ++j )
+            CHECK(as_num(ring.pop()) == out++);
+
+        CHECK(ring.pop() == nullptr);
+    }
+}
+
+TEST_CASE("RequestRing producer consumer", "[RequestRing]")
+{
+    const uintptr_t num = 100000;
+    RequestRing ring(8);
+    uintptr_t bad = 0, next = 1;
+
+    std::thread consumer([&ring, &bad, &next]()
+    {
+        while ( next <= num )
+        {
+            if ( RegexRequest* req = ring.pop() )
+            {
+                if ( as_num(req) != next )
+                    ++bad;
+                ++next;
+            }
+            else
+                std::this_thread::yield();
+        }
+    });
+
+    for ( uintptr_t i = 1; i <= num; ++i )
+    {
+        while ( !ring.push(as_req(i)) )
+            std::this_thread::yield();
+    }
+    consumer.join();
+
+    CHECK(bad == 0);
+    CHECK(next == num + 1);
+    CHECK(ring.pop() == nullptr);
+}
+
+struct PoolRecord
+{
+    std::thread::id tid;
+    unsigned source;
+    unsigned seq;
+};
+
+static std::mutex record_mutex;
+static std::vector<PoolRecord> records;
+
+// pool requests carry the source and sequence in place of a packet
+static void record_work(RegexRequest* req)
+{
+    uintptr_t v = reinterpret_cast<uintptr_t>(req->packet);
+    {
+        std::lock_guard<std::mutex> lock(record_mutex);
+        records.push_back({ std::this_thread::get_id(), (unsigned)(v >> 16), (unsigned)(v & 0xffff) });
+    }
+    req->offload = false;
+}
+
+static void produce(RegexPool* rp, unsigned source, unsigned depth, unsigned num)
+{
+    std::vector<RegexRequest> reqs(depth);
+
+    for ( unsigned seq = 0; seq < num; ++seq )
+    {
+        // reuse a request only when its worker is done with it like the
+        // idle list does so at most depth requests are in the rings
+        RegexRequest& req = reqs[seq % depth];
+
+        while ( req.offload )
+            std::this_thread::yield();
+
+        req.packet = reinterpret_cast<Packet*>((uintptr_t)((source << 16) | seq));
+        req.offload = true;
+        rp->put(source, seq % rp->get_workers(), &req);
+    }
+
+    for ( const auto& req : reqs )
+    {
+        while ( req.offload )
+            std::this_thread::yield();
+    }
+}
+
+TEST_CASE("RegexPool fan in", "[RegexPool]")
+{
+    const unsigned workers = 2, sources = 3, depth = 16, num = 5000;
+    records.clear();
+
+    RegexPool* rp = new RegexPool(workers, sources, depth, record_work);
+    CHECK(rp->get_workers() == workers);
+
+    std::vector<std::thread> producers;
+
+    for ( unsigned s = 0; s < sources; ++s )
+        producers.emplace_back(produce, rp, s, depth, num);
+
+    for ( auto& t : producers )
+        t.join();
+
+    delete rp;
+
+    REQUIRE(records.size() == sources * num);
+
+    std::thread::id tids[workers];
+    unsigned next[sources][workers] = { };
+    unsigned bad_order = 0, bad_worker = 0;
+
+    // each source's requests to a worker are done by that worker in order
+    for ( const auto& r : records )
+    {
+        REQUIRE(r.source < sources);
+        unsigned w = r.seq % workers;
+
+        if ( r.seq != next[r.source][w] * workers + w )
+            ++bad_order;
+
+        ++next[r.source][w];
+
+        if ( tids[w] == std::thread::id() )
+            tids[w] = r.tid;
+
+        else if ( tids[w] != r.tid )
+            ++bad_worker;
+    }
+    CHECK(bad_order == 0);
+    CHECK(bad_worker == 0);
+    CHECK(tids[0] != tids[1]);
+
+    records.clear();
+}
+
+#endif
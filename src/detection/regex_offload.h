@@ -25,8 +25,11 @@
 // There are two flavors: MPSE and thread.  The MpseRegexOffload interfaces to
 // an MPSE that is capable of regex offload such as the RXP whereas
 // ThreadRegexOffload implements the regex search in auxiliary threads w/o
-// requiring extra MPSE instances.  presently all offload is per packet thread;
-// packet threads do not share offload resources.
+// requiring extra MPSE instances.  ThreadRegexOffload threads belong to one
+// packet thread.  PooledRegexOffload instead feeds a pool of search workers
+// shared by all packet threads through lock free rings so that search work
+// can be balanced across cores apart from the stateful packet processing.
+// Only the search is pooled; the rest of detection stays on the packet thread.
 
 #include <condition_variable>
 #include <list>
@@ -43,7 +46,7 @@ struct RegexRequest;
 class RegexOffload
 {
 public:
-    static RegexOffload* get_offloader(unsigned max, bool async);
+    static RegexOffload* get_offloader(unsigned max, bool async, bool pooled = false);
     virtual ~RegexOffload();
 
     virtual void stop();
@@ -62,6 +65,9 @@ public:
 protected:
     RegexOffload(unsigned max);
 
+    // return a request the search worker is done with
+    bool get_done(snort::Packet*&);
+
 protected:
     std::list<RegexRequest*> busy;
     std::list<RegexRequest*> idle;
@@ -91,5 +97,23 @@ private:
     static void worker(RegexRequest*, const snort::SnortConfig*, unsigned id);
 };
 
+class RegexPool;
+
+class PooledRegexOffload : public RegexOffload
+{
+public:
+    PooledRegexOffload(unsigned max);
+    ~PooledRegexOffload() override;
+
+    void put(snort::Packet*) override;
+    bool get(snort::Packet*&) override;
+
+private:
+    unsigned get_worker(const snort::Flow*) const;
+
+    RegexPool* pool;
+    unsigned source;
+};
+
 #endif
 
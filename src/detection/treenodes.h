@@ -31,6 +31,7 @@
 #include "main/policy.h"
 #include "main/snort_types.h"
 #include "ports/port_group.h"
+#include "profiler/perf_counters.h"
 #include "time/clock_defs.h"
 
 namespace snort
@@ -67,6 +68,7 @@ struct OtnState
 
     uint64_t checks = 0;
     uint64_t matches = 0;
+    PerfCounts counts;
     uint8_t noalerts = 0;
     uint64_t alerts = 0;
 
@@ -30,9 +30,13 @@
 
 #include "file_capture.h"
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #include <cassert>
+#include <cerrno>
 
 #include "log/messages.h"
 #include "utils/stats.h"
@@ -433,37 +437,51 @@ FileCaptureBlock* FileCapture::get_file_data(uint8_t** buff, int* size)
 /*
  * writing file data to the disk.
  *
- * In the case of interrupt errors, the write is retried, but only for a
- * finite number of times.
+ * Blocks are written straight out of the mempool. In the case of interrupt
+ * errors, the write is retried, but only for a finite number of times.
  */
-void FileCapture::write_file_data(uint8_t* buf, size_t buf_len, FILE* fh)
+void FileCapture::write_file_data(struct iovec* iov, int iovcnt, int fd)
 {
     int max_retries = 3;
-    size_t bytes_written = 0;
-    int err;
+    int err = 0;
 
-    /* Nothing to write or nothing to write to */
-    if ((buf == nullptr) || (fh == nullptr))
-        return;
-
-    /* writing several times */
-    do
+    while (iovcnt > 0)
     {
-        size_t bytes_left = buf_len - bytes_written;
+        ssize_t n = writev(fd, iov, iovcnt);
 
-        bytes_written += fwrite(buf + bytes_written, 1, bytes_left, fh);
+        if (n < 0)
+        {
+            err = errno;
+            if (((err != EINTR) && (err != EAGAIN)) || (--max_retries <= 0))
+                break;
+            continue;
+        }
 
-        err = ferror(fh);
-        if (err && (err != EINTR) && (err != EAGAIN))
+        // nothing written with blocks pending must not spin forever
+        if (n == 0)
         {
-            break;
+            err = EIO;
+            if (--max_retries <= 0)
+                break;
+            continue;
+        }
+
+        // skip what was written, a partial write can end inside a block
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len)
+        {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
         }
 
-        max_retries--;
+        if (iovcnt > 0)
+        {
+            iov->iov_base = (uint8_t*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
     }
-    while ((max_retries > 0) && (bytes_written < buf_len));
 
-    if (bytes_written < buf_len)
+    if (iovcnt > 0)
     {
         ErrorMessage("File inspect: disk writing error - %s!\n", get_error(err));
     }
@@ -484,13 +502,15 @@ void FileCapture::store_file()
         return;
     }
 
-    FILE* fh = fopen(file_full_name.c_str(), "w");
-    if (!fh )
+    int fd = open(file_full_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
     {
         return;
     }
 
-    // Check the file buffer
+    // Gather the file buffers and write them out in batches
+    struct iovec iov[FILE_CAPTURE_IOV_MAX];
+    int iovcnt = 0;
     uint8_t* buff = nullptr;
     int size = 0;
     void* file_mem;
@@ -500,16 +520,23 @@ void FileCapture::store_file()
         file_mem = get_file_data(&buff, &size);
         // Get file from file buffer
         if (!buff || !size )
+            break;
+
+        iov[iovcnt].iov_base = buff;
+        iov[iovcnt].iov_len = size;
+
+        if (++iovcnt == FILE_CAPTURE_IOV_MAX)
         {
-            fclose(fh);
-            return;
+            write_file_data(iov, iovcnt, fd);
+            iovcnt = 0;
         }
-
-        write_file_data(buff, size, fh);
     }
     while (file_mem);
 
-    fclose(fh);
+    if (iovcnt)
+        write_file_data(iov, iovcnt, fd);
+
+    close(fd);
 }
 
 // Queue files to be stored to disk
@@ -546,6 +573,7 @@ void FileCapture::print_mem_usage()
         LogCount("Buffers in use", file_mempool->allocated());
         LogCount("Buffers in free list", file_mempool->freed());
         LogCount("Buffers in release list", file_mempool->released());
+        LogCount("Buffer claim retries", file_mempool->contended());
         LogCount("Memory usage in bytes", file_mempool->allocated() * block_size);
     }
 }
@@ -38,7 +38,11 @@
 
 #include "file_api.h"
 
+// maximum number of blocks written with one system call
+#define FILE_CAPTURE_IOV_MAX 64
+
 class FileMemPool;
+struct iovec;
 
 namespace snort
 {
@@ -104,7 +108,7 @@ private:
     inline FileCaptureBlock* create_file_buffer();
     inline FileCaptureState save_to_file_buffer(const uint8_t* file_data, int data_size,
         int64_t max_size);
-    void write_file_data(uint8_t* buf, size_t buf_len, FILE* fh);
+    void write_file_data(struct iovec* iov, int iovcnt, int fd);
 
     static FileMemPool* file_mempool;
     static int64_t capture_block_size;
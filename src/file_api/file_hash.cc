@@ -0,0 +1,297 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "file_hash.h"
+
+#include <atomic>
+#include <thread>
+
+#include "file_stats.h"
+
+#ifdef UNIT_TEST
+#include <cstring>
+
+#include "catch/snort_catch.h"
+#endif
+
+// the pool is started and stopped while packet threads are not running
+static bool running = false;
+static int64_t max_queued_bytes = 0;
+static std::atomic<int64_t> queued_bytes { 0 };
+
+static std::mutex pool_mutex;
+static std::condition_variable pool_cv;
+static std::deque<FileHash*> pending;
+static std::vector<std::thread*> workers;
+
+FileHash::FileHash()
+{
+    SHA256_Init(&ctx);
+}
+
+FileHash::~FileHash()
+{
+    wait();
+}
+
+void FileHash::reset()
+{
+    wait();
+    SHA256_Init(&ctx);
+}
+
+void FileHash::update(const uint8_t* data, size_t size)
+{
+    if ( !size )
+        return;
+
+    if ( !running or queued_bytes + (int64_t)size > max_queued_bytes )
+    {
+        if ( running )
+            file_counts.hash_inline_updates++;
+
+        wait();
+        SHA256_Update(&ctx, data, size);
+        return;
+    }
+
+    queued_bytes += size;
+    file_counts.hash_segments_queued++;
+
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        segments.emplace_back(data, data + size);
+
+        if ( scheduled )
+            return;
+
+        scheduled = true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(pool_mutex);
+        pending.emplace_back(this);
+    }
+    pool_cv.notify_one();
+}
+
+void FileHash::digest(uint8_t* hash, bool final)
+{
+    wait();
+
+    if ( final )
+    {
+        SHA256_Final(hash, &ctx);
+        return;
+    }
+
+    SHA256_CTX tmp = ctx;
+    SHA256_Final(hash, &tmp);
+}
+
+// block until the workers are done with this hash
+void FileHash::wait()
+{
+    std::unique_lock<std::mutex> lk(mutex);
+
+    if ( !scheduled )
+        return;
+
+    file_counts.hash_waits++;
+    done_cv.wait(lk, [this] { return !scheduled; });
+}
+
+// called on a worker; ctx is owned by the worker while scheduled is set
+void FileHash::drain()
+{
+    std::unique_lock<std::mutex> lk(mutex);
+
+    while ( !segments.empty() )
+    {
+        std::vector<uint8_t> seg(std::move(segments.front()));
+        segments.pop_front();
+        lk.unlock();
+
+        SHA256_Update(&ctx, seg.data(), seg.size());
+        queued_bytes -= seg.size();
+
+        lk.lock();
+    }
+    scheduled = false;
+
+    // this may be deleted as soon as the lock is released
+    done_cv.notify_all();
+}
+
+void FileHash::worker()
+{
+    while ( true )
+    {
+        std::unique_lock<std::mutex> lk(pool_mutex);
+        pool_cv.wait(lk, [] { return !running or !pending.empty(); });
+
+        // when !running we finish any remaining hashes before exiting
+        if ( pending.empty() )
+            break;
+
+        FileHash* fh = pending.front();
+        pending.pop_front();
+        lk.unlock();
+
+        fh->drain();
+    }
+}
+
+void FileHash::init(unsigned threads, int64_t max_queued)
+{
+    if ( running or !threads )
+        return;
+
+    max_queued_bytes = max_queued;
+    running = true;
+
+    for ( unsigned i = 0; i < threads; ++i )
+        workers.emplace_back(new std::thread(worker));
+}
+
+void FileHash::exit()
+{
+    {
+        std::lock_guard<std::mutex> lk(pool_mutex);
+        running = false;
+    }
+    pool_cv.notify_all();
+
+    for ( auto* t : workers )
+    {
+        t->join();
+        delete t;
+    }
+    workers.clear();
+}
+
+
+#ifdef UNIT_TEST
+static std::vector<uint8_t> make_data(size_t size, uint8_t seed)
+{
+    std::vector<uint8_t> data(size);
+
+    for ( size_t i = 0; i < size; ++i )
+        data[i] = (uint8_t)(seed + i * 7);
+
+    return data;
+}
+
+static void inline_digest(const std::vector<uint8_t>& data, uint8_t* hash)
+{
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, data.data(), data.size());
+    SHA256_Final(hash, &ctx);
+}
+
+static bool same_digest(FileHash& fh, const std::vector<uint8_t>& data)
+{
+    uint8_t a[SHA256_DIGEST_LENGTH], b[SHA256_DIGEST_LENGTH];
+    fh.digest(a, false);
+    inline_digest(data, b);
+    return !memcmp(a, b, sizeof(a));
+}
+
+// segments are held by the pool until a worker is started so the
+// accounting can be checked without racing the workers
+TEST_CASE("file hash queue limit", "[file_hash]")
+{
+    memset(&file_counts, 0, sizeof(file_counts));
+    max_queued_bytes = 100;
+    running = true;
+
+    std::vector<uint8_t> data = make_data(150, 1);
+    FileHash a, b;
+
+    a.update(data.data(), 60);
+    CHECK(queued_bytes == 60);
+    CHECK(file_counts.hash_segments_queued == 1);
+
+    a.update(data.data() + 60, 40);
+    CHECK(queued_bytes == 100);
+    CHECK(file_counts.hash_segments_queued == 2);
+
+    // over the limit so this is hashed inline
+    b.update(data.data(), 1);
+    CHECK(queued_bytes == 100);
+    CHECK(file_counts.hash_inline_updates == 1);
+    CHECK(same_digest(b, std::vector<uint8_t>(data.begin(), data.begin() + 1)));
+
+    // exit drains what is queued before the workers stop
+    running = false;
+    FileHash::init(1, 100);
+    FileHash::exit();
+
+    CHECK(queued_bytes == 0);
+    CHECK(same_digest(a, std::vector<uint8_t>(data.begin(), data.begin() + 100)));
+
+    // without workers everything is inline
+    a.update(data.data() + 100, 50);
+    CHECK(queued_bytes == 0);
+    CHECK(file_counts.hash_segments_queued == 2);
+    CHECK(same_digest(a, data));
+}
+
+TEST_CASE("file hash keeps segment order per file", "[file_hash]")
+{
+    FileHash::init(4, 1 << 20);
+
+    const unsigned num_files = 8;
+    std::vector<uint8_t> data[num_files];
+    FileHash hashes[num_files];
+
+    for ( unsigned i = 0; i < num_files; ++i )
+        data[i] = make_data(64 * 1024 + i, (uint8_t)i);
+
+    // interleave small segments of every file
+    for ( size_t off = 0; off < data[num_files - 1].size(); off += 997 )
+    {
+        for ( unsigned i = 0; i < num_files; ++i )
+        {
+            if ( off < data[i].size() )
+            {
+                size_t len = std::min((size_t)997, data[i].size() - off);
+                hashes[i].update(data[i].data() + off, len);
+            }
+        }
+    }
+
+    for ( unsigned i = 0; i < num_files; ++i )
+    {
+        CHECK(same_digest(hashes[i], data[i]));
+
+        uint8_t a[SHA256_DIGEST_LENGTH], b[SHA256_DIGEST_LENGTH];
+        hashes[i].digest(a, true);
+        inline_digest(data[i], b);
+        CHECK(!memcmp(a, b, sizeof(a)));
+    }
+
+    FileHash::exit();
+    CHECK(queued_bytes == 0);
+}
+#endif
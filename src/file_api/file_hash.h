@@ -0,0 +1,71 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef FILE_HASH_H
+#define FILE_HASH_H
+
+// Incremental SHA-256 of a file. When hashing threads are configured, file
+// segments are copied and hashed by a worker in submission order, so the
+// packet thread only waits when it needs the digest for a signature lookup.
+// Without hashing threads, or when too much data is queued, segments are
+// hashed inline as before.
+
+#include <openssl/sha.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+class FileHash
+{
+public:
+    FileHash();
+    ~FileHash();
+
+    // start a new hash, dropping any state of the previous one
+    void reset();
+
+    void update(const uint8_t* data, size_t size);
+
+    // get the hash of the data seen so far; hashing can continue
+    // afterwards unless this is the final digest
+    void digest(uint8_t* hash, bool final);
+
+    // these must be called during snort init / exit
+    static void init(unsigned threads, int64_t max_queued);
+    static void exit();
+
+private:
+    void drain();
+    void wait();
+    static void worker();
+
+    SHA256_CTX ctx;
+
+    // segments waiting for a worker and whether this hash is
+    // on or owned by a worker; guarded by mutex
+    std::deque<std::vector<uint8_t>> segments;
+    bool scheduled = false;
+    std::mutex mutex;
+    std::condition_variable done_cv;
+};
+
+#endif
+
@@ -29,8 +29,6 @@
 
 #include "file_lib.h"
 
-#include <openssl/sha.h>
-
 #include <iostream>
 #include <iomanip>
 
@@ -50,6 +48,7 @@
 #include "file_config.h"
 #include "file_cache.h"
 #include "file_flows.h"
+#include "file_hash.h"
 #include "file_service.h"
 #include "file_segment.h"
 #include "file_stats.h"
@@ -319,7 +318,6 @@ UserFileDataBase* FileInfo::get_file_data()
 FileContext::FileContext ()
 {
     file_type_context = nullptr;
-    file_signature_context = nullptr;
     file_capture = nullptr;
     file_segments = nullptr;
     inspector = (FileInspect*)InspectorManager::acquire_file_inspector();
@@ -328,8 +326,8 @@ FileContext::FileContext ()
 
 FileContext::~FileContext ()
 {
-    if (file_signature_context)
-        snort_free(file_signature_context);
+    if (file_hash)
+        delete file_hash;
     if (file_capture)
         stop_file_capture();
     if (file_segments)
@@ -426,7 +424,7 @@ void FileContext::finish_signature_lookup(Packet* p, bool final_lookup, FilePoli
         }
         else
         {
-            snort_free(sha256);
+            delete[] sha256;
             sha256 = nullptr;
         }
     }
@@ -438,7 +436,7 @@ void FileContext::set_signature_state(bool gen_sig)
     {
         if ( sha256 )
         {
-            snort_free(sha256);
+            delete[] sha256;
             sha256 = nullptr;
         }
 
@@ -692,60 +690,54 @@ void FileContext::process_file_signature_sha256(const uint8_t* file_data, int da
     switch (position)
     {
     case SNORT_FILE_START:
-        if (!file_signature_context)
-            file_signature_context = snort_calloc(sizeof(SHA256_CTX));
-        SHA256_Init((SHA256_CTX*)file_signature_context);
-        SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+        if (!file_hash)
+            file_hash = new FileHash;
+        else
+            file_hash->reset();
+        file_hash->update(file_data, data_size);
         FILE_DEBUG(file_trace, DEFAULT_TRACE_OPTION_ID, TRACE_DEBUG_LEVEL, GET_CURRENT_PACKET,
             "position is start of file\n");
         if (file_state.sig_state == FILE_SIG_FLUSH)
         {
-            static uint8_t file_signature_context_backup[sizeof(SHA256_CTX)];
-            sha256 = (uint8_t*)snort_alloc(SHA256_HASH_SIZE);
-            memcpy(file_signature_context_backup, file_signature_context, sizeof(SHA256_CTX));
-
-            SHA256_Final(sha256, (SHA256_CTX*)file_signature_context);
-            memcpy(file_signature_context, file_signature_context_backup, sizeof(SHA256_CTX));
+            sha256 = new uint8_t[SHA256_HASH_SIZE];
+            file_hash->digest(sha256, false);
         }
         break;
 
     case SNORT_FILE_MIDDLE:
-        if (!file_signature_context)
+        if (!file_hash)
             return;
-        SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+        file_hash->update(file_data, data_size);
         FILE_DEBUG(file_trace, DEFAULT_TRACE_OPTION_ID, TRACE_DEBUG_LEVEL, GET_CURRENT_PACKET,
             "position is middle of the file\n");
         if (file_state.sig_state == FILE_SIG_FLUSH)
         {
-            static uint8_t file_signature_context_backup[sizeof(SHA256_CTX)];
             if ( !sha256 )
-                sha256 = (uint8_t*)snort_alloc(SHA256_HASH_SIZE);
-            memcpy(file_signature_context_backup, file_signature_context, sizeof(SHA256_CTX));
-
-            SHA256_Final(sha256, (SHA256_CTX*)file_signature_context);
-            memcpy(file_signature_context, file_signature_context_backup, sizeof(SHA256_CTX));
+                sha256 = new uint8_t[SHA256_HASH_SIZE];
+            file_hash->digest(sha256, false);
         }
 
         break;
 
     case SNORT_FILE_END:
-        if (!file_signature_context)
+        if (!file_hash)
             return;
-        SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+        file_hash->update(file_data, data_size);
         sha256 = new uint8_t[SHA256_HASH_SIZE];
-        SHA256_Final(sha256, (SHA256_CTX*)file_signature_context);
+        file_hash->digest(sha256, true);
         file_state.sig_state = FILE_SIG_DONE;
         FILE_DEBUG(file_trace, DEFAULT_TRACE_OPTION_ID, TRACE_DEBUG_LEVEL, GET_CURRENT_PACKET,
             "position is end of the file\n");
         break;
 
     case SNORT_FILE_FULL:
-        if (!file_signature_context)
-            file_signature_context = snort_calloc(sizeof (SHA256_CTX));
-        SHA256_Init((SHA256_CTX*)file_signature_context);
-        SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+        if (!file_hash)
+            file_hash = new FileHash;
+        else
+            file_hash->reset();
+        file_hash->update(file_data, data_size);
         sha256 = new uint8_t[SHA256_HASH_SIZE];
-        SHA256_Final(sha256, (SHA256_CTX*)file_signature_context);
+        file_hash->digest(sha256, true);
         file_state.sig_state = FILE_SIG_DONE;
         FILE_DEBUG(file_trace, DEFAULT_TRACE_OPTION_ID, TRACE_DEBUG_LEVEL, GET_CURRENT_PACKET,
             "position is full file\n");
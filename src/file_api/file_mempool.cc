@@ -31,9 +31,20 @@
 
 #include "file_mempool.h"
 
+#include <sys/mman.h>
+
+#include <cassert>
+
 #include "log/messages.h"
 #include "utils/util.h"
 
+#ifdef UNIT_TEST
+#include <thread>
+#include <vector>
+
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 /*This magic is used for double free detection*/
@@ -41,17 +52,27 @@ using namespace snort;
 #define FREE_MAGIC    0x2525252525252525
 typedef uint64_t MagicType;
 
+// stack tops hold index + 1 in the low half, 0 for empty, and a tag that
+// changes on every update in the high half
+#define TOP_INDEX(top)  ((uint32_t)(top))
+#define TOP_TAG(top)    ((top) >> 32)
+#define MAKE_TOP(tag, index) (((uint64_t)(tag) << 32) | (index))
 
 void FileMemPool::free_pools()
 {
     if (datapool != nullptr)
     {
-        snort_free(datapool);
+        if (datapool_size)
+            munmap(datapool, datapool_size);
+        else
+            snort_free(datapool);
         datapool = nullptr;
+        datapool_size = 0;
     }
 
-    cbuffer_free(free_list);
-    cbuffer_free(released_list);
+    delete[] next;
+    next = nullptr;
+    total = 0;
 }
 
 /*
@@ -63,44 +84,39 @@ void FileMemPool::free_pools()
 
 FileMemPool::FileMemPool(uint64_t num_objects, size_t o_size)
 {
-    unsigned int i;
-
     if ((num_objects < 1) || (o_size < 1))
         return;
 
+    if (num_objects >= UINT32_MAX)
+        num_objects = UINT32_MAX - 1;
+
     obj_size = o_size;
 
     // this is the basis pool that represents all the *data pointers in the list
-    datapool = (void**)snort_calloc(num_objects, obj_size);
+    size_t size = num_objects * obj_size;
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 
-    /* sets up the memory list */
-    free_list = cbuffer_init(num_objects);
-    if (!free_list)
+    if (map != MAP_FAILED)
     {
-        free_pools();
-        return;
+#ifdef MADV_HUGEPAGE
+        madvise(map, size, MADV_HUGEPAGE);
+#endif
+        datapool = (uint8_t*)map;
+        datapool_size = size;
     }
+    else
+        datapool = (uint8_t*)snort_calloc(num_objects, obj_size);
 
-    released_list = cbuffer_init(num_objects);
-    if (!released_list)
-    {
-        free_pools();
-        return;
-    }
+    /* sets up the memory list */
+    next = new std::atomic<uint32_t>[num_objects];
 
-    total = 0;
-    for (i=0; i<num_objects; i++)
+    for (uint64_t i = num_objects; i > 0; i--)
     {
-        void* data = ((char*)datapool) + (i * obj_size);
-
-        if (cbuffer_write(free_list,  data))
-        {
-            free_pools();
-            return;
-        }
-        *(MagicType*)data = FREE_MAGIC;
-        total++;
+        *(MagicType*)(datapool + (i - 1) * obj_size) = FREE_MAGIC;
+        push(free_list, i - 1);
     }
+    total = num_objects;
+    retries = 0;
 }
 
 /*
@@ -112,6 +128,48 @@ FileMemPool::~FileMemPool()
     free_pools();
 }
 
+bool FileMemPool::pop(FreeStack& stack, uint32_t& index)
+{
+    uint64_t top = stack.top.load(std::memory_order_acquire);
+
+    while (true)
+    {
+        if (!TOP_INDEX(top))
+            return false;
+
+        index = TOP_INDEX(top) - 1;
+        uint64_t new_top = MAKE_TOP(TOP_TAG(top) + 1, next[index].load(std::memory_order_relaxed));
+
+        if (stack.top.compare_exchange_weak(top, new_top, std::memory_order_acq_rel,
+            std::memory_order_acquire))
+            break;
+
+        retries.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    stack.count.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void FileMemPool::push(FreeStack& stack, uint32_t index)
+{
+    uint64_t top = stack.top.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        next[index].store(TOP_INDEX(top), std::memory_order_relaxed);
+        uint64_t new_top = MAKE_TOP(TOP_TAG(top) + 1, index + 1);
+
+        if (stack.top.compare_exchange_weak(top, new_top, std::memory_order_release,
+            std::memory_order_relaxed))
+            break;
+
+        retries.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    stack.count.fetch_add(1, std::memory_order_relaxed);
+}
+
 /*
  * Allocate a new object from the FileMemPool
  *
@@ -123,34 +181,30 @@ FileMemPool::~FileMemPool()
 
 void* FileMemPool::m_alloc()
 {
-    void* b = nullptr;
+    uint32_t index;
 
-    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (!pop(free_list, index) and !pop(released_list, index))
+        return nullptr;
 
-    if (cbuffer_read(free_list, &b))
-    {
-        if (cbuffer_read(released_list, &b))
-        {
-            return nullptr;
-        }
-    }
+    void* b = datapool + (uint64_t)index * obj_size;
+    *(MagicType*)b = 0;
 
     return b;
 }
 
 /*
- * Free a new object from the buffer
- * We use circular buffer to synchronize one reader and one writer
+ * Return an object to one of the free stacks
+ * Objects are identified by their offset in the pool
  */
-int FileMemPool::remove(CircularBuffer* cb, void* obj)
+int FileMemPool::remove(FreeStack& stack, void* obj)
 {
-    if (obj == nullptr)
+    if (obj == nullptr or datapool == nullptr)
         return FILE_MEM_FAIL;
 
-    if (cbuffer_write(cb, obj))
-    {
+    uint8_t* p = (uint8_t*)obj;
+
+    if (p < datapool or p >= datapool + total * obj_size or (p - datapool) % obj_size)
         return FILE_MEM_FAIL;
-    }
 
     if (*(MagicType*)obj == FREE_MAGIC)
     {
@@ -158,18 +212,14 @@ int FileMemPool::remove(CircularBuffer* cb, void* obj)
     }
 
     *(MagicType*)obj = FREE_MAGIC;
+    push(stack, (p - datapool) / obj_size);
 
     return FILE_MEM_SUCCESS;
 }
 
 int FileMemPool::m_free(void* obj)
 {
-    std::lock_guard<std::mutex> lock(pool_mutex);
-
-    int ret = remove(free_list, obj);
-
-
-    return ret;
+    return remove(free_list, obj);
 }
 
 /*
@@ -181,31 +231,103 @@ int FileMemPool::m_free(void* obj)
 
 int FileMemPool::m_release(void* obj)
 {
-    std::lock_guard<std::mutex> lock(pool_mutex);
-
     /*A writer that might from different thread*/
-    int ret = remove(released_list, obj);
-
-
-    return ret;
+    return remove(released_list, obj);
 }
 
 /* Returns number of elements allocated in current buffer*/
 uint64_t FileMemPool::allocated()
 {
     uint64_t total_freed = released() + freed();
-    return (total - total_freed);
+    return (total > total_freed) ? (total - total_freed) : 0;
 }
 
 /* Returns number of elements freed in current buffer*/
 uint64_t FileMemPool::freed()
 {
-    return (cbuffer_used(free_list));
+    return free_list.count.load(std::memory_order_relaxed);
 }
 
 /* Returns number of elements released in current buffer*/
 uint64_t FileMemPool::released()
 {
-    return (cbuffer_used(released_list));
+    return released_list.count.load(std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+TEST_CASE("file mempool alloc free release", "[file_mempool]")
+{
+    FileMemPool pool(4, 64);
+    CHECK(pool.total_objects() == 4);
+
+    void* objs[4];
+    for (auto& o : objs)
+    {
+        o = pool.m_alloc();
+        REQUIRE(o != nullptr);
+    }
+    CHECK(pool.m_alloc() == nullptr);
+    CHECK(pool.allocated() == 4);
+
+    CHECK(pool.m_free(objs[0]) == FILE_MEM_SUCCESS);
+    CHECK(pool.m_release(objs[1]) == FILE_MEM_SUCCESS);
+    CHECK(pool.freed() == 1);
+    CHECK(pool.released() == 1);
+    CHECK(pool.allocated() == 2);
+
+    // double free and foreign pointers are rejected
+    CHECK(pool.m_free(objs[0]) == FILE_MEM_FAIL);
+    CHECK(pool.m_release(objs[1]) == FILE_MEM_FAIL);
+    CHECK(pool.m_free((uint8_t*)objs[2] + 1) == FILE_MEM_FAIL);
+    CHECK(pool.m_free(nullptr) == FILE_MEM_FAIL);
+
+    // free list is drained before the released list
+    CHECK(pool.m_alloc() == objs[0]);
+    CHECK(pool.m_alloc() == objs[1]);
+    CHECK(pool.m_alloc() == nullptr);
 }
 
+TEST_CASE("file mempool concurrent alloc and release", "[file_mempool]")
+{
+    const unsigned num_threads = 4;
+    const unsigned num_objects = 64;
+    FileMemPool pool(num_objects, 64);
+    std::atomic<unsigned> errors { 0 };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; t++)
+    {
+        threads.emplace_back([&pool, &errors, t]()
+        {
+            for (unsigned i = 0; i < 10000; i++)
+            {
+                uint8_t* obj = (uint8_t*)pool.m_alloc();
+                if (!obj)
+                    continue;
+
+                // nobody else may hold this object
+                obj[sizeof(MagicType)] = t;
+                std::this_thread::yield();
+                if (obj[sizeof(MagicType)] != t)
+                    errors++;
+
+                int ret = (i & 1) ? pool.m_free(obj) : pool.m_release(obj);
+                if (ret != FILE_MEM_SUCCESS)
+                    errors++;
+            }
+        });
+    }
+
+    for (auto& t : threads)
+        t.join();
+
+    CHECK(errors == 0);
+    CHECK(pool.allocated() == 0);
+    CHECK(pool.freed() + pool.released() == num_objects);
+}
+#endif
+
@@ -23,14 +23,15 @@
 #define FILE_MEMPOOL_H
 
 //  This mempool implementation has very efficient alloc/free operations.
-//  In addition, it provides thread-safe alloc/free for one allocation/free
-//  thread and one release thread.
+//  Objects live in one contiguous region, mapped with transparent huge pages
+//  when available, and free objects are kept on lock-free index stacks so
+//  any number of packet threads and the file writer thread can alloc, free
+//  and release concurrently without taking a lock.
 //  One more bonus: Double free detection is also added into this library
-//  This is a thread safe version of memory pool for one writer and one reader thread
 
-#include <mutex>
-
-#include "circular_buffer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 
 #define FILE_MEM_SUCCESS    0  // FIXIT-RC use bool
 #define FILE_MEM_FAIL      (-1)
@@ -47,11 +48,11 @@ public:
     // Returns: a pointer to the FileMemPool object on success, nullptr on failure
     void* m_alloc();
 
-    // This must be called by the same thread calling file_mempool_alloc()
+    // Return an object to the pool from a packet thread
     // Return: FILE_MEM_SUCCESS or FILE_MEM_FAIL
     int m_free(void* obj);
 
-    // This can be called by a different thread calling file_mempool_alloc()
+    // Return an object to the pool from the file writer thread
     // Return: FILE_MEM_SUCCESS or FILE_MEM_FAIL
     int m_release(void* obj);
 
@@ -67,18 +68,33 @@ public:
     // Returns total number of elements in current buffer
     uint64_t total_objects() { return total; }
 
+    // Returns number of times a thread had to retry claiming or returning
+    // an element because another thread got there first
+    uint64_t contended() { return retries; }
+
 private:
 
+    // Treiber stack of object indexes; the top is tagged with a counter to
+    // avoid ABA, the links are kept in next so objects are never touched
+    struct FreeStack
+    {
+        std::atomic<uint64_t> top { 0 };
+        std::atomic<uint64_t> count { 0 };
+    };
+
     void free_pools();
-    int remove(CircularBuffer* cb, void* obj);
+    bool pop(FreeStack&, uint32_t& index);
+    void push(FreeStack&, uint32_t index);
+    int remove(FreeStack&, void* obj);
 
-    void** datapool = nullptr; /* memory buffer */
+    uint8_t* datapool = nullptr; /* memory buffer */
+    size_t datapool_size = 0;    /* non-zero when mapped */
+    std::atomic<uint32_t>* next = nullptr;
     uint64_t total = 0;
-    CircularBuffer* free_list = nullptr;
-    CircularBuffer* released_list = nullptr;
+    FreeStack free_list;
+    FreeStack released_list;
     size_t obj_size = 0;
-    std::mutex pool_mutex;
+    std::atomic<uint64_t> retries { 0 };
 };
 
 #endif
-
@@ -81,6 +81,12 @@ static const Parameter file_id_params[] =
     { "max_files_per_flow", Parameter::PT_INT, "1:max53", "128",
       "maximal number of files able to be concurrently processed per flow" },
 
+    { "hash_threads", Parameter::PT_INT, "0:64", "0",
+      "number of threads computing file signatures off the packet threads; 0 hashes inline" },
+
+    { "hash_queue_memcap", Parameter::PT_INT, "1:max53", "16",
+      "maximal file data in megabytes queued for hashing before packet threads hash inline" },
+
     { "show_data_depth", Parameter::PT_INT, "0:max53", "100",
       "print this many octets" },
 
@@ -109,6 +115,11 @@ static const PegInfo file_pegs[] =
     { CountType::SUM, "cache_failures", "number of file cache add failures" },
     { CountType::SUM, "files_not_processed", "number of files not processed due to per-flow limit" },
     { CountType::MAX, "max_concurrent_files", "maximum files processed concurrently on a flow" },
+    { CountType::SUM, "hash_segments_queued", "number of file segments queued to the hashing threads" },
+    { CountType::SUM, "hash_waits", "number of times a packet thread waited for queued file segments to be hashed" },
+    { CountType::SUM, "hash_inline_updates", "number of file segments hashed inline because the hash queue was full" },
+    { CountType::MAX, "max_capture_buffers", "maximum file capture buffers in use at once" },
+    { CountType::SUM, "capture_buffer_stalls", "number of times file capture found no free buffer" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -193,6 +204,12 @@ bool FileIdModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("max_files_per_flow") )
         fc->max_files_per_flow = v.get_uint64();
 
+    else if ( v.is("hash_threads") )
+        fc->hash_threads = v.get_uint32();
+
+    else if ( v.is("hash_queue_memcap") )
+        fc->hash_queue_memcap = v.get_int64();
+
     else if ( v.is("show_data_depth") )
         fc->show_data_depth = v.get_int64();
 
@@ -37,6 +37,7 @@
 #include "file_cache.h"
 #include "file_capture.h"
 #include "file_flows.h"
+#include "file_hash.h"
 #include "file_stats.h"
 
 using namespace snort;
@@ -53,6 +54,8 @@ DecodeConfig FileService::decode_conf;
 static int64_t max_files_cached = 0;
 static int64_t capture_memcap = 0;
 static int64_t capture_block_size = 0;
+static uint32_t hash_threads = 0;
+static int64_t hash_queue_memcap = 0;
 
 void FileService::init()
 {
@@ -76,6 +79,13 @@ void FileService::post_init()
         file_cache->set_lookup_timeout(conf->file_lookup_timeout);
     }
 
+    if (file_signature_enabled and conf->hash_threads)
+    {
+        FileHash::init(conf->hash_threads, conf->hash_queue_memcap * 1024 * 1024);
+        hash_threads = conf->hash_threads;
+        hash_queue_memcap = conf->hash_queue_memcap;
+    }
+
     if (file_capture_enabled)
     {
         FileCapture::init(conf->capture_memcap, conf->capture_block_size);
@@ -96,6 +106,14 @@ void FileService::verify_reload(const SnortConfig* sc)
     if (max_files_cached != conf->max_files_cached)
         ReloadError("Changing file_id.max_files_cached requires a restart.\n");
 
+    if (file_signature_enabled)
+    {
+        if (hash_threads != conf->hash_threads)
+            ReloadError("Changing file_id.hash_threads requires a restart.\n");
+        if (hash_threads and hash_queue_memcap != conf->hash_queue_memcap)
+            ReloadError("Changing file_id.hash_queue_memcap requires a restart.\n");
+    }
+
     if (file_capture_enabled)
     {
         if (capture_memcap != conf->capture_memcap)
@@ -117,6 +135,7 @@ void FileService::close()
 
     MimeSession::exit();
     FileCapture::exit();
+    FileHash::exit();
 }
 
 void FileService::thread_init()
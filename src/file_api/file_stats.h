@@ -37,17 +37,20 @@ struct FileCounts
     PegCount cache_add_fails;
     PegCount files_over_flow_limit_not_processed;
     PegCount max_concurrent_files_per_flow;
+    PegCount hash_segments_queued;
+    PegCount hash_waits;
+    PegCount hash_inline_updates;
+    PegCount file_buffers_used_max;         // maximum buffers used simultaneously
+    PegCount file_memcap_failures_total;
     PegCount files_buffered_total;
     PegCount files_released_total;
     PegCount files_freed_total;
     PegCount files_captured_total;
-    PegCount file_memcap_failures_total;
     PegCount file_memcap_failures_reserve;  // This happens during reserve
     PegCount file_reserve_failures;         // This happens during reserve
     PegCount file_size_min;                 // This happens during reserve
     PegCount file_size_max;                 // This happens during reserve
     PegCount file_within_packet;
-    PegCount file_buffers_used_max;         // maximum buffers used simultaneously
     PegCount file_buffers_allocated_total;
     PegCount file_buffers_freed_total;
     PegCount file_buffers_released_total;
@@ -0,0 +1,221 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "filter_sketch.h"
+
+#include <cstring>
+
+static inline uint64_t mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+FilterSketch::FilterSketch(unsigned bytes, bool shared) : shared(shared)
+{
+    unsigned width = 64;
+
+    while ( (size_t)width * 2 * FILTER_SKETCH_DEPTH * sizeof(Cell) <= bytes )
+        width *= 2;
+
+    mask = width - 1;
+    cells = new Cell[(size_t)width * FILTER_SKETCH_DEPTH];
+    clear();
+}
+
+FilterSketch::~FilterSketch()
+{ delete[] cells; }
+
+void FilterSketch::clear()
+{
+    for ( size_t i = 0; i < (size_t)(mask + 1) * FILTER_SKETCH_DEPTH; i++ )
+    {
+        Cell& c = cells[i];
+        c.count.store(0, std::memory_order_relaxed);
+        c.prev.store(0, std::memory_order_relaxed);
+        c.tstart.store(0, std::memory_order_relaxed);
+        c.tlast.store(0, std::memory_order_relaxed);
+        c.mark.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t FilterSketch::hash(const void* key, size_t len)
+{
+    const uint8_t* p = (const uint8_t*)key;
+    uint64_t h = len;
+
+    while ( len >= sizeof(uint64_t) )
+    {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        h = mix(h ^ w);
+        p += sizeof(w);
+        len -= sizeof(w);
+    }
+
+    if ( len )
+    {
+        uint64_t w = 0;
+        memcpy(&w, p, len);
+        h = mix(h ^ w);
+    }
+    return h;
+}
+
+// the two halves of the hash give the cell of each row
+FilterSketch::Cell* FilterSketch::get_cell(uint64_t hash, unsigned row) const
+{
+    uint32_t h1 = hash;
+    uint32_t h2 = (hash >> 32) | 1;
+    return &cells[(size_t)row * (mask + 1) + ((h1 + row * h2) & mask)];
+}
+
+bool FilterSketch::get(uint64_t hash, FilterSketchNode& node) const
+{
+    const Cell* min = nullptr;
+    uint32_t min_count = 0;
+
+    for ( unsigned row = 0; row < FILTER_SKETCH_DEPTH; row++ )
+    {
+        const Cell* c = get_cell(hash, row);
+        uint32_t count = c->count.load(std::memory_order_relaxed);
+
+        if ( !c->tstart.load(std::memory_order_relaxed) )
+        {
+            memset(&node, 0, sizeof(node));
+            return false;
+        }
+
+        if ( !min or count < min_count )
+        {
+            min = c;
+            min_count = count;
+        }
+    }
+
+    node.count = min_count;
+    node.prev = min->prev.load(std::memory_order_relaxed);
+    node.tstart = min->tstart.load(std::memory_order_relaxed);
+    node.tlast = min->tlast.load(std::memory_order_relaxed);
+    node.mark = min->mark.load(std::memory_order_relaxed);
+    return true;
+}
+
+void FilterSketch::raise(std::atomic<uint32_t>& a, uint32_t v)
+{
+    uint32_t cur = a.load(std::memory_order_relaxed);
+
+    if ( !shared )
+    {
+        if ( v > cur )
+            a.store(v, std::memory_order_relaxed);
+        return;
+    }
+
+    while ( v > cur and !a.compare_exchange_weak(cur, v, std::memory_order_relaxed) )
+        ;
+}
+
+void FilterSketch::lower(std::atomic<uint32_t>& a, uint32_t by)
+{
+    if ( !shared )
+    {
+        uint32_t cur = a.load(std::memory_order_relaxed);
+        a.store(cur > by ? cur - by : 0, std::memory_order_relaxed);
+        return;
+    }
+
+    uint32_t cur = a.load(std::memory_order_relaxed);
+
+    while ( !a.compare_exchange_weak(cur, cur > by ? cur - by : 0, std::memory_order_relaxed) )
+        ;
+}
+
+// a cell is replaced only when its window has ended so that a key still in
+// its window keeps its count; otherwise the change is merged.  in local mode
+// an increment is a conservative update that only raises cells to the new
+// estimate.  in shared mode other threads may have changed the cells since
+// the estimate was read so the difference is added instead.
+void FilterSketch::put(
+    uint64_t hash, const FilterSketchNode& old, const FilterSketchNode& node, unsigned seconds)
+{
+    bool same = (node.tstart == old.tstart);
+    uint32_t add = same ? (node.count > old.count ? node.count - old.count : 0) : node.count;
+    uint32_t sub = (same and node.count < old.count) ? old.count - node.count : 0;
+
+    for ( unsigned row = 0; row < FILTER_SKETCH_DEPTH; row++ )
+    {
+        Cell* c = get_cell(hash, row);
+        uint32_t tstart = c->tstart.load(std::memory_order_relaxed);
+
+        if ( ended(tstart, node.tstart, seconds) and
+            c->tstart.compare_exchange_strong(tstart, node.tstart, std::memory_order_relaxed) )
+        {
+            c->count.store(node.count, std::memory_order_relaxed);
+            c->prev.store(node.prev, std::memory_order_relaxed);
+            c->tlast.store(node.tlast, std::memory_order_relaxed);
+            c->mark.store(node.mark, std::memory_order_relaxed);
+            continue;
+        }
+
+        if ( add )
+        {
+            if ( shared )
+                c->count.fetch_add(add, std::memory_order_relaxed);
+            else
+                raise(c->count, node.count);
+        }
+        else if ( sub )
+            lower(c->count, sub);
+
+        raise(c->tlast, node.tlast);
+        c->prev.store(node.prev, std::memory_order_relaxed);
+        c->mark.store(node.mark, std::memory_order_relaxed);
+    }
+}
+
+FilterSketch* SharedFilterSketch::acquire(unsigned bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if ( !sketch )
+        sketch = new FilterSketch(bytes, true);
+
+    users++;
+    return sketch;
+}
+
+void SharedFilterSketch::release()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if ( users and !--users )
+    {
+        delete sketch;
+        sketch = nullptr;
+    }
+}
+
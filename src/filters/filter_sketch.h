@@ -0,0 +1,120 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef FILTER_SKETCH_H
+#define FILTER_SKETCH_H
+
+// FilterSketch is a count-min sketch of filter tracking state that can be
+// used in place of the rate_filter and event_filter hash tables.  A key maps
+// to one cell in each of FILTER_SKETCH_DEPTH rows and the cell with the
+// lowest count is the estimate.  Memory is fixed regardless of the number
+// of addresses tracked.  Cells keep the start of their window and a cell is
+// only replaced by a newer window once its own window has ended, so a key
+// in its window is never estimated below its count.  Collisions and keys
+// sharing a cell across windows can only raise an estimate.  The exception
+// is a decrement (rate_filter with seconds = 0), which is taken from every
+// cell of the key and so may also be taken from a colliding key.
+//
+// A shared sketch is updated by all packet threads so limits apply to the
+// total rate rather than the rate seen by each thread.  Cells are relaxed
+// atomics and increments are added so concurrent updates are not lost.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#define FILTER_SKETCH_DEPTH 4
+
+enum FilterSketchMode
+{
+    FILTER_SKETCH_NONE,
+    FILTER_SKETCH_LOCAL,
+    FILTER_SKETCH_SHARED
+};
+
+// times are seconds truncated to 32 bits
+struct FilterSketchNode
+{
+    uint32_t count;
+    uint32_t prev;
+    uint32_t tstart;
+    uint32_t tlast;
+    uint32_t mark;
+};
+
+class FilterSketch
+{
+public:
+    FilterSketch(unsigned bytes, bool shared);
+    ~FilterSketch();
+
+    static uint64_t hash(const void*, size_t);
+
+    // returns false if no cell for the key has been used
+    bool get(uint64_t hash, FilterSketchNode&) const;
+
+    // old is the node from get() and the difference is applied to each cell;
+    // seconds is the filter window, 0 if none
+    void put(uint64_t hash, const FilterSketchNode& old, const FilterSketchNode&,
+        unsigned seconds);
+
+    void clear();
+
+    unsigned get_width() const
+    { return mask + 1; }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> prev;
+        std::atomic<uint32_t> tstart;
+        std::atomic<uint32_t> tlast;
+        std::atomic<uint32_t> mark;
+    };
+
+    Cell* get_cell(uint64_t hash, unsigned row) const;
+
+    // true if a cell window starting at tstart is unused or has ended by now
+    static bool ended(uint32_t tstart, uint32_t now, unsigned seconds)
+    { return !tstart or ((int32_t)(now - tstart) > 0 and now - tstart > seconds); }
+
+    void raise(std::atomic<uint32_t>&, uint32_t);
+    void lower(std::atomic<uint32_t>&, uint32_t);
+
+    Cell* cells;
+    unsigned mask;
+    bool shared;
+};
+
+// the process wide sketch of shared mode, freed with its last thread
+class SharedFilterSketch
+{
+public:
+    FilterSketch* acquire(unsigned bytes);
+    void release();
+
+private:
+    std::mutex mutex;
+    FilterSketch* sketch = nullptr;
+    unsigned users = 0;
+};
+
+#endif
+
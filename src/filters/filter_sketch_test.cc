@@ -0,0 +1,171 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// filter_sketch_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "filter_sketch.h"
+
+#include <thread>
+#include <vector>
+
+#include "catch/snort_catch.h"
+
+// the smallest sketch has 64 cells per row
+#define SKETCH_MIN 0
+
+static FilterSketchNode make_node(uint32_t count, uint32_t tstart)
+{
+    FilterSketchNode node = { };
+    node.count = count;
+    node.tstart = node.tlast = tstart;
+    return node;
+}
+
+// one event for the key like the filters do: read, update the copy, write back
+static uint32_t event(FilterSketch& fs, uint64_t hash, uint32_t now, unsigned seconds)
+{
+    FilterSketchNode old;
+
+    if ( !fs.get(hash, old) )
+        old = make_node(0, now);
+
+    FilterSketchNode node = old;
+
+    if ( now - old.tstart > seconds )
+        node = make_node(1, now);
+    else
+        node.count++;
+
+    node.tlast = now;
+    fs.put(hash, old, node, seconds);
+    return node.count;
+}
+
+static uint32_t estimate(const FilterSketch& fs, uint64_t hash)
+{
+    FilterSketchNode node;
+    return fs.get(hash, node) ? node.count : 0;
+}
+
+TEST_CASE("filter sketch conservative update", "[filter_sketch]")
+{
+    FilterSketch fs(SKETCH_MIN, false);
+    CHECK(fs.get_width() == 64);
+
+    uint64_t a = FilterSketch::hash("a", 1);
+    FilterSketchNode node;
+    CHECK(!fs.get(a, node));
+
+    for ( unsigned i = 1; i <= 10; i++ )
+        CHECK(event(fs, a, 100, 60) == i);
+
+    CHECK(estimate(fs, a) == 10);
+
+    // a decrement is applied to each cell
+    fs.get(a, node);
+    FilterSketchNode less = node;
+    less.count = 7;
+    fs.put(a, node, less, 0);
+    CHECK(estimate(fs, a) == 7);
+
+    fs.clear();
+    CHECK(!fs.get(a, node));
+}
+
+TEST_CASE("filter sketch collisions only overestimate", "[filter_sketch]")
+{
+    // many more keys than cells so every key collides
+    FilterSketch fs(SKETCH_MIN, false);
+    const unsigned num_keys = 1000;
+    std::vector<uint32_t> truth(num_keys);
+
+    for ( unsigned round = 0; round < 20; round++ )
+    {
+        for ( unsigned k = 0; k < num_keys; k++ )
+        {
+            if ( (k + round) % (k % 7 + 1) )
+                continue;
+
+            event(fs, FilterSketch::hash(&k, sizeof(k)), 100 + round, 60);
+            truth[k]++;
+        }
+    }
+
+    for ( unsigned k = 0; k < num_keys; k++ )
+        CHECK(estimate(fs, FilterSketch::hash(&k, sizeof(k))) >= truth[k]);
+}
+
+TEST_CASE("filter sketch window rollover", "[filter_sketch]")
+{
+    FilterSketch fs(SKETCH_MIN, false);
+    const unsigned seconds = 10;
+    const unsigned num_keys = 500;
+    unsigned busy = num_keys;
+    uint64_t hb = FilterSketch::hash(&busy, sizeof(busy));
+
+    // a busy key counting in its window
+    for ( unsigned i = 0; i < 50; i++ )
+        event(fs, hb, 100, seconds);
+
+    // colliding keys start newer windows while the busy key's is open
+    for ( unsigned k = 0; k < num_keys; k++ )
+    {
+        event(fs, FilterSketch::hash(&k, sizeof(k)), 95, seconds);
+        event(fs, FilterSketch::hash(&k, sizeof(k)), 106, seconds);
+    }
+
+    CHECK(estimate(fs, hb) >= 50);
+    CHECK(event(fs, hb, 109, seconds) >= 51);
+
+    // once its window has ended the key starts over
+    CHECK(event(fs, hb, 111, seconds) >= 1);
+
+    FilterSketch solo(SKETCH_MIN, false);
+
+    for ( unsigned i = 0; i < 50; i++ )
+        event(solo, hb, 100, seconds);
+
+    CHECK(event(solo, hb, 111, seconds) == 1);
+    CHECK(estimate(solo, hb) == 1);
+}
+
+TEST_CASE("filter sketch shared increments", "[filter_sketch]")
+{
+    FilterSketch fs(1024 * 1024, true);
+    uint64_t h = FilterSketch::hash("shared", 6);
+
+    const unsigned num_threads = 4;
+    const unsigned num_events = 20000;
+    std::vector<std::thread> threads;
+
+    for ( unsigned t = 0; t < num_threads; t++ )
+        threads.emplace_back([&fs, h]()
+        {
+            for ( unsigned i = 0; i < num_events; i++ )
+                event(fs, h, 100, 60);
+        });
+
+    for ( auto& t : threads )
+        t.join();
+
+    // racing threads may add an increment to a stale estimate but never lose one
+    CHECK(estimate(fs, h) >= num_threads * num_events);
+}
@@ -102,6 +102,9 @@ typedef struct
 } tSFRFTrackingNode;
 
 static THREAD_LOCAL XHash* rf_hash = nullptr;
+static THREAD_LOCAL FilterSketch* rf_sketch = nullptr;
+static THREAD_LOCAL bool rf_sketch_shared = false;
+static SharedFilterSketch rf_shared_sketch;
 
 // private methods ...
 static int _checkThreshold(
@@ -122,6 +125,21 @@ static tSFRFTrackingNode* _getSFRFTrackingNode(
     time_t curTime
     );
 
+static uint64_t _getSFRFSketchNode(
+    const SfIp*,
+    unsigned tid,
+    time_t curTime,
+    FilterSketchNode&,
+    tSFRFTrackingNode*
+    );
+
+static void _putSFRFSketchNode(
+    uint64_t hash,
+    const FilterSketchNode&,
+    const tSFRFTrackingNode*,
+    unsigned seconds
+    );
+
 static void _updateDependentThresholds(
     RateFilterConfig* config,
     unsigned gid,
@@ -158,6 +176,16 @@ static void SFRF_New(unsigned nbytes)
 
 void SFRF_Delete()
 {
+    if ( rf_sketch )
+    {
+        if ( rf_sketch_shared )
+            rf_shared_sketch.release();
+        else
+            delete rf_sketch;
+
+        rf_sketch = nullptr;
+    }
+
     if ( !rf_hash )
         return;
 
@@ -169,6 +197,9 @@ void SFRF_Flush()
 {
     if ( rf_hash )
         rf_hash->clear_hash();
+
+    if ( rf_sketch and !rf_sketch_shared )
+        rf_sketch->clear();
 }
 
 static void SFRF_ConfigNodeFree(void* item)
@@ -198,8 +229,19 @@ static void SFRF_SidNodeFree(void* item)
     snort_free(pSidnode);
 }
 
-int SFRF_Alloc(unsigned int memcap)
+int SFRF_Alloc(unsigned int memcap, FilterSketchMode mode)
 {
+    if ( mode != FILTER_SKETCH_NONE )
+    {
+        if ( rf_sketch == nullptr )
+        {
+            rf_sketch_shared = (mode == FILTER_SKETCH_SHARED);
+            rf_sketch = rf_sketch_shared ?
+                rf_shared_sketch.acquire(memcap) : new FilterSketch(memcap, false);
+        }
+        return 0;
+    }
+
     if ( rf_hash == nullptr )
     {
         SFRF_New(memcap);
@@ -357,9 +399,18 @@ static int SFRF_TestObject(
     )
 {
     tSFRFTrackingNode* dynNode;
+    tSFRFTrackingNode sketchNode;
+    FilterSketchNode sketchOld;
+    uint64_t sketchHash = 0;
     int retValue = -1;
 
-    dynNode = _getSFRFTrackingNode(ip, cfgNode->tid, curTime);
+    if ( rf_sketch )
+    {
+        sketchHash = _getSFRFSketchNode(ip, cfgNode->tid, curTime, sketchOld, &sketchNode);
+        dynNode = &sketchNode;
+    }
+    else
+        dynNode = _getSFRFTrackingNode(ip, cfgNode->tid, curTime);
 
     if ( dynNode == nullptr )
         return retValue;
@@ -412,6 +463,9 @@ static int SFRF_TestObject(
             dynNode->count--;
     }
 
+    if ( rf_sketch )
+        _putSFRFSketchNode(sketchHash, sketchOld, dynNode, cfgNode->seconds);
+
 #ifdef SFRF_DEBUG
     printf("--SFRF_DEBUG: %d-%u-%u: %u Packet IP %s, op: %d, count %u, action %d\n",
         cfgNode->tid, cfgNode->gid,
@@ -807,3 +861,57 @@ static tSFRFTrackingNode* _getSFRFTrackingNode(const SfIp* ip, unsigned tid, tim
 
     return dynNode;
 }
+
+// in sketch mode the tracking node is a copy of the estimate which is
+// written back after the test; FS_ON is kept as a nonzero revert time
+// and overRate as prev
+static uint64_t _getSFRFSketchNode(
+    const SfIp* ip, unsigned tid, time_t curTime, FilterSketchNode& old,
+    tSFRFTrackingNode* dynNode)
+{
+    tSFRFTrackingNodeKey key;
+
+    key.ip = *(ip);
+    key.tid = tid;
+    key.policyId = get_inspection_policy()->policy_id;
+    key.padding = 0;
+
+    uint64_t hash = FilterSketch::hash(&key, sizeof(key));
+
+    if ( !rf_sketch->get(hash, old) )
+    {
+        old.tstart = old.tlast = (uint32_t)curTime;
+        old.count = old.prev = old.mark = 0;
+    }
+
+    dynNode->count = old.count;
+    dynNode->tstart = old.tstart;
+    dynNode->revertTime = old.mark;
+    dynNode->filterState = old.mark ? FS_ON : FS_OFF;
+#ifdef SFRF_OVER_RATE
+    dynNode->overRate = old.prev;
+    dynNode->tlast = old.tlast;
+#endif
+
+    return hash;
+}
+
+static void _putSFRFSketchNode(
+    uint64_t hash, const FilterSketchNode& old, const tSFRFTrackingNode* dynNode,
+    unsigned seconds)
+{
+    FilterSketchNode node;
+
+    node.count = dynNode->count;
+    node.tstart = (uint32_t)dynNode->tstart;
+    node.mark = (dynNode->filterState == FS_ON) ? (uint32_t)dynNode->revertTime : 0;
+#ifdef SFRF_OVER_RATE
+    node.prev = dynNode->overRate;
+    node.tlast = (uint32_t)dynNode->tlast;
+#else
+    node.prev = 0;
+    node.tlast = node.tstart;
+#endif
+
+    rf_sketch->put(hash, old, node, seconds);
+}
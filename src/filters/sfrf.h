@@ -30,6 +30,8 @@
 #include "framework/counts.h"
 #include "main/policy.h"
 
+#include "filters/filter_sketch.h"
+
 namespace snort
 {
 class GHash;
@@ -142,6 +144,7 @@ struct RateFilterConfig
     snort::GHash* genHash [SFRF_MAX_GENID];
 
     unsigned memcap;
+    FilterSketchMode sketch;
     unsigned noRevertCount;
     int count;
     int internal_event_mask;
@@ -187,6 +190,6 @@ inline bool is_internal_event_enabled(RateFilterConfig* config, uint32_t sid)
     return (config->internal_event_mask & (1 << sid));
 }
 
-int SFRF_Alloc(unsigned int memcap);
+int SFRF_Alloc(unsigned int memcap, FilterSketchMode);
 
 #endif
@@ -899,7 +899,7 @@ static void Init(const SnortConfig* sc, unsigned cap)
     rfc = RateFilter_ConfigNew();
     rfc->memcap = cap;
 
-    SFRF_Alloc(rfc->memcap);
+    SFRF_Alloc(rfc->memcap, FILTER_SKETCH_NONE);
 
     for ( unsigned i = 0; i < NUM_NODES; i++ )
     {
@@ -1011,6 +1011,81 @@ static inline int sfthd_test_global(
     return sfthd_test_non_suppress(sfthd_node, sfthd_ip_node, curtime);
 }
 
+/*
+ *   Test a local or global thresholding object against the sketch.  The
+ *   estimate is tested as a copy and the changes are written back.
+ */
+static int sfthd_test_sketch(
+    FilterSketch* sketch,
+    THD_NODE* sfthd_node,
+    bool global,
+    unsigned sig_id,
+    const SfIp* sip,
+    const SfIp* dip,
+    time_t curtime,
+    PolicyId policy_id)
+{
+    if ( sfthd_node->count == THD_NO_THRESHOLD)
+        return 0;
+
+    const SfIp* ip = (sfthd_node->tracking == THD_TRK_SRC) ? sip : dip;
+
+    if ( sfthd_node->type == THD_TYPE_SUPPRESS )
+        return sfthd_test_suppress(sfthd_node, ip);
+
+    uint64_t hash;
+
+    if ( global )
+    {
+        THD_IP_GNODE_KEY key;
+        key.ip = *ip;
+        key.gen_id = sfthd_node->gen_id;
+        key.sig_id = sig_id;
+        key.policyId = policy_id;
+        key.padding = 0;
+        hash = FilterSketch::hash(&key, sizeof(key));
+    }
+    else
+    {
+        THD_IP_NODE_KEY key;
+        key.policyId = policy_id;
+        key.ip = *ip;
+        key.thd_id = sfthd_node->thd_id;
+        key.padding = 0;
+        hash = FilterSketch::hash(&key, sizeof(key));
+    }
+
+    FilterSketchNode old;
+    THD_IP_NODE data;
+
+    if ( sketch->get(hash, old) )
+    {
+        data.count = old.count + 1;
+        data.prev = old.prev;
+        data.tstart = old.tstart;
+        data.tlast = old.tlast;
+    }
+    else
+    {
+        old.tstart = old.tlast = (uint32_t)curtime;
+        data.count = 1;
+        data.prev = 0;
+        data.tstart = data.tlast = curtime;
+    }
+
+    int status = sfthd_test_non_suppress(sfthd_node, &data, curtime);
+
+    FilterSketchNode node;
+    node.count = data.count;
+    node.prev = data.prev;
+    node.tstart = (uint32_t)data.tstart;
+    node.tlast = (uint32_t)data.tlast;
+    node.mark = 0;
+
+    sketch->put(hash, old, node, sfthd_node->seconds);
+    return status;
+}
+
 /*!
  *
  *  Test a an event against the threshold database.
@@ -1122,7 +1197,9 @@ int sfthd_test_threshold(
         /*
          *   Test SUPPRESSION and THRESHOLDING
          */
-        int status = sfthd_test_local(thd->ip_nodes, sfthd_node, sip, dip, curtime, policy_id);
+        int status = thd->sketch ?
+            sfthd_test_sketch(thd->sketch, sfthd_node, false, sig_id, sip, dip, curtime, policy_id) :
+            sfthd_test_local(thd->ip_nodes, sfthd_node, sip, dip, curtime, policy_id);
 
         if ( status < 0 ) /* -1 == Don't log and stop looking */
         {
@@ -1163,8 +1240,9 @@ global_test:
 
     if ( g_thd_node )
     {
-        int status = sfthd_test_global(thd->ip_gnodes, g_thd_node, sig_id,
-                sip, dip, curtime, policy_id);
+        int status = thd->sketch ?
+            sfthd_test_sketch(thd->sketch, g_thd_node, true, sig_id, sip, dip, curtime, policy_id) :
+            sfthd_test_global(thd->ip_gnodes, g_thd_node, sig_id, sip, dip, curtime, policy_id);
 
         if ( status < 0 ) /* -1 == Don't log and stop looking */
         {
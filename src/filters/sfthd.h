@@ -30,6 +30,8 @@
 
 #include <mutex>
 
+#include "filters/filter_sketch.h"
+
 namespace snort
 {
 class GHash;
@@ -194,6 +196,7 @@ struct THD_STRUCT
 {
     snort::XHash* ip_nodes;   /* Global hash of active IP's key=THD_IP_NODE_KEY, data=THD_IP_NODE */
     snort::XHash* ip_gnodes;  /* Global hash of active IP's key=THD_IP_GNODE_KEY, data=THD_IP_GNODE */
+    FilterSketch* sketch;     /* Replaces both hashes in sketch mode, not owned */
 };
 
 struct ThresholdObjects
@@ -53,6 +53,8 @@ using namespace snort;
 
 /* Data */
 static THREAD_LOCAL THD_STRUCT* thd_runtime = nullptr;
+static THREAD_LOCAL bool thd_sketch_shared = false;
+static SharedFilterSketch thd_shared_sketch;
 
 static THREAD_LOCAL int thd_checked = 0; // per packet
 static THREAD_LOCAL int thd_answer = 0;  // per packet
@@ -88,20 +90,41 @@ void ThresholdConfigFree(ThresholdConfig* tc)
 
 void sfthreshold_free()
 {
-    if (thd_runtime != nullptr)
-        sfthd_free(thd_runtime);
+    if (thd_runtime == nullptr)
+        return;
+
+    if (thd_runtime->sketch)
+    {
+        if (thd_sketch_shared)
+            thd_shared_sketch.release();
+        else
+            delete thd_runtime->sketch;
+    }
 
+    sfthd_free(thd_runtime);
     thd_runtime = nullptr;
 }
 
-int sfthreshold_alloc(unsigned int l_memcap, unsigned int g_memcap)
+// in sketch mode one sketch sized by the local memcap tracks both local
+// and global thresholds
+int sfthreshold_alloc(unsigned int l_memcap, unsigned int g_memcap, FilterSketchMode mode)
 {
-    if (thd_runtime == nullptr)
+    if (thd_runtime != nullptr)
+        return 0;
+
+    if (mode != FILTER_SKETCH_NONE)
     {
-        thd_runtime = sfthd_new(l_memcap, g_memcap);
-        if (thd_runtime == nullptr)
-            return -1;
+        thd_runtime = (THD_STRUCT*)snort_calloc(sizeof(THD_STRUCT));
+        thd_sketch_shared = (mode == FILTER_SKETCH_SHARED);
+        thd_runtime->sketch = thd_sketch_shared ?
+            thd_shared_sketch.acquire(l_memcap) : new FilterSketch(l_memcap, false);
+        return 0;
     }
+
+    thd_runtime = sfthd_new(l_memcap, g_memcap);
+    if (thd_runtime == nullptr)
+        return -1;
+
     return 0;
 }
 
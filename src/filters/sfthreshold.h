@@ -22,6 +22,8 @@
 
 #include "main/policy.h"
 
+#include "filters/filter_sketch.h"
+
 namespace snort
 {
 struct SfIp;
@@ -34,6 +36,7 @@ struct ThresholdConfig
 {
     ThresholdObjects* thd_objs;
     unsigned memcap;
+    FilterSketchMode sketch;
     int enabled;
 };
 
@@ -46,6 +49,6 @@ int sfthreshold_test(
     PolicyId);
 void sfthreshold_free();
 
-int sfthreshold_alloc(unsigned int l_memcap, unsigned int g_memcap);
+int sfthreshold_alloc(unsigned int l_memcap, unsigned int g_memcap, FilterSketchMode);
 
 #endif
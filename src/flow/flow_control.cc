@@ -25,6 +25,7 @@
 #include "flow_control.h"
 
 #include "detection/detection_engine.h"
+#include "main/analyzer.h"
 #include "main/snort_config.h"
 #include "managers/inspector_manager.h"
 #include "packet_io/active.h"
@@ -493,7 +494,17 @@ unsigned FlowControl::process(Flow* flow, Packet* p, bool new_ha_flow)
             RetryPacketEvent retry_event(p);
             DataBus::publish(intrinsic_pub_id, IntrinsicEventIds::RETRY_PACKET, retry_event);
             if ( !retry_event.is_still_pending() )
+            {
                 flow->flags.retry_queued = false;
+
+                // the earlier packets are retried now; queue this one behind them so the
+                // flow is forwarded in order
+                Analyzer* analyzer = Analyzer::get_local_analyzer();
+
+                if ( analyzer and analyzer->release_retries(flow) and
+                    !(p->packet_flags & PKT_RETRANSMIT) )
+                    p->active->retry_packet(p);
+            }
         }
     }
     else
@@ -55,6 +55,9 @@ THREAD_LOCAL const Trace* stream_trace = nullptr;
 
 void Active::drop_packet(snort::Packet const*, bool) { }
 void Active::set_drop_reason(char const*) { }
+bool Active::retry_packet(const Packet*) { return false; }
+Analyzer* Analyzer::get_local_analyzer() { return nullptr; }
+bool Analyzer::release_retries(const Flow*) { return false; }
 ExpectCache::ExpectCache(uint32_t) { }
 ExpectCache::~ExpectCache() = default;
 bool ExpectCache::check(Packet*, Flow*) { return true; }
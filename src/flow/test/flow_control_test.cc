@@ -27,6 +27,7 @@
 #include "flow/flow_control.h"
 
 #include "detection/detection_engine.h"
+#include "main/analyzer.h"
 #include "main/policy.h"
 #include "main/snort_config.h"
 #include "managers/inspector_manager.h"
@@ -56,6 +57,9 @@ THREAD_LOCAL Active::ActiveSuspendReason Active::s_suspend_reason = Active::ASP_
 
 void Active::drop_packet(snort::Packet const*, bool) { }
 void Active::set_drop_reason(char const*) { }
+bool Active::retry_packet(const Packet*) { return false; }
+Analyzer* Analyzer::get_local_analyzer() { return nullptr; }
+bool Analyzer::release_retries(const Flow*) { return false; }
 FlowCache::FlowCache(const FlowCacheConfig& cfg) : config(cfg) { }
 FlowCache::~FlowCache() = default;
 Flow::~Flow() = default;
@@ -41,7 +41,7 @@ struct SnortConfig;
 struct Packet;
 
 // this is the current version of the api
-#define INSAPI_VERSION ((BASE_API_VERSION << 16) | 0)
+#define INSAPI_VERSION ((BASE_API_VERSION << 16) | 1)
 
 struct InspectionBuffer
 {
@@ -176,6 +176,13 @@ public:
         return network_policy_user_id_set;
     }
 
+    // see latency/stage_latency.h
+    void set_latency_stage(unsigned stage)
+    { latency_stage = stage; }
+
+    unsigned get_latency_stage() const
+    { return latency_stage; }
+
     virtual bool is_control_channel() const
     { return false; }
 
@@ -215,6 +222,7 @@ private:
     const char* alias_name = nullptr;
     uint64_t network_policy_user_id = 0;
     bool network_policy_user_id_set = false;
+    unsigned latency_stage = UINT32_MAX;
 };
 
 // at present there is no sequencing among like types except that appid
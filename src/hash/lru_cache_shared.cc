@@ -35,5 +35,7 @@ const PegInfo lru_cache_shared_peg_names[] =
     { CountType::SUM, "reload_prunes", "lru cache pruned entry for lower memcap during reload" },
     { CountType::SUM, "removes", "lru cache found entry and removed it" },
     { CountType::SUM, "replaced", "lru cache found entry and replaced it" },
+    { CountType::SUM, "lock_waits", "lru cache lock acquisitions that waited for another thread" },
+    { CountType::SUM, "second_chances", "lru cache moved referenced entry to front instead of pruning it" },
     { CountType::END, nullptr, nullptr },
 };
@@ -23,12 +23,19 @@
 
 // LruCacheShared -- Implements a thread-safe unordered map where the
 // least-recently-used (LRU) entries are removed once a fixed size is hit.
+//
+// In approximate mode, lookups take the cache lock shared and only set a
+// reference bit on the entry instead of moving it to the front of the list.
+// Pruning then gives referenced entries at the tail a second chance (CLOCK)
+// so that hot entries survive while lookups from different threads no longer
+// serialize on the list.  Strict mode keeps a plain mutex.
 
 #include <atomic>
 #include <cassert>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <typeinfo>
 #include <unordered_map>
 #include <vector>
@@ -48,6 +55,79 @@ struct LruCacheSharedStats
     PegCount reload_prunes = 0; // when an old entry is removed due to lower memcap during reload
     PegCount removes = 0;       // found entry and removed it
     PegCount replaced = 0;      // found entry and replaced it
+    PegCount lock_waits = 0;    // lock acquisitions that had to wait for another thread
+    PegCount second_chances = 0;// referenced entries moved to the front instead of pruned
+};
+
+// Cache lock that counts the acquisitions that had to wait.  Strict LRU
+// only uses the exclusive mutex.  In shared mode the exclusive lock also
+// takes a reader/writer lock which lookups take shared.  The mode only
+// changes while both are held exclusively, so lock_shared() can check it
+// once it has the reader lock.  Exclusive waits are counted under the lock;
+// shared waits are not.
+class LruCacheMutex
+{
+public:
+    void lock()
+    {
+        if ( !mutex.try_lock() )
+        {
+            mutex.lock();
+            ++waits;
+        }
+        if ( shared.load(std::memory_order_relaxed) )
+            rw_mutex.lock();
+    }
+
+    void unlock()
+    {
+        if ( shared.load(std::memory_order_relaxed) )
+            rw_mutex.unlock();
+        mutex.unlock();
+    }
+
+    // returns false, without locking, unless in shared mode
+    bool lock_shared()
+    {
+        if ( !shared.load(std::memory_order_relaxed) )
+            return false;
+
+        if ( !rw_mutex.try_lock_shared() )
+        {
+            shared_waits.fetch_add(1, std::memory_order_relaxed);
+            rw_mutex.lock_shared();
+        }
+
+        if ( shared.load(std::memory_order_relaxed) )
+            return true;
+
+        rw_mutex.unlock_shared();
+        return false;
+    }
+
+    void unlock_shared()
+    { rw_mutex.unlock_shared(); }
+
+    // the caller must not hold the lock
+    void set_shared(bool enable)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::lock_guard<std::shared_timed_mutex> rw_lock(rw_mutex);
+        shared.store(enable, std::memory_order_relaxed);
+    }
+
+    bool is_shared() const
+    { return shared.load(std::memory_order_relaxed); }
+
+    PegCount get_waits() const
+    { return waits + shared_waits.load(std::memory_order_relaxed); }
+
+private:
+    std::mutex mutex;
+    std::shared_timed_mutex rw_mutex;
+    std::atomic<bool> shared { false };
+    PegCount waits = 0;
+    std::atomic<PegCount> shared_waits { 0 };
 };
 
 enum class LcsInsertStatus {
@@ -100,13 +180,13 @@ public:
     //  Get current number of elements in the LruCache.
     size_t size()
     {
-        std::lock_guard<std::mutex> cache_lock(cache_mutex);
+        std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
         return list.size();
     }
 
     virtual size_t mem_size()
     {
-        std::lock_guard<std::mutex> cache_lock(cache_mutex);
+        std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
         return list.size() * mem_chunk;
     }
 
@@ -131,8 +211,23 @@ public:
     const PegInfo* get_pegs() const
     { return lru_cache_shared_peg_names; }
 
-    const PegCount* get_counts() const
-    { return (const PegCount*)&stats; }
+    const PegCount* get_counts()
+    {
+        std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
+        stats.find_hits += shared_hits.exchange(0, std::memory_order_relaxed);
+        stats.find_misses += shared_misses.exchange(0, std::memory_order_relaxed);
+        stats.lock_waits = cache_mutex.get_waits();
+        return (const PegCount*)&stats;
+    }
+
+    // Switch between strict LRU and CLOCK style approximate LRU.  Safe to
+    // call at any time except with the cache locked; reference bits are
+    // only looked at while pruning.
+    void set_approximate_lru(bool enable)
+    { cache_mutex.set_shared(enable); }
+
+    bool is_approximate_lru() const
+    { return cache_mutex.is_shared(); }
 
     void lock()
     { cache_mutex.lock(); }
@@ -141,7 +236,14 @@ public:
     { cache_mutex.unlock(); }
 
 protected:
-    using LruList = std::list<std::pair<Key, Data>>;
+    // a key/data pair with the reference bit set by approximate lookups
+    struct LruNode : public std::pair<Key, Data>
+    {
+        LruNode(const std::pair<Key, Data>& kd) : std::pair<Key, Data>(kd) { }
+        std::atomic<bool> referenced { false };
+    };
+
+    using LruList = std::list<LruNode>;
     using LruListIter = typename LruList::iterator;
     using LruMap = std::unordered_map<Key, LruListIter, Hash, Eq>;
     using LruMapIter = typename LruMap::iterator;
@@ -153,13 +255,54 @@ protected:
 
     std::atomic<size_t> current_size;// Number of entries currently in the cache.
 
-    std::mutex cache_mutex;
+    LruCacheMutex cache_mutex;
     LruList list;  //  Contains key/data pairs. Maintains LRU order with
                    //  least recently used at the end.
     LruMap map;    //  Maps key to list iterator for fast lookup.
 
     struct LruCacheSharedStats stats;
 
+    // lookups done under the shared lock, folded into stats by get_counts()
+    std::atomic<PegCount> shared_hits { 0 };
+    std::atomic<PegCount> shared_misses { 0 };
+
+    static void reference(LruListIter list_iter)
+    {
+        if ( !list_iter->referenced.load(std::memory_order_relaxed) )
+            list_iter->referenced.store(true, std::memory_order_relaxed);
+    }
+
+    // Caller must hold the lock exclusively.
+    void touch(LruListIter list_iter)
+    {
+        if ( is_approximate_lru() )
+            reference(list_iter);
+        else
+            list.splice(list.begin(), list, list_iter);
+    }
+
+    // Approximate lookup under the shared lock.  Returns false if the cache
+    // is not in approximate mode so the caller must take the exclusive lock.
+    // Else data is nullptr, without counting a miss, if the key is not found
+    // so the caller can go on to insert it under the exclusive lock.
+    bool find_shared(const Key& key, Data& data)
+    {
+        if ( !cache_mutex.lock_shared() )
+            return false;
+
+        auto map_iter = map.find(key);
+        if (map_iter == map.end())
+            data = nullptr;
+        else
+        {
+            reference(map_iter->second);
+            shared_hits.fetch_add(1, std::memory_order_relaxed);
+            data = map_iter->second->second;
+        }
+        cache_mutex.unlock_shared();
+        return true;
+    }
+
     // The reason for these functions is to allow derived classes to do their
     // size book keeping differently (e.g. host_cache). This effectively
     // decouples the current_size variable from the actual size in memory,
@@ -186,6 +329,15 @@ protected:
         while (current_size > max_size && !list.empty())
         {
             list_iter = --list.end();
+
+            // each entry is spared at most once per pass over the list
+            if ( list_iter->referenced.load(std::memory_order_relaxed) )
+            {
+                list_iter->referenced.store(false, std::memory_order_relaxed);
+                list.splice(list.begin(), list, list_iter);
+                ++stats.second_chances;
+                continue;
+            }
             data.emplace_back(list_iter->second); // increase reference count
             decrease_size(list_iter->second.get());
             map.erase(list_iter->first);
@@ -206,7 +358,7 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::set_max_size(size_t newsiz
     // after the cache_lock does.
     Purgatory data;
 
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     //  Remove the oldest entries if we have to reduce cache size.
     max_size = newsize;
@@ -219,7 +371,16 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::set_max_size(size_t newsiz
 template<typename Key, typename Value, typename Hash, typename Eq, typename Purgatory>
 std::shared_ptr<Value> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find(const Key& key)
 {
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    Data data;
+
+    if ( find_shared(key, data) )
+    {
+        if ( !data )
+            shared_misses.fetch_add(1, std::memory_order_relaxed);
+        return data;
+    }
+
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter == map.end())
@@ -229,7 +390,7 @@ std::shared_ptr<Value> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find(con
     }
 
     //  Move entry to front of LruList
-    list.splice(list.begin(), list, map_iter->second);
+    touch(map_iter->second);
     stats.find_hits++;
     return map_iter->second->second;
 }
@@ -252,13 +413,18 @@ std::shared_ptr<Value> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_els
     // delete it before we got a chance to return it.
     Purgatory tmp_data;
 
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    Data found;
+
+    if ( find_shared(key, found) and found )
+        return found;
+
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter != map.end())
     {
         stats.find_hits++;
-        list.splice(list.begin(), list, map_iter->second); // update LRU
+        touch(map_iter->second); // update LRU
         return map_iter->second->second;
     }
 
@@ -286,7 +452,12 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_else_insert(const Key
 {
     Purgatory tmp_data;
 
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    Data found;
+
+    if ( !replace and find_shared(key, found) and found )
+        return true;
+
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter != map.end())
@@ -301,7 +472,7 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_else_insert(const Key
             increase_size(map_iter->second->second.get());
             stats.replaced++;
         }
-        list.splice(list.begin(), list, map_iter->second); // update LRU
+        touch(map_iter->second); // update LRU
         return true;
     }
 
@@ -326,7 +497,15 @@ std::shared_ptr<Value> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_els
 {
     Purgatory tmp_data;
 
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    Data found;
+
+    if ( !replace and find_shared(key, found) and found )
+    {
+        if (status) *status = LcsInsertStatus::LCS_ITEM_PRESENT;
+        return found;
+    }
+
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter != map.end())
@@ -343,7 +522,7 @@ std::shared_ptr<Value> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_els
             stats.replaced++;
             if (status) *status = LcsInsertStatus::LCS_ITEM_REPLACED;
         }
-        list.splice(list.begin(), list, map_iter->second); // update LRU
+        touch(map_iter->second); // update LRU
         return map_iter->second->second;
     }
 
@@ -367,7 +546,7 @@ template<typename Key, typename Value, typename Hash, typename Eq, typename Purg
 std::vector<std::pair<Key, std::shared_ptr<Value>>> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::get_all_data()
 {
     std::vector<std::pair<Key, Data> > vec;
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     vec.reserve(list.size());
     std::copy(list.cbegin(), list.cend(), std::back_inserter(vec));
@@ -390,7 +569,7 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::remove(const Key& key)
     // data and cache_lock!
     Data data;
 
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter == map.end())
@@ -414,7 +593,7 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::remove(const Key& key)
 template<typename Key, typename Value, typename Hash, typename Eq, typename Purgatory>
 bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::remove(const Key& key, Data& data)
 {
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter == map.end())
@@ -25,7 +25,10 @@
 
 #include "hash/lru_cache_shared.h"
 
+#include <atomic>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 #include <CppUTest/CommandLineTestRunner.h>
 #include <CppUTest/TestHarness.h>
@@ -201,6 +204,8 @@ TEST(lru_cache_shared, stats_test)
     CHECK(stats[5] == 12);  //  find misses
     CHECK(stats[6] == 0);   //  reload prunes
     CHECK(stats[7] == 1);   //  removes
+    CHECK(stats[9] == 0);   //  lock waits
+    CHECK(stats[10] == 0);  //  second chances
 
     // Check statistics names.
     const PegInfo* pegs = lru_cache.get_pegs();
@@ -212,6 +217,84 @@ TEST(lru_cache_shared, stats_test)
     CHECK(!strcmp(pegs[5].name, "find_misses"));
     CHECK(!strcmp(pegs[6].name, "reload_prunes"));
     CHECK(!strcmp(pegs[7].name, "removes"));
+    CHECK(!strcmp(pegs[9].name, "lock_waits"));
+    CHECK(!strcmp(pegs[10].name, "second_chances"));
+}
+
+//  Test that approximate lookups keep the list order and that referenced
+//  entries get a second chance when pruning.
+TEST(lru_cache_shared, approximate_lru)
+{
+    LruCacheShared<int, std::string, std::hash<int> > lru_cache(3);
+    lru_cache.set_approximate_lru(true);
+
+    for (int i = 0; i < 3; i++)
+        lru_cache[i]->assign(std::to_string(i));
+
+    CHECK(*lru_cache.find(0) == "0");
+    CHECK(lru_cache.find(5) == nullptr);
+
+    auto vec = lru_cache.get_all_data();
+    CHECK(vec[0].first == 2);
+    CHECK(vec[2].first == 0);
+
+    // 0 is the oldest but was referenced so 1 is pruned instead
+    lru_cache[3]->assign("3");
+
+    vec = lru_cache.get_all_data();
+    CHECK(vec.size() == 3);
+    CHECK(vec[0].first == 0);
+    CHECK(vec[1].first == 3);
+    CHECK(vec[2].first == 2);
+
+    lru_cache[4]->assign("4");
+    CHECK(lru_cache.find(2) == nullptr);
+
+    const PegCount* stats = lru_cache.get_counts();
+    CHECK(stats[0] == 5);   //  adds
+    CHECK(stats[1] == 2);   //  alloc prunes
+    CHECK(stats[4] == 1);   //  find hits
+    CHECK(stats[5] == 7);   //  find misses
+    CHECK(stats[10] == 1);  //  second chances
+}
+
+//  Test switching modes while other threads use the cache.
+TEST(lru_cache_shared, mode_switch)
+{
+    LruCacheShared<int, std::string, std::hash<int> > lru_cache(64);
+    std::atomic<bool> done { false };
+    std::atomic<int> failures { 0 };
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&lru_cache, &done, &failures, t]()
+        {
+            for (int i = 0; !done; i++)
+            {
+                int key = (i * 7 + t) % 100;
+                if ( !lru_cache[key] )
+                    ++failures;
+                lru_cache.find(key + 1);
+            }
+        });
+    }
+
+    for (int i = 0; i < 200; i++)
+    {
+        lru_cache.set_approximate_lru(i % 2 == 0);
+        CHECK(lru_cache.is_approximate_lru() == (i % 2 == 0));
+        std::this_thread::yield();
+    }
+
+    done = true;
+
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(failures == 0);
+    CHECK(lru_cache.size() <= 64);
+    CHECK(lru_cache.get_all_data().size() == lru_cache.size());
 }
 
 int main(int argc, char** argv)
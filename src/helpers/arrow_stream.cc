@@ -0,0 +1,669 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "arrow_stream.h"
+
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// flatbuffers
+//-------------------------------------------------------------------------
+
+// the message metadata is a flatbuffer which is normally built back to
+// front.  here objects are written front to back instead, a table before
+// the objects it refers to, and the offsets are patched afterwards since
+// they only need to point forward.  scalars are little endian.
+
+static void put_le(std::string& s, uint64_t v, unsigned size)
+{
+    for ( unsigned i = 0; i < size; ++i )
+        s.push_back((char)(v >> (8 * i)));
+}
+
+static void set_le(std::string& s, size_t pos, uint64_t v, unsigned size)
+{
+    for ( unsigned i = 0; i < size; ++i )
+        s[pos + i] = (char)(v >> (8 * i));
+}
+
+class FlatBuilder
+{
+public:
+    struct Field
+    {
+        unsigned id;
+        unsigned size;      // 1, 2, 4, or 8 bytes
+        uint64_t value;
+        bool offset;        // to be patched, size must be 4
+    };
+
+    static const unsigned MAX_FIELDS = 8;
+
+    FlatBuilder()
+    { buf.assign(4, '\0'); }
+
+    void finish(size_t root)
+    { patch(0, root); }
+
+    // returns the position of the table; where[id] is set to the position
+    // of each offset field
+    size_t table(std::initializer_list<Field>, size_t* where = nullptr);
+
+    // returns the position of the vector, elements follow its length
+    size_t offsets(unsigned n);
+    size_t longs(const std::vector<int64_t>&);
+    size_t string(const char*, unsigned len);
+
+    void patch(size_t at, size_t target)
+    {
+        assert(target > at);
+        set_le(buf, at, target - at, 4);
+    }
+
+    void align(unsigned mod, unsigned rem = 0)
+    {
+        while ( buf.size() % mod != rem )
+            buf.push_back('\0');
+    }
+
+    std::string buf;
+};
+
+size_t FlatBuilder::table(std::initializer_list<Field> fields, size_t* where)
+{
+    unsigned slots = 0;
+    bool wide = false;
+
+    for ( const auto& f : fields )
+    {
+        assert(f.id < MAX_FIELDS);
+        slots = std::max(slots, f.id + 1);
+        wide = wide or f.size == 8;
+    }
+
+    // fields are placed largest first so they are aligned if the table
+    // start is; the table starts with the offset to its vtable
+    uint16_t voff[MAX_FIELDS] = { };
+    unsigned tsize = 4;
+
+    for ( unsigned size : { 8, 4, 2, 1 } )
+    {
+        for ( const auto& f : fields )
+        {
+            if ( f.size == size )
+            {
+                voff[f.id] = tsize;
+                tsize += size;
+            }
+        }
+    }
+
+    unsigned vsize = 4 + 2 * slots;
+    align(wide ? 8 : 4, ((wide ? 4 : 0) + 8 - vsize % 8) % (wide ? 8 : 4));
+
+    size_t vtable = buf.size();
+    put_le(buf, vsize, 2);
+    put_le(buf, tsize, 2);
+
+    for ( unsigned i = 0; i < slots; ++i )
+        put_le(buf, voff[i], 2);
+
+    size_t pos = buf.size();
+    put_le(buf, pos - vtable, 4);
+    buf.resize(pos + tsize, '\0');
+
+    for ( const auto& f : fields )
+    {
+        set_le(buf, pos + voff[f.id], f.value, f.size);
+
+        if ( f.offset and where )
+            where[f.id] = pos + voff[f.id];
+    }
+    return pos;
+}
+
+size_t FlatBuilder::offsets(unsigned n)
+{
+    align(4);
+    size_t pos = buf.size();
+    put_le(buf, n, 4);
+    buf.resize(buf.size() + 4 * n, '\0');
+    return pos;
+}
+
+// structs of longs are laid out the same
+size_t FlatBuilder::longs(const std::vector<int64_t>& v)
+{
+    align(8, 4);
+    size_t pos = buf.size();
+    put_le(buf, v.size() / 2, 4);
+
+    for ( auto i : v )
+        put_le(buf, i, 8);
+
+    return pos;
+}
+
+size_t FlatBuilder::string(const char* s, unsigned len)
+{
+    align(4);
+    size_t pos = buf.size();
+    put_le(buf, len, 4);
+    buf.append(s, len);
+    buf.push_back('\0');
+    return pos;
+}
+
+//-------------------------------------------------------------------------
+// arrow metadata
+//-------------------------------------------------------------------------
+
+#define METADATA_V5 4
+
+#define HEADER_SCHEMA 1
+#define HEADER_DICTIONARY 2
+#define HEADER_RECORD_BATCH 3
+
+#define TYPE_INT 2
+#define TYPE_UTF8 5
+#define TYPE_TIMESTAMP 10
+#define TYPE_FIXED_BINARY 15
+
+#define UNIT_MICROSECOND 2
+
+#define CONTINUATION 0xFFFFFFFF
+
+static inline unsigned pad8(size_t n)
+{ return (n + 7) & ~(size_t)7; }
+
+// Message { version, header_type, header, bodyLength }
+static size_t put_message(FlatBuilder& fb, unsigned type, uint64_t body_len)
+{
+    size_t where[FlatBuilder::MAX_FIELDS];
+
+    size_t msg = fb.table(
+        { { 0, 2, METADATA_V5, false }, { 1, 1, type, false },
+          { 2, 4, 0, true }, { 3, 8, body_len, false } }, where);
+
+    fb.finish(msg);
+    return where[2];
+}
+
+// RecordBatch { length, nodes, buffers }
+static size_t put_record_batch(FlatBuilder& fb, unsigned rows,
+    const std::vector<int64_t>& nodes, const std::vector<int64_t>& buffers)
+{
+    size_t where[FlatBuilder::MAX_FIELDS];
+
+    size_t rb = fb.table(
+        { { 0, 8, rows, false }, { 1, 4, 0, true }, { 2, 4, 0, true } }, where);
+
+    fb.patch(where[1], fb.longs(nodes));
+    fb.patch(where[2], fb.longs(buffers));
+    return rb;
+}
+
+// Int { bitWidth, is_signed }
+static size_t put_int_type(FlatBuilder& fb, unsigned bits, bool sign)
+{ return fb.table({ { 0, 4, bits, false }, { 1, 1, sign, false } }); }
+
+// continuation, metadata length, metadata padded to 8 bytes
+static void put_metadata(std::string& out, const std::string& meta)
+{
+    unsigned len = pad8(meta.size());
+    put_le(out, CONTINUATION, 4);
+    put_le(out, len, 4);
+    out += meta;
+    out.append(len - meta.size(), '\0');
+}
+
+static void add_buffer(std::vector<int64_t>& buffers, uint64_t& body_len, size_t len)
+{
+    buffers.emplace_back(body_len);
+    buffers.emplace_back(len);
+    body_len += pad8(len);
+}
+
+static void put_buffer(std::string& out, const char* s, size_t len)
+{
+    out.append(s, len);
+    out.append(pad8(len) - len, '\0');
+}
+
+//-------------------------------------------------------------------------
+// rows
+//-------------------------------------------------------------------------
+
+static unsigned get_width(ArrowStream::Type type)
+{
+    switch ( type )
+    {
+    case ArrowStream::UINT8: return 1;
+    case ArrowStream::UINT16: return 2;
+    case ArrowStream::UINT32: return 4;
+    case ArrowStream::UINT64: return 8;
+    case ArrowStream::TIMESTAMP_US: return 8;
+    case ArrowStream::ADDR: return 16;
+    case ArrowStream::UTF8: return 4;
+    case ArrowStream::DICT_UTF8: return 4;
+    }
+    return 0;
+}
+
+unsigned ArrowStream::add_column(const char* name, Type type, bool nullable)
+{
+    assert(!rows);
+
+    columns.emplace_back();
+    Column& c = columns.back();
+
+    c.name = name;
+    c.type = type;
+    c.nullable = nullable;
+
+    if ( type == UTF8 )
+        put_le(c.values, 0, 4);
+
+    else if ( type == DICT_UTF8 )
+        clear_dict(c);
+
+    return columns.size() - 1;
+}
+
+void ArrowStream::append_valid(Column& c)
+{
+    if ( !(rows % 8) )
+        c.valid.push_back('\0');
+
+    c.valid.back() |= (char)(1 << (rows % 8));
+    c.set = true;
+}
+
+void ArrowStream::append_null(Column& c)
+{
+    if ( !(rows % 8) )
+        c.valid.push_back('\0');
+
+    if ( c.type == UTF8 )
+    {
+        int32_t off = c.data.size();
+        c.values.append((const char*)&off, sizeof(off));
+    }
+    else
+        c.values.append(get_width(c.type), '\0');
+
+    if ( c.nullable )
+        c.null_count++;
+    else
+        c.valid.back() |= (char)(1 << (rows % 8));
+}
+
+void ArrowStream::set_uint(unsigned col, uint64_t v)
+{
+    Column& c = columns[col];
+    assert(!c.set);
+
+    switch ( c.type )
+    {
+    case UINT8:
+        c.values.push_back((char)v);
+        break;
+    case UINT16:
+    {
+        uint16_t u = v;
+        c.values.append((const char*)&u, sizeof(u));
+        break;
+    }
+    case UINT32:
+    {
+        uint32_t u = v;
+        c.values.append((const char*)&u, sizeof(u));
+        break;
+    }
+    case UINT64:
+    case TIMESTAMP_US:
+        c.values.append((const char*)&v, sizeof(v));
+        break;
+    default:
+        assert(false);
+        return;
+    }
+    append_valid(c);
+}
+
+void ArrowStream::set_addr(unsigned col, const uint8_t* addr)
+{
+    Column& c = columns[col];
+    assert(!c.set and c.type == ADDR);
+
+    c.values.append((const char*)addr, 16);
+    append_valid(c);
+}
+
+void ArrowStream::set_string(unsigned col, const char* s, unsigned len)
+{
+    Column& c = columns[col];
+    assert(!c.set);
+
+    if ( c.type == DICT_UTF8 )
+    {
+        int32_t idx = lookup(c, s, len);
+        c.values.append((const char*)&idx, sizeof(idx));
+    }
+    else
+    {
+        assert(c.type == UTF8);
+        c.data.append(s, len);
+        int32_t off = c.data.size();
+        c.values.append((const char*)&off, sizeof(off));
+    }
+    append_valid(c);
+}
+
+void ArrowStream::end_row()
+{
+    for ( auto& c : columns )
+    {
+        if ( !c.set )
+            append_null(c);
+
+        c.set = false;
+    }
+    ++rows;
+}
+
+//-------------------------------------------------------------------------
+// dictionaries
+//-------------------------------------------------------------------------
+
+static uint32_t hash(const char* s, unsigned len)
+{
+    uint32_t h = 2166136261;
+
+    for ( unsigned i = 0; i < len; ++i )
+        h = (h ^ (uint8_t)s[i]) * 16777619;
+
+    return h;
+}
+
+int32_t ArrowStream::lookup(Column& c, const char* s, unsigned len)
+{
+    unsigned mask = c.dict_hash.size() - 1;
+    unsigned i = hash(s, len) & mask;
+
+    while ( c.dict_hash[i] >= 0 )
+    {
+        int32_t idx = c.dict_hash[i];
+        unsigned off = c.dict_offsets[idx];
+
+        if ( (unsigned)c.dict_offsets[idx + 1] - off == len and
+            !memcmp(c.dict_data.data() + off, s, len) )
+            return idx;
+
+        i = (i + 1) & mask;
+    }
+
+    int32_t idx = c.dict_offsets.size() - 1;
+    c.dict_data.append(s, len);
+    c.dict_offsets.emplace_back(c.dict_data.size());
+    c.dict_hash[i] = idx;
+
+    // keep the load under 1/2
+    if ( 2 * c.dict_offsets.size() > c.dict_hash.size() )
+    {
+        c.dict_hash.assign(2 * c.dict_hash.size(), -1);
+        mask = c.dict_hash.size() - 1;
+
+        for ( int32_t j = 0; j < (int32_t)c.dict_offsets.size() - 1; ++j )
+        {
+            unsigned off = c.dict_offsets[j];
+            unsigned k = hash(c.dict_data.data() + off, c.dict_offsets[j + 1] - off) & mask;
+
+            while ( c.dict_hash[k] >= 0 )
+                k = (k + 1) & mask;
+
+            c.dict_hash[k] = j;
+        }
+    }
+    return idx;
+}
+
+void ArrowStream::clear_dict(Column& c)
+{
+    c.dict_offsets.assign(1, 0);
+    c.dict_data.clear();
+    c.dict_hash.assign(64, -1);
+    c.dict_sent = 0;
+    c.dict_replace = true;
+}
+
+//-------------------------------------------------------------------------
+// messages
+//-------------------------------------------------------------------------
+
+// Schema { endianness, fields }
+// Field { name, nullable, type_type, type, dictionary, children }
+// DictionaryEncoding { id, indexType }
+void ArrowStream::write_schema(std::string& out)
+{
+    FlatBuilder fb;
+    size_t where[FlatBuilder::MAX_FIELDS];
+
+    size_t hdr = put_message(fb, HEADER_SCHEMA, 0);
+
+#ifdef WORDS_BIGENDIAN
+    const unsigned endianness = 1;
+#else
+    const unsigned endianness = 0;
+#endif
+
+    fb.patch(hdr, fb.table({ { 0, 2, endianness, false }, { 1, 4, 0, true } }, where));
+
+    size_t fields = fb.offsets(columns.size());
+    fb.patch(where[1], fields);
+
+    for ( unsigned i = 0; i < columns.size(); ++i )
+    {
+        Column& c = columns[i];
+        unsigned type;
+
+        switch ( c.type )
+        {
+        case TIMESTAMP_US: type = TYPE_TIMESTAMP; break;
+        case ADDR: type = TYPE_FIXED_BINARY; break;
+        case UTF8:
+        case DICT_UTF8: type = TYPE_UTF8; break;
+        default: type = TYPE_INT; break;
+        }
+
+        size_t field;
+
+        if ( c.type == DICT_UTF8 )
+        {
+            field = fb.table(
+                { { 0, 4, 0, true }, { 1, 1, c.nullable, false }, { 2, 1, type, false },
+                  { 3, 4, 0, true }, { 4, 4, 0, true }, { 5, 4, 0, true } }, where);
+        }
+        else
+        {
+            field = fb.table(
+                { { 0, 4, 0, true }, { 1, 1, c.nullable, false }, { 2, 1, type, false },
+                  { 3, 4, 0, true }, { 5, 4, 0, true } }, where);
+        }
+        fb.patch(fields + 4 + 4 * i, field);
+
+        size_t field_where[FlatBuilder::MAX_FIELDS];
+        memcpy(field_where, where, sizeof(where));
+
+        fb.patch(field_where[0], fb.string(c.name.c_str(), c.name.size()));
+
+        switch ( c.type )
+        {
+        case TIMESTAMP_US:
+            fb.patch(field_where[3], fb.table({ { 0, 2, UNIT_MICROSECOND, false } }));
+            break;
+        case ADDR:
+            fb.patch(field_where[3], fb.table({ { 0, 4, 16, false } }));
+            break;
+        case UTF8:
+        case DICT_UTF8:
+            fb.patch(field_where[3], fb.table({ }));
+            break;
+        default:
+            fb.patch(field_where[3], put_int_type(fb, 8 * get_width(c.type), false));
+            break;
+        }
+
+        if ( c.type == DICT_UTF8 )
+        {
+            fb.patch(field_where[4], fb.table({ { 0, 8, i, false }, { 1, 4, 0, true } }, where));
+            fb.patch(where[1], put_int_type(fb, 32, true));
+        }
+        fb.patch(field_where[5], fb.offsets(0));
+    }
+    put_metadata(out, fb.buf);
+
+    // a new stream needs the full dictionaries
+    for ( auto& c : columns )
+    {
+        c.dict_sent = 0;
+        c.dict_replace = true;
+    }
+}
+
+// DictionaryBatch { id, data, isDelta }
+void ArrowStream::write_dictionary(std::string& out, unsigned col, Column& c)
+{
+    unsigned count = c.dict_offsets.size() - 1;
+    unsigned n = count - c.dict_sent;
+    int32_t base = c.dict_offsets[c.dict_sent];
+    size_t data_len = c.dict_offsets[count] - base;
+
+    std::vector<int64_t> nodes = { n, 0 };
+    std::vector<int64_t> buffers;
+    uint64_t body_len = 0;
+
+    add_buffer(buffers, body_len, 0);
+    add_buffer(buffers, body_len, 4 * (n + 1));
+    add_buffer(buffers, body_len, data_len);
+
+    FlatBuilder fb;
+    size_t where[FlatBuilder::MAX_FIELDS];
+
+    size_t hdr = put_message(fb, HEADER_DICTIONARY, body_len);
+
+    fb.patch(hdr, fb.table(
+        { { 0, 8, col, false }, { 1, 4, 0, true }, { 2, 1, !c.dict_replace, false } }, where));
+
+    fb.patch(where[1], put_record_batch(fb, n, nodes, buffers));
+    put_metadata(out, fb.buf);
+
+    // offsets start over at 0 for a delta
+    for ( unsigned i = c.dict_sent; i <= count; ++i )
+    {
+        int32_t off = c.dict_offsets[i] - base;
+        out.append((const char*)&off, sizeof(off));
+    }
+    out.append(pad8(4 * (n + 1)) - 4 * (n + 1), '\0');
+    put_buffer(out, c.dict_data.data() + base, data_len);
+
+    c.dict_sent = count;
+    c.dict_replace = false;
+}
+
+void ArrowStream::write_batch(std::string& out)
+{
+    if ( !rows )
+        return;
+
+    for ( unsigned i = 0; i < columns.size(); ++i )
+    {
+        Column& c = columns[i];
+
+        if ( c.type == DICT_UTF8 and (c.dict_replace or c.dict_offsets.size() - 1 > c.dict_sent) )
+            write_dictionary(out, i, c);
+    }
+
+    std::vector<int64_t> nodes;
+    std::vector<int64_t> buffers;
+    uint64_t body_len = 0;
+
+    for ( const auto& c : columns )
+    {
+        nodes.emplace_back(rows);
+        nodes.emplace_back(c.null_count);
+
+        add_buffer(buffers, body_len, c.null_count ? c.valid.size() : 0);
+        add_buffer(buffers, body_len, c.values.size());
+
+        if ( c.type == UTF8 )
+            add_buffer(buffers, body_len, c.data.size());
+    }
+
+    FlatBuilder fb;
+    size_t hdr = put_message(fb, HEADER_RECORD_BATCH, body_len);
+    fb.patch(hdr, put_record_batch(fb, rows, nodes, buffers));
+    put_metadata(out, fb.buf);
+
+    for ( const auto& c : columns )
+    {
+        if ( c.null_count )
+            put_buffer(out, c.valid.data(), c.valid.size());
+
+        put_buffer(out, c.values.data(), c.values.size());
+
+        if ( c.type == UTF8 )
+            put_buffer(out, c.data.data(), c.data.size());
+    }
+    clear_batch();
+
+    for ( auto& c : columns )
+    {
+        if ( c.type == DICT_UTF8 and c.dict_offsets.size() - 1 > max_dict )
+            clear_dict(c);
+    }
+}
+
+void ArrowStream::write_eos(std::string& out)
+{
+    put_le(out, CONTINUATION, 4);
+    put_le(out, 0, 4);
+}
+
+void ArrowStream::clear_batch()
+{
+    for ( auto& c : columns )
+    {
+        c.null_count = 0;
+        c.valid.clear();
+        c.values.clear();
+        c.data.clear();
+
+        if ( c.type == UTF8 )
+            put_le(c.values, 0, 4);
+    }
+    rows = 0;
+}
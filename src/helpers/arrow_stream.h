@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef ARROW_STREAM_H
+#define ARROW_STREAM_H
+
+// ArrowStream encodes rows into Apache Arrow IPC stream messages: a schema
+// message, then for each batch the dictionary deltas followed by a record
+// batch, and finally the end of stream marker.  Columns are accumulated in
+// Arrow layout as rows are added so writing a batch only adds the message
+// metadata.  Dictionary encoded strings send each distinct value once per
+// stream; the dictionaries are replaced when they grow past the limit.
+//
+// Only the types needed by loggers are supported.  Body buffers are in host
+// byte order which is declared in the schema.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "main/snort_types.h"
+
+namespace snort
+{
+class SO_PUBLIC ArrowStream
+{
+public:
+    enum Type
+    {
+        UINT8, UINT16, UINT32, UINT64,
+        TIMESTAMP_US,   // int64 microseconds since the epoch, no time zone
+        ADDR,           // fixed size binary with 16 bytes
+        UTF8,
+        DICT_UTF8,      // utf8 encoded with int32 indices into a dictionary
+    };
+
+    ArrowStream(unsigned max_dict_size = 65536) : max_dict(max_dict_size)
+    { }
+
+    // schema; columns must be added before the first row
+    unsigned add_column(const char* name, Type, bool nullable = true);
+
+    // columns not set before end_row() are null
+    void set_uint(unsigned col, uint64_t);
+    void set_addr(unsigned col, const uint8_t*);
+    void set_string(unsigned col, const char*, unsigned len);
+    void end_row();
+
+    unsigned get_rows() const
+    { return rows; }
+
+    // append the message(s) to out; the schema starts a new stream so the
+    // following batch sends the dictionaries in full
+    void write_schema(std::string& out);
+    void write_batch(std::string& out);
+    static void write_eos(std::string& out);
+
+private:
+    struct Column
+    {
+        std::string name;
+        Type type;
+        bool nullable;
+        bool set = false;
+
+        unsigned null_count = 0;
+        std::string valid;      // bitmap
+        std::string values;     // fixed width values, offsets, or indices
+        std::string data;       // utf8 bytes
+
+        // dictionary values, offsets are to dict_data
+        std::vector<int32_t> dict_offsets;
+        std::string dict_data;
+        std::vector<int32_t> dict_hash;
+        unsigned dict_sent = 0;
+        bool dict_replace = true;
+    };
+
+    void append_null(Column&);
+    void append_valid(Column&);
+    int32_t lookup(Column&, const char*, unsigned len);
+    void clear_dict(Column&);
+
+    void write_dictionary(std::string& out, unsigned col, Column&);
+    void clear_batch();
+
+    std::vector<Column> columns;
+    unsigned rows = 0;
+    unsigned max_dict;
+};
+}
+#endif
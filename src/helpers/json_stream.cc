@@ -24,18 +24,35 @@
 #include "json_stream.h"
 
 #include <cassert>
-#include <iomanip>
+
+#include "json_writer.h"
 
 using namespace snort;
 
+// each call formats into buf and then writes it out in one go
+void JsonStream::put_key(const char* key)
+{
+    if ( !key )
+        return;
+
+    JsonWriter w(buf);
+    w.put_quoted(key);
+    w.put(": ", 2);
+}
+
+void JsonStream::write()
+{
+    out.write(buf.data(), buf.size());
+    buf.clear();
+}
+
 void JsonStream::open(const char* key)
 {
     split();
+    put_key(key);
 
-    if ( key )
-        out << std::quoted(key) << ": ";
-
-    out << "{ ";
+    buf.append("{ ", 2);
+    write();
     sep = false;
     ++level;
 }
@@ -56,11 +73,10 @@ void JsonStream::close()
 void JsonStream::open_array(const char* key)
 {
     split();
+    put_key(key);
 
-    if ( key )
-        out << std::quoted(key) << ": ";
-
-    out << "[ ";
+    buf.append("[ ", 2);
+    write();
     sep = false;
     level_array++;
 }
@@ -81,31 +97,28 @@ void JsonStream::close_array()
 void JsonStream::put(const char* key)
 {
     split();
+    put_key(key);
 
-    if ( key )
-        out << std::quoted(key) << ": ";
-
-    out << "null";
+    buf.append("null", 4);
+    write();
 }
 
 void JsonStream::put(const char* key, int64_t val)
 {
     split();
+    put_key(key);
 
-    if ( key )
-        out << std::quoted(key) << ": ";
-
-    out << val;
+    JsonWriter(buf).put_int(val);
+    write();
 }
 
 void JsonStream::uput(const char* key, uint64_t val)
 {
     split();
+    put_key(key);
 
-    if ( key )
-        out << std::quoted(key) << ": ";
-
-    out << val;
+    JsonWriter(buf).put_uint(val);
+    write();
 }
 
 void JsonStream::put(const char* key, const char* val)
@@ -114,14 +127,14 @@ void JsonStream::put(const char* key, const char* val)
         return;
 
     split();
-
-    if ( key )
-        out << std::quoted(key) << ": ";
+    put_key(key);
 
     if (val)
-        out << std::quoted(val);
+        JsonWriter(buf).put_quoted(val);
     else
-        out << "null";
+        buf.append("null", 4);
+
+    write();
 }
 
 void JsonStream::put(const char* key, const std::string& val)
@@ -130,19 +143,17 @@ void JsonStream::put(const char* key, const std::string& val)
         return;
 
     split();
+    put_key(key);
 
-    if ( key )
-        out << std::quoted(key) << ": ";
-
-    out << std::quoted(val);
+    JsonWriter(buf).put_quoted(val.data(), val.size());
+    write();
 }
 
 void JsonStream::put(const char* key, double val, int precision)
 {
     split();
-
-    if ( key )
-        out << std::quoted(key) << ": ";
+    put_key(key);
+    write();
 
     out.precision(precision);
     out << std::fixed << val;
@@ -151,27 +162,25 @@ void JsonStream::put(const char* key, double val, int precision)
 void JsonStream::put_true(const char* key)
 {
     split();
+    put_key(key);
 
-    if ( key )
-        out << std::quoted(key) << ": ";
-
-    out << "true";
+    buf.append("true", 4);
+    write();
 }
 
 void JsonStream::put_false(const char* key)
 {
     split();
+    put_key(key);
 
-    if ( key )
-        out << std::quoted(key) << ": ";
-
-    out << "false";
+    buf.append("false", 5);
+    write();
 }
 
 void JsonStream::split()
 {
     if ( sep )
-        out << ", ";
+        buf.append(", ", 2);
     else
         sep = true;
 }
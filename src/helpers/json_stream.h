@@ -23,6 +23,8 @@
 // Simple output stream for outputting JSON data.
 
 #include <iostream>
+#include <string>
+
 #include "main/snort_types.h"
 
 namespace snort
@@ -53,9 +55,12 @@ public:
 
 private:
     void split();
+    void put_key(const char*);
+    void write();
 
 private:
     std::ostream& out;
+    std::string buf;
     bool sep = false;
     unsigned level = 0;
     unsigned level_array = 0;
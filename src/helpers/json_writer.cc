@@ -0,0 +1,136 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "json_writer.h"
+
+using namespace snort;
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// nonzero if any byte of w is '"' or '\'
+static inline uint64_t needs_escape(uint64_t w)
+{
+    const uint64_t ones = 0x0101010101010101ull;
+    const uint64_t highs = 0x8080808080808080ull;
+
+    uint64_t q = w ^ (ones * '"');
+    uint64_t b = w ^ (ones * '\\');
+
+    return (((q - ones) & ~q) | ((b - ones) & ~b)) & highs;
+}
+
+void JsonWriter::put_escaped(const char* s, size_t n)
+{
+    const char* end = s + n;
+    const char* run = s;
+
+    while ( s < end )
+    {
+        if ( end - s >= 8 )
+        {
+            uint64_t w;
+            memcpy(&w, s, sizeof(w));
+
+            if ( !needs_escape(w) )
+            {
+                s += 8;
+                continue;
+            }
+        }
+
+        if ( *s == '"' or *s == '\\' )
+        {
+            out.append(run, s - run);
+            out.push_back('\\');
+            run = s;
+        }
+        s++;
+    }
+    out.append(run, s - run);
+}
+
+unsigned JsonWriter::format_uint(char* buf, uint64_t v)
+{
+    char tmp[MAX_DIGITS];
+    char* p = tmp + sizeof(tmp);
+
+    while ( v >= 100 )
+    {
+        unsigned i = (v % 100) * 2;
+        v /= 100;
+        *--p = digit_pairs[i + 1];
+        *--p = digit_pairs[i];
+    }
+
+    if ( v >= 10 )
+    {
+        unsigned i = v * 2;
+        *--p = digit_pairs[i + 1];
+        *--p = digit_pairs[i];
+    }
+    else
+        *--p = '0' + v;
+
+    unsigned len = tmp + sizeof(tmp) - p;
+    memcpy(buf, p, len);
+    return len;
+}
+
+void JsonWriter::put_int(int64_t v)
+{
+    if ( v < 0 )
+    {
+        out.push_back('-');
+        put_uint(0 - (uint64_t)v);
+    }
+    else
+        put_uint(v);
+}
+
+void JsonWriter::put_hex(uint64_t v, unsigned min_digits)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    char tmp[16];
+    char* p = tmp + sizeof(tmp);
+
+    do
+    {
+        *--p = hex[v & 0xF];
+        v >>= 4;
+    }
+    while ( v );
+
+    while ( p > tmp and tmp + sizeof(tmp) - p < (long)min_digits )
+        *--p = '0';
+
+    out.append(p, tmp + sizeof(tmp) - p);
+}
@@ -0,0 +1,81 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+// JsonWriter appends JSON text to a string without printf or iostreams so
+// that serializers can reuse one buffer and avoid allocating once it has
+// grown.  Strings are quoted the same way as std::quoted and TextLog_Quote:
+// only '"' and '\' are escaped.  The escape scan checks 8 bytes at a time.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "main/snort_types.h"
+
+namespace snort
+{
+class SO_PUBLIC JsonWriter
+{
+public:
+    JsonWriter(std::string& s) : out(s) { }
+
+    void put(char c)
+    { out.push_back(c); }
+
+    void put(const char* s, size_t n)
+    { out.append(s, n); }
+
+    void put(const char* s)
+    { out.append(s); }
+
+    void put_escaped(const char*, size_t);
+
+    void put_quoted(const char* s, size_t n)
+    {
+        out.push_back('"');
+        put_escaped(s, n);
+        out.push_back('"');
+    }
+
+    void put_quoted(const char* s)
+    { put_quoted(s, strlen(s)); }
+
+    void put_uint(uint64_t v)
+    {
+        char buf[MAX_DIGITS];
+        out.append(buf, format_uint(buf, v));
+    }
+
+    void put_int(int64_t);
+
+    // upper case hex with at least min_digits digits and no prefix
+    void put_hex(uint64_t, unsigned min_digits = 1);
+
+    // buf must hold MAX_DIGITS chars; returns the length, no terminator
+    static unsigned format_uint(char* buf, uint64_t);
+
+    static const unsigned MAX_DIGITS = 20;
+
+private:
+    std::string& out;
+};
+}
+#endif
@@ -0,0 +1,293 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// arrow_stream_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "../arrow_stream.h"
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// just enough of a reader to walk the messages
+//-------------------------------------------------------------------------
+
+static uint64_t get_le(const std::string& s, size_t pos, unsigned size)
+{
+    uint64_t v = 0;
+
+    for ( unsigned i = 0; i < size; ++i )
+        v |= (uint64_t)(uint8_t)s[pos + i] << (8 * i);
+
+    return v;
+}
+
+// position of the field in the table or 0 if absent
+static size_t get_field(const std::string& fb, size_t table, unsigned id)
+{
+    size_t vtable = table - (int32_t)get_le(fb, table, 4);
+    unsigned vsize = get_le(fb, vtable, 2);
+
+    if ( 4 + 2 * id >= vsize )
+        return 0;
+
+    unsigned off = get_le(fb, vtable + 4 + 2 * id, 2);
+    return off ? table + off : 0;
+}
+
+static size_t get_table(const std::string& fb, size_t table, unsigned id)
+{
+    size_t pos = get_field(fb, table, id);
+    return pos + get_le(fb, pos, 4);
+}
+
+struct Message
+{
+    unsigned type;
+    uint64_t body_len;
+    bool delta;
+    uint64_t rows;
+};
+
+// header types are schema = 1, dictionary = 2, record batch = 3
+static std::vector<Message> walk(const std::string& s, bool& eos)
+{
+    std::vector<Message> msgs;
+    size_t pos = 0;
+    eos = false;
+
+    while ( pos < s.size() )
+    {
+        REQUIRE(get_le(s, pos, 4) == 0xFFFFFFFF);
+        unsigned len = get_le(s, pos + 4, 4);
+
+        if ( !len )
+        {
+            eos = true;
+            pos += 8;
+            break;
+        }
+        REQUIRE(len % 8 == 0);
+
+        std::string fb = s.substr(pos + 8, len);
+        size_t msg = get_le(fb, 0, 4);
+
+        Message m = { };
+        m.type = get_le(fb, get_field(fb, msg, 1), 1);
+        m.body_len = get_le(fb, get_field(fb, msg, 3), 8);
+
+        size_t hdr = get_table(fb, msg, 2);
+
+        if ( m.type == 2 )
+        {
+            size_t delta = get_field(fb, hdr, 2);
+            m.delta = delta and get_le(fb, delta, 1);
+            hdr = get_table(fb, hdr, 1);
+        }
+        if ( m.type != 1 )
+            m.rows = get_le(fb, get_field(fb, hdr, 0), 8);
+
+        CHECK(m.body_len % 8 == 0);
+        msgs.emplace_back(m);
+        pos += 8 + len + m.body_len;
+    }
+    CHECK(pos == s.size());
+    return msgs;
+}
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_CASE("messages", "[arrow_stream]")
+{
+    ArrowStream as;
+    unsigned num = as.add_column("num", ArrowStream::UINT32);
+    unsigned msg = as.add_column("msg", ArrowStream::DICT_UTF8);
+    unsigned text = as.add_column("text", ArrowStream::UTF8);
+
+    std::string s;
+    bool eos;
+
+    as.write_schema(s);
+
+    SECTION("schema")
+    {
+        auto msgs = walk(s, eos);
+        REQUIRE(msgs.size() == 1);
+        CHECK(msgs[0].type == 1);
+        CHECK(msgs[0].body_len == 0);
+        CHECK(!eos);
+    }
+    SECTION("no rows")
+    {
+        as.write_batch(s);
+        CHECK(walk(s, eos).size() == 1);
+    }
+    SECTION("end of stream")
+    {
+        ArrowStream::write_eos(s);
+        CHECK(walk(s, eos).size() == 1);
+        CHECK(eos);
+        CHECK(s.substr(s.size() - 8) == std::string("\xff\xff\xff\xff\0\0\0\0", 8));
+    }
+    SECTION("dictionary deltas")
+    {
+        as.set_uint(num, 1);
+        as.set_string(msg, "one", 3);
+        as.set_string(text, "x", 1);
+        as.end_row();
+
+        as.set_string(msg, "one", 3);
+        as.end_row();
+
+        CHECK(as.get_rows() == 2);
+        as.write_batch(s);
+        CHECK(as.get_rows() == 0);
+
+        // nothing new
+        as.set_string(msg, "one", 3);
+        as.end_row();
+        as.write_batch(s);
+
+        as.set_string(msg, "two", 3);
+        as.end_row();
+        as.write_batch(s);
+
+        auto msgs = walk(s, eos);
+        REQUIRE(msgs.size() == 6);
+
+        CHECK(msgs[1].type == 2);
+        CHECK(!msgs[1].delta);
+        CHECK(msgs[1].rows == 1);
+        CHECK(msgs[2].type == 3);
+        CHECK(msgs[2].rows == 2);
+
+        CHECK(msgs[3].type == 3);
+        CHECK(msgs[3].rows == 1);
+
+        CHECK(msgs[4].type == 2);
+        CHECK(msgs[4].delta);
+        CHECK(msgs[4].rows == 1);
+        CHECK(msgs[5].type == 3);
+    }
+    SECTION("new stream")
+    {
+        as.set_string(msg, "one", 3);
+        as.end_row();
+        as.write_batch(s);
+
+        as.write_schema(s);
+        as.set_string(msg, "one", 3);
+        as.end_row();
+        as.write_batch(s);
+
+        auto msgs = walk(s, eos);
+        REQUIRE(msgs.size() == 6);
+        CHECK(msgs[3].type == 1);
+        CHECK(msgs[4].type == 2);
+        CHECK(!msgs[4].delta);
+        CHECK(msgs[4].rows == 1);
+    }
+}
+
+TEST_CASE("dictionary limit", "[arrow_stream]")
+{
+    ArrowStream as(2);
+    unsigned msg = as.add_column("msg", ArrowStream::DICT_UTF8);
+
+    std::string s;
+    bool eos;
+
+    as.write_schema(s);
+
+    for ( const char* str : { "a", "b", "c" } )
+    {
+        as.set_string(msg, str, 1);
+        as.end_row();
+    }
+    as.write_batch(s);
+
+    as.set_string(msg, "a", 1);
+    as.end_row();
+    as.write_batch(s);
+
+    auto msgs = walk(s, eos);
+    REQUIRE(msgs.size() == 5);
+
+    CHECK(msgs[1].rows == 3);
+    CHECK(msgs[3].type == 2);
+    CHECK(!msgs[3].delta);
+    CHECK(msgs[3].rows == 1);
+}
+
+TEST_CASE("many strings", "[arrow_stream]")
+{
+    ArrowStream as;
+    unsigned msg = as.add_column("msg", ArrowStream::DICT_UTF8);
+
+    std::string s;
+    bool eos;
+
+    as.write_schema(s);
+
+    for ( unsigned i = 0; i < 1000; ++i )
+    {
+        std::string str = std::to_string(i % 300);
+        as.set_string(msg, str.c_str(), str.size());
+        as.end_row();
+    }
+    as.write_batch(s);
+
+    auto msgs = walk(s, eos);
+    REQUIRE(msgs.size() == 3);
+    CHECK(msgs[1].rows == 300);
+    CHECK(msgs[2].rows == 1000);
+}
+
+TEST_CASE("nulls", "[arrow_stream]")
+{
+    ArrowStream as;
+    unsigned a = as.add_column("a", ArrowStream::UINT64);
+    as.add_column("b", ArrowStream::ADDR);
+    as.add_column("c", ArrowStream::UINT16, false);
+
+    std::string s;
+    bool eos;
+
+    as.set_uint(a, 7);
+    as.end_row();
+    as.end_row();
+
+    as.write_schema(s);
+    as.write_batch(s);
+
+    auto msgs = walk(s, eos);
+    REQUIRE(msgs.size() == 2);
+
+    // a: bitmap, 16 values; b: bitmap, 32 values; c: 8 values (4 padded)
+    CHECK(msgs[1].body_len == 8 + 16 + 8 + 32 + 8);
+}
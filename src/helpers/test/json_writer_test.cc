@@ -0,0 +1,225 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// json_writer_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+
+#include "catch/catch.hpp"
+
+#include "../json_writer.h"
+
+using namespace snort;
+
+#ifdef CATCH_TEST_BUILD
+
+TEST_CASE("unsigned", "[json_writer]")
+{
+    std::string s;
+    JsonWriter w(s);
+
+    SECTION("zero")
+    {
+        w.put_uint(0);
+        CHECK(s == "0");
+    }
+    SECTION("digit pairs")
+    {
+        for ( uint64_t v : { 7ull, 42ull, 100ull, 999ull, 1000ull, 65535ull, 4294967295ull } )
+        {
+            s.clear();
+            w.put_uint(v);
+            CHECK(s == std::to_string(v));
+        }
+    }
+    SECTION("max")
+    {
+        w.put_uint(UINT64_MAX);
+        CHECK(s == "18446744073709551615");
+    }
+}
+
+TEST_CASE("signed", "[json_writer]")
+{
+    std::string s;
+    JsonWriter w(s);
+
+    SECTION("negative")
+    {
+        w.put_int(-1234567);
+        CHECK(s == "-1234567");
+    }
+    SECTION("min")
+    {
+        w.put_int(INT64_MIN);
+        CHECK(s == "-9223372036854775808");
+    }
+    SECTION("positive")
+    {
+        w.put_int(1685000000);
+        CHECK(s == "1685000000");
+    }
+}
+
+TEST_CASE("hex", "[json_writer]")
+{
+    std::string s;
+    JsonWriter w(s);
+
+    SECTION("ether type")
+    {
+        w.put_hex(0x86dd);
+        CHECK(s == "86DD");
+    }
+    SECTION("mac byte")
+    {
+        w.put_hex(0x0a, 2);
+        w.put(':');
+        w.put_hex(0, 2);
+        CHECK(s == "0A:00");
+    }
+    SECTION("zero")
+    {
+        w.put_hex(0);
+        CHECK(s == "0");
+    }
+}
+
+TEST_CASE("quoted", "[json_writer]")
+{
+    std::string s;
+    JsonWriter w(s);
+
+    SECTION("plain")
+    {
+        w.put_quoted("GET /index.html HTTP/1.1");
+        CHECK(s == "\"GET /index.html HTTP/1.1\"");
+    }
+    SECTION("empty")
+    {
+        w.put_quoted("");
+        CHECK(s == "\"\"");
+    }
+    SECTION("escapes in every position")
+    {
+        // cover the word scan and the tail
+        const std::string text = "0123456789abcdef012";
+
+        for ( unsigned i = 0; i < text.size(); ++i )
+        {
+            std::string in = text;
+            in[i] = (i & 1) ? '"' : '\\';
+
+            std::string exp = "\"" + text.substr(0, i) + '\\' + in[i] + text.substr(i + 1) + "\"";
+
+            s.clear();
+            w.put_quoted(in.c_str());
+            CHECK(s == exp);
+        }
+    }
+    SECTION("high bytes")
+    {
+        w.put_quoted("caf\xc3\xa9 \xff\"");
+        CHECK(s == "\"caf\xc3\xa9 \xff\\\"\"");
+    }
+}
+
+#endif
+
+#ifdef BENCHMARK_TEST
+
+// an alert_json record with the default fields
+static void put_alert(JsonWriter& w, uint64_t num)
+{
+    w.put("{ \"timestamp\" : \"", 17);
+    w.put("06/01-12:00:00.123456");
+    w.put("\", \"pkt_num\" : ", 15);
+    w.put_uint(num);
+    w.put(", \"proto\" : ", 12);
+    w.put_quoted("TCP");
+    w.put(", \"pkt_gen\" : ", 14);
+    w.put_quoted("raw");
+    w.put(", \"pkt_len\" : ", 14);
+    w.put_uint(1514);
+    w.put(", \"dir\" : ", 10);
+    w.put_quoted("C2S");
+    w.put(", \"src_ap\" : \"", 14);
+    w.put("192.168.1.100");
+    w.put(':');
+    w.put_uint(49152 + num % 1000);
+    w.put("\", \"dst_ap\" : \"", 15);
+    w.put("10.0.0.1");
+    w.put(":443\", \"rule\" : \"", 17);
+    w.put_uint(1);
+    w.put(':');
+    w.put_uint(2000000 + num % 100);
+    w.put(':');
+    w.put_uint(3);
+    w.put("\", \"action\" : ", 14);
+    w.put_quoted("allow");
+    w.put(" }\n", 3);
+}
+
+static int print_alert(char* buf, size_t len, uint64_t num)
+{
+    return snprintf(buf, len,
+        "{ \"timestamp\" : \"%s\", \"pkt_num\" : %" PRIu64 ", \"proto\" : \"%s\", "
+        "\"pkt_gen\" : \"%s\", \"pkt_len\" : %u, \"dir\" : \"%s\", "
+        "\"src_ap\" : \"%s:%u\", \"dst_ap\" : \"%s:%u\", \"rule\" : \"%u:%u:%u\", "
+        "\"action\" : \"%s\" }\n",
+        "06/01-12:00:00.123456", num, "TCP", "raw", 1514, "C2S",
+        "192.168.1.100", (unsigned)(49152 + num % 1000), "10.0.0.1", 443,
+        1, (unsigned)(2000000 + num % 100), 3, "allow");
+}
+
+TEST_CASE("alert records", "[json_writer]")
+{
+    std::string s;
+    s.reserve(4096);
+    JsonWriter w(s);
+    char buf[4096];
+    uint64_t num = 0;
+
+    BENCHMARK("snprintf")
+    {
+        return print_alert(buf, sizeof(buf), ++num);
+    };
+
+    BENCHMARK("json writer")
+    {
+        s.clear();
+        put_alert(w, ++num);
+        return s.size();
+    };
+
+    const std::string msg(200, 'x');
+
+    BENCHMARK("quote 200 bytes")
+    {
+        s.clear();
+        w.put_quoted(msg.c_str(), msg.size());
+        return s.size();
+    };
+}
+
+#endif
@@ -129,7 +129,7 @@ public:
             // Get a local temporary reference of data being deleted (as if a trash can).
             // To avoid race condition, data needs to self-destruct after the cache_lock does.
             Data data;
-            std::lock_guard<std::mutex> cache_lock(cache_mutex);
+            std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
             if ( !list.empty() )
             {
@@ -205,7 +205,7 @@ private:
             // Do not change the order of data and cache_lock, as the data must
             // self destruct after cache_lock.
             Purgatory data;
-            std::lock_guard<std::mutex> cache_lock(cache_mutex);
+            std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
             LruBase::prune(data);
         }
     }
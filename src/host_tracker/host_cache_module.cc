@@ -360,6 +360,10 @@ const Command* HostCacheModule::get_commands() const
 
 static const Parameter host_cache_params[] =
 {
+    { "approximate_lru", Parameter::PT_BOOL, nullptr, "false",
+      "mark hosts as referenced on lookup instead of reordering the LRU list "
+      "so that lookups share the segment lock" },
+
     { "dump_file", Parameter::PT_STRING, nullptr, nullptr,
       "file name to dump host cache on shutdown; won't dump by default" },
 
@@ -374,7 +378,11 @@ static const Parameter host_cache_params[] =
 
 bool HostCacheModule::set(const char*, Value& v, SnortConfig*)
 {
-    if ( v.is("dump_file") )
+    if ( v.is("approximate_lru") )
+    {
+        approximate_lru = v.get_bool();
+    }
+    else if ( v.is("dump_file") )
     {
         dump_file = v.get_string();
     }
@@ -403,6 +411,9 @@ bool HostCacheModule::set(const char*, Value& v, SnortConfig*)
 
 bool HostCacheModule::end(const char* fqn, int, SnortConfig* sc)
 {
+    if ( !strcmp(fqn, HOST_CACHE_NAME) )
+        host_cache.set_approximate_lru(approximate_lru);
+
     if ( memcap and !strcmp(fqn, HOST_CACHE_NAME) )
     {
         if ( Snort::is_reloading() )
@@ -85,6 +85,7 @@ private:
     std::string dump_file;
     size_t memcap = 0;
     uint8_t segments = 1;
+    bool approximate_lru = false;
 };
 extern THREAD_LOCAL const snort::Trace* host_cache_trace;
 
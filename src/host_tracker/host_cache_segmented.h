@@ -57,6 +57,7 @@ public:
     PegCount* get_counts();
 
     void set_segments(uint8_t segments) { segment_count = segments; }
+    void set_approximate_lru(bool);
     void print_config();
     bool set_max_size(size_t max_size);
     bool reload_resize(size_t memcap_per_segment);
@@ -65,7 +66,7 @@ public:
 
     std::shared_ptr<Value> operator[](const Key& key);
 
-    uint8_t get_segment_idx(Key val);
+    uint8_t get_segment_idx(const Key& key);
     std::shared_ptr<Value> find(const Key& key);
     std::shared_ptr<Value> find_else_create(const Key& key, bool* new_data);
     std::vector<std::pair<Key, std::shared_ptr<Value>>> get_all_data();
@@ -85,6 +86,7 @@ private:
     std::atomic<size_t> memcap_per_segment;
     struct LruCacheSharedStats counts;
     bool init_done = false;
+    bool approximate_lru = false;
 };
 
 
@@ -114,6 +116,7 @@ void HostCacheSegmented<Key, Value>::init()
     for (size_t i = 0; i < segment_count; ++i)
     {
         auto cache = new HostCacheIp(memcap_per_segment.load());
+        cache->set_approximate_lru(approximate_lru);
         seg_list.emplace_back((HostCacheIp*)cache);
     }
     init_done = true;
@@ -139,6 +142,15 @@ void HostCacheSegmented<Key, Value>::setup(uint8_t segs, size_t memcap )
     set_max_size(memcap);
 }
 
+// Segments created later by init() pick up the setting too.
+template<typename Key, typename Value>
+void HostCacheSegmented<Key, Value>::set_approximate_lru(bool enable)
+{
+    approximate_lru = enable;
+    for (auto cache : seg_list)
+        cache->set_approximate_lru(enable);
+}
+
 template<typename Key, typename Value>
 size_t HostCacheSegmented<Key, Value>::get_valid_id(uint8_t idx)
 {
@@ -199,16 +211,15 @@ bool HostCacheSegmented<Key, Value>::reload_resize(size_t memcap)
 }
 
 // Computes the index of the segment where a given key-value pair belongs.
+// The IP hash is spread with a Fibonacci multiplier and the top bits are
+// used so that addresses from the same subnet don't pile into one segment
+// and the segment doesn't correlate with the bucket in the segment's map.
 template<typename Key, typename Value>
-uint8_t HostCacheSegmented<Key, Value>::get_segment_idx(Key val)
+uint8_t HostCacheSegmented<Key, Value>::get_segment_idx(const Key& key)
 {
-    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&val);
-    uint8_t result = 0;
-    for (size_t i = 0; i < sizeof(Key); ++i)
-        result ^= bytes[i];
+    uint64_t h = (uint64_t)HashIp()(key) * 0x9E3779B97F4A7C15ull;
     //Assumes segment_count is a power of 2 always
-    //This is a fast way to do a modulo operation
-    return result & (segment_count - 1);
+    return (h >> 56) & (segment_count - 1);
 }
 
 //Retrieves all the data stored across all the segments of the cache.
@@ -120,10 +120,10 @@ static void try_reload_prune(bool is_not_locked)
 TEST(host_cache_module, cache_segments)
 {
     SfIp ip0, ip1, ip2, ip3;
-    ip0.set("1.2.3.2");
-    ip1.set("11.22.2.0");
-    ip2.set("192.168.1.1");
-    ip3.set("10.20.33.10");
+    ip0.set("10.0.0.2");
+    ip1.set("10.0.0.3");
+    ip2.set("10.0.0.4");
+    ip3.set("10.0.0.5");
 
     uint8_t segment0 = host_cache.get_segment_idx(ip0);
     uint8_t segment1 = host_cache.get_segment_idx(ip1);
@@ -166,7 +166,9 @@ TEST(host_cache_module, misc)
     CHECK(!strcmp(ht_pegs[6].name, "reload_prunes"));
     CHECK(!strcmp(ht_pegs[7].name, "removes"));
     CHECK(!strcmp(ht_pegs[8].name, "replaced"));
-    CHECK(!ht_pegs[9].name);
+    CHECK(!strcmp(ht_pegs[9].name, "lock_waits"));
+    CHECK(!strcmp(ht_pegs[10].name, "second_chances"));
+    CHECK(!ht_pegs[11].name);
 
     // call this to set up the counts vector, before inserting hosts into the
     // cache, because sum_stats resets the pegs.
@@ -174,9 +176,9 @@ TEST(host_cache_module, misc)
 
     // add 3 entries to segment 3 
     SfIp ip1, ip2, ip3;
-    ip1.set("1.1.1.1");
-    ip2.set("2.2.2.2");
-    ip3.set("3.3.3.3");
+    ip1.set("3.3.3.3");
+    ip2.set("6.6.6.6");
+    ip3.set("1.2.3.4");
     
     host_cache.find_else_create(ip1, nullptr);
     host_cache.find_else_create(ip2, nullptr);
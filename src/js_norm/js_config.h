@@ -26,6 +26,7 @@
 struct JSNormConfig
 {
     int64_t bytes_depth = -1;
+    int64_t norm_window = -1;
     int32_t identifier_depth = 0xffff;
     uint8_t max_template_nesting = 32;
     uint32_t max_bracket_depth = 256;
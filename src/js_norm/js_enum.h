@@ -41,6 +41,7 @@ enum PEG_COUNT
     PEG_BYTES = 0,
     PEG_IDENTIFIERS,
     PEG_IDENTIFIER_OVERFLOWS,
+    PEG_BYTES_TRIMMED,
     PEG_COUNT_MAX
 };
 
@@ -107,6 +107,12 @@ void JSNorm::normalize(const void* in_data, size_t in_len, const void*& data, si
     pdu_cnt = 0;
 
     const Packet* packet = DetectionEngine::get_current_packet();
+
+    if (jsn_ctx != nullptr and config->norm_window >= 0)
+    {
+        auto trimmed = jsn_ctx->trim_script(config->norm_window);
+        JSNormModule::increment_peg_counts(PEG_BYTES_TRIMMED, trimmed);
+    }
     src_ptr = (const uint8_t*)in_data;
     src_end = src_ptr + in_len;
 
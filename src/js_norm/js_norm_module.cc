@@ -56,6 +56,9 @@ const Parameter JSNormModule::params[] =
     { "bytes_depth", Parameter::PT_INT, "-1:max53", "-1",
       "number of input JavaScript bytes to normalize (-1 unlimited)" },
 
+    { "norm_window", Parameter::PT_INT, "-1:max32", "-1",
+      "number of normalized bytes from previous PDUs to keep in the output (-1 unlimited)" },
+
     { "identifier_depth", Parameter::PT_INT, "0:65536", "65536",
       "max number of unique JavaScript identifiers to normalize" },
 
@@ -93,6 +96,7 @@ const PegInfo JSNormModule::peg_names[PEG_COUNT_MAX + 1] =
     { CountType::SUM, "bytes", "total number of bytes processed" },
     { CountType::SUM, "identifiers", "total number of unique identifiers processed" },
     { CountType::SUM, "identifier_overflows", "total number of unique identifier limit overflows" },
+    { CountType::SUM, "bytes_trimmed", "total number of normalized bytes dropped out of the window" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -139,6 +143,10 @@ bool JSNormModule::set(const char*, Value& v, SnortConfig*)
     {
         config->bytes_depth = v.get_int64();
     }
+    else if (v.is("norm_window"))
+    {
+        config->norm_window = v.get_int64();
+    }
     else if (v.is("identifier_depth"))
     {
         config->identifier_depth = v.get_int32();
@@ -99,3 +99,25 @@ JSTokenizer::JSRet JSNormalizer::normalize(const char* src, size_t src_len, bool
 
     return rem_bytes ? ret : JSTokenizer::EOS;
 }
+
+size_t JSNormalizer::trim_script(size_t window)
+{
+    size_t len = out_buf.data_len();
+
+    if (len <= window)
+        return 0;
+
+    size_t anchor = tokenizer.output_anchor();
+    size_t n = min(len - window, anchor);
+
+    if (n == 0)
+        return 0;
+
+    out_buf.discard(n);
+    tokenizer.shift_output(n);
+
+    debug_logf(5, js_trace, TRACE_PROC, nullptr,
+        "%zu bytes of normalized script trimmed\n", n);
+
+    return n;
+}
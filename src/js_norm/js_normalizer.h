@@ -48,6 +48,10 @@ public:
     void reset_depth()
     { rem_bytes = depth; }
 
+    // drops the head of already normalized script, keeping at least the last
+    // window bytes and everything the tokenizer may still rewrite
+    size_t trim_script(size_t window);
+
     const char* take_script()
     { tokenizer.reset_output(); return out_buf.take_data(); }
 
@@ -79,6 +83,8 @@ public:
     { return tmp_buf_size; }
     const JSTokenizer& get_tokenizer() const
     { return tokenizer; }
+    void set_stream_io(bool stream_io)
+    { tokenizer.stream_io = stream_io; }
 #endif // CATCH_TEST_BUILD || BENCHMARK_TEST
 
 #ifdef BENCHMARK_TEST
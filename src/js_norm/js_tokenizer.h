@@ -173,6 +173,12 @@ public:
     void reset_output()
     { ignored_id_pos = -1; }
 
+    // the lowest output position the tokenizer may still rewind to
+    std::streamsize output_anchor() const;
+
+    // rebases all saved output positions after n bytes were dropped from the output head
+    void shift_output(std::streamsize n);
+
     bool is_unescape_nesting_seen() const;
     bool is_mixed_encoding_seen() const;
     bool is_opening_tag_seen() const;
@@ -181,6 +187,8 @@ public:
 
 private:
     int yylex() override;
+    int LexerInput(char* buf, int max_size) override;
+    void LexerOutput(const char* buf, int size) override;
 
     void switch_to_initial();
     void switch_to_temporal(const std::string& data);
@@ -401,6 +409,12 @@ private:
     std::stack<Scope> scope_stack;
 
 #if defined(CATCH_TEST_BUILD) || defined(BENCHMARK_TEST)
+public:
+    // go through std::istream/std::ostream like yyFlexLexer does, so tests
+    // can compare the output with the one from the stream buffers
+    bool stream_io = false;
+
+private:
     friend JSTokenizerTester;
     friend JSTestConfig;
 #endif // CATCH_TEST_BUILD || BENCHMARK_TEST
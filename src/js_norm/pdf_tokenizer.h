@@ -52,6 +52,8 @@ public:
 
 private:
     int yylex() override;
+    int LexerInput(char* buf, int max_size) override;
+    void LexerOutput(const char* buf, int size) override;
 
     PDFRet h_dict_open();
     PDFRet h_dict_close();
@@ -135,6 +137,13 @@ private:
         uint16_t low = 0;
         int cur_byte = 0;
     } u16_state;
+
+#if defined(CATCH_TEST_BUILD) || defined(BENCHMARK_TEST)
+public:
+    // go through std::istream/std::ostream like yyFlexLexer does, so tests
+    // can compare the output with the one from the stream buffers
+    bool stream_io = false;
+#endif // CATCH_TEST_BUILD || BENCHMARK_TEST
 };
 
 bool PDFTokenizer::h_lit_str()
@@ -41,31 +41,56 @@ JSTokenizerTester::JSTokenizerTester(const JSTestConfig& conf) :
         conf.max_bracket_depth,
         conf.max_token_buf_size
     ),
+    ref_ident_ctx(conf.identifier_depth,
+        conf.max_scope_depth,
+        conf.ignored_ids_list,
+        conf.ignored_properties_list),
+    ref_normalizer(
+        conf.normalize_identifiers ?
+            static_cast<JSIdentifier&>(ref_ident_ctx) :
+            static_cast<JSIdentifier&>(ref_ident_ctx_stub),
+        conf.norm_depth,
+        conf.max_template_nesting,
+        conf.max_bracket_depth,
+        conf.max_token_buf_size
+    ),
     config(conf)
-{ }
+{
+    ref_normalizer.set_stream_io(true);
+}
 
 void JSTokenizerTester::do_pdu(const std::string& source)
 {
+    bool external = config.normalize_as_external.is_set() and config.normalize_as_external;
+
     last_source = source;
-    last_return = normalizer.normalize(last_source.c_str(), last_source.size(),
-        config.normalize_as_external.is_set() and config.normalize_as_external);
+    last_return = normalizer.normalize(last_source.c_str(), last_source.size(), external);
+    ref_return = ref_normalizer.normalize(last_source.c_str(), last_source.size(), external);
 }
 
-void JSTokenizerTester::check_output(const std::string& expected)
+std::string JSTokenizerTester::get_output(JSNormalizer& norm) const
 {
-    std::string result_str;
-
     if (config.use_expected_for_last_pdu.is_set() and config.use_expected_for_last_pdu)
     {
-        auto size = normalizer.script_size();
-        auto temp_buf = normalizer.take_script();
-        result_str = {temp_buf, size};
+        auto size = norm.script_size();
+        auto temp_buf = norm.take_script();
+        std::string result_str(temp_buf, size);
         delete[] temp_buf;
+        return result_str;
     }
-    else
-        result_str = {normalizer.get_script(), normalizer.script_size()};
+
+    return {norm.get_script(), norm.script_size()};
+}
+
+void JSTokenizerTester::check_output(const std::string& expected)
+{
+    std::string result_str = get_output(normalizer);
+    std::string ref_str = get_output(ref_normalizer);
 
     CHECK(result_str == expected);
+    CHECK(result_str == ref_str);
+    CHECK(last_return == ref_return);
+    CHECK(normalizer.get_src_next() == ref_normalizer.get_src_next());
 }
 
 void JSTokenizerTester::run_checks(const JSTestConfig& checks)
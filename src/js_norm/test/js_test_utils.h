@@ -70,9 +70,18 @@ public:
     JSIdentifierCtxStub ident_ctx_stub;
     JSNormalizer normalizer;
 
+    // the same PDUs normalized with the tokenizer going through
+    // std::istream/std::ostream, the output must not differ
+    JSIdentifierCtx ref_ident_ctx;
+    JSIdentifierCtxStub ref_ident_ctx_stub;
+    JSNormalizer ref_normalizer;
+
 private:
+    std::string get_output(JSNormalizer&) const;
+
     const JSTestConfig& config;
     JSTokenizer::JSRet last_return = JSTokenizer::EOS;
+    JSTokenizer::JSRet ref_return = JSTokenizer::EOS;
     std::string last_source;
 };
 
@@ -136,6 +136,34 @@ TEST_CASE("normalization", "[JSNorm]")
 
         CHECK(std::string((const char*)dst, dst_len) == norm_pdu_3);
     }
+
+    SECTION("window")
+    {
+        config.norm_window = 0;
+
+        const std::string pdu_1 = "1;2;3;4;5;6;7;8;9;";
+        const std::string pdu_2 = "0;";
+
+        // previous output is dropped, except the tail to be renormalized
+        const std::string norm_pdu_1 = "1;2;3;4;5;6;7;8;9;";
+        const std::string norm_pdu_2 = "5;6;7;8;9;0;";
+
+        jsn.tick();
+        jsn.normalize(pdu_1.c_str(), pdu_1.size(), dst, dst_len);
+
+        REQUIRE(dst != nullptr);
+        REQUIRE(dst_len != 0);
+
+        CHECK(std::string((const char*)dst, dst_len) == norm_pdu_1);
+
+        jsn.tick();
+        jsn.normalize(pdu_2.c_str(), pdu_2.size(), dst, dst_len);
+
+        REQUIRE(dst != nullptr);
+        REQUIRE(dst_len != 0);
+
+        CHECK(std::string((const char*)dst, dst_len) == norm_pdu_2);
+    }
 }
 
 TEST_CASE("non-blocking events", "[JSNorm]")
@@ -35,6 +35,8 @@ using namespace std::string_literals;
 
 typedef pair<string, string> Chunk;
 
+// each input is also processed with the tokenizer going through
+// std::istream/std::ostream, the output must not differ
 static void test_pdf_proc(const string& source, const string& expected,
     PDFTokenizer::PDFRet ret = PDFTokenizer::PDFRet::EOS)
 {
@@ -42,10 +44,18 @@ static void test_pdf_proc(const string& source, const string& expected,
     ostringstream out;
     PDFTokenizer extractor(in, out);
 
+    istringstream ref_in(source);
+    ostringstream ref_out;
+    PDFTokenizer ref_extractor(ref_in, ref_out);
+    ref_extractor.stream_io = true;
+
     auto r = extractor.process();
+    auto ref_r = ref_extractor.process();
 
     CHECK(ret == r);
     CHECK(expected == out.str());
+    CHECK(ref_r == r);
+    CHECK(ref_out.str() == out.str());
 }
 
 static void test_pdf_proc(const vector<Chunk>& chunks)
@@ -54,6 +64,11 @@ static void test_pdf_proc(const vector<Chunk>& chunks)
     ostringstream out;
     PDFTokenizer extractor(in, out);
 
+    istringstream ref_in;
+    ostringstream ref_out;
+    PDFTokenizer ref_extractor(ref_in, ref_out);
+    ref_extractor.stream_io = true;
+
     for (const auto& chunk : chunks)
     {
         auto src = chunk.first;
@@ -61,11 +76,16 @@ static void test_pdf_proc(const vector<Chunk>& chunks)
 
         in.str(src);
         out.str("");
+        ref_in.str(src);
+        ref_out.str("");
 
         auto r = extractor.process();
+        auto ref_r = ref_extractor.process();
 
         CHECK(PDFTokenizer::PDFRet::EOS == r);
         CHECK(exp == out.str());
+        CHECK(ref_r == r);
+        CHECK(ref_out.str() == out.str());
     }
 }
 
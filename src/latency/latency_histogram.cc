@@ -0,0 +1,179 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// latency_histogram.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+void LatencyHistogram::reset()
+{
+    memset(buckets, 0, sizeof(buckets));
+    count = sum = max = 0;
+}
+
+uint64_t LatencyHistogram::lowest(unsigned i)
+{
+    if ( i < 2 * sub_count )
+        return i;
+
+    unsigned shift = i / sub_count - 1;
+    return (uint64_t)(sub_count + i % sub_count) << shift;
+}
+
+uint64_t LatencyHistogram::highest(unsigned i)
+{
+    if ( i < 2 * sub_count )
+        return i;
+
+    if ( i == num_buckets - 1 )
+        return UINT64_MAX;
+
+    return lowest(i + 1) - 1;
+}
+
+LatencyHistogram& LatencyHistogram::operator+=(const LatencyHistogram& rhs)
+{
+    for ( unsigned i = 0; i < num_buckets; ++i )
+        buckets[i] += rhs.buckets[i];
+
+    count += rhs.count;
+    sum += rhs.sum;
+    max = std::max(max, rhs.max);
+
+    return *this;
+}
+
+LatencyHistogram& LatencyHistogram::operator-=(const LatencyHistogram& rhs)
+{
+    unsigned top = 0;
+
+    for ( unsigned i = 0; i < num_buckets; ++i )
+    {
+        buckets[i] -= rhs.buckets[i];
+
+        if ( buckets[i] )
+            top = i;
+    }
+
+    count -= rhs.count;
+    sum -= rhs.sum;
+    max = count ? std::min(max, highest(top)) : 0;
+
+    return *this;
+}
+
+uint64_t LatencyHistogram::get_percentile(double pct) const
+{
+    if ( !count )
+        return 0;
+
+    uint64_t rank = (uint64_t)std::ceil(pct / 100.0 * count);
+
+    if ( !rank )
+        rank = 1;
+
+    uint64_t seen = 0;
+
+    for ( unsigned i = 0; i < num_buckets; ++i )
+    {
+        seen += buckets[i];
+
+        if ( seen >= rank )
+            return std::min(highest(i), max);
+    }
+    return max;
+}
+
+#ifdef UNIT_TEST
+
+TEST_CASE("latency histogram buckets", "[latency]")
+{
+    // every bucket covers the values between its bounds
+    for ( unsigned i = 0; i < LatencyHistogram::num_buckets - 1; ++i )
+    {
+        CHECK( LatencyHistogram::index(LatencyHistogram::lowest(i)) == i );
+        CHECK( LatencyHistogram::index(LatencyHistogram::highest(i)) == i );
+        CHECK( LatencyHistogram::lowest(i + 1) == LatencyHistogram::highest(i) + 1 );
+    }
+
+    // the relative error is bounded
+    for ( uint64_t v = 1; v < (1ull << 40); v = v * 3 + 1 )
+    {
+        unsigned i = LatencyHistogram::index(v);
+        uint64_t width = LatencyHistogram::highest(i) - LatencyHistogram::lowest(i) + 1;
+        CHECK( width * LatencyHistogram::sub_count <= std::max<uint64_t>(v, 2 * LatencyHistogram::sub_count) );
+    }
+    CHECK( LatencyHistogram::index(UINT64_MAX) == LatencyHistogram::num_buckets - 1 );
+}
+
+TEST_CASE("latency histogram percentiles", "[latency]")
+{
+    LatencyHistogram h;
+
+    for ( uint64_t v = 1; v <= 10000; ++v )
+        h.record(v);
+
+    CHECK( h.get_count() == 10000 );
+    CHECK( h.get_max() == 10000 );
+    CHECK( h.get_sum() == 50005000 );
+
+    auto near = [](uint64_t v, uint64_t expect)
+    { return v >= expect and v <= expect + expect / LatencyHistogram::sub_count; };
+
+    CHECK( near(h.get_percentile(50.0), 5000) );
+    CHECK( near(h.get_percentile(99.0), 9900) );
+    CHECK( near(h.get_percentile(99.9), 9990) );
+    CHECK( h.get_percentile(100.0) == 10000 );
+
+    SECTION("merge and difference")
+    {
+        LatencyHistogram before = h;
+        LatencyHistogram other;
+        other.record(1000000);
+        h += other;
+
+        CHECK( h.get_count() == 10001 );
+        CHECK( h.get_max() == 1000000 );
+
+        h -= before;
+        CHECK( h.get_count() == 1 );
+        CHECK( near(h.get_percentile(50.0), 1000000) );
+        CHECK( h.get_max() == 1000000 );
+    }
+
+    SECTION("reset")
+    {
+        h.reset();
+        CHECK( h.get_count() == 0 );
+        CHECK( h.get_percentile(99.0) == 0 );
+    }
+}
+
+#endif
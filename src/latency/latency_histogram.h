@@ -0,0 +1,96 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// latency_histogram.h author Cisco
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+// LatencyHistogram counts values in log-linear buckets like an HDR
+// histogram: values below 2 * sub_count have their own bucket and each
+// larger power of two is split into sub_count buckets so any value is
+// reported within 1 / sub_count of its actual value.  Recording is an
+// index computation and an increment.
+
+#include <cstdint>
+
+#include "main/snort_types.h"
+
+class SO_PUBLIC LatencyHistogram
+{
+public:
+    static const unsigned sub_bits = 5;
+    static const unsigned sub_count = 1 << sub_bits;
+    static const unsigned max_bits = 48;
+    static const unsigned num_buckets = (max_bits - sub_bits) * sub_count;
+
+    LatencyHistogram()
+    { reset(); }
+
+    void record(uint64_t v)
+    {
+        ++buckets[index(v)];
+        ++count;
+        sum += v;
+
+        if ( v > max )
+            max = v;
+    }
+
+    void reset();
+
+    LatencyHistogram& operator+=(const LatencyHistogram&);
+
+    // the counts since an earlier copy of this histogram; max becomes the
+    // top of the highest bucket
+    LatencyHistogram& operator-=(const LatencyHistogram&);
+
+    // the largest value in the bucket holding the pct percentile
+    uint64_t get_percentile(double pct) const;
+
+    uint64_t get_count() const
+    { return count; }
+
+    uint64_t get_sum() const
+    { return sum; }
+
+    uint64_t get_max() const
+    { return max; }
+
+    static unsigned index(uint64_t v)
+    {
+        if ( v < 2 * sub_count )
+            return (unsigned)v;
+
+        unsigned shift = 63 - __builtin_clzll(v) - sub_bits;
+        unsigned i = (shift + 1) * sub_count + (unsigned)(v >> shift) - sub_count;
+
+        return i < num_buckets ? i : num_buckets - 1;
+    }
+
+    static uint64_t lowest(unsigned i);
+    static uint64_t highest(unsigned i);
+
+private:
+    uint64_t buckets[num_buckets];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+};
+
+#endif
@@ -25,13 +25,22 @@
 #include "latency_module.h"
 
 #include <chrono>
-
+#include <mutex>
+#include <vector>
+
+#include "control/control.h"
+#include "log/messages.h"
+#include "lua/lua.h"
+#include "main/analyzer_command.h"
+#include "main/snort.h"
 #include "main/snort_config.h"
 #include "trace/trace.h"
 
 #include "latency_config.h"
+#include "latency_histogram.h"
 #include "latency_rules.h"
 #include "latency_stats.h"
+#include "stage_latency.h"
 
 using namespace snort;
 
@@ -53,6 +62,9 @@ static const Parameter s_packet_params[] =
     { "fastpath", Parameter::PT_BOOL, nullptr, "false",
         "fastpath expensive packets (max_time exceeded)" },
 
+    { "histograms", Parameter::PT_BOOL, nullptr, "false",
+        "keep latency histograms for packets, decode, detection, logging, and each inspector" },
+
 #ifdef REG_TEST
     { "test_timeout", Parameter::PT_BOOL, nullptr, "false",
         "timeout on every packet" },
@@ -119,6 +131,109 @@ static const PegInfo latency_pegs[] =
     { CountType::END, nullptr, nullptr }
 };
 
+// -----------------------------------------------------------------------------
+// commands
+// -----------------------------------------------------------------------------
+
+class LatencyHistogramDump : public AnalyzerCommand
+{
+public:
+    LatencyHistogramDump(ControlConn* conn) :
+        AnalyzerCommand(conn), totals(StageLatency::get_num_stages())
+    { }
+
+    ~LatencyHistogramDump() override;
+
+    bool execute(Analyzer&, void**) override;
+
+    const char* stringify() override
+    { return "LATENCY_HISTOGRAM_DUMP"; }
+
+private:
+    std::mutex mutex;
+    std::vector<LatencyHistogram> totals;
+};
+
+bool LatencyHistogramDump::execute(Analyzer&, void**)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for ( unsigned i = 0; i < totals.size(); ++i )
+    {
+        if ( auto h = StageLatency::get_histogram(i) )
+            totals[i] += *h;
+    }
+    return true;
+}
+
+static double usecs(uint64_t ticks)
+{ return StageLatency::to_nsecs(ticks) / 1000.0; }
+
+LatencyHistogramDump::~LatencyHistogramDump()
+{
+    LogRespond(ctrlcon, "%-24s %12s %10s %10s %10s %10s %10s\n",
+        "stage", "count", "p50", "p90", "p99", "p99.9", "max");
+
+    for ( unsigned i = 0; i < totals.size(); ++i )
+    {
+        const LatencyHistogram& h = totals[i];
+
+        if ( !h.get_count() )
+            continue;
+
+        LogRespond(ctrlcon, "%-24s %12" PRIu64 " %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+            StageLatency::get_name(i), h.get_count(), usecs(h.get_percentile(50.0)),
+            usecs(h.get_percentile(90.0)), usecs(h.get_percentile(99.0)),
+            usecs(h.get_percentile(99.9)), usecs(h.get_max()));
+    }
+    LogRespond(ctrlcon, "latencies in usecs\n");
+}
+
+class LatencyHistogramReset : public AnalyzerCommand
+{
+public:
+    bool execute(Analyzer&, void**) override
+    {
+        StageLatency::reset();
+        return true;
+    }
+
+    const char* stringify() override
+    { return "LATENCY_HISTOGRAM_RESET"; }
+};
+
+static int dump_histograms(lua_State* L)
+{
+    ControlConn* ctrlcon = ControlConn::query_from_lua(L);
+
+    if ( !SnortConfig::get_conf()->latency->packet_latency.histograms )
+    {
+        LogRespond(ctrlcon, "latency histograms are not enabled\n");
+        return 0;
+    }
+    main_broadcast_command(new LatencyHistogramDump(ctrlcon), ctrlcon);
+    return 0;
+}
+
+static int reset_histograms(lua_State* L)
+{
+    ControlConn* ctrlcon = ControlConn::query_from_lua(L);
+    main_broadcast_command(new LatencyHistogramReset, ctrlcon);
+    LogRespond(ctrlcon, "latency histograms reset\n");
+    return 0;
+}
+
+static const Command latency_cmds[] =
+{
+    { "dump_histograms", dump_histograms, nullptr,
+      "print latency percentiles by stage (usecs)" },
+
+    { "reset_histograms", reset_histograms, nullptr,
+      "clear the latency histograms" },
+
+    { nullptr, nullptr, nullptr, nullptr }
+};
+
 // -----------------------------------------------------------------------------
 // latency module
 // -----------------------------------------------------------------------------
@@ -132,6 +247,9 @@ static inline bool latency_set(const Value& v, PacketLatencyConfig& config)
     }
     else if ( v.is("fastpath") )
         config.fastpath = v.get_bool();
+
+    else if ( v.is("histograms") )
+        config.histograms = v.get_bool();
 #ifdef REG_TEST
     else if ( v.is("test_timeout") )
         config.test_timeout = v.get_bool();
@@ -211,6 +329,9 @@ bool LatencyModule::end(const char*, int, SnortConfig* sc)
     return true;
 }
 
+const Command* LatencyModule::get_commands() const
+{ return latency_cmds; }
+
 const RuleMap* LatencyModule::get_rules() const
 { return latency_rules; }
 
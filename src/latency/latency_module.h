@@ -31,6 +31,7 @@ public:
     bool set(const char*, snort::Value&, snort::SnortConfig*) override;
     bool end(const char*, int, snort::SnortConfig*) override;
 
+    const snort::Command* get_commands() const override;
     const snort::RuleMap* get_rules() const override;
     unsigned get_gid() const override;
 
@@ -36,6 +36,7 @@
 #include "latency_stats.h"
 #include "latency_timer.h"
 #include "latency_util.h"
+#include "stage_latency.h"
 
 #ifdef UNIT_TEST
 #include "catch/snort_catch.h"
@@ -275,6 +276,7 @@ void PacketLatency::tterm()
         delete impl;
         impl = nullptr;
     }
+    StageLatency::tterm();
 }
 
 // -----------------------------------------------------------------------------
@@ -27,6 +27,7 @@ struct PacketLatencyConfig
 {
     hr_duration max_time = CLOCK_ZERO;
     bool fastpath = false;
+    bool histograms = false;
     bool force_enable = false;
 #ifdef REG_TEST
     bool test_timeout = false;
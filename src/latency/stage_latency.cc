@@ -0,0 +1,115 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// stage_latency.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "stage_latency.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include "latency_histogram.h"
+
+// names are only added so a stage id is good for the life of the process
+// and packet threads can read any name below the published count
+static std::string stage_names[StageLatency::max_stages] =
+{ "packet", "decode", "detection", "logging" };
+
+static std::atomic<unsigned> num_stages { StageLatency::MAX_FIXED };
+static std::mutex stage_mutex;
+
+static THREAD_LOCAL LatencyHistogram* histograms[StageLatency::max_stages] = { };
+
+THREAD_LOCAL bool StageLatency::enabled = false;
+
+unsigned StageLatency::get_stage(const char* name)
+{
+    std::lock_guard<std::mutex> lock(stage_mutex);
+    unsigned n = num_stages.load(std::memory_order_relaxed);
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        if ( stage_names[i] == name )
+            return i;
+    }
+
+    if ( n == max_stages )
+        return NONE;
+
+    stage_names[n] = name;
+    num_stages.store(n + 1, std::memory_order_release);
+
+    return n;
+}
+
+unsigned StageLatency::get_num_stages()
+{ return num_stages.load(std::memory_order_acquire); }
+
+const char* StageLatency::get_name(unsigned stage)
+{
+    assert(stage < get_num_stages());
+    return stage_names[stage].c_str();
+}
+
+void StageLatency::record(unsigned stage, hr_duration d)
+{
+    assert(stage < max_stages);
+    LatencyHistogram*& h = histograms[stage];
+
+    if ( !h )
+        h = new LatencyHistogram;
+
+    h->record(TO_TICKS(d));
+}
+
+const LatencyHistogram* StageLatency::get_histogram(unsigned stage)
+{ return stage < max_stages ? histograms[stage] : nullptr; }
+
+uint64_t StageLatency::to_nsecs(uint64_t ticks)
+{
+#ifdef USE_TSC_CLOCK
+    return ticks * 1000 / clock_scale();
+#else
+    return TO_NSECS(hr_duration(ticks));
+#endif
+}
+
+void StageLatency::reset()
+{
+    for ( auto h : histograms )
+    {
+        if ( h )
+            h->reset();
+    }
+}
+
+void StageLatency::tterm()
+{
+    for ( auto& h : histograms )
+    {
+        delete h;
+        h = nullptr;
+    }
+}
@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// stage_latency.h author Cisco
+
+#ifndef STAGE_LATENCY_H
+#define STAGE_LATENCY_H
+
+// StageLatency keeps a latency histogram per processing stage in each
+// packet thread.  The fixed stages are the whole packet, decode, detection
+// and logging; each inspector instance gets a stage by name when the
+// inspectors are configured.  Histograms count clock ticks and are only
+// allocated for stages that have been timed on the thread.
+
+#include "main/snort_types.h"
+#include "main/thread.h"
+#include "time/clock_defs.h"
+#include "time/stopwatch.h"
+
+class LatencyHistogram;
+
+class SO_PUBLIC StageLatency
+{
+public:
+    enum : unsigned { PACKET, DECODE, DETECTION, LOGGING, MAX_FIXED };
+
+    static const unsigned max_stages = 256;
+    static const unsigned NONE = max_stages;
+
+    // main thread only; returns NONE when there are too many stages
+    static unsigned get_stage(const char* name);
+
+    static unsigned get_num_stages();
+    static const char* get_name(unsigned stage);
+
+    static void set_enabled(bool b)
+    { enabled = b; }
+
+    static bool is_enabled()
+    { return enabled; }
+
+    static void record(unsigned stage, hr_duration);
+
+    // this thread's histogram or nullptr if nothing was recorded
+    static const LatencyHistogram* get_histogram(unsigned stage);
+
+    static uint64_t to_nsecs(uint64_t ticks);
+
+    static void reset();
+    static void tterm();
+
+    class Context
+    {
+    public:
+        Context(unsigned stage) : stage(stage)
+        {
+            if ( enabled and stage < max_stages )
+                sw.start();
+        }
+
+        ~Context()
+        {
+            if ( sw.active() )
+                record(stage, sw.get());
+        }
+
+    private:
+        Stopwatch<SnortClock> sw;
+        unsigned stage;
+    };
+
+private:
+    static THREAD_LOCAL bool enabled;
+};
+
+#endif
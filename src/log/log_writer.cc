@@ -0,0 +1,349 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "log_writer.h"
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include "log/messages.h"
+#include "main/snort_config.h"
+#include "utils/util.h"
+
+using namespace snort;
+
+// records are an 8 byte length followed by the data padded to 8 bytes; a
+// record that doesn't fit before the end of the ring is preceded by a wrap
+// marker and starts at the beginning
+#define REC_HDR sizeof(uint64_t)
+#define REC_WRAP UINT64_MAX
+#define MAX_IOV 64
+
+const PegInfo log_writer_pegs[] =
+{
+    { CountType::SUM, "log_records", "records queued for the log writer thread" },
+    { CountType::SUM, "log_bytes", "bytes queued for the log writer thread" },
+    { CountType::SUM, "log_drops", "records dropped because the log ring was full" },
+    { CountType::SUM, "log_waits", "times a packet thread waited for room in the log ring" },
+    { CountType::MAX, "log_max_queued", "maximum bytes waiting in a log ring" },
+    { CountType::END, nullptr, nullptr }
+};
+
+THREAD_LOCAL LogWriterStats log_writer_stats;
+
+static inline size_t rec_size(size_t len)
+{ return REC_HDR + ((len + 7) & ~(size_t)7); }
+
+//-------------------------------------------------------------------------
+// the writer thread
+//-------------------------------------------------------------------------
+
+class LogWriter
+{
+public:
+    static void add(LogStream*);
+    static void remove(LogStream*);
+
+private:
+    static void worker();
+
+    static std::mutex start_mutex;
+    static std::mutex mutex;
+    static std::list<LogStream*> streams;
+    static std::thread* thread;
+    static bool running;
+};
+
+std::mutex LogWriter::start_mutex;
+std::mutex LogWriter::mutex;
+std::list<LogStream*> LogWriter::streams;
+std::thread* LogWriter::thread = nullptr;
+bool LogWriter::running = false;
+
+// start_mutex keeps a stream from starting a new thread while the last one
+// is being joined; mutex keeps the stream list stable while it is drained
+void LogWriter::add(LogStream* ls)
+{
+    std::lock_guard<std::mutex> sl(start_mutex);
+    std::lock_guard<std::mutex> lk(mutex);
+    streams.emplace_back(ls);
+
+    if ( !thread )
+    {
+        running = true;
+        thread = new std::thread(worker);
+    }
+}
+
+void LogWriter::remove(LogStream* ls)
+{
+    std::lock_guard<std::mutex> sl(start_mutex);
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        streams.remove(ls);
+
+        if ( !streams.empty() or !thread )
+            return;
+
+        running = false;
+    }
+    thread->join();
+    delete thread;
+    thread = nullptr;
+}
+
+void LogWriter::worker()
+{
+    while ( true )
+    {
+        bool busy = false;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+
+            if ( !running )
+                break;
+
+            for ( auto ls : streams )
+                busy = ls->drain() or busy;
+        }
+        if ( !busy )
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+//-------------------------------------------------------------------------
+// streams
+//-------------------------------------------------------------------------
+
+bool LogStream::enabled()
+{ return SnortConfig::get_conf()->log_ring_size != 0; }
+
+LogStream::LogStream(unsigned max_record) :
+    LogStream(max_record, SnortConfig::get_conf()->log_ring_size,
+        SnortConfig::get_conf()->log_ring_block)
+{ }
+
+LogStream::LogStream(unsigned max_record, size_t ring_size, bool block) : block(block)
+{
+    size_t min = 2 * rec_size(max_record);
+    size = 1;
+
+    while ( size < ring_size or size < min )
+        size <<= 1;
+
+    ring = (uint8_t*)snort_alloc(size);
+}
+
+LogStream::~LogStream()
+{
+    stop();
+    snort_free(ring);
+}
+
+void LogStream::start()
+{
+    LogWriter::add(this);
+    started = true;
+}
+
+void LogStream::stop()
+{
+    if ( !started )
+        return;
+
+    // the writer must finish with this stream before the file is closed
+    while ( tail.load(std::memory_order_acquire) != head.load(std::memory_order_relaxed) )
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    LogWriter::remove(this);
+    started = false;
+}
+
+bool LogStream::write(const void* data, unsigned len)
+{
+    uint8_t* rec = reserve(len);
+
+    if ( !rec )
+        return false;
+
+    memcpy(rec, data, len);
+    commit(len);
+    return true;
+}
+
+// the wrap marker is past head so the writer won't see it before commit
+uint8_t* LogStream::reserve(unsigned len)
+{
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t pos = h & (size - 1);
+    size_t need = rec_size(len);
+    size_t skip = (size - pos < need) ? size - pos : 0;
+
+    if ( skip + need > size )
+    {
+        log_writer_stats.drops++;
+        return nullptr;
+    }
+
+    while ( h + skip + need - tail.load(std::memory_order_acquire) > size )
+    {
+        if ( !block )
+        {
+            log_writer_stats.drops++;
+            return nullptr;
+        }
+        log_writer_stats.waits++;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    if ( skip )
+    {
+        *(uint64_t*)(ring + pos) = REC_WRAP;
+        h += skip;
+        pos = 0;
+    }
+    reserved = h;
+    return ring + pos + REC_HDR;
+}
+
+void LogStream::commit(unsigned len)
+{
+    size_t h = reserved;
+    *(uint64_t*)(ring + (h & (size - 1))) = len;
+    h += rec_size(len);
+
+    head.store(h, std::memory_order_release);
+
+    size_t queued = h - tail.load(std::memory_order_relaxed);
+
+    if ( queued > log_writer_stats.max_queued )
+        log_writer_stats.max_queued = queued;
+
+    log_writer_stats.records++;
+    log_writer_stats.bytes += len;
+}
+
+void LogStream::flush(struct iovec* iov, int count)
+{
+    int fd = get_fd();
+
+    if ( fd < 0 )
+        return;
+
+    int max_retries = 3;
+    int err = 0;
+
+    while ( count > 0 )
+    {
+        ssize_t n = writev(fd, iov, count);
+
+        if ( n < 0 )
+        {
+            err = errno;
+            if ( (err != EINTR and err != EAGAIN) or --max_retries <= 0 )
+                break;
+            continue;
+        }
+
+        // nothing written with bytes pending must not spin forever
+        if ( n == 0 )
+        {
+            err = EIO;
+            if ( --max_retries <= 0 )
+                break;
+            continue;
+        }
+
+        // skip what was written, a partial write can end inside a record
+        while ( count > 0 and (size_t)n >= iov->iov_len )
+        {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+
+        if ( count > 0 )
+        {
+            iov->iov_base = (uint8_t*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+
+    if ( count > 0 and !reported )
+    {
+        ErrorMessage("log writer: can't write log file: %s\n", get_error(err));
+        reported = true;
+    }
+}
+
+bool LogStream::drain()
+{
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+
+    if ( t == h )
+        return false;
+
+    struct iovec iov[MAX_IOV];
+    int count = 0;
+
+    while ( t != h )
+    {
+        size_t pos = t & (size - 1);
+        uint64_t len = *(uint64_t*)(ring + pos);
+
+        if ( len == REC_WRAP )
+        {
+            t += size - pos;
+            continue;
+        }
+
+        bool roll_first = check_size(len);
+
+        if ( roll_first or count == MAX_IOV )
+        {
+            flush(iov, count);
+            tail.store(t, std::memory_order_release);
+            count = 0;
+
+            if ( roll_first )
+                roll();
+        }
+
+        iov[count].iov_base = ring + pos + REC_HDR;
+        iov[count].iov_len = len;
+        count++;
+        t += rec_size(len);
+    }
+
+    flush(iov, count);
+    tail.store(t, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+// LogStream moves file output off the packet threads.  A stream belongs to
+// one packet thread which copies each record into the stream's ring; the
+// LogWriter thread drains the rings of all streams to their files with
+// writev.  Records are never split so a subclass can roll its file between
+// records.  When a ring is full the record is dropped or the packet thread
+// waits for the writer per output.log_ring_overflow.  Streams are only
+// created when output.log_ring_size is set.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "framework/counts.h"
+#include "main/snort_types.h"
+#include "main/thread.h"
+
+struct iovec;
+
+struct LogWriterStats
+{
+    PegCount records;
+    PegCount bytes;
+    PegCount drops;
+    PegCount waits;
+    PegCount max_queued;
+};
+
+extern const PegInfo log_writer_pegs[];
+extern THREAD_LOCAL LogWriterStats log_writer_stats;
+
+namespace snort
+{
+class SO_PUBLIC LogStream
+{
+public:
+    // true if streams are configured
+    static bool enabled();
+
+    // packet thread
+    // the ring holds at least two records of max_record bytes; the size and
+    // overflow handling are per output.log_ring_* unless given
+    LogStream(unsigned max_record);
+    LogStream(unsigned max_record, size_t ring_size, bool block);
+    virtual ~LogStream();
+
+    // the subclass must stop the stream before it closes its file
+    void start();
+    void stop();
+
+    // returns false if the record was dropped
+    bool write(const void*, unsigned len);
+
+    // build a record in place instead of copying it; reserve() returns
+    // nullptr if the record must be dropped, else commit() must follow with
+    // at most the reserved length
+    uint8_t* reserve(unsigned len);
+    void commit(unsigned len);
+
+    // writer thread
+    // returns false when there was nothing to write
+    bool drain();
+
+protected:
+    // records are discarded while there is no file, ie -1 is returned
+    virtual int get_fd() = 0;
+
+    // called with the length of each record before it is written;
+    // return true to roll the file first
+    virtual bool check_size(unsigned)
+    { return false; }
+
+    virtual void roll() { }
+
+private:
+    void flush(struct iovec*, int count);
+
+    uint8_t* ring;
+    size_t size;
+    bool block;
+    bool started = false;
+    bool reported = false;
+
+    size_t reserved = 0;
+
+    std::atomic<size_t> head { 0 };
+    std::atomic<size_t> tail { 0 };
+};
+}
+
+#endif
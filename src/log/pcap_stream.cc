@@ -0,0 +1,236 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "pcap_stream.h"
+
+#include <fcntl.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "log/messages.h"
+#include "main/thread.h"
+#include "utils/util.h"
+
+using namespace snort;
+
+// all fields are in host order; readers check the magic numbers
+#define PCAP_MAGIC 0xa1b2c3d4
+#define PCAP_REC_HDR 16
+
+#define PCAPNG_SHB 0x0A0D0D0A
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+#define PCAPNG_MAGIC 0x1A2B3C4D
+#define PCAPNG_EPB_HDR 28
+#define PCAPNG_EPB_SIZE (PCAPNG_EPB_HDR + 4)
+
+#define OPT_END 0
+#define OPT_SHB_USERAPPL 4
+#define OPT_IF_NAME 2
+#define OPT_IF_DESCRIPTION 3
+
+static inline unsigned pad4(unsigned n)
+{ return (n + 3) & ~3u; }
+
+static inline unsigned max_record(unsigned snaplen, bool ng)
+{ return ng ? PCAPNG_EPB_SIZE + pad4(snaplen) : PCAP_REC_HDR + snaplen; }
+
+template <typename T>
+static void put(std::string& s, T v)
+{ s.append((const char*)&v, sizeof(v)); }
+
+static void put_option(std::string& s, uint16_t code, const std::string& val)
+{
+    put<uint16_t>(s, code);
+    put<uint16_t>(s, val.size());
+    s += val;
+    s.append(pad4(val.size()) - val.size(), '\0');
+}
+
+// block type, total length, body, total length
+static void put_block(std::string& s, uint32_t type, const std::string& body)
+{
+    uint32_t len = 12 + body.size();
+    put(s, type);
+    put(s, len);
+    s += body;
+    put(s, len);
+}
+
+PcapStream::PcapStream(int linktype, unsigned snaplen, bool ng, const char* if_name,
+    size_t ring_size, bool block) :
+    LogStream(max_record(snaplen, ng), ring_size, block), if_name(if_name ? if_name : ""),
+    linktype(linktype), snaplen(snaplen), ng(ng), instance(get_instance_id())
+{ }
+
+PcapStream::~PcapStream()
+{ close(); }
+
+bool PcapStream::open(const std::string& name, bool stamp, size_t max)
+{
+    base = name;
+    limit = max;
+
+    if ( !open_file(stamp) )
+        return false;
+
+    start();
+    return true;
+}
+
+void PcapStream::close()
+{
+    stop();
+
+    if ( fd >= 0 )
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool PcapStream::open_file(bool stamped)
+{
+    if ( stamped )
+    {
+        // don't reuse a name when rolling over more than once per second
+        stamp = std::max(time(nullptr), stamp + 1);
+        file = base + "." + std::to_string(stamp);
+    }
+    else
+        file = base;
+
+    fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    if ( fd < 0 )
+    {
+        ErrorMessage("can't open packet log %s: %s\n", file.c_str(), get_error(errno));
+        return false;
+    }
+
+    std::string hdr;
+
+    if ( ng )
+    {
+        std::string body;
+        put<uint32_t>(body, PCAPNG_MAGIC);
+        put<uint16_t>(body, 1);
+        put<uint16_t>(body, 0);
+        put<int64_t>(body, -1);     // section length is unknown
+        put_option(body, OPT_SHB_USERAPPL, "snort");
+        put<uint32_t>(body, OPT_END);
+        put_block(hdr, PCAPNG_SHB, body);
+
+        body.clear();
+        put<uint16_t>(body, linktype);
+        put<uint16_t>(body, 0);
+        put<uint32_t>(body, snaplen);
+
+        if ( !if_name.empty() )
+            put_option(body, OPT_IF_NAME, if_name);
+
+        put_option(body, OPT_IF_DESCRIPTION, "snort packet thread " +
+            std::to_string(instance));
+        put<uint32_t>(body, OPT_END);
+        put_block(hdr, PCAPNG_IDB, body);
+    }
+    else
+    {
+        put<uint32_t>(hdr, PCAP_MAGIC);
+        put<uint16_t>(hdr, 2);
+        put<uint16_t>(hdr, 4);
+        put<int32_t>(hdr, 0);
+        put<uint32_t>(hdr, 0);
+        put<uint32_t>(hdr, snaplen);
+        put<uint32_t>(hdr, linktype);
+    }
+
+    if ( ::write(fd, hdr.data(), hdr.size()) != (ssize_t)hdr.size() )
+        ErrorMessage("can't write packet log %s: %s\n", file.c_str(), get_error(errno));
+
+    current = hdr.size();
+    return true;
+}
+
+// the timestamp resolution is the default, microseconds, for both formats
+bool PcapStream::write(const struct timeval& ts, const uint8_t* pkt, unsigned caplen,
+    unsigned len)
+{
+    caplen = std::min(caplen, snaplen);
+
+    if ( ng )
+    {
+        uint32_t total = PCAPNG_EPB_SIZE + pad4(caplen);
+        uint8_t* rec = reserve(total);
+
+        if ( !rec )
+            return false;
+
+        uint64_t usec = (uint64_t)ts.tv_sec * 1000000 + ts.tv_usec;
+        uint32_t hdr[] = { PCAPNG_EPB, total, 0, (uint32_t)(usec >> 32), (uint32_t)usec, caplen, len };
+
+        memcpy(rec, hdr, sizeof(hdr));
+        memcpy(rec + PCAPNG_EPB_HDR, pkt, caplen);
+        memset(rec + PCAPNG_EPB_HDR + caplen, 0, pad4(caplen) - caplen);
+        memcpy(rec + total - 4, &total, 4);
+        commit(total);
+    }
+    else
+    {
+        uint32_t total = PCAP_REC_HDR + caplen;
+        uint8_t* rec = reserve(total);
+
+        if ( !rec )
+            return false;
+
+        uint32_t hdr[] = { (uint32_t)ts.tv_sec, (uint32_t)ts.tv_usec, caplen, len };
+
+        memcpy(rec, hdr, sizeof(hdr));
+        memcpy(rec + PCAP_REC_HDR, pkt, caplen);
+        commit(total);
+    }
+    return true;
+}
+
+bool PcapStream::check_size(unsigned len)
+{
+    if ( roll_requested.exchange(false) or (limit and current + len > limit) )
+    {
+        pending = len;
+        return true;
+    }
+    current += len;
+    return false;
+}
+
+// if the new file can't be opened the error is reported and the records
+// are discarded
+void PcapStream::roll()
+{
+    ::close(fd);
+    open_file(true);
+    current += pending;
+}
@@ -0,0 +1,94 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef PCAP_STREAM_H
+#define PCAP_STREAM_H
+
+// PcapStream writes packets to a pcap or pcapng file through a LogStream
+// so the packet thread only copies the packet into its ring and the log
+// writer thread does the file I/O.  A pcapng file has a single interface
+// block describing the packet thread that writes it.  Packets are dropped
+// instead of waiting unless the stream was created to block.
+
+#include <atomic>
+#include <ctime>
+#include <string>
+
+#include "log/log_writer.h"
+
+struct timeval;
+
+namespace snort
+{
+class SO_PUBLIC PcapStream : public LogStream
+{
+public:
+    // linktype is the LINKTYPE_* of the packets and snaplen the maximum
+    // number of bytes kept from each
+    PcapStream(int linktype, unsigned snaplen, bool ng, const char* if_name,
+        size_t ring_size, bool block);
+    ~PcapStream() override;
+
+    // the file is named base or base.<time> if stamped; limit is the size
+    // in bytes before rolling over to a new stamped file, 0 is unlimited
+    bool open(const std::string& base, bool stamp, size_t limit = 0);
+    void close();
+
+    // caplen bytes of the packet are available and up to snaplen are
+    // kept; returns false if the packet was dropped
+    bool write(const struct timeval&, const uint8_t* pkt, unsigned caplen, unsigned len);
+
+    // roll over before the next packet is written
+    void request_roll()
+    { roll_requested = true; }
+
+    // only valid while the stream is stopped
+    const std::string& get_file() const
+    { return file; }
+
+protected:
+    int get_fd() override
+    { return fd; }
+
+    bool check_size(unsigned) override;
+    void roll() override;
+
+private:
+    bool open_file(bool stamp);
+
+    std::string base;
+    std::string file;
+    std::string if_name;
+
+    size_t limit = 0;
+    size_t current = 0;
+    unsigned pending = 0;
+    time_t stamp = 0;
+    int fd = -1;
+
+    int linktype;
+    unsigned snaplen;
+    bool ng;
+
+    // the writer thread has no instance id of its own
+    unsigned instance;
+
+    std::atomic<bool> roll_requested { false };
+};
+}
+#endif
@@ -0,0 +1,340 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// log_writer_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "log/log_writer.h"
+#include "main/snort_config.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// stubs
+//-------------------------------------------------------------------------
+
+static unsigned errors = 0;
+
+namespace snort
+{
+const SnortConfig* SnortConfig::get_conf() { return nullptr; }
+void ErrorMessage(const char*, ...) { ++errors; }
+const char* get_error(int) { return ""; }
+}
+
+// writev is replaced so tests can make the fd write short; by default
+// it writes everything like the real one
+static ssize_t max_write = -1;
+static unsigned writev_calls = 0;
+
+extern "C" ssize_t writev(int fd, const struct iovec* iov, int count)
+{
+    ++writev_calls;
+
+    if ( max_write < 0 )
+        return syscall(SYS_writev, fd, iov, count);
+
+    if ( max_write == 0 or count == 0 )
+        return 0;
+
+    size_t len = std::min((size_t)max_write, iov->iov_len);
+    return syscall(SYS_write, fd, iov->iov_base, len);
+}
+
+//-------------------------------------------------------------------------
+// a stream writing to a temporary file; records are a 4 byte sequence
+// number, a 4 byte length and a payload derived from the sequence number
+//-------------------------------------------------------------------------
+
+class TestStream : public LogStream
+{
+public:
+    TestStream(unsigned max, size_t ring, bool block, size_t roll_at = 0) :
+        LogStream(max, ring, block), roll_at(roll_at)
+    { file = tmpfile(); }
+
+    ~TestStream() override
+    {
+        stop();
+        fclose(file);
+    }
+
+    bool put(uint32_t seq, uint32_t len)
+    {
+        uint8_t* rec = reserve(len);
+
+        if ( !rec )
+            return false;
+
+        memcpy(rec, &seq, sizeof(seq));
+        memcpy(rec + 4, &len, sizeof(len));
+
+        for ( uint32_t i = 8; i < len; i++ )
+            rec[i] = (uint8_t)(seq + i);
+
+        commit(len);
+        return true;
+    }
+
+    // returns the sequence numbers found, failing on a bad record
+    std::vector<uint32_t> get()
+    {
+        std::vector<uint32_t> seqs;
+        std::vector<uint8_t> buf(lseek(fileno(file), 0, SEEK_END));
+
+        CHECK(pread(fileno(file), buf.data(), buf.size(), 0) == (ssize_t)buf.size());
+
+        size_t pos = 0;
+
+        while ( pos < buf.size() )
+        {
+            uint32_t seq, len;
+            CHECK(pos + 8 <= buf.size());
+            memcpy(&seq, &buf[pos], sizeof(seq));
+            memcpy(&len, &buf[pos + 4], sizeof(len));
+            CHECK(len >= 8 and pos + len <= buf.size());
+
+            for ( uint32_t i = 8; i < len; i++ )
+                CHECK(buf[pos + i] == (uint8_t)(seq + i));
+
+            starts.emplace_back(pos);
+            seqs.emplace_back(seq);
+            pos += len;
+        }
+        return seqs;
+    }
+
+    bool at_start(size_t off) const
+    { return off == 0 or std::find(starts.begin(), starts.end(), off) != starts.end(); }
+
+    std::vector<size_t> rolls;
+
+protected:
+    int get_fd() override
+    { return fileno(file); }
+
+    bool check_size(unsigned len) override
+    {
+        if ( delay )
+            usleep(delay);
+
+        if ( roll_at and size + len > roll_at )
+        {
+            size = len;
+            return true;
+        }
+        size += len;
+        return false;
+    }
+
+    // remember where the file would have been rolled
+    void roll() override
+    { rolls.emplace_back(lseek(fileno(file), 0, SEEK_END)); }
+
+public:
+    unsigned delay = 0;
+
+private:
+    FILE* file;
+    size_t roll_at;
+    size_t size = 0;
+    std::vector<size_t> starts;
+};
+
+static std::vector<uint32_t> sequence(uint32_t n)
+{
+    std::vector<uint32_t> v;
+
+    for ( uint32_t i = 0; i < n; i++ )
+        v.emplace_back(i);
+
+    return v;
+}
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_GROUP(log_stream)
+{
+    void setup() override
+    {
+        memset(&log_writer_stats, 0, sizeof(log_writer_stats));
+        max_write = -1;
+        writev_calls = 0;
+        errors = 0;
+    }
+
+    void teardown() override
+    { max_write = -1; }
+};
+
+// records of varying lengths wrap around a small ring many times
+TEST(log_stream, ring_wrap)
+{
+    TestStream ls(64, 512, false);
+    uint32_t seq = 0;
+
+    for ( unsigned i = 0; i < 200; i++ )
+    {
+        for ( unsigned j = 0; j < 3; j++, seq++ )
+            CHECK(ls.put(seq, 8 + (seq * 7) % 57));
+
+        CHECK(ls.drain());
+        CHECK_FALSE(ls.drain());
+    }
+
+    CHECK(ls.get() == sequence(seq));
+    CHECK(log_writer_stats.records == seq);
+    CHECK(log_writer_stats.drops == 0);
+}
+
+// a full ring drops new records without waiting
+TEST(log_stream, overflow_drop)
+{
+    TestStream ls(64, 256, false);
+    uint32_t seq = 0;
+
+    while ( ls.put(seq, 48) )
+        seq++;
+
+    CHECK(seq > 0);
+    CHECK(log_writer_stats.drops == 1);
+    CHECK_FALSE(ls.put(seq, 48));
+    CHECK(log_writer_stats.drops == 2);
+    CHECK(log_writer_stats.waits == 0);
+
+    CHECK(ls.drain());
+    CHECK(ls.put(seq, 48));
+    CHECK(ls.drain());
+
+    CHECK(ls.get() == sequence(seq + 1));
+}
+
+// a full ring makes the packet thread wait for the writer thread
+TEST(log_stream, overflow_wait)
+{
+    TestStream ls(64, 256, true);
+    ls.delay = 200;
+    ls.start();
+
+    const uint32_t num = 100;
+
+    for ( uint32_t seq = 0; seq < num; seq++ )
+        CHECK(ls.put(seq, 48));
+
+    ls.stop();
+
+    CHECK(log_writer_stats.waits > 0);
+    CHECK(log_writer_stats.drops == 0);
+    CHECK(ls.get() == sequence(num));
+}
+
+// files are only rolled between records
+TEST(log_stream, record_never_split)
+{
+    TestStream ls(200, 2048, false, 300);
+    uint32_t seq = 0;
+
+    for ( unsigned i = 0; i < 50; i++ )
+    {
+        for ( unsigned j = 0; j < 4; j++, seq++ )
+            CHECK(ls.put(seq, 8 + (seq * 13) % 193));
+
+        ls.drain();
+    }
+
+    CHECK(ls.get() == sequence(seq));
+    CHECK(ls.rolls.size() > 10);
+
+    for ( auto off : ls.rolls )
+        CHECK(ls.at_start(off));
+}
+
+// a record too big for the ring is always dropped
+TEST(log_stream, too_big)
+{
+    TestStream ls(64, 128, true);
+
+    CHECK_FALSE(ls.put(0, 300));
+    CHECK(log_writer_stats.drops == 1);
+    CHECK(ls.put(1, 64));
+    CHECK(ls.drain());
+    CHECK(ls.get() == std::vector<uint32_t>{ 1 });
+}
+
+// partial writes, including ones ending inside a record, are resumed
+TEST(log_stream, short_write)
+{
+    TestStream ls(64, 2048, false);
+    max_write = 5;
+
+    for ( uint32_t seq = 0; seq < 20; seq++ )
+        CHECK(ls.put(seq, 8 + seq * 3));
+
+    CHECK(ls.drain());
+    max_write = -1;
+
+    CHECK(writev_calls > 20);
+    CHECK(errors == 0);
+    CHECK(ls.get() == sequence(20));
+}
+
+// an fd that takes nothing gives up after the retries instead of spinning
+TEST(log_stream, zero_write)
+{
+    TestStream ls(64, 512, false);
+    max_write = 0;
+
+    CHECK(ls.put(0, 32));
+    CHECK(ls.drain());
+
+    CHECK(writev_calls == 3);
+    CHECK(errors == 1);
+
+    // the error is only reported once
+    CHECK(ls.put(1, 32));
+    CHECK(ls.drain());
+    CHECK(errors == 1);
+
+    max_write = -1;
+    CHECK(ls.put(2, 32));
+    CHECK(ls.drain());
+    CHECK(ls.get() == std::vector<uint32_t>{ 2 });
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,313 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// pcap_stream_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "log/pcap_stream.h"
+#include "main/snort_config.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// stubs
+//-------------------------------------------------------------------------
+
+static unsigned errors = 0;
+
+namespace snort
+{
+const SnortConfig* SnortConfig::get_conf() { return nullptr; }
+void ErrorMessage(const char*, ...) { ++errors; }
+const char* get_error(int) { return ""; }
+unsigned get_instance_id() { return 3; }
+}
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+#define LINKTYPE_ETHERNET 1
+
+static std::string dir;
+
+static std::vector<uint8_t> read_file(const std::string& name)
+{
+    std::vector<uint8_t> buf;
+    FILE* f = fopen(name.c_str(), "rb");
+
+    CHECK(f != nullptr);
+
+    if ( !f )
+        return buf;
+
+    int c;
+
+    while ( (c = fgetc(f)) != EOF )
+        buf.emplace_back((uint8_t)c);
+
+    fclose(f);
+    return buf;
+}
+
+static uint16_t get16(const std::vector<uint8_t>& buf, size_t pos)
+{
+    uint16_t v = 0;
+    CHECK(pos + sizeof(v) <= buf.size());
+    memcpy(&v, &buf[pos], sizeof(v));
+    return v;
+}
+
+static uint32_t get32(const std::vector<uint8_t>& buf, size_t pos)
+{
+    uint32_t v = 0;
+    CHECK(pos + sizeof(v) <= buf.size());
+    memcpy(&v, &buf[pos], sizeof(v));
+    return v;
+}
+
+static std::string get_str(const std::vector<uint8_t>& buf, size_t pos, size_t len)
+{
+    CHECK(pos + len <= buf.size());
+    return std::string((const char*)&buf[pos], len);
+}
+
+// write the packets and return the file contents
+static std::vector<uint8_t> capture(bool ng, unsigned snaplen, const char* if_name,
+    const std::vector<unsigned>& caplens, unsigned len = 1500)
+{
+    PcapStream ps(LINKTYPE_ETHERNET, snaplen, ng, if_name, 4096, true);
+    CHECK(ps.open(dir + "/test.pcap", false));
+
+    uint8_t pkt[64];
+
+    for ( unsigned i = 0; i < sizeof(pkt); i++ )
+        pkt[i] = (uint8_t)(i + 1);
+
+    for ( unsigned i = 0; i < caplens.size(); i++ )
+    {
+        struct timeval ts = { (time_t)(1000 + i), (suseconds_t)(500 + i) };
+        CHECK(ps.write(ts, pkt, caplens[i], len));
+    }
+
+    ps.close();
+    return read_file(ps.get_file());
+}
+
+// check a packet's data and padding, returns the padded length
+static unsigned check_data(const std::vector<uint8_t>& buf, size_t pos, unsigned caplen,
+    unsigned padded)
+{
+    CHECK(pos + padded <= buf.size());
+
+    for ( unsigned i = 0; i < caplen; i++ )
+        CHECK(buf[pos + i] == (uint8_t)(i + 1));
+
+    for ( unsigned i = caplen; i < padded; i++ )
+        CHECK(buf[pos + i] == 0);
+
+    return padded;
+}
+
+// pcapng blocks are a 4 byte multiple with the length repeated at the end
+static size_t check_block(const std::vector<uint8_t>& buf, size_t pos, uint32_t type,
+    uint32_t len)
+{
+    CHECK(get32(buf, pos) == type);
+    CHECK(get32(buf, pos + 4) == len);
+    CHECK(len % 4 == 0);
+    CHECK(get32(buf, pos + len - 4) == len);
+    return pos + len;
+}
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_GROUP(pcap_stream)
+{
+    void setup() override
+    {
+        char tmp[] = "/tmp/pcap_stream_XXXXXX";
+        CHECK(mkdtemp(tmp) != nullptr);
+        dir = tmp;
+        errors = 0;
+    }
+
+    void teardown() override
+    {
+        std::string file = dir + "/test.pcap";
+        unlink(file.c_str());
+        rmdir(dir.c_str());
+        CHECK(errors == 0);
+    }
+};
+
+TEST(pcap_stream, pcap_header)
+{
+    std::vector<uint8_t> buf = capture(false, 1518, nullptr, { });
+
+    CHECK(buf.size() == 24);
+    CHECK(get32(buf, 0) == 0xa1b2c3d4);
+    CHECK(get16(buf, 4) == 2);
+    CHECK(get16(buf, 6) == 4);
+    CHECK(get32(buf, 8) == 0);
+    CHECK(get32(buf, 12) == 0);
+    CHECK(get32(buf, 16) == 1518);
+    CHECK(get32(buf, 20) == LINKTYPE_ETHERNET);
+}
+
+TEST(pcap_stream, pcap_records)
+{
+    std::vector<unsigned> caplens = { 60, 1, 0, 7 };
+    std::vector<uint8_t> buf = capture(false, 1518, nullptr, caplens, 1514);
+    size_t pos = 24;
+
+    for ( unsigned i = 0; i < caplens.size(); i++ )
+    {
+        CHECK(get32(buf, pos) == 1000 + i);
+        CHECK(get32(buf, pos + 4) == 500 + i);
+        CHECK(get32(buf, pos + 8) == caplens[i]);
+        CHECK(get32(buf, pos + 12) == 1514);
+        pos += 16;
+        pos += check_data(buf, pos, caplens[i], caplens[i]);
+    }
+    CHECK(pos == buf.size());
+}
+
+TEST(pcap_stream, pcap_snaplen)
+{
+    std::vector<uint8_t> buf = capture(false, 20, nullptr, { 64, 20, 19 }, 64);
+    size_t pos = 24;
+
+    CHECK(get32(buf, 16) == 20);
+
+    for ( unsigned caplen : { 20, 20, 19 } )
+    {
+        CHECK(get32(buf, pos + 8) == caplen);
+        CHECK(get32(buf, pos + 12) == 64);
+        pos += 16;
+        pos += check_data(buf, pos, caplen, caplen);
+    }
+    CHECK(pos == buf.size());
+}
+
+TEST(pcap_stream, pcapng_header)
+{
+    std::vector<uint8_t> buf = capture(true, 1518, "eth0", { });
+
+    // SHB: magic, version, section length, "snort" padded to 8, end
+    size_t pos = check_block(buf, 0, 0x0A0D0D0A, 44);
+    CHECK(get32(buf, 8) == 0x1A2B3C4D);
+    CHECK(get16(buf, 12) == 1);
+    CHECK(get16(buf, 14) == 0);
+    CHECK(get32(buf, 16) == 0xffffffff);
+    CHECK(get32(buf, 20) == 0xffffffff);
+    CHECK(get16(buf, 24) == 4);
+    CHECK(get16(buf, 26) == 5);
+    CHECK(get_str(buf, 28, 8) == std::string("snort\0\0\0", 8));
+    CHECK(get32(buf, 36) == 0);
+
+    // IDB: linktype, snaplen, name, description padded to 24, end
+    size_t idb = pos;
+    pos = check_block(buf, idb, 0x00000001, 60);
+    CHECK(get16(buf, idb + 8) == LINKTYPE_ETHERNET);
+    CHECK(get16(buf, idb + 10) == 0);
+    CHECK(get32(buf, idb + 12) == 1518);
+    CHECK(get16(buf, idb + 16) == 2);
+    CHECK(get16(buf, idb + 18) == 4);
+    CHECK(get_str(buf, idb + 20, 4) == "eth0");
+    CHECK(get16(buf, idb + 24) == 3);
+    CHECK(get16(buf, idb + 26) == 21);
+    CHECK(get_str(buf, idb + 28, 24) == std::string("snort packet thread 3\0\0\0", 24));
+    CHECK(get32(buf, idb + 52) == 0);
+
+    CHECK(pos == buf.size());
+}
+
+TEST(pcap_stream, pcapng_no_if_name)
+{
+    std::vector<uint8_t> buf = capture(true, 1518, nullptr, { });
+    size_t idb = check_block(buf, 0, 0x0A0D0D0A, 44);
+
+    CHECK(check_block(buf, idb, 0x00000001, 52) == buf.size());
+    CHECK(get16(buf, idb + 16) == 3);
+    CHECK(get16(buf, idb + 18) == 21);
+}
+
+TEST(pcap_stream, pcapng_records)
+{
+    std::vector<unsigned> caplens = { 60, 1, 2, 3, 4, 5, 0 };
+    std::vector<uint8_t> buf = capture(true, 1518, "eth0", caplens, 1514);
+    size_t pos = 44 + 60;
+
+    for ( unsigned i = 0; i < caplens.size(); i++ )
+    {
+        unsigned padded = (caplens[i] + 3) & ~3u;
+        uint32_t total = 32 + padded;
+        uint64_t usec = (uint64_t)(1000 + i) * 1000000 + 500 + i;
+        size_t next = check_block(buf, pos, 0x00000006, total);
+
+        CHECK(get32(buf, pos + 8) == 0);
+        CHECK(get32(buf, pos + 12) == (uint32_t)(usec >> 32));
+        CHECK(get32(buf, pos + 16) == (uint32_t)usec);
+        CHECK(get32(buf, pos + 20) == caplens[i]);
+        CHECK(get32(buf, pos + 24) == 1514);
+        check_data(buf, pos + 28, caplens[i], padded);
+        pos = next;
+    }
+    CHECK(pos == buf.size());
+}
+
+TEST(pcap_stream, pcapng_snaplen)
+{
+    std::vector<uint8_t> buf = capture(true, 18, nullptr, { 64, 18, 17 }, 64);
+    size_t pos = 44 + 52;
+
+    CHECK(get32(buf, 44 + 12) == 18);
+
+    for ( unsigned caplen : { 18, 18, 17 } )
+    {
+        size_t next = check_block(buf, pos, 0x00000006, 32 + 20);
+        CHECK(get32(buf, pos + 20) == caplen);
+        CHECK(get32(buf, pos + 24) == 64);
+        check_data(buf, pos + 28, caplen, 20);
+        pos = next;
+    }
+    CHECK(pos == buf.size());
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
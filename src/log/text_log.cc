@@ -35,11 +35,16 @@
 #include <time.h>
 
 #include <algorithm>
+#include <cerrno>
 #include <cstdarg>
+#include <string>
 
+#include "main/thread.h"
 #include "utils/util.h"
 
 #include "log.h"
+#include "log_writer.h"
+#include "messages.h"
 
 using namespace snort;
 
@@ -51,6 +56,7 @@ struct TextLog
 {
 /* private:
    file attributes: */
+    LogStream* stream;
     FILE* file;
     char* name;
     size_t size;
@@ -98,6 +104,70 @@ static size_t TextLog_Size(FILE* file)
     return err ? 0 : sbuf.st_size;
 }
 
+static void TextLog_Reopen(TextLog* const txt)
+{
+    TextLog_Close(txt->file);
+    RollAlertFile(txt->name);
+    txt->file = TextLog_Open(txt->name);
+
+    txt->last = time(nullptr);
+    txt->size = 0;
+}
+
+/*-------------------------------------------------------------------
+ * TextLogStream: the file attributes are only used by the log writer
+ * thread once the stream is started.  The instance file name is resolved
+ * on the packet thread.  If the file can't be reopened when it is
+ * rolled the error is reported and the stream's records are discarded.
+ *-------------------------------------------------------------------
+ */
+class TextLogStream : public LogStream
+{
+public:
+    TextLogStream(TextLog* txt) : LogStream(txt->maxBuf), txt(txt)
+    { get_instance_file(path, txt->name ? txt->name : "alert.txt"); }
+
+protected:
+    int get_fd() override
+    { return txt->file ? fileno(txt->file) : -1; }
+
+    bool check_size(unsigned len) override
+    {
+        if ( txt->maxFile and txt->size + len > txt->maxFile and txt->last < time(nullptr) )
+        {
+            pending = len;
+            return true;
+        }
+        txt->size += len;
+        return false;
+    }
+
+    void roll() override
+    {
+        if ( !txt->file )
+            return;
+
+        TextLog_Close(txt->file);
+        txt->file = nullptr;
+
+        std::string rolled = path + "." + std::to_string((unsigned long)time(nullptr));
+
+        if ( rename(path.c_str(), rolled.c_str()) )
+            ErrorMessage("log writer: can't roll %s: %s\n", path.c_str(), get_error(errno));
+
+        if ( !(txt->file = fopen(path.c_str(), "a")) )
+            ErrorMessage("log writer: can't open %s: %s\n", path.c_str(), get_error(errno));
+
+        txt->last = time(nullptr);
+        txt->size = pending;
+    }
+
+private:
+    TextLog* txt;
+    std::string path;
+    unsigned pending = 0;
+};
+
 namespace snort
 {
 int TextLog_Avail(TextLog* const txt)
@@ -116,7 +186,7 @@ void TextLog_Reset(TextLog* const txt)
  *-------------------------------------------------------------------
  */
 TextLog* TextLog_Init(
-    const char* name, unsigned int maxBuf, size_t maxFile)
+    const char* name, unsigned int maxBuf, size_t maxFile, bool async)
 {
     TextLog* txt;
 
@@ -134,6 +204,13 @@ TextLog* TextLog_Init(
     txt->maxBuf = maxBuf;
     TextLog_Reset(txt);
 
+    txt->stream = nullptr;
+
+    if ( async and txt->file != stdout and LogStream::enabled() )
+    {
+        txt->stream = new TextLogStream(txt);
+        txt->stream->start();
+    }
     return txt;
 }
 
@@ -147,6 +224,12 @@ void TextLog_Term(TextLog* const txt)
         return;
 
     TextLog_Flush(txt);
+
+    if ( txt->stream )
+    {
+        txt->stream->stop();
+        delete txt->stream;
+    }
     TextLog_Close(txt->file);
 
     if ( txt->name )
@@ -167,12 +250,7 @@ static void TextLog_Roll(TextLog* const txt)
     if ( txt->last >= time(nullptr) )
         return;
 
-    TextLog_Close(txt->file);
-    RollAlertFile(txt->name);
-    txt->file = TextLog_Open(txt->name);
-
-    txt->last = time(nullptr);
-    txt->size = 0;
+    TextLog_Reopen(txt);
 }
 
 /*-------------------------------------------------------------------
@@ -186,6 +264,13 @@ bool TextLog_Flush(TextLog* const txt)
     if ( !txt->pos )
         return false;
 
+    if ( txt->stream )
+    {
+        ok = txt->stream->write(txt->buf, txt->pos);
+        TextLog_Reset(txt);
+        return ok;
+    }
+
     if ( txt->maxFile and txt->size + txt->pos > txt->maxFile )
         TextLog_Roll(txt);
 
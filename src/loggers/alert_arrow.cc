@@ -0,0 +1,597 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// alert_arrow.cc author Cisco
+
+// alerts as Apache Arrow IPC streams for analytics ingestion.  each packet
+// thread accumulates rows in columns and writes a record batch when it is
+// full or old enough.  strings are dictionary encoded by default so a rule
+// message is written once per file instead of once per alert.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdio>
+#include <ctime>
+
+#include "detection/ips_context.h"
+#include "detection/signature.h"
+#include "events/event.h"
+#include "flow/flow.h"
+#include "flow/flow_key.h"
+#include "framework/logger.h"
+#include "framework/module.h"
+#include "helpers/arrow_stream.h"
+#include "log/messages.h"
+#include "main/snort_config.h"
+#include "main/thread.h"
+#include "packet_io/active.h"
+#include "protocols/icmp4.h"
+#include "protocols/packet.h"
+#include "protocols/tcp.h"
+#include "utils/util.h"
+
+using namespace snort;
+using namespace std;
+
+#define S_NAME "alert_arrow"
+#define F_NAME S_NAME ".arrows"
+
+//-------------------------------------------------------------------------
+// field functions
+//-------------------------------------------------------------------------
+
+struct Args
+{
+    Packet* pkt;
+    const char* msg;
+    const Event& event;
+    ArrowStream& out;
+    unsigned col;
+};
+
+static void put_string(const Args& a, const char* s)
+{ a.out.set_string(a.col, s, strlen(s)); }
+
+static void put_addr(const Args& a, const SfIp* ip)
+{
+    if ( ip and (a.pkt->has_ip() or a.pkt->is_data()) )
+        a.out.set_addr(a.col, (const uint8_t*)ip->get_ip6_ptr());
+}
+
+static void put_time(const Args& a, const struct timeval& tv)
+{ a.out.set_uint(a.col, (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec); }
+
+static void ff_action(const Args& a)
+{ put_string(a, a.pkt->active->get_action_string()); }
+
+static void ff_class(const Args& a)
+{
+    if ( a.event.sig_info->class_type and !a.event.sig_info->class_type->text.empty() )
+        put_string(a, a.event.sig_info->class_type->text.c_str());
+}
+
+static void ff_client_bytes(const Args& a)
+{
+    if ( a.pkt->flow )
+        a.out.set_uint(a.col, a.pkt->flow->flowstats.client_bytes);
+}
+
+static void ff_client_pkts(const Args& a)
+{
+    if ( a.pkt->flow )
+        a.out.set_uint(a.col, a.pkt->flow->flowstats.client_pkts);
+}
+
+static void ff_dir(const Args& a)
+{
+    if ( a.pkt->is_from_application_client() )
+        put_string(a, "C2S");
+
+    else if ( a.pkt->is_from_application_server() )
+        put_string(a, "S2C");
+
+    else
+        put_string(a, "UNK");
+}
+
+static void ff_dst_addr(const Args& a)
+{ put_addr(a, a.pkt->ptrs.ip_api.get_dst()); }
+
+static void ff_dst_port(const Args& a)
+{
+    if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
+        a.out.set_uint(a.col, a.pkt->ptrs.dp);
+}
+
+static void ff_flowstart_time(const Args& a)
+{
+    if ( a.pkt->flow )
+        put_time(a, a.pkt->flow->flowstats.start_time);
+}
+
+static void ff_gid(const Args& a)
+{ a.out.set_uint(a.col, a.event.sig_info->gid); }
+
+static void ff_icmp_code(const Args& a)
+{
+    if ( a.pkt->ptrs.icmph )
+        a.out.set_uint(a.col, a.pkt->ptrs.icmph->code);
+}
+
+static void ff_icmp_type(const Args& a)
+{
+    if ( a.pkt->ptrs.icmph )
+        a.out.set_uint(a.col, a.pkt->ptrs.icmph->type);
+}
+
+// rule messages are quoted
+static void ff_msg(const Args& a)
+{
+    const char* s = a.msg;
+    unsigned len = strlen(s);
+
+    if ( len >= 2 and s[0] == '"' and s[len - 1] == '"' )
+    {
+        ++s;
+        len -= 2;
+    }
+    a.out.set_string(a.col, s, len);
+}
+
+static void ff_mpls(const Args& a)
+{
+    if ( a.pkt->flow )
+        a.out.set_uint(a.col, a.pkt->flow->key->mplsLabel);
+
+    else if ( a.pkt->proto_bits & PROTO_BIT__MPLS )
+        a.out.set_uint(a.col, a.pkt->ptrs.mplsHdr.label);
+}
+
+static void ff_pkt_gen(const Args& a)
+{ put_string(a, a.pkt->get_pseudo_type()); }
+
+static void ff_pkt_len(const Args& a)
+{
+    if ( a.pkt->has_ip() )
+        a.out.set_uint(a.col, a.pkt->ptrs.ip_api.dgram_len());
+    else
+        a.out.set_uint(a.col, a.pkt->dsize);
+}
+
+static void ff_pkt_num(const Args& a)
+{ a.out.set_uint(a.col, a.pkt->context->packet_number); }
+
+static void ff_priority(const Args& a)
+{ a.out.set_uint(a.col, a.event.sig_info->priority); }
+
+static void ff_proto(const Args& a)
+{ put_string(a, a.pkt->get_type()); }
+
+static void ff_rev(const Args& a)
+{ a.out.set_uint(a.col, a.event.sig_info->rev); }
+
+static void ff_server_bytes(const Args& a)
+{
+    if ( a.pkt->flow )
+        a.out.set_uint(a.col, a.pkt->flow->flowstats.server_bytes);
+}
+
+static void ff_server_pkts(const Args& a)
+{
+    if ( a.pkt->flow )
+        a.out.set_uint(a.col, a.pkt->flow->flowstats.server_pkts);
+}
+
+static void ff_service(const Args& a)
+{
+    if ( a.pkt->flow and a.pkt->flow->service )
+        put_string(a, a.pkt->flow->service);
+}
+
+static void ff_sid(const Args& a)
+{ a.out.set_uint(a.col, a.event.sig_info->sid); }
+
+static void ff_src_addr(const Args& a)
+{ put_addr(a, a.pkt->ptrs.ip_api.get_src()); }
+
+static void ff_src_port(const Args& a)
+{
+    if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
+        a.out.set_uint(a.col, a.pkt->ptrs.sp);
+}
+
+static void ff_tcp_flags(const Args& a)
+{
+    if ( a.pkt->ptrs.tcph )
+        a.out.set_uint(a.col, a.pkt->ptrs.tcph->th_flags);
+}
+
+static void ff_timestamp(const Args& a)
+{ put_time(a, a.pkt->pkth->ts); }
+
+static void ff_tos(const Args& a)
+{
+    if ( a.pkt->has_ip() )
+        a.out.set_uint(a.col, a.pkt->ptrs.ip_api.tos());
+}
+
+static void ff_ttl(const Args& a)
+{
+    if ( a.pkt->has_ip() )
+        a.out.set_uint(a.col, a.pkt->ptrs.ip_api.ttl());
+}
+
+static void ff_vlan(const Args& a)
+{ a.out.set_uint(a.col, a.pkt->get_flow_vlan_id()); }
+
+//-------------------------------------------------------------------------
+// module stuff
+//-------------------------------------------------------------------------
+
+typedef void (*ArrowFunc)(const Args&);
+
+// strings are dictionary encoded unless configured otherwise
+#define STRING ArrowStream::DICT_UTF8
+
+// in arrow_range order
+
+struct ArrowField
+{
+    const char* name;
+    ArrowFunc func;
+    ArrowStream::Type type;
+};
+
+static const ArrowField arrow_fields[] =
+{
+    { "action", ff_action, STRING },
+    { "class", ff_class, STRING },
+    { "client_bytes", ff_client_bytes, ArrowStream::UINT64 },
+    { "client_pkts", ff_client_pkts, ArrowStream::UINT64 },
+    { "dir", ff_dir, STRING },
+    { "dst_addr", ff_dst_addr, ArrowStream::ADDR },
+    { "dst_port", ff_dst_port, ArrowStream::UINT16 },
+    { "flowstart_time", ff_flowstart_time, ArrowStream::TIMESTAMP_US },
+    { "gid", ff_gid, ArrowStream::UINT32 },
+    { "icmp_code", ff_icmp_code, ArrowStream::UINT8 },
+    { "icmp_type", ff_icmp_type, ArrowStream::UINT8 },
+    { "msg", ff_msg, STRING },
+    { "mpls", ff_mpls, ArrowStream::UINT32 },
+    { "pkt_gen", ff_pkt_gen, STRING },
+    { "pkt_len", ff_pkt_len, ArrowStream::UINT32 },
+    { "pkt_num", ff_pkt_num, ArrowStream::UINT64 },
+    { "priority", ff_priority, ArrowStream::UINT32 },
+    { "proto", ff_proto, STRING },
+    { "rev", ff_rev, ArrowStream::UINT32 },
+    { "server_bytes", ff_server_bytes, ArrowStream::UINT64 },
+    { "server_pkts", ff_server_pkts, ArrowStream::UINT64 },
+    { "service", ff_service, STRING },
+    { "sid", ff_sid, ArrowStream::UINT32 },
+    { "src_addr", ff_src_addr, ArrowStream::ADDR },
+    { "src_port", ff_src_port, ArrowStream::UINT16 },
+    { "tcp_flags", ff_tcp_flags, ArrowStream::UINT8 },
+    { "timestamp", ff_timestamp, ArrowStream::TIMESTAMP_US },
+    { "tos", ff_tos, ArrowStream::UINT8 },
+    { "ttl", ff_ttl, ArrowStream::UINT8 },
+    { "vlan", ff_vlan, ArrowStream::UINT16 },
+};
+
+#define arrow_range \
+    "action | class | client_bytes | client_pkts | dir | dst_addr | dst_port | " \
+    "flowstart_time | gid | icmp_code | icmp_type | msg | mpls | pkt_gen | pkt_len | " \
+    "pkt_num | priority | proto | rev | server_bytes | server_pkts | service | sid | " \
+    "src_addr | src_port | tcp_flags | timestamp | tos | ttl | vlan"
+
+#define arrow_deflt \
+    "timestamp pkt_num proto pkt_gen pkt_len dir src_addr src_port dst_addr dst_port " \
+    "gid sid rev priority msg class action service"
+
+static const Parameter s_params[] =
+{
+    { "batch_rows", Parameter::PT_INT, "1:65535", "1024",
+      "write a record batch when it has this many alerts" },
+
+    { "batch_time", Parameter::PT_INT, "0:max32", "1",
+      "write a partial record batch with the next alert after this many seconds (0 is never)" },
+
+    { "dictionary", Parameter::PT_BOOL, nullptr, "true",
+      "dictionary encode strings" },
+
+    { "fields", Parameter::PT_MULTI, arrow_range, arrow_deflt,
+      "selected fields will be output in given order left to right" },
+
+    { "limit", Parameter::PT_INT, "0:maxSZ", "0",
+      "set maximum size in MB before rollover (0 is unlimited)" },
+
+    { "rotate", Parameter::PT_INT, "0:max32", "0",
+      "set maximum age of a file in seconds before rollover (0 is unlimited)" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+#define s_help \
+    "output event in Apache Arrow IPC stream format files"
+
+class ArrowModule : public Module
+{
+public:
+    ArrowModule() : Module(S_NAME, s_help, s_params) { }
+
+    bool set(const char*, Value&, SnortConfig*) override;
+    bool begin(const char*, int, SnortConfig*) override;
+
+    Usage get_usage() const override
+    { return GLOBAL; }
+
+public:
+    unsigned batch_rows = 1024;
+    unsigned batch_time = 1;
+    bool dictionary = true;
+    size_t limit = 0;
+    unsigned rotate = 0;
+    vector<unsigned> fields;
+};
+
+static void set_fields(Value& v, vector<unsigned>& fields)
+{
+    string tok;
+    v.set_first_token();
+    fields.clear();
+
+    while ( v.get_next_token(tok) )
+    {
+        int i = Parameter::index(arrow_range, tok.c_str());
+        if ( i >= 0 )
+            fields.emplace_back(i);
+    }
+}
+
+bool ArrowModule::set(const char*, Value& v, SnortConfig*)
+{
+    if ( v.is("batch_rows") )
+        batch_rows = v.get_uint16();
+
+    else if ( v.is("batch_time") )
+        batch_time = v.get_uint32();
+
+    else if ( v.is("dictionary") )
+        dictionary = v.get_bool();
+
+    else if ( v.is("fields") )
+        set_fields(v, fields);
+
+    else if ( v.is("limit") )
+        limit = v.get_size() * 1024 * 1024;
+
+    else if ( v.is("rotate") )
+        rotate = v.get_uint32();
+
+    return true;
+}
+
+bool ArrowModule::begin(const char*, int, SnortConfig*)
+{
+    batch_rows = 1024;
+    batch_time = 1;
+    dictionary = true;
+    limit = 0;
+    rotate = 0;
+
+    if ( fields.empty() )
+    {
+        Value v(arrow_deflt);
+        set_fields(v, fields);
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// logger stuff
+//-------------------------------------------------------------------------
+
+struct ArrowLog
+{
+    ArrowStream stream;
+    string buf;
+    string path;
+    FILE* file = nullptr;
+    size_t size = 0;
+    time_t stamp = 0;
+    time_t opened = 0;      // packet time
+    time_t batched = 0;     // packet time of the first row
+};
+
+static THREAD_LOCAL ArrowLog* arrow_log = nullptr;
+
+class ArrowLogger : public Logger
+{
+public:
+    ArrowLogger(ArrowModule*);
+
+    void open() override;
+    void close() override;
+
+    void alert(Packet*, const char* msg, const Event&) override;
+
+private:
+    void open_file(ArrowLog&, time_t);
+    void close_file(ArrowLog&);
+    void write_batch(ArrowLog&);
+
+private:
+    vector<unsigned> fields;
+    unsigned batch_rows;
+    unsigned batch_time;
+    bool dictionary;
+    size_t limit;
+    unsigned rotate;
+};
+
+ArrowLogger::ArrowLogger(ArrowModule* m) : fields(std::move(m->fields)),
+    batch_rows(m->batch_rows), batch_time(m->batch_time), dictionary(m->dictionary),
+    limit(m->limit), rotate(m->rotate)
+{ }
+
+// each file is a stream with its own schema and dictionaries and the file
+// creation time appended to the name
+void ArrowLogger::open_file(ArrowLog& log, time_t now)
+{
+    // don't reuse a name when rolling over more than once per second
+    log.stamp = std::max(time(nullptr), log.stamp + 1);
+
+    string name = log.path + "." + to_string(log.stamp);
+    log.file = fopen(name.c_str(), "wb");
+
+    if ( !log.file )
+        FatalError("%s could not open %s: %s\n", S_NAME, name.c_str(), get_error(errno));
+
+    log.buf.clear();
+    log.stream.write_schema(log.buf);
+    log.size = fwrite(log.buf.data(), 1, log.buf.size(), log.file);
+    log.opened = now;
+}
+
+void ArrowLogger::close_file(ArrowLog& log)
+{
+    log.buf.clear();
+    log.stream.write_batch(log.buf);
+    ArrowStream::write_eos(log.buf);
+
+    fwrite(log.buf.data(), 1, log.buf.size(), log.file);
+    fclose(log.file);
+    log.file = nullptr;
+}
+
+void ArrowLogger::write_batch(ArrowLog& log)
+{
+    log.buf.clear();
+    log.stream.write_batch(log.buf);
+
+    if ( fwrite(log.buf.data(), 1, log.buf.size(), log.file) != log.buf.size() )
+        ErrorMessage("%s could not write: %s\n", S_NAME, get_error(errno));
+
+    fflush(log.file);
+    log.size += log.buf.size();
+}
+
+void ArrowLogger::open()
+{
+    ArrowLog* log = new ArrowLog;
+    get_instance_file(log->path, F_NAME);
+
+    for ( auto idx : fields )
+    {
+        ArrowStream::Type type = arrow_fields[idx].type;
+
+        if ( type == STRING and !dictionary )
+            type = ArrowStream::UTF8;
+
+        log->stream.add_column(arrow_fields[idx].name, type);
+    }
+    open_file(*log, 0);
+    arrow_log = log;
+}
+
+void ArrowLogger::close()
+{
+    if ( !arrow_log )
+        return;
+
+    close_file(*arrow_log);
+    delete arrow_log;
+    arrow_log = nullptr;
+}
+
+void ArrowLogger::alert(Packet* p, const char* msg, const Event& event)
+{
+    ArrowLog& log = *arrow_log;
+    time_t now = p->pkth->ts.tv_sec;
+
+    if ( !log.stream.get_rows() )
+        log.batched = now;
+
+    Args a = { p, msg, event, log.stream, 0 };
+
+    for ( auto idx : fields )
+    {
+        arrow_fields[idx].func(a);
+        ++a.col;
+    }
+    log.stream.end_row();
+
+    if ( log.stream.get_rows() < batch_rows and
+        (!batch_time or now - log.batched < (time_t)batch_time) )
+        return;
+
+    write_batch(log);
+
+    if ( !log.opened )
+        log.opened = now;
+
+    if ( (limit and log.size >= limit) or (rotate and now - log.opened >= (time_t)rotate) )
+    {
+        close_file(log);
+        open_file(log, now);
+    }
+}
+
+//-------------------------------------------------------------------------
+// api stuff
+//-------------------------------------------------------------------------
+
+static Module* mod_ctor()
+{ return new ArrowModule; }
+
+static void mod_dtor(Module* m)
+{ delete m; }
+
+static Logger* arrow_ctor(Module* mod)
+{ return new ArrowLogger((ArrowModule*)mod); }
+
+static void arrow_dtor(Logger* p)
+{ delete p; }
+
+static LogApi arrow_api
+{
+    {
+        PT_LOGGER,
+        sizeof(LogApi),
+        LOGAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        S_NAME,
+        s_help,
+        mod_ctor,
+        mod_dtor
+    },
+    OUTPUT_TYPE_FLAG__ALERT,
+    arrow_ctor,
+    arrow_dtor
+};
+
+#ifdef BUILDING_SO
+SO_PUBLIC const BaseApi* snort_plugins[] =
+#else
+const BaseApi* alert_arrow[] =
+#endif
+{
+    &arrow_api.base,
+    nullptr
+};
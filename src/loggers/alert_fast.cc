@@ -217,7 +217,7 @@ const BufferIds& FastLogger::get_buffer_ids(Inspector* gadget, Packet* p)
 void FastLogger::open()
 {
     unsigned sz = packet ? FULL_BUF : FAST_BUF;
-    fast_log = TextLog_Init(file.c_str(), sz, limit);
+    fast_log = TextLog_Init(file.c_str(), sz, limit, true);
 }
 
 void FastLogger::close()
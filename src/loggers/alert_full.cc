@@ -134,7 +134,7 @@ FullLogger::FullLogger(FullModule* m) : file(m->file ? F_NAME : "stdout"), limit
 
 void FullLogger::open()
 {
-    full_log = TextLog_Init(file.c_str(), LOG_BUFFER, limit);
+    full_log = TextLog_Init(file.c_str(), LOG_BUFFER, limit, true);
 }
 
 void FullLogger::close()
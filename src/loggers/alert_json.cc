@@ -37,6 +37,7 @@
 #include "framework/logger.h"
 #include "framework/module.h"
 #include "helpers/base64_encoder.h"
+#include "helpers/json_writer.h"
 #include "log/log.h"
 #include "log/log_text.h"
 #include "log/text_log.h"
@@ -49,6 +50,7 @@
 #include "protocols/udp.h"
 #include "protocols/vlan.h"
 #include "utils/stats.h"
+#include "utils/util.h"
 
 using namespace snort;
 using namespace std;
@@ -69,21 +71,65 @@ struct Args
     Packet* pkt;
     const char* msg;
     const Event& event;
-    bool comma;
+    JsonWriter& out;
+    const string* label;
 };
 
-static void print_label(const Args& a, const char* label)
+// the label includes the leading separator, see JsonLogger::JsonLogger()
+static void print_label(const Args& a)
+{ a.out.put(a.label->data(), a.label->size()); }
+
+// ntop is relatively expensive and consecutive alerts tend to have the same
+// few addresses so the strings are cached per thread, direct mapped
+#define ADDR_CACHE_SIZE 64
+
+struct AddrString
 {
-    if ( a.comma )
-        TextLog_Print(json_log, ",");
+    SfIp ip;
+    unsigned len;
+    SfIpString str;
+};
 
-    TextLog_Print(json_log, " \"%s\" : ", label);
+static THREAD_LOCAL AddrString* addr_cache = nullptr;
+
+static void put_addr(const Args& a, const SfIp* ip)
+{
+    if ( !ip )
+        return;
+
+    const uint32_t* w = ip->get_ip6_ptr();
+    uint32_t h = w[0] ^ w[1] ^ w[2] ^ w[3];
+    h ^= (h >> 16) ^ (h >> 8);
+
+    AddrString& as = addr_cache[h & (ADDR_CACHE_SIZE - 1)];
+
+    // an IPv4 address and its mapped IPv6 form hash alike but print differently
+    if ( !as.len or as.ip.get_family() != ip->get_family() or !as.ip.fast_equals_raw(*ip) )
+    {
+        as.ip = *ip;
+        as.len = strlen(ip->ntop(as.str));
+    }
+    a.out.put(as.str, as.len);
+}
+
+static void put_mac(const Args& a, const uint8_t* mac)
+{
+    a.out.put('"');
+
+    for ( unsigned i = 0; i < 6; ++i )
+    {
+        if ( i )
+            a.out.put(':');
+
+        a.out.put_hex(mac[i], 2);
+    }
+    a.out.put('"');
 }
 
 static bool ff_action(const Args& a)
 {
-    print_label(a, "action");
-    TextLog_Quote(json_log, a.pkt->active->get_action_string());
+    print_label(a);
+    a.out.put_quoted(a.pkt->active->get_action_string());
     return true;
 }
 
@@ -94,8 +140,8 @@ static bool ff_class(const Args& a)
     if ( a.event.sig_info->class_type and !a.event.sig_info->class_type->text.empty() )
         cls = a.event.sig_info->class_type->text.c_str();
 
-    print_label(a, "class");
-    TextLog_Quote(json_log, cls);
+    print_label(a);
+    a.out.put_quoted(cls);
     return true;
 }
 
@@ -111,21 +157,21 @@ static bool ff_b64_data(const Args& a)
     unsigned nin = 0;
     Base64Encoder b64;
 
-    print_label(a, "b64_data");
-    TextLog_Putc(json_log, '"');
+    print_label(a);
+    a.out.put('"');
 
     while ( nin < a.pkt->dsize )
     {
         unsigned kin = min(a.pkt->dsize-nin, block_size);
         unsigned kout = b64.encode(in+nin, kin, out);
-        TextLog_Write(json_log, out, kout);
+        a.out.put(out, kout);
         nin += kin;
     }
 
     if ( unsigned kout = b64.finish(out) )
-        TextLog_Write(json_log, out, kout);
+        a.out.put(out, kout);
 
-    TextLog_Putc(json_log, '"');
+    a.out.put('"');
     return true;
 }
 
@@ -133,8 +179,8 @@ static bool ff_client_bytes(const Args& a)
 {
     if (a.pkt->flow)
     {
-        print_label(a, "client_bytes");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.client_bytes);
+        print_label(a);
+        a.out.put_uint(a.pkt->flow->flowstats.client_bytes);
         return true;
     }
     return false;
@@ -144,8 +190,8 @@ static bool ff_client_pkts(const Args& a)
 {
     if (a.pkt->flow)
     {
-        print_label(a, "client_pkts");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.client_pkts);
+        print_label(a);
+        a.out.put_uint(a.pkt->flow->flowstats.client_pkts);
         return true;
     }
     return false;
@@ -162,8 +208,8 @@ static bool ff_dir(const Args& a)
     else
         dir = "UNK";
 
-    print_label(a, "dir");
-    TextLog_Quote(json_log, dir);
+    print_label(a);
+    a.out.put_quoted(dir);
     return true;
 }
 
@@ -171,9 +217,10 @@ static bool ff_dst_addr(const Args& a)
 {
     if ( a.pkt->has_ip() or a.pkt->is_data() )
     {
-        SfIpString ip_str;
-        print_label(a, "dst_addr");
-        TextLog_Quote(json_log, a.pkt->ptrs.ip_api.get_dst()->ntop(ip_str));
+        print_label(a);
+        a.out.put('"');
+        put_addr(a, a.pkt->ptrs.ip_api.get_dst());
+        a.out.put('"');
         return true;
     }
     return false;
@@ -181,17 +228,20 @@ static bool ff_dst_addr(const Args& a)
 
 static bool ff_dst_ap(const Args& a)
 {
-    SfIpString addr = "";
     unsigned port = 0;
 
-    if ( a.pkt->has_ip() or a.pkt->is_data() )
-        a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
-
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
         port = a.pkt->ptrs.dp;
 
-    print_label(a, "dst_ap");
-    TextLog_Print(json_log, "\"%s:%u\"", addr, port);
+    print_label(a);
+    a.out.put('"');
+
+    if ( a.pkt->has_ip() or a.pkt->is_data() )
+        put_addr(a, a.pkt->ptrs.ip_api.get_dst());
+
+    a.out.put(':');
+    a.out.put_uint(port);
+    a.out.put('"');
     return true;
 }
 
@@ -199,8 +249,8 @@ static bool ff_dst_port(const Args& a)
 {
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
     {
-        print_label(a, "dst_port");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.dp);
+        print_label(a);
+        a.out.put_uint(a.pkt->ptrs.dp);
         return true;
     }
     return false;
@@ -211,12 +261,10 @@ static bool ff_eth_dst(const Args& a)
     if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
         return false;
 
-    print_label(a, "eth_dst");
+    print_label(a);
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
-    TextLog_Print(json_log, "\"%02X:%02X:%02X:%02X:%02X:%02X\"", eh->ether_dst[0],
-        eh->ether_dst[1], eh->ether_dst[2], eh->ether_dst[3],
-        eh->ether_dst[4], eh->ether_dst[5]);
+    put_mac(a, eh->ether_dst);
 
     return true;
 }
@@ -226,8 +274,8 @@ static bool ff_eth_len(const Args& a)
     if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
         return false;
 
-    print_label(a, "eth_len");
-    TextLog_Print(json_log, "%u", a.pkt->pkth->pktlen);
+    print_label(a);
+    a.out.put_uint(a.pkt->pkth->pktlen);
     return true;
 }
 
@@ -236,12 +284,10 @@ static bool ff_eth_src(const Args& a)
     if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
         return false;
 
-    print_label(a, "eth_src");
+    print_label(a);
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
-    TextLog_Print(json_log, "\"%02X:%02X:%02X:%02X:%02X:%02X\"", eh->ether_src[0],
-        eh->ether_src[1], eh->ether_src[2], eh->ether_src[3],
-        eh->ether_src[4], eh->ether_src[5]);
+    put_mac(a, eh->ether_src);
     return true;
 }
 
@@ -252,8 +298,10 @@ static bool ff_eth_type(const Args& a)
 
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
-    print_label(a, "eth_type");
-    TextLog_Print(json_log, "\"0x%X\"", ntohs(eh->ether_type));
+    print_label(a);
+    a.out.put("\"0x", 3);
+    a.out.put_hex(ntohs(eh->ether_type));
+    a.out.put('"');
     return true;
 }
 
@@ -261,8 +309,8 @@ static bool ff_flowstart_time(const Args& a)
 {
     if (a.pkt->flow)
     {
-        print_label(a, "flowstart_time");
-        TextLog_Print(json_log, "%ld", a.pkt->flow->flowstats.start_time.tv_sec);
+        print_label(a);
+        a.out.put_int(a.pkt->flow->flowstats.start_time.tv_sec);
         return true;
     }
     return false;
@@ -272,16 +320,16 @@ static bool ff_geneve_vni(const Args& a)
 {
     if (a.pkt->proto_bits & PROTO_BIT__GENEVE)
     {
-        print_label(a, "geneve_vni");
-        TextLog_Print(json_log, "%u", a.pkt->get_flow_geneve_vni());
+        print_label(a);
+        a.out.put_uint(a.pkt->get_flow_geneve_vni());
     }
     return true;
 }
 
 static bool ff_gid(const Args& a)
 {
-    print_label(a, "gid");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->gid);
+    print_label(a);
+    a.out.put_uint(a.event.sig_info->gid);
     return true;
 }
 
@@ -289,8 +337,8 @@ static bool ff_icmp_code(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
     {
-        print_label(a, "icmp_code");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.icmph->code);
+        print_label(a);
+        a.out.put_uint(a.pkt->ptrs.icmph->code);
         return true;
     }
     return false;
@@ -300,8 +348,8 @@ static bool ff_icmp_id(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
     {
-        print_label(a, "icmp_id");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_id));
+        print_label(a);
+        a.out.put_uint(ntohs(a.pkt->ptrs.icmph->s_icmp_id));
         return true;
     }
     return false;
@@ -311,8 +359,8 @@ static bool ff_icmp_seq(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
     {
-        print_label(a, "icmp_seq");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_seq));
+        print_label(a);
+        a.out.put_uint(ntohs(a.pkt->ptrs.icmph->s_icmp_seq));
         return true;
     }
     return false;
@@ -322,8 +370,8 @@ static bool ff_icmp_type(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
     {
-        print_label(a, "icmp_type");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.icmph->type);
+        print_label(a);
+        a.out.put_uint(a.pkt->ptrs.icmph->type);
         return true;
     }
     return false;
@@ -331,8 +379,8 @@ static bool ff_icmp_type(const Args& a)
 
 static bool ff_iface(const Args& a)
 {
-    print_label(a, "iface");
-    TextLog_Quote(json_log, SFDAQ::get_input_spec());
+    print_label(a);
+    a.out.put_quoted(SFDAQ::get_input_spec());
     return true;
 }
 
@@ -340,8 +388,8 @@ static bool ff_ip_id(const Args& a)
 {
     if (a.pkt->has_ip())
     {
-        print_label(a, "ip_id");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.id());
+        print_label(a);
+        a.out.put_uint(a.pkt->ptrs.ip_api.id());
         return true;
     }
     return false;
@@ -351,8 +399,8 @@ static bool ff_ip_len(const Args& a)
 {
     if (a.pkt->has_ip())
     {
-        print_label(a, "ip_len");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.pay_len());
+        print_label(a);
+        a.out.put_uint(a.pkt->ptrs.ip_api.pay_len());
         return true;
     }
     return false;
@@ -360,8 +408,8 @@ static bool ff_ip_len(const Args& a)
 
 static bool ff_msg(const Args& a)
 {
-    print_label(a, "msg");
-    TextLog_Puts(json_log, a.msg);
+    print_label(a);
+    a.out.put(a.msg);
     return true;
 }
 
@@ -378,72 +426,77 @@ static bool ff_mpls(const Args& a)
     else
         return false;
 
-    print_label(a, "mpls");
-    TextLog_Print(json_log, "%u", mpls);
+    print_label(a);
+    a.out.put_uint(mpls);
     return true;
 }
 
 static bool ff_pkt_gen(const Args& a)
 {
-    print_label(a, "pkt_gen");
-    TextLog_Quote(json_log, a.pkt->get_pseudo_type());
+    print_label(a);
+    a.out.put_quoted(a.pkt->get_pseudo_type());
     return true;
 }
 
 static bool ff_pkt_len(const Args& a)
 {
-    print_label(a, "pkt_len");
+    print_label(a);
 
     if (a.pkt->has_ip())
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.dgram_len());
+        a.out.put_uint(a.pkt->ptrs.ip_api.dgram_len());
     else
-        TextLog_Print(json_log, "%u", a.pkt->dsize);
+        a.out.put_uint(a.pkt->dsize);
 
     return true;
 }
 
 static bool ff_pkt_num(const Args& a)
 {
-    print_label(a, "pkt_num");
-    TextLog_Print(json_log, STDu64, a.pkt->context->packet_number);
+    print_label(a);
+    a.out.put_uint(a.pkt->context->packet_number);
     return true;
 }
 
 static bool ff_priority(const Args& a)
 {
-    print_label(a, "priority");
-    TextLog_Print(json_log, "%u", a.event.sig_info->priority);
+    print_label(a);
+    a.out.put_uint(a.event.sig_info->priority);
     return true;
 }
 
 static bool ff_proto(const Args& a)
 {
-    print_label(a, "proto");
-    TextLog_Quote(json_log, a.pkt->get_type());
+    print_label(a);
+    a.out.put_quoted(a.pkt->get_type());
     return true;
 }
 
 static bool ff_rev(const Args& a)
 {
-    print_label(a, "rev");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->rev);
+    print_label(a);
+    a.out.put_uint(a.event.sig_info->rev);
     return true;
 }
 
 static bool ff_rule(const Args& a)
 {
-    print_label(a, "rule");
+    print_label(a);
 
-    TextLog_Print(json_log, "\"%u:%u:%u\"",
-        a.event.sig_info->gid, a.event.sig_info->sid, a.event.sig_info->rev);
+    a.out.put('"');
+    a.out.put_uint(a.event.sig_info->gid);
+    a.out.put(':');
+    a.out.put_uint(a.event.sig_info->sid);
+    a.out.put(':');
+    a.out.put_uint(a.event.sig_info->rev);
+    a.out.put('"');
 
     return true;
 }
 
 static bool ff_seconds(const Args& a)
 {
-    print_label(a, "seconds");
-    TextLog_Print(json_log, "%ld",  a.pkt->pkth->ts.tv_sec);
+    print_label(a);
+    a.out.put_int(a.pkt->pkth->ts.tv_sec);
     return true;
 }
 
@@ -451,8 +504,8 @@ static bool ff_server_bytes(const Args& a)
 {
     if (a.pkt->flow)
     {
-        print_label(a, "server_bytes");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.server_bytes);
+        print_label(a);
+        a.out.put_uint(a.pkt->flow->flowstats.server_bytes);
         return true;
     }
     return false;
@@ -462,8 +515,8 @@ static bool ff_server_pkts(const Args& a)
 {
     if (a.pkt->flow)
     {
-        print_label(a, "server_pkts");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.server_pkts);
+        print_label(a);
+        a.out.put_uint(a.pkt->flow->flowstats.server_pkts);
         return true;
     }
     return false;
@@ -476,8 +529,8 @@ static bool ff_service(const Args& a)
     if ( a.pkt->flow and a.pkt->flow->service )
         svc = a.pkt->flow->service;
 
-    print_label(a, "service");
-    TextLog_Quote(json_log, svc);
+    print_label(a);
+    a.out.put_quoted(svc);
     return true;
 }
 
@@ -486,8 +539,8 @@ static bool ff_sgt(const Args& a)
     if (a.pkt->proto_bits & PROTO_BIT__CISCO_META_DATA)
     {
         const cisco_meta_data::CiscoMetaDataHdr* cmdh = layer::get_cisco_meta_data_layer(a.pkt);
-        print_label(a, "sgt");
-        TextLog_Print(json_log, "%hu", cmdh->sgt_val());
+        print_label(a);
+        a.out.put_uint(cmdh->sgt_val());
         return true;
     }
     return false;
@@ -495,8 +548,8 @@ static bool ff_sgt(const Args& a)
 
 static bool ff_sid(const Args& a)
 {
-    print_label(a, "sid");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->sid);
+    print_label(a);
+    a.out.put_uint(a.event.sig_info->sid);
     return true;
 }
 
@@ -504,9 +557,10 @@ static bool ff_src_addr(const Args& a)
 {
     if ( a.pkt->has_ip() or a.pkt->is_data() )
     {
-        SfIpString ip_str;
-        print_label(a, "src_addr");
-        TextLog_Quote(json_log, a.pkt->ptrs.ip_api.get_src()->ntop(ip_str));
+        print_label(a);
+        a.out.put('"');
+        put_addr(a, a.pkt->ptrs.ip_api.get_src());
+        a.out.put('"');
         return true;
     }
     return false;
@@ -514,17 +568,20 @@ static bool ff_src_addr(const Args& a)
 
 static bool ff_src_ap(const Args& a)
 {
-    SfIpString addr = "";
     unsigned port = 0;
 
-    if ( a.pkt->has_ip() or a.pkt->is_data() )
-        a.pkt->ptrs.ip_api.get_src()->ntop(addr);
-
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
         port = a.pkt->ptrs.sp;
 
-    print_label(a, "src_ap");
-    TextLog_Print(json_log, "\"%s:%u\"", addr, port);
+    print_label(a);
+    a.out.put('"');
+
+    if ( a.pkt->has_ip() or a.pkt->is_data() )
+        put_addr(a, a.pkt->ptrs.ip_api.get_src());
+
+    a.out.put(':');
+    a.out.put_uint(port);
+    a.out.put('"');
     return true;
 }
 
@@ -532,8 +589,8 @@ static bool ff_src_port(const Args& a)
 {
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
     {
-        print_label(a, "src_port");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.sp);
+        print_label(a);
+        a.out.put_uint(a.pkt->ptrs.sp);
         return true;
     }
     return false;
@@ -541,19 +598,21 @@ static bool ff_src_port(const Args& a)
 
 static bool ff_target(const Args& a)
 {
-    SfIpString addr = "";
+    const SfIp* addr;
 
     if ( a.event.sig_info->target == TARGET_SRC )
-        a.pkt->ptrs.ip_api.get_src()->ntop(addr);
+        addr = a.pkt->ptrs.ip_api.get_src();
 
     else if ( a.event.sig_info->target == TARGET_DST )
-        a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
+        addr = a.pkt->ptrs.ip_api.get_dst();
 
     else
         return false;
 
-    print_label(a, "target");
-    TextLog_Quote(json_log, addr);
+    print_label(a);
+    a.out.put('"');
+    put_addr(a, addr);
+    a.out.put('"');
     return true;
 }
 
@@ -561,8 +620,8 @@ static bool ff_tcp_ack(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
     {
-        print_label(a, "tcp_ack");
-        TextLog_Print(json_log, "%u", ntohl(a.pkt->ptrs.tcph->th_ack));
+        print_label(a);
+        a.out.put_uint(ntohl(a.pkt->ptrs.tcph->th_ack));
         return true;
     }
     return false;
@@ -575,8 +634,8 @@ static bool ff_tcp_flags(const Args& a)
         char tcpFlags[9];
         CreateTCPFlagString(a.pkt->ptrs.tcph, tcpFlags);
 
-        print_label(a, "tcp_flags");
-        TextLog_Quote(json_log, tcpFlags);
+        print_label(a);
+        a.out.put_quoted(tcpFlags);
         return true;
     }
     return false;
@@ -586,8 +645,8 @@ static bool ff_tcp_len(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
     {
-        print_label(a, "tcp_len");
-        TextLog_Print(json_log, "%u", (a.pkt->ptrs.tcph->off()));
+        print_label(a);
+        a.out.put_uint((a.pkt->ptrs.tcph->off()));
         return true;
     }
     return false;
@@ -597,8 +656,8 @@ static bool ff_tcp_seq(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
     {
-        print_label(a, "tcp_seq");
-        TextLog_Print(json_log, "%u", ntohl(a.pkt->ptrs.tcph->th_seq));
+        print_label(a);
+        a.out.put_uint(ntohl(a.pkt->ptrs.tcph->th_seq));
         return true;
     }
     return false;
@@ -608,8 +667,8 @@ static bool ff_tcp_win(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
     {
-        print_label(a, "tcp_win");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.tcph->th_win));
+        print_label(a);
+        a.out.put_uint(ntohs(a.pkt->ptrs.tcph->th_win));
         return true;
     }
     return false;
@@ -617,10 +676,12 @@ static bool ff_tcp_win(const Args& a)
 
 static bool ff_timestamp(const Args& a)
 {
-    print_label(a, "timestamp");
-    TextLog_Putc(json_log, '"');
-    LogTimeStamp(json_log, a.pkt);
-    TextLog_Putc(json_log, '"');
+    print_label(a);
+    char timestamp[TIMEBUF_SIZE];
+    ts_print((const struct timeval*)&a.pkt->pkth->ts, timestamp);
+    a.out.put('"');
+    a.out.put(timestamp);
+    a.out.put('"');
     return true;
 }
 
@@ -628,8 +689,8 @@ static bool ff_tos(const Args& a)
 {
     if (a.pkt->has_ip())
     {
-        print_label(a, "tos");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.tos());
+        print_label(a);
+        a.out.put_uint(a.pkt->ptrs.ip_api.tos());
         return true;
     }
     return false;
@@ -639,8 +700,8 @@ static bool ff_ttl(const Args& a)
 {
     if (a.pkt->has_ip())
     {
-        print_label(a, "ttl");
-        TextLog_Print(json_log, "%u",a.pkt->ptrs.ip_api.ttl());
+        print_label(a);
+        a.out.put_uint(a.pkt->ptrs.ip_api.ttl());
         return true;
     }
     return false;
@@ -650,8 +711,8 @@ static bool ff_udp_len(const Args& a)
 {
     if (a.pkt->ptrs.udph )
     {
-        print_label(a, "udp_len");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.udph->uh_len));
+        print_label(a);
+        a.out.put_uint(ntohs(a.pkt->ptrs.udph->uh_len));
         return true;
     }
     return false;
@@ -659,8 +720,8 @@ static bool ff_udp_len(const Args& a)
 
 static bool ff_vlan(const Args& a)
 {
-    print_label(a, "vlan");
-    TextLog_Print(json_log, "%hu", a.pkt->get_flow_vlan_id());
+    print_label(a);
+    a.out.put_uint(a.pkt->get_flow_vlan_id());
     return true;
 }
 
@@ -730,7 +791,7 @@ public:
     bool file = false;
     size_t limit = 0;
     string sep;
-    vector<JsonFunc> fields;
+    vector<unsigned> fields;
 };
 
 bool JsonModule::set(const char*, Value& v, SnortConfig*)
@@ -748,7 +809,7 @@ bool JsonModule::set(const char*, Value& v, SnortConfig*)
         {
             int i = Parameter::index(json_range, tok.c_str());
             if ( i >= 0 )
-                fields.emplace_back(json_func[i]);
+                fields.emplace_back(i);
         }
     }
 
@@ -777,7 +838,7 @@ bool JsonModule::begin(const char*, int, SnortConfig*)
         {
             int i = Parameter::index(json_range, tok.c_str());
             if ( i >= 0 )
-                fields.emplace_back(json_func[i]);
+                fields.emplace_back(i);
         }
     }
     return true;
@@ -787,6 +848,17 @@ bool JsonModule::begin(const char*, int, SnortConfig*)
 // logger stuff
 //-------------------------------------------------------------------------
 
+// each field is compiled to its function and the label text so that an
+// alert is built with appends only; the first label has no comma
+struct JsonField
+{
+    JsonFunc func;
+    string first;
+    string next;
+};
+
+static THREAD_LOCAL string* json_buf = nullptr;
+
 class JsonLogger : public Logger
 {
 public:
@@ -800,36 +872,72 @@ public:
 public:
     string file;
     unsigned long limit;
-    vector<JsonFunc> fields;
+    vector<JsonField> fields;
     string sep;
 };
 
-JsonLogger::JsonLogger(JsonModule* m) : file(m->file ? F_NAME : "stdout"), limit(m->limit), fields(std::move(m->fields)), sep(m->sep)
-{ }
+// the name of the given json_range index
+static string get_name(unsigned idx)
+{
+    const char* s = json_range;
+
+    while ( idx-- )
+        s = strchr(s, '|') + 1;
+
+    while ( *s == ' ' )
+        ++s;
+
+    return string(s, strcspn(s, " |"));
+}
+
+JsonLogger::JsonLogger(JsonModule* m) : file(m->file ? F_NAME : "stdout"), limit(m->limit), sep(m->sep)
+{
+    for ( auto idx : m->fields )
+    {
+        string label = " \"" + get_name(idx) + "\" : ";
+        fields.push_back({ json_func[idx], label, "," + label });
+    }
+    m->fields.clear();
+}
 
 void JsonLogger::open()
 {
-    json_log = TextLog_Init(file.c_str(), LOG_BUFFER, limit);
+    json_log = TextLog_Init(file.c_str(), LOG_BUFFER, limit, true);
+
+    json_buf = new string;
+    json_buf->reserve(LOG_BUFFER);
+
+    addr_cache = new AddrString[ADDR_CACHE_SIZE]();
 }
 
 void JsonLogger::close()
 {
     if ( json_log )
         TextLog_Term(json_log);
+
+    delete json_buf;
+    json_buf = nullptr;
+
+    delete[] addr_cache;
+    addr_cache = nullptr;
 }
 
 void JsonLogger::alert(Packet* p, const char* msg, const Event& event)
 {
-    Args a = { p, msg, event, false };
-    TextLog_Putc(json_log, '{');
+    json_buf->clear();
+    JsonWriter out(*json_buf);
+
+    Args a = { p, msg, event, out, nullptr };
+    out.put('{');
 
-    for ( JsonFunc f : fields )
+    for ( const auto& f : fields )
     {
-        f(a);
-        a.comma = true;
+        a.label = (&f == fields.data()) ? &f.first : &f.next;
+        f.func(a);
     }
 
-    TextLog_Print(json_log, " }\n");
+    out.put(" }\n", 3);
+    TextLog_Write(json_log, json_buf->data(), json_buf->size());
     TextLog_Flush(json_log);
 }
 
@@ -878,3 +986,54 @@ const BaseApi* alert_json[] =
     nullptr
 };
 
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+
+static string addr_str(const SfIp& ip)
+{
+    string s;
+    JsonWriter out(s);
+    Event event;
+    Args a = { nullptr, nullptr, event, out, nullptr };
+
+    put_addr(a, &ip);
+    return s;
+}
+
+TEST_CASE("json addr cache keeps family", "[alert_json]")
+{
+    addr_cache = new AddrString[ADDR_CACHE_SIZE]();
+
+    SfIp v4, v6;
+    REQUIRE(v4.set("1.2.3.4") == SFIP_SUCCESS);
+    REQUIRE(v6.set("::ffff:1.2.3.4") == SFIP_SUCCESS);
+    REQUIRE(v4.is_ip4());
+    REQUIRE(v6.is_ip6());
+
+    SfIpString v4_str, v6_str;
+    v4.ntop(v4_str);
+    v6.ntop(v6_str);
+    CHECK(string(v4_str) != string(v6_str));
+
+    for ( unsigned i = 0; i < 4; ++i )
+    {
+        CHECK(addr_str(v4) == v4_str);
+        CHECK(addr_str(v6) == v6_str);
+    }
+
+    // cached and fresh lookups of another address agree
+    SfIp other;
+    REQUIRE(other.set("2001:db8::1") == SFIP_SUCCESS);
+    CHECK(addr_str(other) == "2001:db8::1");
+    CHECK(addr_str(other) == "2001:db8::1");
+
+    delete[] addr_cache;
+    addr_cache = nullptr;
+}
+
+#endif
@@ -28,6 +28,7 @@
 #include "framework/logger.h"
 #include "framework/module.h"
 #include "log/messages.h"
+#include "log/pcap_stream.h"
 #include "main/snort_config.h"
 #include "packet_io/sfdaq.h"
 #include "packet_io/sfdaq_config.h"
@@ -53,10 +54,13 @@ struct LtdConfig
     size_t limit;
 };
 
+// when log rings are configured the file is written by the log writer
+// thread through stream instead of dumpd
 struct LtdContext
 {
     char* file;
     pcap_dumper_t* dumpd;
+    PcapStream* stream;
     time_t lastTime;
     size_t size;
     int log_cnt;
@@ -124,6 +128,12 @@ static inline size_t SizeOf(const Packet* p)
 static void LogTcpdumpSingle(
     LtdConfig* data, Packet* p, const char*, Event*)
 {
+    if ( context.stream )
+    {
+        context.stream->write(p->pkth->ts, p->pkt, p->pktlen, p->pkth->pktlen);
+        return;
+    }
+
     size_t dumpSize = SizeOf(p);
 
     if ( data->limit && (context.size + dumpSize > data->limit) )
@@ -149,7 +159,7 @@ static void LogTcpdumpStream(
 // (take original packet headers and append reassembled data)
 }
 
-static void TcpdumpInitLogFile(LtdConfig*, bool no_timestamp)
+static void TcpdumpInitLogFile(LtdConfig* data, bool no_timestamp)
 {
     string file;
     string filename = F_NAME;
@@ -157,6 +167,23 @@ static void TcpdumpInitLogFile(LtdConfig*, bool no_timestamp)
     context.lastTime = time(nullptr);
     context.log_cnt = 0;
 
+    if ( LogStream::enabled() )
+    {
+        // the stream stamps and rolls over the file itself; the
+        // LINKTYPE_IPV4 and LINKTYPE_IPV6 values don't need conversion
+        get_instance_file(file, filename.c_str());
+
+        const SnortConfig* sc = SnortConfig::get_conf();
+        context.stream = new PcapStream(SFDAQ::get_base_protocol(),
+            sc->daq_config->get_mru_size(), false, nullptr, sc->log_ring_size,
+            sc->log_ring_block);
+
+        if ( !context.stream->open(file, !no_timestamp, data ? data->limit : 0) )
+            FatalError("%s: can't open %s\n", S_NAME, file.c_str());
+
+        return;
+    }
+
     if(!no_timestamp)
     {
         char timestamp[16];
@@ -194,6 +221,12 @@ static void TcpdumpInitLogFile(LtdConfig*, bool no_timestamp)
 
 static void TcpdumpRollLogFile(LtdConfig* data)
 {
+    if ( context.stream )
+    {
+        context.stream->request_roll();
+        return;
+    }
+
     time_t now = time(nullptr);
 
     /* don't roll over any sooner than resolution
@@ -273,6 +306,15 @@ void PcapLogger::open()
 
 void PcapLogger::close()
 {
+    if ( context.stream )
+    {
+        // the current file is known once the stream is stopped
+        context.stream->close();
+        context.file = snort_strdup(context.stream->get_file().c_str());
+        delete context.stream;
+        context.stream = nullptr;
+    }
+
     SpoLogTcpdumpCleanup(nullptr);
 
     if ( context.dumpd )
@@ -286,7 +328,7 @@ void PcapLogger::close()
 
 void PcapLogger::log(Packet* p, const char* msg, Event* event)
 {
-    if(!context.dumpd)
+    if(!context.dumpd and !context.stream)
         open();
 
     context.log_cnt++;
@@ -298,7 +340,7 @@ void PcapLogger::log(Packet* p, const char* msg, Event* event)
 
 void PcapLogger::reset()
 {
-    if(!context.dumpd)
+    if(!context.dumpd and !context.stream)
         open();
     else
         TcpdumpRollLogFile(config);
@@ -37,6 +37,7 @@
 #include "events/event.h"
 #include "framework/logger.h"
 #include "framework/module.h"
+#include "log/log_writer.h"
 #include "log/messages.h"
 #include "log/obfuscator.h"
 #include "log/unified2.h"
@@ -71,6 +72,8 @@ struct Unified2Config
 struct U2
 {
     FILE* stream;
+    LogStream* log_stream;
+    char* io_buffer;
     unsigned int current;
     int base_proto;
     uint32_t timestamp;
@@ -92,63 +95,139 @@ static THREAD_LOCAL uint8_t* write_pkt_buffer = nullptr;
     (MAX_XFF_WRITE_BUF_LENGTH - \
     sizeof(struct in6_addr) + DECODE_BLEN)
 
-/* This buffer is used in lieu of the underlying default stream buf to
- * prevent flushing in the middle of a record.  Every write is force
- * flushed to disk immediately after the entire record is written so
- * spoolers get an entire record */
-
-/* use the size of the buffer we copy record data into */
-static THREAD_LOCAL char* io_buffer = nullptr;
-
 /* -------------------- Local Functions -----------------------*/
 
 static void Unified2Write(uint8_t*, uint32_t, Unified2Config*);
 
-static void Unified2InitFile(Unified2Config* config)
+// returns false if the file can't be opened
+static bool Unified2InitFile(Unified2Config* config, U2& out)
 {
     assert(config);
 
     char filepath[STD_BUF];
     char* fname_ptr;
 
-    u2.timestamp = (uint32_t)time(nullptr);
+    out.timestamp = (uint32_t)time(nullptr);
 
     if (!config->nostamp)
     {
         if (SnortSnprintf(filepath, sizeof(filepath), "%s.%u",
-            u2.filepath, u2.timestamp) != SNORT_SNPRINTF_SUCCESS)
+            out.filepath, out.timestamp) != SNORT_SNPRINTF_SUCCESS)
         {
-            FatalError("unified2 failed to copy file path.\n");
+            ErrorMessage("unified2 failed to copy file path.\n");
+            out.stream = nullptr;
+            return false;
         }
 
         fname_ptr = filepath;
     }
     else
     {
-        fname_ptr = u2.filepath;
+        fname_ptr = out.filepath;
     }
 
-    if ((u2.stream = fopen(fname_ptr, "wb")) == nullptr)
+    if ((out.stream = fopen(fname_ptr, "wb")) == nullptr)
     {
-        FatalError("unified2 could not open %s: %s\n", fname_ptr, get_error(errno));
+        ErrorMessage("unified2 could not open %s: %s\n", fname_ptr, get_error(errno));
+        return false;
     }
 
     /* Set buffer to size of record buffer so the system doesn't flush
      * part of a record if it's greater than BUFSIZ */
-    if (setvbuf(u2.stream, io_buffer, _IOFBF, u2_buf_sz) != 0)
+    if (setvbuf(out.stream, out.io_buffer, _IOFBF, u2_buf_sz) != 0)
     {
         ErrorMessage("unified2 could not set I/O buffer: %s. "
             "Using system default.\n", get_error(errno));
     }
+    return true;
 }
 
-static inline void Unified2RotateFile(Unified2Config* config)
+static inline bool Unified2RotateFile(Unified2Config* config, U2& out)
 {
-    fclose(u2.stream);
-    u2.current = 0;
-    Unified2InitFile(config);
+    fclose(out.stream);
+    out.current = 0;
+    return Unified2InitFile(config, out);
 }
 
+// packet thread files can't be replaced so failing to open one is fatal
+static inline void Unified2OpenFile(Unified2Config* config)
+{
+    if ( !Unified2InitFile(config, u2) )
+        FatalError("unified2 can't continue without a log file\n");
+}
+
+static inline void Unified2RollFile(Unified2Config* config)
+{
+    if ( !Unified2RotateFile(config, u2) )
+        FatalError("unified2 can't continue without a log file\n");
+}
+
+static inline void Unified2CheckRotate(Unified2Config* config, uint32_t write_len)
+{
+    // files written by a log stream are rotated by the log writer thread
+    if ( !u2.log_stream && config->limit && (u2.current + write_len) > config->limit )
+        Unified2RollFile(config);
+}
+
+// the log writer thread owns the stream's file, buffer and size so the
+// packet thread's U2 has no file; if the file can't be reopened when it is
+// rolled the error is reported and the stream's records are discarded
+class U2Stream : public LogStream
+{
+public:
+    U2Stream(Unified2Config* config, const char* filepath) :
+        LogStream(u2_buf_sz), config(config)
+    {
+        memset(&state, 0, sizeof(state));
+        memcpy(state.filepath, filepath, sizeof(state.filepath));
+        state.io_buffer = new char[u2_buf_sz];
+    }
+
+    ~U2Stream() override
+    {
+        stop();
+
+        if ( state.stream )
+            fclose(state.stream);
+
+        delete[] state.io_buffer;
+    }
+
+    bool open()
+    { return Unified2InitFile(config, state); }
+
+protected:
+    int get_fd() override
+    { return state.stream ? fileno(state.stream) : -1; }
+
+    bool check_size(unsigned len) override
+    {
+        if ( config->limit && (state.current + len) > config->limit )
+        {
+            pending = len;
+            return true;
+        }
+        state.current += len;
+        return false;
+    }
+
+    void roll() override
+    {
+        if ( !state.stream )
+            return;
+
+        if ( !Unified2RotateFile(config, state) )
+            ErrorMessage("unified2 stopped writing %s\n", state.filepath);
+
+        state.current = pending;
+    }
+
+private:
+    Unified2Config* config;
+    U2 state;
+    unsigned pending = 0;
+};
+
 static inline unsigned get_version(const SfIp& addr)
 {
     uint16_t family = addr.get_family();
@@ -230,8 +309,7 @@ static void alert_event(Packet* p, const char*, Unified2Config* config, const Ev
     Serial_Unified2_Header hdr;
     uint32_t write_len = sizeof(hdr) + sizeof(u2_event);
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
+    Unified2CheckRotate(config, write_len);
 
     hdr.length = htonl(sizeof(Unified2Event));
     hdr.type = htonl(UNIFIED2_EVENT3);
@@ -300,8 +378,7 @@ static void _WriteExtraData(Unified2Config* config,
     if (write_len > sizeof(write_buffer))
         return;
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
+    Unified2CheckRotate(config, write_len);
 
     hdr.length = htonl(write_len - sizeof(hdr));
     hdr.type = htonl(UNIFIED2_EXTRA_DATA);
@@ -388,8 +465,7 @@ static void _Unified2LogPacketAlert(
     logheader.packet_length = htonl(pkt_length + u2h_len);
     write_len += pkt_length + u2h_len;
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
+    Unified2CheckRotate(config, write_len);
 
     hdr.length = htonl(sizeof(Serial_Unified2Packet) - 4 + pkt_length + u2h_len);
     hdr.type = htonl(u2_type);
@@ -467,6 +543,13 @@ static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config
 {
     size_t fwcount = 0;
 
+    if ( u2.log_stream )
+    {
+        if ( buf )
+            u2.log_stream->write(buf, buf_len);
+        return;
+    }
+
     /* Nothing to write or nothing to write to */
     if ((buf == nullptr) || (config == nullptr) || (u2.stream == nullptr))
         return;
@@ -536,7 +619,7 @@ static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config
                 ErrorMessage("unified2 file is possibly corrupt. "
                     "Closing this unified2 file and creating a new one.\n");
 
-                Unified2RotateFile(config);
+                Unified2RollFile(config);
 
                 if (config->nostamp)
                 {
@@ -700,8 +783,7 @@ static void _AlertIP4_v2(Packet* p, const char*, Unified2Config* config, const E
                 app_name, strlen(app_name) + 1);
     }
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
+    Unified2CheckRotate(config, write_len);
 
     hdr.length = htonl(sizeof(alertdata));
     hdr.type = htonl(UNIFIED2_IDS_EVENT_VLAN);
@@ -789,8 +871,7 @@ static void _AlertIP6_v2(Packet* p, const char*, Unified2Config* config, const E
                 app_name, strlen(app_name) + 1);
     }
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
+    Unified2CheckRotate(config, write_len);
 
     hdr.length = htonl(sizeof(Unified2IDSEventIPv6));
     hdr.type = htonl(UNIFIED2_IDS_EVENT_IPV6_VLAN);
@@ -912,23 +993,42 @@ void U2Logger::open()
     u2.base_proto = htonl(SFDAQ::get_base_protocol());
 
     write_pkt_buffer = new uint8_t[u2_buf_sz];
-    io_buffer = new char[u2_buf_sz];
 
-    Unified2InitFile(&config);
+    if ( LogStream::enabled() )
+    {
+        U2Stream* ls = new U2Stream(&config, u2.filepath);
+
+        if ( !ls->open() )
+            FatalError("unified2 can't continue without a log file\n");
+
+        ls->start();
+        u2.log_stream = ls;
+    }
+    else
+    {
+        u2.io_buffer = new char[u2_buf_sz];
+        Unified2OpenFile(&config);
+    }
 
     Stream::reg_xtra_data_log(AlertExtraData, &config);
 }
 
 void U2Logger::close()
 {
+    delete u2.log_stream;
+    u2.log_stream = nullptr;
+
     if ( u2.stream )
+    {
         fclose(u2.stream);
+        u2.stream = nullptr;
+    }
 
     delete[] write_pkt_buffer;
-    delete[] io_buffer;
+    delete[] u2.io_buffer;
 
     write_pkt_buffer = nullptr;
-    io_buffer = nullptr;
+    u2.io_buffer = nullptr;
 }
 
 void U2Logger::alert_legacy(Packet* p, const char* msg, const Event& event)
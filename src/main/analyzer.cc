@@ -44,8 +44,10 @@
 #include "flow/flow.h"
 #include "flow/ha.h"
 #include "framework/data_bus.h"
+#include "latency/latency_config.h"
 #include "latency/packet_latency.h"
 #include "latency/rule_latency.h"
+#include "latency/stage_latency.h"
 #include "log/messages.h"
 #include "main/swapper.h"
 #include "main.h"
@@ -56,6 +58,7 @@
 #include "managers/module_manager.h"
 #include "memory/memory_cap.h"
 #include "packet_io/active.h"
+#include "packet_io/batch_tuner.h"
 #include "packet_io/sfdaq.h"
 #include "packet_io/sfdaq_config.h"
 #include "packet_io/sfdaq_instance.h"
@@ -73,6 +76,7 @@
 
 #include "analyzer_command.h"
 #include "oops_handler.h"
+#include "retry_queue.h"
 #include "snort.h"
 #include "snort_config.h"
 #include "thread_config.h"
@@ -87,63 +91,6 @@ static THREAD_LOCAL Analyzer* local_analyzer = nullptr;
 
 //-------------------------------------------------------------------------
 
-class RetryQueue
-{
-    struct Entry
-    {
-        Entry(const struct timeval& next_try, DAQ_Msg_h msg) : next_try(next_try), msg(msg) { }
-
-        struct timeval next_try;
-        DAQ_Msg_h msg;
-    };
-
-public:
-    RetryQueue(unsigned interval_ms)
-    {
-        assert(interval_ms > 0);
-        interval = { static_cast<time_t>(interval_ms / 1000), static_cast<suseconds_t>((interval_ms % 1000) * 1000) };
-    }
-
-    ~RetryQueue()
-    {
-        assert(empty());
-    }
-
-    void put(DAQ_Msg_h msg)
-    {
-        struct timeval now, next_try;
-        packet_gettimeofday(&now);
-        timeradd(&now, &interval, &next_try);
-        queue.emplace_back(next_try, msg);
-    }
-
-    DAQ_Msg_h get(const struct timeval* now = nullptr)
-    {
-        if (!empty())
-        {
-            const Entry& entry = queue.front();
-            if (!now || !timercmp(now, &entry.next_try, <))
-            {
-                DAQ_Msg_h msg = entry.msg;
-                queue.pop_front();
-                return msg;
-            }
-        }
-        return nullptr;
-    }
-
-    bool empty() const
-    {
-        return queue.empty();
-    }
-
-private:
-    deque<Entry> queue;
-    struct timeval interval;
-};
-
-//-------------------------------------------------------------------------
-
 /*
  * Static Class Methods
  */
@@ -318,11 +265,22 @@ static void packet_trace_dump(Packet* p, DAQ_Verdict verdict, bool msg_was_held)
 
 void Analyzer::add_to_retry_queue(DAQ_Msg_h daq_msg, Flow* flow)
 {
-    retry_queue->put(daq_msg);
+    struct timeval now;
+    packet_gettimeofday(&now);
+    retry_queue->put(daq_msg, flow, now);
     if (flow)
         flow->flags.retry_queued = true;
 }
 
+bool Analyzer::release_retries(const Flow* flow)
+{
+    if (!retry_queue->release(flow))
+        return false;
+
+    daq_stats.retries_released++;
+    return true;
+}
+
 /*
  * Private message processing methods
  */
@@ -455,7 +413,11 @@ void Analyzer::process_daq_msg(DAQ_Msg_h msg, bool retry)
     switch (daq_msg_get_type(msg))
     {
         case DAQ_MSG_TYPE_PACKET:
-            process_daq_pkt_msg(msg, retry);
+            {
+                // the packet stage covers decode through finalize
+                StageLatency::Context stage_latency_ctx(StageLatency::PACKET);
+                process_daq_pkt_msg(msg, retry);
+            }
             // process_daq_pkt_msg() handles finalizing the message (or tracking it if offloaded)
             return;
         case DAQ_MSG_TYPE_SOF:
@@ -485,9 +447,11 @@ void Analyzer::process_retry_queue()
         struct timeval now;
         packet_gettimeofday(&now);
         DAQ_Msg_h msg;
+        uint64_t waited;
 
-        while ((msg = retry_queue->get(&now)) != nullptr)
+        while ((msg = retry_queue->get(&now, &waited)) != nullptr)
         {
+            daq_stats.retry_waits[RetryQueue::get_bin(waited)]++;
             process_daq_msg(msg, true);
             daq_stats.retries_processed++;
         }
@@ -652,14 +616,16 @@ void Analyzer::init_unprivileged()
     HostAttributesManager::initialize();
     RuleContext::set_enabled(sc->profiler->rule.show);
     TimeProfilerStats::set_enabled(sc->profiler->time.show);
+    StageLatency::set_enabled(sc->latency->packet_latency.histograms);
 
     // in case there are HA messages waiting, process them first
     HighAvailabilityManager::process_receive();
     PacketManager::thread_init();
 
     // init filters hash tables that depend on alerts
-    sfthreshold_alloc(sc->threshold_config->memcap, sc->threshold_config->memcap);
-    SFRF_Alloc(sc->rate_filter_config->memcap);
+    sfthreshold_alloc(sc->threshold_config->memcap, sc->threshold_config->memcap,
+        sc->threshold_config->sketch);
+    SFRF_Alloc(sc->rate_filter_config->memcap, sc->rate_filter_config->sketch);
 }
 
 void Analyzer::reinit(const SnortConfig* sc)
@@ -668,6 +634,7 @@ void Analyzer::reinit(const SnortConfig* sc)
     ActionManager::thread_reinit(sc);
     TraceApi::thread_reinit(sc->trace_config);
     EventManager::reload_outputs();
+    StageLatency::set_enabled(sc->latency->packet_latency.histograms);
 }
 
 void Analyzer::stop_removed(const SnortConfig* sc)
@@ -748,6 +715,7 @@ Analyzer::~Analyzer()
     delete daq_instance;
     delete oops_handler;
     delete retry_queue;
+    delete batch_tuner;
 }
 
 void Analyzer::operator()(Swapper* ps, uint16_t run_num)
@@ -773,6 +741,12 @@ void Analyzer::operator()(Swapper* ps, uint16_t run_num)
         STHREAD_TYPE_PACKET, get_instance_id());
 
     SFDAQ::set_local_instance(daq_instance);
+
+    const SFDAQConfig* daq_config = SnortConfig::get_conf()->daq_config;
+    if (daq_config->adaptive_batch)
+        batch_tuner = new BatchTuner(daq_instance->get_batch_size(),
+            daq_config->batch_latency, daq_config->max_backoff);
+
     set_state(State::INITIALIZED);
 
     Profiler::start();
@@ -871,8 +845,9 @@ void Analyzer::handle_uncompleted_commands()
 DAQ_RecvStatus Analyzer::process_messages()
 {
     // Max receive becomes the minimum of the configured batch size, the remaining exit_after
-    // count (if requested), and the remaining pause_after count (if requested).
-    unsigned max_recv = daq_instance->get_batch_size();
+    // count (if requested), and the remaining pause_after count (if requested).  With adaptive
+    // batching the tuned size stands in for the configured batch size.
+    unsigned max_recv = batch_tuner ? batch_tuner->get_size() : daq_instance->get_batch_size();
     if (exit_after_cnt && exit_after_cnt < max_recv)
         max_recv = exit_after_cnt;
     if (pause_after_cnt && pause_after_cnt < max_recv)
@@ -884,6 +859,11 @@ DAQ_RecvStatus Analyzer::process_messages()
         Profile profile(daqPerfStats);
         rstat = daq_instance->receive_messages(max_recv);
     }
+    daq_stats.receive_sizes[BatchTuner::get_bin(max_recv)]++;
+
+    chrono::steady_clock::time_point start;
+    if (batch_tuner)
+        start = chrono::steady_clock::now();
 
     // Preemptively service available onloads to potentially unblock processing the first message.
     // This conveniently handles servicing offloads in the no messages received case as well.
@@ -911,6 +891,24 @@ DAQ_RecvStatus Analyzer::process_messages()
         handle_uncompleted_commands();
     }
 
+    if (batch_tuner)
+    {
+        auto nsecs = chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now() - start).count();
+        batch_tuner->update(max_recv, num_recv, nsecs);
+
+        // A nonblocking receive that came back empty; back off once the busy polls are used up
+        // instead of spinning on an idle source.
+        if (!num_recv && rstat == DAQ_RSTAT_WOULD_BLOCK)
+        {
+            if (unsigned usecs = batch_tuner->backoff())
+            {
+                daq_stats.backoffs++;
+                this_thread::sleep_for(chrono::microseconds(usecs));
+            }
+        }
+    }
+
     if (exit_after_cnt && (exit_after_cnt -= num_recv) == 0)
         stop();
     if (pause_after_cnt && (pause_after_cnt -= num_recv) == 0)
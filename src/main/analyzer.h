@@ -35,6 +35,7 @@
 #include "main/snort_types.h"
 #include "thread.h"
 
+class BatchTuner;
 class ContextSwitcher;
 class OopsHandler;
 class RetryQueue;
@@ -101,6 +102,10 @@ public:
     void finalize_daq_message(DAQ_Msg_h, DAQ_Verdict);
     void add_to_retry_queue(DAQ_Msg_h, snort::Flow*);
 
+    // retry the flow's queued messages now, ahead of the retry interval,
+    // when its pending decision has been made; false if none are queued
+    SO_PUBLIC bool release_retries(const snort::Flow*);
+
     // Functions called by analyzer commands
     void start();
     void run(bool paused = false);
@@ -152,6 +157,7 @@ private:
     snort::SFDAQInstance* daq_instance;
     RetryQueue* retry_queue;
     OopsHandler* oops_handler;
+    BatchTuner* batch_tuner = nullptr;
     ContextSwitcher* switcher = nullptr;
     std::mutex pending_work_queue_mutex;
     std::list<UncompletedAnalyzerCommand*> uncompleted_work_queue;
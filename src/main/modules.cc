@@ -44,6 +44,7 @@
 #include "host_tracker/host_cache_module.h"
 #include "js_norm/js_norm_module.h"
 #include "latency/latency_module.h"
+#include "log/log_writer.h"
 #include "log/messages.h"
 #include "managers/module_manager.h"
 #include "managers/plugin_manager.h"
@@ -465,6 +466,10 @@ static const Parameter alerts_params[] =
     { "event_filter_memcap", Parameter::PT_INT, "0:max32", "1048576",
       "set available MB of memory for event_filters" },
 
+    { "event_filter_sketch", Parameter::PT_ENUM, "none | local | shared", "none",
+      "track event_filters with a fixed size approximate sketch per packet thread "
+      "or shared by all packet threads instead of a hash table" },
+
     { "log_references", Parameter::PT_BOOL, nullptr, "false",
       "include rule references in alert info (full only)" },
 
@@ -474,6 +479,10 @@ static const Parameter alerts_params[] =
     { "rate_filter_memcap", Parameter::PT_INT, "0:max32", "1048576",
       "set available MB of memory for rate_filters" },
 
+    { "rate_filter_sketch", Parameter::PT_ENUM, "none | local | shared", "none",
+      "track rate_filters with a fixed size approximate sketch per packet thread "
+      "or shared by all packet threads instead of a hash table" },
+
     { "reference_net", Parameter::PT_STRING, nullptr, nullptr,
       "set the CIDR for homenet "
       "(for use with -l or -B, does NOT change $HOME_NET in IDS mode)" },
@@ -508,6 +517,9 @@ bool AlertsModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("event_filter_memcap") )
         sc->threshold_config->memcap = v.get_uint32();
 
+    else if ( v.is("event_filter_sketch") )
+        sc->threshold_config->sketch = (FilterSketchMode)v.get_uint8();
+
     else if ( v.is("log_references") )
         v.update_mask(sc->output_flags, OUTPUT_FLAG__ALERT_REFS);
 
@@ -517,6 +529,9 @@ bool AlertsModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("rate_filter_memcap") )
         sc->rate_filter_config->memcap = v.get_uint32();
 
+    else if ( v.is("rate_filter_sketch") )
+        sc->rate_filter_config->sketch = (FilterSketchMode)v.get_uint8();
+
     else if ( v.is("reference_net") )
         return ( sc->homenet.set(v.get_string()) == SFIP_SUCCESS );
 
@@ -558,6 +573,12 @@ static const Parameter output_params[] =
     { "logdir", Parameter::PT_STRING, nullptr, ".",
       "where to put log files (same as -l)" },
 
+    { "log_ring_size", Parameter::PT_INT, "0:maxSZ", "0",
+      "bytes queued per thread for each log file written by the log writer thread (0 writes from the packet threads)" },
+
+    { "log_ring_overflow", Parameter::PT_ENUM, "drop | block", "drop",
+      "drop records or wait for the log writer thread when a log ring is full" },
+
     { "show_year", Parameter::PT_BOOL, nullptr, "false",
       "include year in timestamp in the alert and log files (same as -y)" },
 
@@ -603,6 +624,12 @@ public:
 
     const RuleMap* get_rules() const override
     { return output_rules; }
+
+    const PegInfo* get_pegs() const override
+    { return log_writer_pegs; }
+
+    PegCount* get_counts() const override
+    { return (PegCount*)&log_writer_stats; }
 };
 
 bool OutputModule::set(const char*, Value& v, SnortConfig* sc)
@@ -625,6 +652,12 @@ bool OutputModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("logdir") )
         sc->log_dir = v.get_string();
 
+    else if ( v.is("log_ring_size") )
+        sc->log_ring_size = v.get_size();
+
+    else if ( v.is("log_ring_overflow") )
+        sc->log_ring_block = v.get_uint8() == 1;
+
     else if ( v.is("max_data") )
         sc->event_trace_max = v.get_uint16();
 
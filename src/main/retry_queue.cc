@@ -0,0 +1,218 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// retry_queue.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "retry_queue.h"
+
+#include <cassert>
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+static inline uint64_t to_usecs(const struct timeval& tv)
+{ return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec; }
+
+RetryQueue::RetryQueue(unsigned interval_ms)
+{
+    assert(interval_ms > 0);
+    interval = (uint64_t)interval_ms * 1000;
+}
+
+RetryQueue::~RetryQueue()
+{
+    assert(empty());
+}
+
+void RetryQueue::put(DAQ_Msg_h msg, const snort::Flow* flow, const struct timeval& now)
+{
+    uint64_t usecs = to_usecs(now);
+    auto it = flows.find(flow);
+
+    if ( it == flows.end() )
+    {
+        FlowQueue& fq = flows[flow];
+        fq.deadline = usecs + interval;
+        wakeups.emplace(fq.deadline, flow);
+        fq.msgs.emplace_back(msg, usecs);
+    }
+    else
+        it->second.msgs.emplace_back(msg, usecs);
+
+    ++count;
+}
+
+bool RetryQueue::release(const snort::Flow* flow)
+{
+    auto it = flows.find(flow);
+
+    if ( it == flows.end() )
+        return false;
+
+    // a flow that is already released keeps its place
+    if ( it->second.deadline )
+    {
+        wakeups.erase(Wakeup(it->second.deadline, flow));
+        it->second.deadline = 0;
+        released.emplace_back(flow);
+    }
+    return true;
+}
+
+// move all of the flow's messages to the ready list; any that are put back
+// while being retried start a new flow queue behind them
+void RetryQueue::schedule(const snort::Flow* flow, FlowQueue& fq)
+{
+    for ( auto& e : fq.msgs )
+        ready.emplace_back(e);
+
+    flows.erase(flow);
+}
+
+DAQ_Msg_h RetryQueue::get(const struct timeval* now, uint64_t* waited)
+{
+    if ( ready.empty() )
+    {
+        if ( !released.empty() )
+        {
+            const snort::Flow* flow = released.front();
+            released.pop_front();
+            schedule(flow, flows[flow]);
+        }
+        else if ( !wakeups.empty() and (!now or wakeups.begin()->first <= to_usecs(*now)) )
+        {
+            const snort::Flow* flow = wakeups.begin()->second;
+            wakeups.erase(wakeups.begin());
+            schedule(flow, flows[flow]);
+        }
+        else
+            return nullptr;
+    }
+
+    const Entry& e = ready.front();
+    DAQ_Msg_h msg = e.msg;
+
+    if ( waited )
+    {
+        uint64_t usecs = now ? to_usecs(*now) : e.queued;
+        *waited = usecs > e.queued ? usecs - e.queued : 0;
+    }
+    ready.pop_front();
+    --count;
+    return msg;
+}
+
+unsigned RetryQueue::get_bin(uint64_t usecs)
+{
+    unsigned bin = 0;
+
+    for ( uint64_t limit = 1000; bin < num_bins - 1 and usecs >= limit; limit *= 10 )
+        ++bin;
+
+    return bin;
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static DAQ_Msg_h msg(uintptr_t n)
+{ return (DAQ_Msg_h)n; }
+
+static const snort::Flow* flow(uintptr_t n)
+{ return (const snort::Flow*)n; }
+
+static struct timeval at_ms(unsigned ms)
+{ return { (time_t)(ms / 1000), (suseconds_t)((ms % 1000) * 1000) }; }
+
+TEST_CASE("retry queue deadline order", "[retry_queue]")
+{
+    RetryQueue rq(200);
+    struct timeval t;
+
+    t = at_ms(0);
+    rq.put(msg(1), flow(1), t);
+    t = at_ms(50);
+    rq.put(msg(2), flow(2), t);
+    rq.put(msg(3), flow(1), t);
+    CHECK(rq.size() == 3);
+
+    t = at_ms(199);
+    CHECK(rq.get(&t) == nullptr);
+
+    // flow 1 is due and its later message comes along in order
+    uint64_t waited;
+    t = at_ms(200);
+    CHECK(rq.get(&t, &waited) == msg(1));
+    CHECK(waited == 200000);
+    CHECK(rq.get(&t, &waited) == msg(3));
+    CHECK(waited == 150000);
+    CHECK(rq.get(&t) == nullptr);
+
+    t = at_ms(250);
+    CHECK(rq.get(&t) == msg(2));
+    CHECK(rq.get(&t) == nullptr);
+    CHECK(rq.empty());
+}
+
+TEST_CASE("retry queue release", "[retry_queue]")
+{
+    RetryQueue rq(200);
+    struct timeval t = at_ms(0);
+
+    rq.put(msg(1), flow(1), t);
+    rq.put(msg(2), flow(2), t);
+    rq.put(msg(3), flow(2), t);
+
+    CHECK(!rq.release(flow(3)));
+    CHECK(rq.release(flow(2)));
+    CHECK(rq.release(flow(2)));
+
+    t = at_ms(10);
+    CHECK(rq.get(&t) == msg(2));
+
+    // a message put back while its flow is being retried waits again
+    rq.put(msg(2), flow(2), t);
+    CHECK(rq.get(&t) == msg(3));
+    CHECK(rq.get(&t) == nullptr);
+
+    // purge everything regardless of deadlines
+    CHECK(rq.get() == msg(1));
+    CHECK(rq.get() == msg(2));
+    CHECK(rq.get() == nullptr);
+    CHECK(rq.empty());
+}
+
+TEST_CASE("retry queue bins", "[retry_queue]")
+{
+    CHECK(RetryQueue::get_bin(0) == 0);
+    CHECK(RetryQueue::get_bin(999) == 0);
+    CHECK(RetryQueue::get_bin(1000) == 1);
+    CHECK(RetryQueue::get_bin(99999) == 2);
+    CHECK(RetryQueue::get_bin(100000) == 3);
+    CHECK(RetryQueue::get_bin(1000000) == 4);
+    CHECK(RetryQueue::get_bin(UINT64_MAX) == 4);
+}
+
+#endif
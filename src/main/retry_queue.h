@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// retry_queue.h author Cisco
+
+#ifndef RETRY_QUEUE_H
+#define RETRY_QUEUE_H
+
+// RetryQueue holds DAQ messages waiting on a pending decision such as a
+// file verdict.  Messages are queued per flow so that a flow's packets are
+// always retried together and in arrival order.  Each flow queue wakes up
+// when its oldest message has waited the retry interval; wakeups are kept
+// in deadline order so servicing the queue only looks at what is due.  A
+// flow can be released early when its verdict arrives.
+
+#include <daq_common.h>
+#include <sys/time.h>
+
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+namespace snort
+{
+class Flow;
+}
+
+class RetryQueue
+{
+public:
+    RetryQueue(unsigned interval_ms);
+    ~RetryQueue();
+
+    // flow may be null
+    void put(DAQ_Msg_h, const snort::Flow*, const struct timeval& now);
+
+    // returns the next message that is due or released in flow order,
+    // or any message if now is null.  waited is set to the usecs the
+    // message spent in the queue.
+    DAQ_Msg_h get(const struct timeval* now = nullptr, uint64_t* waited = nullptr);
+
+    // make the queued messages for the flow due now; returns false if the
+    // flow has none
+    bool release(const snort::Flow*);
+
+    bool empty() const
+    { return ready.empty() and flows.empty(); }
+
+    unsigned size() const
+    { return count; }
+
+    // the retry wait pegs are < 1 ms, < 10 ms, < 100 ms, < 1 s, and 1 s+
+    static const unsigned num_bins = 5;
+    static unsigned get_bin(uint64_t usecs);
+
+private:
+    struct Entry
+    {
+        Entry(DAQ_Msg_h msg, uint64_t queued) : msg(msg), queued(queued) { }
+
+        DAQ_Msg_h msg;
+        uint64_t queued;
+    };
+
+    struct FlowQueue
+    {
+        std::deque<Entry> msgs;
+        uint64_t deadline;
+    };
+
+    typedef std::pair<uint64_t, const snort::Flow*> Wakeup;
+
+    void schedule(const snort::Flow*, FlowQueue&);
+
+    std::unordered_map<const snort::Flow*, FlowQueue> flows;
+    std::set<Wakeup> wakeups;
+    std::deque<const snort::Flow*> released;
+    std::deque<Entry> ready;
+
+    uint64_t interval;
+    unsigned count = 0;
+};
+
+#endif
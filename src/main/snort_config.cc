@@ -517,9 +517,15 @@ bool SnortConfig::verify() const
     else if (sc->threshold_config->memcap != threshold_config->memcap)
         ReloadError("Changing alerts.event_filter_memcap requires a restart.\n");
 
+    else if (sc->threshold_config->sketch != threshold_config->sketch)
+        ReloadError("Changing alerts.event_filter_sketch requires a restart.\n");
+
     else  if (sc->rate_filter_config->memcap != rate_filter_config->memcap)
         ReloadError("Changing alerts.rate_filter_memcap requires a restart.\n");
 
+    else if (sc->rate_filter_config->sketch != rate_filter_config->sketch)
+        ReloadError("Changing alerts.rate_filter_sketch requires a restart.\n");
+
     else if (sc->detection_filter_config->memcap != detection_filter_config->memcap)
         ReloadError("Changing alerts.detection_filter_memcap requires a restart.\n");
 
@@ -206,6 +206,9 @@ public:
     uint32_t tagged_packet_limit = 256;
     uint16_t event_trace_max = 0;
 
+    size_t log_ring_size = 0;
+    bool log_ring_block = false;
+
     std::string log_dir;
 
     //------------------------------------------------------
@@ -226,6 +229,7 @@ public:
 
     unsigned offload_limit = 99999;  // disabled
     unsigned offload_threads = 0;    // disabled
+    bool offload_pool = false;
 
     bool hyperscan_literals = false;
     bool pcre_to_regex = false;
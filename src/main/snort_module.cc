@@ -1209,7 +1209,7 @@ bool SnortModule::end(const char*, int, SnortConfig* sc)
 {
     cli_mode = false;
 
-    if ( sc->offload_threads and ThreadConfig::get_instance_max() != 1 )
+    if ( sc->offload_threads and !sc->offload_pool and ThreadConfig::get_instance_max() != 1 )
         ParseError("You can not enable experimental offload with more than one packet thread.");
 
     if ( no_warn_flowbits )
@@ -86,7 +86,7 @@ void ContextSwitcher::start() { }
 void InitTag() { }
 void CleanupTag() { }
 void RateFilter_Cleanup() { }
-int sfthreshold_alloc(unsigned int, unsigned int) { return -1; }
+int sfthreshold_alloc(unsigned int, unsigned int, FilterSketchMode) { return -1; }
 void sfthreshold_reset() { }
 void sfthreshold_free() { }
 void EventTrace_Init() { }
@@ -107,7 +107,7 @@ void IpsManager::clear_options(const snort::SnortConfig*) { }
 void ActionManager::thread_init(const snort::SnortConfig*) { }
 void ActionManager::thread_term() { }
 void ActionManager::thread_reinit(const snort::SnortConfig*) { }
-int SFRF_Alloc(unsigned int) { return -1; }
+int SFRF_Alloc(unsigned int, FilterSketchMode) { return -1; }
 void packet_time_update(const struct timeval*) { }
 void main_poke(unsigned) { }
 void set_default_policy(const snort::SnortConfig*) { }
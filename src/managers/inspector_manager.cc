@@ -34,6 +34,7 @@
 #include "flow/expect_cache.h"
 #include "flow/flow.h"
 #include "flow/session.h"
+#include "latency/stage_latency.h"
 #include "log/messages.h"
 #include "main/shell.h"
 #include "main/snort.h"
@@ -1785,6 +1786,9 @@ static bool configure(SnortConfig* sc, InspectorList* il, bool cloned, bool& new
 
     for ( auto* p : il->ilist )
     {
+        if ( p->handler->get_latency_stage() >= StageLatency::max_stages )
+            p->handler->set_latency_stage(StageLatency::get_stage(p->name.c_str()));
+
         if ( cloned )
         {
             ReloadType reload_type = p->get_reload_type();
@@ -2016,6 +2020,12 @@ void InspectorManager::print_config(SnortConfig* sc)
 // packet handling
 //-------------------------------------------------------------------------
 
+static inline void eval(Inspector* ins, Packet* p)
+{
+    StageLatency::Context stage_latency_ctx(ins->get_latency_stage());
+    ins->eval(p);
+}
+
 template<bool T>
 static inline void execute(
     Packet* p, PHInstance* const * prep, unsigned num, bool probe = false)
@@ -2048,10 +2058,10 @@ static inline void execute(
         if ( p->type() == PktType::NONE )
         {
             if ( p->proto_bits & ppc.api.proto_bits )
-                (*prep)->handler->eval(p);
+                eval((*prep)->handler, p);
         }
         else if ( BIT((unsigned)p->type()) & ppc.api.proto_bits )
-            (*prep)->handler->eval(p);
+            eval((*prep)->handler, p);
 
         if ( T )
             trace_ulogf(snort_trace, TRACE_INSPECTOR_MANAGER, p,
@@ -2106,7 +2116,7 @@ void inline InspectorManager::full_inspection(Packet* p)
     else if ( flow->gadget && flow->gadget->likes(p) )
     {
         if ( !T )
-            flow->gadget->eval(p);
+            eval(flow->gadget, p);
         else
         {
             Stopwatch<SnortClock> timer;
@@ -2114,7 +2124,7 @@ void inline InspectorManager::full_inspection(Packet* p)
             trace_ulogf(snort_trace, TRACE_INSPECTOR_MANAGER, p, "enter %s\n", inspector_name);
             timer.start();
 
-            flow->gadget->eval(p);
+            eval(flow->gadget, p);
 
             trace_ulogf(snort_trace, TRACE_INSPECTOR_MANAGER, p,
                 "exit %s, elapsed time: %" PRId64 "\n", inspector_name, TO_USECS(timer.get()));
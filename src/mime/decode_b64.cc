@@ -157,6 +157,29 @@ int sf_base64decode(uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf, uint32
     outbuf_ptr = outbuf;
     while ((cursor < endofinbuf) && (n < max_base64_chars))
     {
+        /* Fast path: a whole group of four base64 chars without padding, with enough room
+           for the output. Produces exactly what the byte-by-byte steps below would do. */
+        if ((base64data_ptr == base64data) && (endofinbuf - cursor >= 4)
+            && (n + 4 <= max_base64_chars) && (outbuf_size - *bytes_written >= 3))
+        {
+            tableval_a = sf_decode64tab[cursor[0]];
+            tableval_b = sf_decode64tab[cursor[1]];
+            tableval_c = sf_decode64tab[cursor[2]];
+            tableval_d = sf_decode64tab[cursor[3]];
+
+            if ((tableval_a | tableval_b | tableval_c | tableval_d) < 64)
+            {
+                outbuf_ptr[0] = (tableval_a << 2) | (tableval_b >> 4);
+                outbuf_ptr[1] = (tableval_b << 4) | (tableval_c >> 2);
+                outbuf_ptr[2] = (tableval_c << 6) | tableval_d;
+                outbuf_ptr += 3;
+                *bytes_written += 3;
+                cursor += 4;
+                n += 4;
+                continue;
+            }
+        }
+
         if (sf_decode64tab[*cursor] != 100)
         {
             *base64data_ptr++ = *cursor;
@@ -24,8 +24,8 @@
 
 #include "decode_qp.h"
 
-#include <cctype>
-#include <cstdlib>
+#include <algorithm>
+#include <cstring>
 
 #include "utils/util_unfold.h"
 
@@ -99,77 +99,101 @@ QPDecode::~QPDecode()
         delete buffer;
 }
 
+// printable chars, blanks and line breaks are copied as is, the rest is skipped
+static inline bool qp_literal(uint8_t ch)
+{
+    return ((ch >= 0x20) && (ch < 0x7f) && (ch != '=')) || (ch == '\t') || (ch == '\r') ||
+        (ch == '\n');
+}
+
+static inline int qp_hex(uint8_t ch)
+{
+    if ((ch >= '0') && (ch <= '9'))
+        return ch - '0';
+    if ((ch >= 'A') && (ch <= 'F'))
+        return ch - 'A' + 10;
+    if ((ch >= 'a') && (ch <= 'f'))
+        return ch - 'a' + 10;
+    return -1;
+}
+
 int sf_qpdecode(const char* src, uint32_t slen, char* dst, uint32_t dlen, uint32_t* bytes_read,
     uint32_t* bytes_copied)
 {
     if (!src || !slen || !dst || !dlen || !bytes_read || !bytes_copied )
         return -1;
 
-    *bytes_read = 0;
-    *bytes_copied = 0;
+    const uint8_t* in = (const uint8_t*)src;
+    uint32_t rd = 0;
+    uint32_t cp = 0;
 
-    while ( (*bytes_read < slen) && (*bytes_copied < dlen))
+    while ( (rd < slen) && (cp < dlen))
     {
-        char ch = src[*bytes_read];
-        *bytes_read += 1;
+        uint8_t ch = in[rd];
+
+        if ( qp_literal(ch) )
+        {
+            /* copy the whole run of literal chars at once */
+            uint32_t run_end = rd + std::min(slen - rd, dlen - cp);
+            uint32_t run = rd + 1;
+
+            while ( (run < run_end) && qp_literal(in[run]) )
+                run++;
+
+            memcpy(dst + cp, in + rd, run - rd);
+            cp += run - rd;
+            rd = run;
+            continue;
+        }
+
+        rd++;
+
+        if ( ch != '=' )
+            continue;
+
+        if ( rd >= slen )
+        {
+            /* soft line break or escape sequence spans to the next chunk */
+            rd--;
+            break;
+        }
+
+        if ( in[rd] == '\n' )
+        {
+            rd++;
+            continue;
+        }
+
+        if ( rd >= (slen - 1) )
+        {
+            rd--;
+            break;
+        }
+
+        uint8_t ch1 = in[rd];
+        uint8_t ch2 = in[rd + 1];
 
-        if ( ch == '=' )
+        if ( ch1 == '\r' && ch2 == '\n')
         {
-            if ( (*bytes_read < slen))
-            {
-                if (src[*bytes_read] == '\n')
-                {
-                    *bytes_read += 1;
-                    continue;
-                }
-                else if ( *bytes_read < (slen - 1) )
-                {
-                    char ch1 = src[*bytes_read];
-                    char ch2 = src[*bytes_read + 1];
-                    if ( ch1 == '\r' && ch2 == '\n')
-                    {
-                        *bytes_read += 2;
-                        continue;
-                    }
-                    if (isxdigit((int)ch1) && isxdigit((int)ch2))
-                    {
-                        char hexBuf[3];
-                        char* eptr;
-                        hexBuf[0] = ch1;
-                        hexBuf[1] = ch2;
-                        hexBuf[2] = '\0';
-                        dst[*bytes_copied]= (char)strtoul(hexBuf, &eptr, 16);
-                        if ((*eptr != '\0'))
-                        {
-                            return -1;
-                        }
-                        *bytes_read += 2;
-                        *bytes_copied +=1;
-                        continue;
-                    }
-                    dst[*bytes_copied] = ch;
-                    *bytes_copied +=1;
-                    continue;
-                }
-                else
-                {
-                    *bytes_read -= 1;
-                    return 0;
-                }
-            }
-            else
-            {
-                *bytes_read -= 1;
-                return 0;
-            }
+            rd += 2;
+            continue;
         }
-        else if ( isprint(ch) || isblank(ch) || ch == '\r' || ch == '\n' )
+
+        int hi = qp_hex(ch1);
+        int lo = qp_hex(ch2);
+
+        if ( (hi >= 0) && (lo >= 0) )
         {
-            dst[*bytes_copied] = ch;
-            *bytes_copied +=1;
+            dst[cp++] = (char)((hi << 4) | lo);
+            rd += 2;
+            continue;
         }
+
+        dst[cp++] = ch;
     }
 
+    *bytes_read = rd;
+    *bytes_copied = cp;
+
     return 0;
 }
-
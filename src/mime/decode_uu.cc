@@ -236,8 +236,9 @@ int sf_uudecode(uint8_t* src, uint32_t slen, uint8_t* dst, uint32_t dlen, uint32
         }
         else
         {
-            /* probably padding. skip over it.*/
-            ptr++;
+            /* probably padding. skip over it up to the end of line.*/
+            const uint8_t* eol = (const uint8_t*)memchr(ptr, '\n', end - ptr);
+            ptr = eol ? eol : end;
         }
     }
 
@@ -0,0 +1,238 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// decode_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <string>
+
+#include "catch/catch.hpp"
+
+#include "mime/decode_b64.h"
+#include "mime/decode_qp.h"
+#include "mime/decode_uu.h"
+#include "utils/util_unfold.h"
+
+using namespace snort;
+
+static std::string b64(const std::string& src, uint32_t dst_size = 256, int* ret = nullptr)
+{
+    std::string in(src);
+    uint8_t dst[256];
+    uint32_t written = 0;
+
+    int r = sf_base64decode((uint8_t*)&in[0], in.size(), dst, dst_size, &written);
+
+    if (ret)
+        *ret = r;
+
+    return std::string((const char*)dst, written);
+}
+
+static std::string qp(const std::string& src, uint32_t* read = nullptr, uint32_t dst_size = 256)
+{
+    char dst[256];
+    uint32_t bytes_read = 0;
+    uint32_t copied = 0;
+
+    sf_qpdecode(src.c_str(), src.size(), dst, dst_size, &bytes_read, &copied);
+
+    if (read)
+        *read = bytes_read;
+
+    return std::string(dst, copied);
+}
+
+static std::string strip(const std::string& src, uint32_t dst_size = 256)
+{
+    uint8_t dst[256];
+    uint32_t written = 0;
+
+    sf_strip_CRLF((const uint8_t*)src.c_str(), src.size(), dst, dst_size, &written);
+
+    return std::string((const char*)dst, written);
+}
+
+#ifdef CATCH_TEST_BUILD
+
+TEST_CASE("base64", "[mime_decode]")
+{
+    int ret = 0;
+
+    SECTION("aligned")
+    {
+        CHECK(b64("Zm9vYmFy") == "foobar");
+    }
+    SECTION("padding")
+    {
+        CHECK(b64("Zm9vYg==") == "foob");
+        CHECK(b64("Zm9vYmE=") == "fooba");
+    }
+    SECTION("no padding at the end")
+    {
+        CHECK(b64("Zm9vYmE") == "foo");
+    }
+    SECTION("stops at padding")
+    {
+        CHECK(b64("Zg==Zm9v") == "f");
+    }
+    SECTION("invalid chars skipped")
+    {
+        CHECK(b64("Zm9v\r\n  Ym\tFy!") == "foobar");
+        CHECK(b64("Z*m9vYmFy") == "foobar");
+    }
+    SECTION("misplaced padding")
+    {
+        CHECK(b64("Zm9v=mFy", 256, &ret) == "foo");
+        CHECK(ret == -1);
+    }
+    SECTION("output limit")
+    {
+        CHECK(b64("Zm9vYmFy", 4) == "foob");
+        CHECK(b64("Zm9vYmFy", 2) == "fo");
+    }
+}
+
+TEST_CASE("quoted-printable", "[mime_decode]")
+{
+    uint32_t read = 0;
+
+    SECTION("plain text")
+    {
+        CHECK(qp("foo bar\r\n", &read) == "foo bar\r\n");
+        CHECK(read == 9);
+    }
+    SECTION("escapes")
+    {
+        CHECK(qp("f=6Fo=3d=3D", &read) == "foo==");
+        CHECK(read == 11);
+    }
+    SECTION("soft line breaks")
+    {
+        CHECK(qp("fo=\r\no=\nbar", &read) == "foobar");
+        CHECK(read == 11);
+    }
+    SECTION("bad escape")
+    {
+        CHECK(qp("a=zzb", &read) == "a=zzb");
+        CHECK(read == 5);
+    }
+    SECTION("non-printable skipped")
+    {
+        CHECK(qp("a\x01\x80" "b", &read) == "ab");
+        CHECK(read == 4);
+    }
+    SECTION("escape split")
+    {
+        CHECK(qp("foo=", &read) == "foo");
+        CHECK(read == 3);
+        CHECK(qp("foo=4", &read) == "foo");
+        CHECK(read == 3);
+    }
+    SECTION("output limit")
+    {
+        CHECK(qp("foobar", &read, 4) == "foob");
+        CHECK(read == 4);
+    }
+}
+
+TEST_CASE("uuencode", "[mime_decode]")
+{
+    const char src[] = "begin 644 foo\n&9F]O8F%R\n`\nend\n";
+    uint8_t dst[64];
+    uint32_t read = 0;
+    uint32_t copied = 0;
+    bool begin_found = false;
+    bool end_found = false;
+
+    REQUIRE(sf_uudecode((uint8_t*)src, strlen(src), dst, sizeof(dst), &read, &copied,
+        &begin_found, &end_found) == 0);
+
+    CHECK(begin_found);
+    CHECK(std::string((const char*)dst, copied) == "foobar");
+}
+
+TEST_CASE("strip CRLF", "[mime_decode]")
+{
+    CHECK(strip("foo\r\nbar\n\rbaz") == "foobarbaz");
+    CHECK(strip("\r\n\r\n") == "");
+    CHECK(strip("foo\r\nbar", 4) == "foob");
+}
+
+#endif
+
+#ifdef BENCHMARK_TEST
+
+static std::string make_b64(size_t len)
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string str;
+
+    for (size_t i = 0; i < len; ++i)
+    {
+        str += alphabet[i % 64];
+        if (i % 76 == 75)
+            str += "\r\n";
+    }
+
+    return str;
+}
+
+TEST_CASE("decoders, 64 K", "[mime_decode]")
+{
+    constexpr size_t size = 1 << 16;
+    static uint8_t dst[size];
+    static uint8_t tmp[size * 2];
+    uint32_t read = 0;
+    uint32_t written = 0;
+
+    auto data_b64 = make_b64(size);
+    std::string data_qp;
+
+    while (data_qp.size() < size)
+        data_qp += "Lorem ipsum dolor sit amet, =C3=A9t=C3=A9 consectetur=\r\n";
+
+    BENCHMARK("memcpy()")
+    {
+        return memcpy(dst, data_b64.c_str(), size);
+    };
+
+    BENCHMARK("strip CRLF")
+    {
+        return sf_strip_CRLF((const uint8_t*)data_b64.c_str(), data_b64.size(), tmp, sizeof(tmp),
+            &written);
+    };
+
+    BENCHMARK("base64")
+    {
+        return sf_base64decode((uint8_t*)&data_b64[0], data_b64.size(), dst, sizeof(dst),
+            &written);
+    };
+
+    BENCHMARK("quoted-printable")
+    {
+        return sf_qpdecode(data_qp.c_str(), data_qp.size(), (char*)dst, sizeof(dst), &read,
+            &written);
+    };
+}
+
+#endif
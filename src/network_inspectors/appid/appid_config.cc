@@ -93,6 +93,9 @@ void AppIdConfig::show() const
     ConfigLogger::log_flag("log_all_sessions", log_all_sessions);
     ConfigLogger::log_flag("log_stats", log_stats);
     ConfigLogger::log_value("memcap", memcap);
+    ConfigLogger::log_value("learned_app_cache_memcap", learned_app_cache_memcap);
+    ConfigLogger::log_value("learned_app_cache_confidence", learned_app_cache_confidence);
+    ConfigLogger::log_value("learned_app_cache_timeout", learned_app_cache_timeout);
 }
 
 static bool once = false;
@@ -199,6 +202,8 @@ OdpContext::OdpContext(const AppIdConfig& config, SnortConfig* sc)
     app_info_mgr.init_appid_info_table(config, sc, *this);
     client_pattern_detector = new PatternClientDetector(&client_disco_mgr);
     service_pattern_detector = new PatternServiceDetector(&service_disco_mgr);
+    learned_app_cache.configure(config.learned_app_cache_memcap,
+        config.learned_app_cache_confidence, config.learned_app_cache_timeout);
     version = next_version++;
 }
 
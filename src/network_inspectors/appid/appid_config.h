@@ -37,6 +37,7 @@
 #include "detector_plugins/sip_patterns.h"
 #include "detector_plugins/ssl_patterns.h"
 #include "host_port_app_cache.h"
+#include "learned_app_cache.h"
 #include "length_app_cache.h"
 #include "lua_detector_flow_api.h"
 #include "lua_detector_module.h"
@@ -100,6 +101,9 @@ public:
     bool tp_appid_stats_enable = false;
     bool tp_appid_config_dump = false;
     size_t memcap = 0;
+    size_t learned_app_cache_memcap = 0;
+    uint8_t learned_app_cache_confidence = 3;
+    uint32_t learned_app_cache_timeout = 3600;
     bool list_odp_detectors = false;
     bool log_all_sessions = false;
     bool enable_rna_filter = false;
@@ -184,6 +188,11 @@ public:
         return first_pkt_cache.find_on_first_pkt(ip, port, proto, *this);
     }
 
+    LearnedAppCache& get_learned_app_cache()
+    {
+        return learned_app_cache;
+    }
+
     AppId length_cache_find(const LengthKey& key)
     {
         return length_cache.find(key);
@@ -259,6 +268,7 @@ private:
     HostPortCache host_port_cache;
     HostPortCache first_pkt_cache;
     LengthCache length_cache;
+    LearnedAppCache learned_app_cache;
     CipPatternMatchers cip_matchers;
     DnsPatternMatchers dns_matchers;
     HttpPatternMatchers http_matchers;
@@ -31,6 +31,7 @@
 #include "profiler/profiler.h"
 #include "protocols/packet.h"
 #include "protocols/tcp.h"
+#include "time/packet_time.h"
 
 #include "appid_config.h"
 #include "appid_debug.h"
@@ -44,6 +45,7 @@
 #include "detector_plugins/detector_dns.h"
 #include "detector_plugins/http_url_patterns.h"
 #include "host_port_app_cache.h"
+#include "learned_app_cache.h"
 #include "service_plugins/service_discovery.h"
 #include "tp_lib_handler.h"
 #include "tp_appid_utils.h"
@@ -536,23 +538,24 @@ static inline bool is_check_host_cache_valid(AppIdSession& asd, AppId service_id
     return false;
 }
 
-bool AppIdDiscovery::detect_on_first_pkt(Packet* p, AppIdSession& asd,
-    IpProtocol protocol, AppidSessionDirection direction, AppId& service_id,
-    AppId& client_id, AppId& payload_id)
+static inline const SfIp* get_server(const Packet* p, AppidSessionDirection direction,
+    uint16_t& port)
 {
-    uint16_t port;
-    const SfIp* ip;
-
     if (direction == APP_ID_FROM_INITIATOR)
     {
-        ip = p->ptrs.ip_api.get_dst();
         port = p->ptrs.dp;
+        return p->ptrs.ip_api.get_dst();
     }
-    else
-    {
-        ip = p->ptrs.ip_api.get_src();
-        port = p->ptrs.sp;
-    }
+    port = p->ptrs.sp;
+    return p->ptrs.ip_api.get_src();
+}
+
+bool AppIdDiscovery::detect_on_first_pkt(Packet* p, AppIdSession& asd,
+    IpProtocol protocol, AppidSessionDirection direction, AppId& service_id,
+    AppId& client_id, AppId& payload_id)
+{
+    uint16_t port;
+    const SfIp* ip = get_server(p, direction, port);
 
     HostAppIdsVal* hv = nullptr;
     hv = asd.get_odp_ctxt().host_first_pkt_find(ip, port, protocol);
@@ -650,6 +653,61 @@ bool AppIdDiscovery::detect_on_first_pkt(Packet* p, AppIdSession& asd,
     return false;
 }
 
+static void detect_from_learned_cache(Packet* p, AppIdSession& asd, IpProtocol protocol,
+    AppidSessionDirection direction)
+{
+    LearnedAppCache& cache = asd.get_odp_ctxt().get_learned_app_cache();
+
+    if (!cache.enabled() or (protocol != IpProtocol::TCP and protocol != IpProtocol::UDP))
+        return;
+
+    uint16_t port;
+    const SfIp* ip = get_server(p, direction, port);
+    AppId id = cache.find(ip, port, protocol, packet_time());
+
+    if (id <= APP_ID_NONE)
+        return;
+
+    asd.set_service_id(id, asd.get_odp_ctxt());
+    asd.sync_with_snort_protocol_id(id, p);
+    asd.service_disco_state = APPID_DISCO_STATE_FINISHED;
+    asd.set_session_flags(APPID_SESSION_SERVICE_DETECTED | APPID_SESSION_LEARNED_CACHE_MATCHED);
+    appid_stats.learned_cache_hits++;
+
+    const char *app_name = asd.get_odp_ctxt().get_app_info_mgr().get_app_name(id);
+    appid_log(p, TRACE_DEBUG_LEVEL, "Learned cache match found on first packet, service: %s(%d)\n",
+        app_name ? app_name : "unknown", id);
+}
+
+// remember the service of a flow that discovery identified itself
+static void learn_service(Packet* p, AppIdSession& asd, IpProtocol protocol,
+    AppidSessionDirection direction)
+{
+    if (asd.service_disco_state != APPID_DISCO_STATE_FINISHED or
+        asd.get_session_flags(APPID_SESSION_LEARNED_CACHE_DONE |
+            APPID_SESSION_LEARNED_CACHE_MATCHED | APPID_SESSION_HOST_CACHE_MATCHED |
+            APPID_SESSION_FIRST_PKT_CACHE_MATCHED | APPID_SESSION_DECRYPTED |
+            APPID_SESSION_HTTP_TUNNEL))
+        return;
+
+    LearnedAppCache& cache = asd.get_odp_ctxt().get_learned_app_cache();
+
+    if (!cache.enabled())
+        return;
+
+    asd.set_session_flags(APPID_SESSION_LEARNED_CACHE_DONE);
+    AppId id = asd.get_service_id();
+
+    if (id <= APP_ID_NONE)
+        return;
+
+    uint16_t port;
+    const SfIp* ip = get_server(p, direction, port);
+
+    if (cache.learn(ip, port, protocol, packet_time(), id))
+        appid_stats.learned_cache_adds++;
+}
+
 bool AppIdDiscovery::do_discovery(Packet* p, AppIdSession& asd, IpProtocol protocol,
     IpProtocol outer_protocol, AppidSessionDirection direction, AppId& service_id,
     AppId& client_id, AppId& payload_id, AppId& misc_id, AppidChangeBits& change_bits,
@@ -659,7 +717,8 @@ bool AppIdDiscovery::do_discovery(Packet* p, AppIdSession& asd, IpProtocol proto
 
     if (asd.session_packet_count == 1)
     {
-        detect_on_first_pkt(p, asd, protocol, direction, service_id, client_id, payload_id);
+        if (!detect_on_first_pkt(p, asd, protocol, direction, service_id, client_id, payload_id))
+            detect_from_learned_cache(p, asd, protocol, direction);
     }
 
     if (asd.get_session_flags(APPID_SESSION_FIRST_PKT_CACHE_MATCHED) and !asd.get_odp_ctxt().need_reinspection)
@@ -821,6 +880,8 @@ bool AppIdDiscovery::do_discovery(Packet* p, AppIdSession& asd, IpProtocol proto
         }
     }
 
+    learn_service(p, asd, protocol, direction);
+
     return is_discovery_done;
 }
 
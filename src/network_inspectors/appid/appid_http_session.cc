@@ -285,11 +285,9 @@ void AppIdHttpSession::init_chp_match_descriptor(ChpMatchDescriptor& cmd)
     }
 }
 
-void AppIdHttpSession::process_chp_buffers(AppidChangeBits& change_bits, HttpPatternMatchers& http_matchers)
+void AppIdHttpSession::process_chp_buffers(ChpMatchDescriptor& cmd, AppidChangeBits& change_bits,
+    HttpPatternMatchers& http_matchers)
 {
-    ChpMatchDescriptor cmd;
-
-    init_chp_match_descriptor(cmd);
     if ( chp_hold_flow )
         chp_finished = false;
 
@@ -556,8 +554,12 @@ int AppIdHttpSession::process_http_packet(AppidSessionDirection direction,
         }
     }
 
+    // fields scanned for CHP patterns here also answer the simple lookups below
+    ChpMatchDescriptor cmd;
+    init_chp_match_descriptor(cmd);
+
     if (!chp_finished or chp_hold_flow)
-        process_chp_buffers(change_bits, http_matchers);
+        process_chp_buffers(cmd, change_bits, http_matchers);
 
     if (skip_simple_detect) // true if process_chp_buffers() found match
         return 0;
@@ -604,7 +606,7 @@ int AppIdHttpSession::process_http_packet(AppidSessionDirection direction,
             AppId client_id = APP_ID_NONE;
 
             http_matchers.identify_user_agent(useragent->c_str(), useragent->size(),
-                service_id, client_id, &version);
+                service_id, client_id, &version, &cmd);
             if (service_id > APP_ID_NONE and service_id != APP_ID_HTTP and asd.get_service_id() != service_id)
             {
                 const char* app_name = asd.get_odp_ctxt().get_app_info_mgr().get_app_name(service_id);
@@ -663,7 +665,7 @@ int AppIdHttpSession::process_http_packet(AppidSessionDirection direction,
         and content_type and !asd.get_tp_payload_app_id() and payload.get_id() <= APP_ID_NONE)
     {
         AppId payload_id = http_matchers.get_appid_by_content_type(content_type->c_str(),
-            content_type->size());
+            content_type->size(), &cmd);
         set_payload(payload_id, change_bits, "Content-Type");
         is_payload_processed = true;
         asd.scan_flags &= ~SCAN_HTTP_CONTENT_TYPE_FLAG;
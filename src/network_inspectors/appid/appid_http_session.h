@@ -161,7 +161,7 @@ protected:
 
     void init_chp_match_descriptor(ChpMatchDescriptor& cmd);
     bool initial_chp_sweep(ChpMatchDescriptor&, HttpPatternMatchers&);
-    void process_chp_buffers(AppidChangeBits&, HttpPatternMatchers&);
+    void process_chp_buffers(ChpMatchDescriptor&, AppidChangeBits&, HttpPatternMatchers&);
     void free_chp_matches(ChpMatchDescriptor& cmd, unsigned max_matches);
     void set_http_change_bits(AppidChangeBits& change_bits, HttpFieldIds id);
     void set_scan_flags(HttpFieldIds id);
@@ -62,6 +62,7 @@ THREAD_LOCAL const Trace* appid_trace = nullptr;
 
 THREAD_LOCAL ProfileStats appid_perf_stats;
 THREAD_LOCAL ProfileStats tp_appid_perf_stats;
+THREAD_LOCAL ProfileStats lua_detector_perf_stats;
 THREAD_LOCAL AppIdStats appid_stats;
 THREAD_LOCAL bool ThirdPartyAppIdContext::tp_reload_in_progress = false;
 
@@ -80,6 +81,12 @@ static const Parameter s_params[] =
 #endif
     { "memcap", Parameter::PT_INT, "1024:maxSZ", "1048576",
       "max size of the service cache before we start pruning the cache" },
+    { "learned_app_cache_memcap", Parameter::PT_INT, "0:maxSZ", "0",
+      "max size of the cache of identifications learned by server, 0 to disable" },
+    { "learned_app_cache_confidence", Parameter::PT_INT, "1:16", "3",
+      "number of agreeing flows needed before a learned identification is used" },
+    { "learned_app_cache_timeout", Parameter::PT_INT, "0:max32", "3600",
+      "seconds a learned identification is used without being confirmed, 0 for no limit" },
     { "log_stats", Parameter::PT_BOOL, nullptr, "false",
       "enable logging of appid statistics" },
     { "app_stats_period", Parameter::PT_INT, "1:max32", "300",
@@ -470,6 +477,12 @@ static const PegInfo appid_pegs[] =
     { CountType::SUM, "tp_reload_ignored_pkts", "count of packets ignored after third-party module is reloaded" },
     { CountType::NOW, "bytes_in_use", "number of bytes in use in the cache" },
     { CountType::NOW, "items_in_use", "items in use in the cache" },
+    { CountType::SUM, "http_field_scans", "count of HTTP header field pattern scans" },
+    { CountType::SUM, "http_field_scans_saved", "count of HTTP header field lookups that reused a CHP scan" },
+    { CountType::SUM, "lua_validations", "count of calls to Lua detector validate functions" },
+    { CountType::SUM, "lua_validate_errors", "count of Lua detector validate calls that failed" },
+    { CountType::SUM, "learned_cache_hits", "count of flows identified on the first packet from learned identifications" },
+    { CountType::SUM, "learned_cache_adds", "count of servers added to the learned identification cache" },
     { CountType::END, nullptr, nullptr },
 };
 
@@ -509,6 +522,11 @@ snort::ProfileStats* AppIdModule::get_profile(
             name = "tp_appid";
             parent = get_name();
             return &tp_appid_perf_stats;
+
+        case 2:
+            name = "lua_detectors";
+            parent = get_name();
+            return &lua_detector_perf_stats;
     }
     return nullptr;
 }
@@ -536,6 +554,12 @@ bool AppIdModule::set(const char*, Value& v, SnortConfig*)
 #endif
     if ( v.is("memcap") )
         config->memcap = v.get_size();
+    else if ( v.is("learned_app_cache_memcap") )
+        config->learned_app_cache_memcap = v.get_size();
+    else if ( v.is("learned_app_cache_confidence") )
+        config->learned_app_cache_confidence = v.get_uint8();
+    else if ( v.is("learned_app_cache_timeout") )
+        config->learned_app_cache_timeout = v.get_uint32();
     else if ( v.is("log_stats") )
         config->log_stats = v.get_bool();
     else if ( v.is("app_stats_period") )
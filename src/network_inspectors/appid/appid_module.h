@@ -41,6 +41,7 @@ class Trace;
 
 extern THREAD_LOCAL snort::ProfileStats appid_perf_stats;
 extern THREAD_LOCAL snort::ProfileStats tp_appid_perf_stats;
+extern THREAD_LOCAL snort::ProfileStats lua_detector_perf_stats;
 extern THREAD_LOCAL const snort::Trace* appid_trace;
 
 #define MOD_NAME "appid"
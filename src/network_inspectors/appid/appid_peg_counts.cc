@@ -34,38 +34,54 @@
 
 using namespace snort;
 
-THREAD_LOCAL AppIdPegCounts::AppIdDynamicPeg* AppIdPegCounts::unknown_appids_peg;
-THREAD_LOCAL std::unordered_map<AppId, AppIdPegCounts::AppIdDynamicPeg>* AppIdPegCounts::appid_peg_counts;
+THREAD_LOCAL AppIdPegCounts::ThreadPegs* AppIdPegCounts::thread_pegs = nullptr;
 std::unordered_map<AppId, std::pair<std::string, uint32_t>> AppIdPegCounts::appid_peg_ids;
+std::shared_ptr<const AppIdPegCounts::PegIndex> AppIdPegCounts::peg_index;
 AppIdPegCounts::AppIdDynamicPeg AppIdPegCounts::appid_dynamic_sum[SF_APPID_MAX + 1];
 AppIdPegCounts::AppIdDynamicPeg AppIdPegCounts::zeroed_peg;
 PegCount AppIdPegCounts::all_zeroed_peg[DetectorPegs::NUM_APPID_DETECTOR_PEGS] = {};
 
 static std::mutex dynamic_stats_mutex;
+static std::mutex peg_index_mutex;
 
-void AppIdPegCounts::init_pegs()
+// the index is built from appid_peg_ids when the first thread asks for it
+// after the peg info changed; threads keep the index they started with
+std::shared_ptr<const AppIdPegCounts::PegIndex> AppIdPegCounts::get_peg_index()
 {
-    assert(!appid_peg_counts);
-    appid_peg_counts = new std::unordered_map<AppId, AppIdPegCounts::AppIdDynamicPeg>();
+    const std::lock_guard<std::mutex> _lock(peg_index_mutex);
 
-    for (auto& appid : appid_peg_ids)
+    if (!peg_index)
     {
-        appid_peg_counts->emplace(appid.first, zeroed_peg);
+        auto index = std::make_shared<PegIndex>();
+        index->reserve(appid_peg_ids.size());
+
+        for (auto& appid : appid_peg_ids)
+            index->emplace(appid.first, appid.second.second);
+
+        peg_index = index;
     }
-    unknown_appids_peg = new AppIdDynamicPeg(zeroed_peg);
+    return peg_index;
+}
+
+void AppIdPegCounts::init_pegs()
+{
+    assert(!thread_pegs);
+    thread_pegs = new ThreadPegs;
+    thread_pegs->peg_index = get_peg_index();
+    thread_pegs->counts.resize(thread_pegs->peg_index->size());
 }
 
 void AppIdPegCounts::cleanup_pegs()
 {
-    delete appid_peg_counts;
-    appid_peg_counts = nullptr;
-    delete unknown_appids_peg;
-    unknown_appids_peg = nullptr;
+    delete thread_pegs;
+    thread_pegs = nullptr;
 }
 
 void AppIdPegCounts::cleanup_peg_info()
 {
+    const std::lock_guard<std::mutex> _lock(peg_index_mutex);
     appid_peg_ids.clear();
+    peg_index.reset();
 }
 
 void AppIdPegCounts::cleanup_dynamic_sum()
@@ -78,104 +94,92 @@ void AppIdPegCounts::cleanup_dynamic_sum()
             DetectorPegs::NUM_APPID_DETECTOR_PEGS);
     }
 
-    if (appid_peg_counts)
-    {
-        for (auto& peg : (*appid_peg_counts))
-        {
-            memset(&peg.second.stats, 0, sizeof(PegCount) * DetectorPegs::NUM_APPID_DETECTOR_PEGS);
-        }
-    }
-
     // reset unknown_app stats
     memset(appid_dynamic_sum[SF_APPID_MAX].stats, 0, sizeof(PegCount) *
         DetectorPegs::NUM_APPID_DETECTOR_PEGS);
-    if (unknown_appids_peg)
-        memset(&unknown_appids_peg->stats, 0, sizeof(PegCount) * DetectorPegs::NUM_APPID_DETECTOR_PEGS);
 
+    if (thread_pegs)
+    {
+        for (auto& peg : thread_pegs->counts)
+            peg.zero_out();
+
+        thread_pegs->unknown.zero_out();
+    }
 }
 
 void AppIdPegCounts::add_app_peg_info(std::string app_name, AppId app_id)
 {
     std::replace(app_name.begin(), app_name.end(), ' ', '_');
 
+    const std::lock_guard<std::mutex> _lock(peg_index_mutex);
     appid_peg_ids.emplace(app_id, std::make_pair(app_name, appid_peg_ids.size()));
+    peg_index.reset();
 }
 
 void AppIdPegCounts::sum_stats()
 {
-    if (!appid_peg_counts or !unknown_appids_peg)
+    if (!thread_pegs)
         return;
 
     const std::lock_guard<std::mutex> _lock(dynamic_stats_mutex);
+    unsigned num_pegs = std::min(thread_pegs->counts.size(), (size_t)SF_APPID_MAX);
 
-    for (auto& peg : (*appid_peg_counts))
+    for (unsigned i = 0; i < num_pegs; ++i)
     {
-        auto dyn_indx = appid_peg_ids[peg.first].second;
+        AppIdDynamicPeg& peg = thread_pegs->counts[i];
+
         for (unsigned j = 0; j < DetectorPegs::NUM_APPID_DETECTOR_PEGS; ++j)
-            appid_dynamic_sum[dyn_indx].stats[j] += peg.second.stats[j];
+            appid_dynamic_sum[i].stats[j] += peg.stats[j];
 
-        peg.second.zero_out();
+        peg.zero_out();
     }
 
     // unknown_app stats
     for (unsigned j = 0; j < DetectorPegs::NUM_APPID_DETECTOR_PEGS; ++j)
-        appid_dynamic_sum[SF_APPID_MAX].stats[j] += unknown_appids_peg->stats[j];
+        appid_dynamic_sum[SF_APPID_MAX].stats[j] += thread_pegs->unknown.stats[j];
+
+    thread_pegs->unknown.zero_out();
+}
+
+AppIdPegCounts::AppIdDynamicPeg& AppIdPegCounts::get_peg(AppId id)
+{
+    const PegIndex& index = *thread_pegs->peg_index;
+    auto peg = index.find(id);
+
+    if (peg != index.end())
+        return thread_pegs->counts[peg->second];
 
-    unknown_appids_peg->zero_out();
+    return thread_pegs->unknown;
 }
 
 void AppIdPegCounts::inc_service_count(AppId id)
 {
-    auto peg = appid_peg_counts->find(id);
-    if (peg != appid_peg_counts->end())
-        peg->second.stats[DetectorPegs::SERVICE_DETECTS]++;
-    else
-        unknown_appids_peg->stats[DetectorPegs::SERVICE_DETECTS]++;
+    get_peg(id).stats[DetectorPegs::SERVICE_DETECTS]++;
 }
 
 void AppIdPegCounts::inc_client_count(AppId id)
 {
-    auto peg = appid_peg_counts->find(id);
-    if (peg != appid_peg_counts->end())
-        peg->second.stats[DetectorPegs::CLIENT_DETECTS]++;
-    else
-        unknown_appids_peg->stats[DetectorPegs::CLIENT_DETECTS]++;
+    get_peg(id).stats[DetectorPegs::CLIENT_DETECTS]++;
 }
 
 void AppIdPegCounts::inc_payload_count(AppId id)
 {
-    auto peg = appid_peg_counts->find(id);
-    if (peg != appid_peg_counts->end())
-        peg->second.stats[DetectorPegs::PAYLOAD_DETECTS]++;
-    else
-        unknown_appids_peg->stats[DetectorPegs::PAYLOAD_DETECTS]++;
+    get_peg(id).stats[DetectorPegs::PAYLOAD_DETECTS]++;
 }
 
 void AppIdPegCounts::inc_user_count(AppId id)
 {
-    auto peg = appid_peg_counts->find(id);
-    if (peg != appid_peg_counts->end())
-        peg->second.stats[DetectorPegs::USER_DETECTS]++;
-    else
-        unknown_appids_peg->stats[DetectorPegs::USER_DETECTS]++;
+    get_peg(id).stats[DetectorPegs::USER_DETECTS]++;
 }
 
 void AppIdPegCounts::inc_misc_count(AppId id)
 {
-    auto peg = appid_peg_counts->find(id);
-    if (peg != appid_peg_counts->end())
-        peg->second.stats[DetectorPegs::MISC_DETECTS]++;
-    else
-        unknown_appids_peg->stats[DetectorPegs::MISC_DETECTS]++;
+    get_peg(id).stats[DetectorPegs::MISC_DETECTS]++;
 }
 
 void AppIdPegCounts::inc_referred_count(AppId id)
 {
-    auto peg = appid_peg_counts->find(id);
-    if (peg != appid_peg_counts->end())
-        peg->second.stats[DetectorPegs::REFERRED_DETECTS]++;
-    else
-        unknown_appids_peg->stats[DetectorPegs::REFERRED_DETECTS]++;
+    get_peg(id).stats[DetectorPegs::REFERRED_DETECTS]++;
 }
 
 void AppIdPegCounts::print()
@@ -28,10 +28,12 @@
 // initialize the PegCount array when that file is loaded.
 // Functions for incrementing the peg counts are also provided.
 // The AppId can be a very large number so using it as the array index is not practical.
-// Packet threads are using dynamic pegs, and std::map that is used to translate the AppId to its
-// array index.
+// Packet threads are using dynamic pegs, and a map that is used to translate the AppId to its
+// array index.  The map is built once and shared read only by the packet threads; each thread
+// only has its array of counts.
 // Only the main thread is using a static array.
 
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -55,6 +57,12 @@ struct AppIdStats
     PegCount tp_reload_ignored_pkts;
     PegCount bytes_in_use;
     PegCount items_in_use;
+    PegCount http_field_scans;
+    PegCount http_field_scans_saved;
+    PegCount lua_validations;
+    PegCount lua_validate_errors;
+    PegCount learned_cache_hits;
+    PegCount learned_cache_adds;
 };
 
 class AppIdPegCounts
@@ -112,10 +120,24 @@ public:
     static void print();
 
 private:
+    friend class AppIdPegCountsTest; // for unit test
+
+    typedef std::unordered_map<AppId, uint32_t> PegIndex;
+
+    struct ThreadPegs
+    {
+        std::shared_ptr<const PegIndex> peg_index;
+        std::vector<AppIdDynamicPeg> counts;
+        AppIdDynamicPeg unknown;
+    };
+
+    static AppIdDynamicPeg& get_peg(AppId);
+    static std::shared_ptr<const PegIndex> get_peg_index();
+
     static AppIdDynamicPeg appid_dynamic_sum[SF_APPID_MAX+1];
-    static THREAD_LOCAL AppIdDynamicPeg* unknown_appids_peg;
-    static THREAD_LOCAL std::unordered_map<AppId, AppIdPegCounts::AppIdDynamicPeg>* appid_peg_counts;
+    static THREAD_LOCAL ThreadPegs* thread_pegs;
     static std::unordered_map<AppId, std::pair<std::string, uint32_t>> appid_peg_ids;
+    static std::shared_ptr<const PegIndex> peg_index;
     static AppIdDynamicPeg zeroed_peg;
     static PegCount all_zeroed_peg[DetectorPegs::NUM_APPID_DETECTOR_PEGS];
 };
@@ -94,6 +94,8 @@ namespace snort
 #define APPID_SESSION_FIRST_PKT_CACHE_MATCHED    (1ULL << 45)
 #define APPID_SESSION_DO_NOT_DECRYPT        (1ULL << 46)
 #define APPID_SESSION_EARLY_SSH_DETECTED        (1ULL << 47)
+#define APPID_SESSION_LEARNED_CACHE_MATCHED     (1ULL << 48)
+#define APPID_SESSION_LEARNED_CACHE_DONE        (1ULL << 49)
 #define APPID_SESSION_IGNORE_ID_FLAGS \
     (APPID_SESSION_FUTURE_FLOW | \
     APPID_SESSION_NOT_A_SERVICE | \
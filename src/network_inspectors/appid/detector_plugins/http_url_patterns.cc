@@ -144,15 +144,6 @@ static const char GOOGLE_TB_PATTERN[] = "toolbarqueries.google.com";
 
 #define COMPATIBLE_BROWSER_STRING " (Compat)"
 
-struct MatchedPatterns
-{
-    DetectorHTTPPattern* mpattern;
-    int after_match_pos;  // Warning: may point past end of buffer.
-                          // Position of character in buffer after last
-                          // matching character.
-    MatchedPatterns* next;
-};
-
 static DetectorHTTPPatterns static_content_type_patterns =
 {
     { SINGLE, 0, APP_ID_QUICKTIME, 0,
@@ -639,6 +630,48 @@ static int http_pattern_match(void* id, void*, int match_end_pos, void* data, vo
         return 0;
 }
 
+struct FieldScan
+{
+    ChpMatchDescriptor* cmd;    // null when only the simple patterns are wanted
+    MatchedPatterns** matches;
+    HttpFieldIds field;
+    bool key;
+    bool simple_done;
+};
+
+// the simple patterns are collected as by content_pattern_match or
+// http_pattern_match; a scan for CHP keeps going after the user agent
+// lookup would have stopped
+static int field_pattern_match(void* id, void*, int match_end_pos, void* data, void*)
+{
+    FieldScan* scan = (FieldScan*)data;
+    const FieldPatternId* fid = (const FieldPatternId*)id;
+
+    if ( fid->chp )
+    {
+        if ( !scan->cmd )
+            return 0;
+
+        if ( scan->key )
+            return chp_key_pattern_match(fid->chp, nullptr, match_end_pos, scan->cmd, nullptr);
+
+        return chp_pattern_match(fid->chp, nullptr, match_end_pos, scan->cmd, nullptr);
+    }
+
+    if ( scan->simple_done )
+        return 0;
+
+    if ( scan->field == RSP_CONTENT_TYPE_FID )
+        return content_pattern_match(fid->pattern, nullptr, match_end_pos, scan->matches, nullptr);
+
+    if ( http_pattern_match(fid->pattern, nullptr, match_end_pos, scan->matches, nullptr) )
+    {
+        scan->simple_done = true;
+        return scan->cmd ? 0 : 1;
+    }
+    return 0;
+}
+
 int HttpPatternMatchers::process_host_patterns(DetectorHTTPPatterns& patterns)
 {
     if (!host_url_matcher)
@@ -664,46 +697,18 @@ int HttpPatternMatchers::process_host_patterns(DetectorHTTPPatterns& patterns)
 int HttpPatternMatchers::process_chp_list(CHPListElement* chplist)
 {
     for (CHPListElement* chpe = chplist; chpe; chpe = chpe->next)
-        chp_matchers[chpe->chp_action.ptype].add(chpe->chp_action.pattern,
-            chpe->chp_action.psize, &chpe->chp_action, true);
+    {
+        field_pattern_ids.push_back({ &chpe->chp_action, nullptr });
+        field_matchers[chpe->chp_action.ptype].add(chpe->chp_action.pattern,
+            chpe->chp_action.psize, &field_pattern_ids.back(), true);
+    }
 
     for (size_t i = 0; i < NUM_HTTP_FIELDS; i++)
-        chp_matchers[i].prep();
+        field_matchers[i].prep();
 
     return 1;
 }
 
-#define HTTP_FIELD_PREFIX_USER_AGENT    "\r\nUser-Agent: "
-#define HTTP_FIELD_PREFIX_USER_AGENT_SIZE (sizeof(HTTP_FIELD_PREFIX_USER_AGENT)-1)
-#define HTTP_FIELD_PREFIX_HOST    "\r\nHost: "
-#define HTTP_FIELD_PREFIX_HOST_SIZE (sizeof(HTTP_FIELD_PREFIX_HOST)-1)
-#define HTTP_FIELD_PREFIX_REFERER    "\r\nReferer: "
-#define HTTP_FIELD_PREFIX_REFERER_SIZE (sizeof(HTTP_FIELD_PREFIX_REFERER)-1)
-#define HTTP_FIELD_PREFIX_URI    " "
-#define HTTP_FIELD_PREFIX_URI_SIZE (sizeof(HTTP_FIELD_PREFIX_URI)-1)
-#define HTTP_FIELD_PREFIX_COOKIE    "\r\nCookie: "
-#define HTTP_FIELD_PREFIX_COOKIE_SIZE (sizeof(HTTP_FIELD_PREFIX_COOKIE)-1)
-
-static FieldPattern http_field_patterns[] =
-{
-    { (const uint8_t*)HTTP_FIELD_PREFIX_URI, REQ_URI_FID, HTTP_FIELD_PREFIX_URI_SIZE },
-    { (const uint8_t*)HTTP_FIELD_PREFIX_HOST, REQ_HOST_FID, HTTP_FIELD_PREFIX_HOST_SIZE },
-    { (const uint8_t*)HTTP_FIELD_PREFIX_REFERER, REQ_REFERER_FID, HTTP_FIELD_PREFIX_REFERER_SIZE },
-    { (const uint8_t*)HTTP_FIELD_PREFIX_COOKIE, REQ_COOKIE_FID, HTTP_FIELD_PREFIX_COOKIE_SIZE },
-    { (const uint8_t*)HTTP_FIELD_PREFIX_USER_AGENT, REQ_AGENT_FID,
-      HTTP_FIELD_PREFIX_USER_AGENT_SIZE },
-};
-
-void HttpPatternMatchers::process_http_field_patterns(FieldPattern* patternList,
-    size_t patternListCount)
-{
-    for (size_t i = 0; i < patternListCount; i++)
-        field_matcher.add( (const char*)patternList[i].data, patternList[i].length,
-            &patternList[i], false);
-
-    field_matcher.prep();
-}
-
 static void process_patterns(SearchTool& matcher, DetectorHTTPPatterns& patterns, bool
     last = true)
 {
@@ -714,21 +719,31 @@ static void process_patterns(SearchTool& matcher, DetectorHTTPPatterns& patterns
         matcher.prep();
 }
 
+void HttpPatternMatchers::add_field_patterns(HttpFieldIds field, DetectorHTTPPatterns& patterns,
+    bool no_case)
+{
+    for (auto& pat: patterns)
+    {
+        field_pattern_ids.push_back({ nullptr, &pat });
+        field_matchers[field].add(pat.pattern, pat.pattern_size, &field_pattern_ids.back(),
+            no_case);
+    }
+}
+
+// the user agent and content type patterns are compiled with the CHP
+// patterns of their field so that one scan of the field finds both
 int HttpPatternMatchers::finalize_patterns()
 {
     process_patterns(via_matcher, static_via_http_detector_patterns);
-    process_patterns(url_matcher, url_patterns);
-    process_patterns(client_agent_matcher, static_client_agent_patterns, false);
-    process_patterns(client_agent_matcher, client_agent_patterns);
+
+    add_field_patterns(REQ_AGENT_FID, static_client_agent_patterns, false);
+    add_field_patterns(REQ_AGENT_FID, client_agent_patterns, false);
 
     if (process_host_patterns(static_http_host_payload_patterns) < 0)
         return -1;
 
-    process_patterns(content_type_matcher, static_content_type_patterns, false);
-    process_patterns(content_type_matcher, content_type_patterns);
-
-    uint32_t numPatterns = sizeof(http_field_patterns) / sizeof(*http_field_patterns);
-    process_http_field_patterns(http_field_patterns, numPatterns);
+    add_field_patterns(RSP_CONTENT_TYPE_FID, static_content_type_patterns, false);
+    add_field_patterns(RSP_CONTENT_TYPE_FID, content_type_patterns, false);
 
     process_chp_list(chpList);
 
@@ -738,16 +753,12 @@ int HttpPatternMatchers::finalize_patterns()
 void HttpPatternMatchers::reload_patterns()
 {
     via_matcher.reload();
-    url_matcher.reload();
-    client_agent_matcher.reload();
     assert(host_url_matcher);
     mlmp_reload_patterns(*host_url_matcher);
     assert(rtmp_host_url_matcher);
     mlmp_reload_patterns(*rtmp_host_url_matcher);
-    content_type_matcher.reload();
-    field_matcher.reload();
     for (size_t i = 0; i < NUM_HTTP_FIELDS; i++)
-        chp_matchers[i].reload();
+        field_matchers[i].reload();
 }
 
 unsigned HttpPatternMatchers::get_pattern_count()
@@ -864,11 +875,32 @@ static void extract_chp(const char* buf, int bs, int start, int psize, char* ada
     *outbuf = snort_strndup(begin, end - begin);
 }
 
-void HttpPatternMatchers::scan_key_chp(ChpMatchDescriptor& cmd)
+// scan the current field of the descriptor for its CHP and simple patterns
+void HttpPatternMatchers::scan_field(ChpMatchDescriptor& cmd, bool key)
 {
     unsigned i = cmd.cur_ptype;
-    chp_matchers[i].find_all(cmd.buffer[i], cmd.length[i], &chp_key_pattern_match,
-        false, (void*)&cmd);
+    FieldScan scan = { &cmd, &cmd.field_matches[i], cmd.cur_ptype, key, false };
+
+    field_matchers[i].find_all(cmd.buffer[i], cmd.length[i], &field_pattern_match,
+        false, (void*)&scan);
+    cmd.scanned[i] = true;
+    appid_stats.http_field_scans++;
+}
+
+MatchedPatterns* HttpPatternMatchers::scan_simple_field(HttpFieldIds field, const char* data,
+    unsigned size)
+{
+    MatchedPatterns* mp = nullptr;
+    FieldScan scan = { nullptr, &mp, field, false, false };
+
+    field_matchers[field].find_all(data, size, &field_pattern_match, false, (void*)&scan);
+    appid_stats.http_field_scans++;
+    return mp;
+}
+
+void HttpPatternMatchers::scan_key_chp(ChpMatchDescriptor& cmd)
+{
+    scan_field(cmd, true);
     cmd.sort_chp_matches();
 }
 
@@ -881,8 +913,7 @@ AppId HttpPatternMatchers::scan_chp(ChpMatchDescriptor& cmd, char** version, cha
     if ( pt > MAX_KEY_PATTERN )
     {
         // There is no previous attempt to match generated by scan_key_chp()
-        chp_matchers[pt].find_all(cmd.buffer[pt], cmd.length[pt], &chp_pattern_match, false,
-            (void*)&cmd);
+        scan_field(cmd, false);
     }
 
     if ( cmd.chp_matches[pt].empty() )
@@ -982,12 +1013,19 @@ static inline const char* continue_buffer_scan(const char* start, const char* en
 }
 
 void HttpPatternMatchers::identify_user_agent(const char* start, int size, AppId& service_id,
-    AppId& client_id, char** version)
+    AppId& client_id, char** version, const ChpMatchDescriptor* cmd)
 {
     char temp_ver[MAX_VERSION_SIZE] = { '\0' };
-    MatchedPatterns* mp = nullptr;
+    MatchedPatterns* mp;
+    bool saved = cmd and cmd->scanned[REQ_AGENT_FID] and cmd->buffer[REQ_AGENT_FID] == start;
 
-    client_agent_matcher.find_all(start, size, &http_pattern_match, false, (void*)&mp);
+    if ( saved )
+    {
+        mp = cmd->field_matches[REQ_AGENT_FID];
+        appid_stats.http_field_scans_saved++;
+    }
+    else
+        mp = scan_simple_field(REQ_AGENT_FID, start, size);
     if (mp)
     {
         const char* end = start + size;
@@ -1303,7 +1341,8 @@ void HttpPatternMatchers::identify_user_agent(const char* start, int size, AppId
 
 done:
     replace_optional_string(version, temp_ver);
-    free_matched_patterns(mp);
+    if ( !saved )
+        free_matched_patterns(mp);
 }
 
 int HttpPatternMatchers::get_appid_by_pattern(const char* data, unsigned size, char** version)
@@ -1383,11 +1422,17 @@ AppId HttpPatternMatchers::scan_header_x_working_with(const char* data, uint32_t
     return APP_ID_NONE;
 }
 
-AppId HttpPatternMatchers::get_appid_by_content_type(const char* data, int size)
+AppId HttpPatternMatchers::get_appid_by_content_type(const char* data, int size,
+    const ChpMatchDescriptor* cmd)
 {
-    MatchedPatterns* mp = nullptr;
+    if ( cmd and cmd->scanned[RSP_CONTENT_TYPE_FID] and cmd->buffer[RSP_CONTENT_TYPE_FID] == data )
+    {
+        appid_stats.http_field_scans_saved++;
+        const MatchedPatterns* mp = cmd->field_matches[RSP_CONTENT_TYPE_FID];
+        return mp ? mp->mpattern->app_id : APP_ID_NONE;
+    }
 
-    content_type_matcher.find_all(data, size, &content_pattern_match, false, (void*)&mp);
+    MatchedPatterns* mp = scan_simple_field(RSP_CONTENT_TYPE_FID, data, size);
     if (!mp)
         return APP_ID_NONE;
 
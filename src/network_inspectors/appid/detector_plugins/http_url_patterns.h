@@ -22,6 +22,7 @@
 #ifndef HTTP_URL_PATTERNS_H
 #define HTTP_URL_PATTERNS_H
 
+#include <deque>
 #include <list>
 #include <vector>
 
@@ -89,13 +90,6 @@ enum DHPSequence
     USER_AGENT_HEADER = 5
 };
 
-struct FieldPattern
-{
-    const uint8_t* data;
-    HttpFieldIds patternType;
-    unsigned length;
-};
-
 struct DetectorHTTPPattern
 {
     bool init(const uint8_t* pat, unsigned len, DHPSequence seq, AppId service, AppId client, AppId payload, AppId app)
@@ -133,6 +127,15 @@ struct DetectorHTTPPattern
 };
 typedef std::vector<DetectorHTTPPattern> DetectorHTTPPatterns;
 
+struct MatchedPatterns
+{
+    DetectorHTTPPattern* mpattern;
+    int after_match_pos;  // Warning: may point past end of buffer.
+                          // Position of character in buffer after last
+                          // matching character.
+    MatchedPatterns* next;
+};
+
 // CHP (Complex HTTP Pattern) uses more than one HTTP pattern
 // to do appid detection and/or perform other actions
 #define CHP_APPID_BITS_FOR_INSTANCE  7
@@ -224,6 +227,25 @@ typedef std::vector<CHPMatchCandidate> CHPMatchTally;
 class ChpMatchDescriptor
 {
 public:
+    ChpMatchDescriptor() = default;
+
+    // the saved field matches are owned by the descriptor
+    ChpMatchDescriptor(const ChpMatchDescriptor&) = delete;
+    ChpMatchDescriptor& operator=(const ChpMatchDescriptor&) = delete;
+
+    ~ChpMatchDescriptor()
+    {
+        for ( auto mp : field_matches )
+        {
+            while ( mp )
+            {
+                MatchedPatterns* tmp = mp;
+                mp = mp->next;
+                snort_free(tmp);
+            }
+        }
+    }
+
     void sort_chp_matches()
     {
         chp_matches[cur_ptype].sort(ChpMatchDescriptor::comp_chp_actions);
@@ -235,6 +257,11 @@ public:
     std::list<MatchedCHPAction> chp_matches[NUM_HTTP_FIELDS];
     CHPMatchTally match_tally;
 
+    // the CHP scan of a field also finds the user agent and content type
+    // patterns; those matches are kept for the lookups that follow
+    MatchedPatterns* field_matches[NUM_HTTP_FIELDS] = { };
+    bool scanned[NUM_HTTP_FIELDS] = { };
+
 private:
     static bool comp_chp_actions( const MatchedCHPAction& lhs, const MatchedCHPAction& rhs)
     {
@@ -275,11 +302,18 @@ public:
     DHPSequence seq = SINGLE;
 };
 
+// the search tool id of a pattern in a field database, either a CHP pattern
+// or a simple user agent or content type pattern
+struct FieldPatternId
+{
+    CHPAction* chp;
+    DetectorHTTPPattern* pattern;
+};
+
 class HttpPatternMatchers
 {
 public:
-    HttpPatternMatchers()
-        : url_matcher(), client_agent_matcher(), via_matcher(), content_type_matcher()
+    HttpPatternMatchers() : via_matcher()
     { }
     ~HttpPatternMatchers();
 
@@ -296,7 +330,6 @@ public:
     int process_chp_list(CHPListElement*);
     int process_host_patterns(DetectorHTTPPatterns&);
     int process_mlmp_patterns();
-    void process_http_field_patterns(FieldPattern*, size_t);
 
     void scan_key_chp(ChpMatchDescriptor&);
     AppId scan_chp(ChpMatchDescriptor&, char**, char**, int*, AppIdHttpSession*,
@@ -305,9 +338,10 @@ public:
     int get_appid_by_pattern(const char*, unsigned, char**);
     bool get_appid_from_url(const char*, const char*, char**, const char*, AppId*, AppId*,
         AppId*, AppId*, bool, OdpContext&);
-    AppId get_appid_by_content_type(const char*, int);
+    AppId get_appid_by_content_type(const char*, int, const ChpMatchDescriptor* = nullptr);
     void get_server_vendor_version(const char*, int, char**, char**, AppIdServiceSubtype**);
-    void identify_user_agent(const char*, int, AppId&, AppId&, char**);
+    void identify_user_agent(const char*, int, AppId&, AppId&, char**,
+        const ChpMatchDescriptor* = nullptr);
     uint32_t parse_multiple_http_patterns(const char* pattern, tMlmpPattern*,
         uint32_t numPartLimit, int level);
 
@@ -321,17 +355,19 @@ private:
     std::vector<HostUrlDetectorPattern*> host_url_patterns;
     CHPListElement* chpList = nullptr;
 
-    snort::SearchTool url_matcher;
-    snort::SearchTool client_agent_matcher;
     snort::SearchTool via_matcher;
-    snort::SearchTool content_type_matcher;
-    snort::SearchTool field_matcher;
-    snort::SearchTool chp_matchers[NUM_HTTP_FIELDS];
+    // one database per field with its CHP patterns and, for the user agent
+    // and content type fields, its simple patterns
+    snort::SearchTool field_matchers[NUM_HTTP_FIELDS];
+    std::deque<FieldPatternId> field_pattern_ids;
     tMlmpTree* host_url_matcher = nullptr;
     tMlmpTree* rtmp_host_url_matcher = nullptr;
     unsigned chp_pattern_count = 0;
 
     void free_chp_app_elements();
+    void add_field_patterns(HttpFieldIds, DetectorHTTPPatterns&, bool no_case);
+    void scan_field(ChpMatchDescriptor&, bool key);
+    MatchedPatterns* scan_simple_field(HttpFieldIds, const char*, unsigned);
     int add_mlmp_pattern(tMlmpTree* matcher, DetectorHTTPPattern& pattern );
     int add_mlmp_pattern(tMlmpTree* matcher, DetectorAppUrlPattern& pattern);
 
@@ -65,11 +65,16 @@ void SearchTool::reload() { }
 static bool test_find_all_done = false;
 static bool test_find_all_enabled = false;
 static MatchedPatterns* mock_mp = nullptr;
-int SearchTool::find_all(const char*, unsigned, MpseMatch, bool, void* mp_arg, const SnortConfig*)
+static std::vector<std::pair<FieldPatternId*, int>> mock_hits;
+int SearchTool::find_all(const char*, unsigned, MpseMatch match, bool, void* mp_arg,
+    const SnortConfig*)
 {
     test_find_all_done = true;
     if (test_find_all_enabled)
-        memcpy(mp_arg, &mock_mp, sizeof(MatchedPatterns*));
+        *((FieldScan*)mp_arg)->matches = mock_mp;
+    for (auto& hit : mock_hits)
+        if (match(hit.first, nullptr, hit.second, mp_arg, nullptr))
+            break;
     return 0;
 }
 }
@@ -547,6 +552,110 @@ TEST(http_url_patterns_tests, identify_user_agent_skypedirect)
     test_find_all_enabled = false;
 }
 
+TEST(http_url_patterns_tests, scan_field_saved_user_agent)
+{
+    // one scan of the field finds both the CHP and the user agent patterns
+    CHPApp chpapp = { };
+    chpapp.key_pattern_count = 1;
+    chpapp.key_pattern_length_sum = 5;
+    CHPAction chpa = { };
+    chpa.key_pattern = 1;
+    chpa.ptype = REQ_AGENT_FID;
+    chpa.psize = 5;
+    chpa.chpapp = &chpapp;
+    DetectorHTTPPattern agent;
+    agent.client_id = APP_ID_SKYPE;
+    FieldPatternId chp_id = { &chpa, nullptr };
+    FieldPatternId agent_id = { nullptr, &agent };
+    mock_hits = { { &chp_id, 5 }, { &agent_id, 5 } };
+
+    const char* data = "Skype/2.1";
+    ChpMatchDescriptor cmd;
+    cmd.cur_ptype = REQ_AGENT_FID;
+    cmd.buffer[REQ_AGENT_FID] = data;
+    cmd.length[REQ_AGENT_FID] = strlen(data);
+
+    appid_stats.http_field_scans = 0;
+    appid_stats.http_field_scans_saved = 0;
+    hm->scan_key_chp(cmd);
+    CHECK_TRUE(cmd.scanned[REQ_AGENT_FID]);
+    CHECK_EQUAL(1, (int)cmd.chp_matches[REQ_AGENT_FID].size());
+    CHECK_EQUAL(0, cmd.chp_matches[REQ_AGENT_FID].front().start_match_pos);
+    CHECK_EQUAL(1, (int)cmd.match_tally.size());
+    CHECK(cmd.match_tally[0].chpapp == &chpapp);
+    CHECK(cmd.field_matches[REQ_AGENT_FID] != nullptr);
+    CHECK(cmd.field_matches[REQ_AGENT_FID]->mpattern == &agent);
+    CHECK(cmd.field_matches[REQ_AGENT_FID]->next == nullptr);
+    CHECK_EQUAL(1, (int)appid_stats.http_field_scans);
+
+    // the lookup of the same buffer reuses the saved matches
+    test_find_all_done = false;
+    hm->identify_user_agent(data, strlen(data), service_id, client_id, &version, &cmd);
+    CHECK_FALSE(test_find_all_done);
+    CHECK_EQUAL(1, (int)appid_stats.http_field_scans_saved);
+    CHECK_EQUAL(APP_ID_SKYPE_AUTH, service_id);
+    CHECK_EQUAL(APP_ID_SKYPE, client_id);
+    CHECK(cmd.field_matches[REQ_AGENT_FID] != nullptr);
+    snort_free(version);
+    version = nullptr;
+
+    // a different buffer is scanned again, for its simple patterns only
+    char copy[16];
+    strcpy(copy, data);
+    service_id = client_id = APP_ID_NONE;
+    test_find_all_done = false;
+    hm->identify_user_agent(copy, strlen(copy), service_id, client_id, &version, &cmd);
+    CHECK_TRUE(test_find_all_done);
+    CHECK_EQUAL(1, (int)appid_stats.http_field_scans_saved);
+    CHECK_EQUAL(2, (int)appid_stats.http_field_scans);
+    CHECK_EQUAL(APP_ID_SKYPE, client_id);
+    CHECK_EQUAL(1, (int)cmd.chp_matches[REQ_AGENT_FID].size());
+    snort_free(version);
+    version = nullptr;
+
+    mock_hits.clear();
+}
+
+TEST(http_url_patterns_tests, scan_field_saved_content_type)
+{
+    CHPAction chpa = { };
+    chpa.ptype = RSP_CONTENT_TYPE_FID;
+    chpa.psize = 4;
+    DetectorHTTPPattern content;
+    content.app_id = APP_ID_GOOGLE;
+    FieldPatternId chp_id = { &chpa, nullptr };
+    FieldPatternId content_id = { nullptr, &content };
+    mock_hits = { { &content_id, 4 }, { &chp_id, 9 } };
+
+    const char* data = "text/html";
+    ChpMatchDescriptor cmd;
+    cmd.cur_ptype = RSP_CONTENT_TYPE_FID;
+    cmd.buffer[RSP_CONTENT_TYPE_FID] = data;
+    cmd.length[RSP_CONTENT_TYPE_FID] = strlen(data);
+
+    appid_stats.http_field_scans = 0;
+    appid_stats.http_field_scans_saved = 0;
+    hm->scan_chp(cmd, &version, &user, &total_found, &mock_hsession, odpctxt);
+    CHECK_TRUE(cmd.scanned[RSP_CONTENT_TYPE_FID]);
+    CHECK(cmd.field_matches[RSP_CONTENT_TYPE_FID] != nullptr);
+    CHECK(cmd.field_matches[RSP_CONTENT_TYPE_FID]->mpattern == &content);
+    CHECK_EQUAL(1, (int)appid_stats.http_field_scans);
+
+    test_find_all_done = false;
+    CHECK_EQUAL(APP_ID_GOOGLE, hm->get_appid_by_content_type(data, strlen(data), &cmd));
+    CHECK_FALSE(test_find_all_done);
+    CHECK_EQUAL(1, (int)appid_stats.http_field_scans_saved);
+
+    // without a descriptor the CHP pattern is ignored
+    mock_hits = { { &chp_id, 9 } };
+    test_find_all_done = false;
+    CHECK_EQUAL(APP_ID_NONE, hm->get_appid_by_content_type(data, strlen(data)));
+    CHECK_TRUE(test_find_all_done);
+    CHECK_EQUAL(2, (int)appid_stats.http_field_scans);
+
+    mock_hits.clear();
+}
+
 int main(int argc, char** argv)
 {
     int return_value = CommandLineTestRunner::RunAllTests(argc, argv);
@@ -0,0 +1,162 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "learned_app_cache.h"
+
+#include <cstring>
+
+using namespace snort;
+
+#define MAX_LOCKS 1024
+
+void LearnedAppCache::configure(size_t memcap, uint8_t confidence, uint32_t secs)
+{
+    size_t n = memcap / (sizeof(Entry) * WAYS);
+
+    num_sets = 0;
+    entries.reset();
+    locks.reset();
+
+    if ( !n )
+        return;
+
+    // power of 2 sets so the hash can be masked
+    unsigned sets = 1;
+
+    while ( sets <= n / 2 and sets < (1u << 30) )
+        sets <<= 1;
+
+    entries.reset(new Entry[sets * WAYS]);
+    memset((void*)entries.get(), 0, sets * WAYS * sizeof(Entry));
+
+    num_locks = sets < MAX_LOCKS ? sets : MAX_LOCKS;
+    locks.reset(new std::mutex[num_locks]);
+
+    num_sets = sets;
+    threshold = confidence ? confidence : 1;
+    timeout = secs;
+}
+
+unsigned LearnedAppCache::get_set(const SfIp* ip, uint16_t port, IpProtocol proto) const
+{
+    const uint32_t* a = ip->get_ip6_ptr();
+    uint64_t h = ((uint64_t)port << 8) | (uint8_t)proto;
+
+    for ( unsigned i = 0; i < 4; i++ )
+    {
+        h ^= a[i];
+        h *= 0x9e3779b97f4a7c15ull;
+        h ^= h >> 29;
+    }
+    return (unsigned)(h >> 32) & (num_sets - 1);
+}
+
+AppId LearnedAppCache::find(const SfIp* ip, uint16_t port, IpProtocol proto, time_t now)
+{
+    if ( !num_sets )
+        return APP_ID_NONE;
+
+    unsigned set = get_set(ip, port, proto);
+    Entry* e = &entries[set * WAYS];
+    std::lock_guard<std::mutex> lock(locks[set & (num_locks - 1)]);
+
+    for ( unsigned i = 0; i < WAYS; i++, e++ )
+    {
+        if ( !matches(*e, ip, port, proto) )
+            continue;
+
+        if ( e->confidence < threshold or expired(*e, now) )
+            return APP_ID_NONE;
+
+        e->hits++;
+        return e->service;
+    }
+    return APP_ID_NONE;
+}
+
+bool LearnedAppCache::learn(const SfIp* ip, uint16_t port, IpProtocol proto, time_t now,
+    AppId service)
+{
+    if ( !num_sets )
+        return false;
+
+    unsigned set = get_set(ip, port, proto);
+    Entry* e = &entries[set * WAYS];
+    Entry* victim = nullptr;
+    bool victim_free = false;
+    std::lock_guard<std::mutex> lock(locks[set & (num_locks - 1)]);
+
+    for ( unsigned i = 0; i < WAYS; i++, e++ )
+    {
+        if ( matches(*e, ip, port, proto) )
+        {
+            if ( expired(*e, now) )
+            {
+                victim = e;
+                break;
+            }
+            if ( e->service == service )
+            {
+                if ( e->confidence < MAX_CONFIDENCE )
+                    e->confidence++;
+            }
+            else if ( --e->confidence == 0 )
+            {
+                // the server changed, start over with what was just seen
+                e->service = service;
+                e->confidence = 1;
+                e->hits = 0;
+            }
+            e->last_learned = (uint32_t)now;
+            return false;
+        }
+
+        if ( victim_free )
+            continue;
+
+        if ( !e->confidence or expired(*e, now) )
+        {
+            victim = e;
+            victim_free = true;
+        }
+        else if ( !victim or e->hits < victim->hits )
+            victim = e;
+    }
+
+    // age the survivors so that stale popularity doesn't pin them forever
+    e = &entries[set * WAYS];
+
+    for ( unsigned i = 0; i < WAYS; i++, e++ )
+    {
+        if ( e != victim )
+            e->hits >>= 1;
+    }
+
+    victim->ip = *ip;
+    victim->port = port;
+    victim->proto = proto;
+    victim->confidence = 1;
+    victim->service = service;
+    victim->hits = 0;
+    victim->last_learned = (uint32_t)now;
+    return true;
+}
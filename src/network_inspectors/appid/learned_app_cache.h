@@ -0,0 +1,89 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef LEARNED_APP_CACHE_H
+#define LEARNED_APP_CACHE_H
+
+// LearnedAppCache remembers the service that discovery found for a server
+// address, port, and protocol so that later flows to the same server can be
+// identified on the first packet.  Clients and payloads depend on who is
+// connecting and what they ask for so they are left to discovery.  It is shared by all packet
+// threads and bounded by a memcap: the table is set associative with a
+// small number of ways per set and a set is locked only while it is looked
+// up or updated.  Each entry has a confidence which is raised when a flow
+// agrees with it and lowered when a flow disagrees; the identification is
+// replaced when the confidence drops to zero and is only used once it
+// reaches the configured threshold.  When a set is full the entry with the
+// fewest hits is replaced and the hits of the others are halved so that
+// entries that were popular long ago age out.
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+
+#include "application_ids.h"
+#include "protocols/protocol_ids.h"
+#include "sfip/sf_ip.h"
+
+class LearnedAppCache
+{
+public:
+    void configure(size_t memcap, uint8_t confidence, uint32_t timeout);
+
+    bool enabled() const
+    { return num_sets != 0; }
+
+    // returns the service of an entry with enough confidence or APP_ID_NONE
+    AppId find(const snort::SfIp*, uint16_t port, IpProtocol, time_t now);
+
+    // returns true if a new entry was added
+    bool learn(const snort::SfIp*, uint16_t port, IpProtocol, time_t now, AppId service);
+
+    static const unsigned WAYS = 4;
+    static const uint8_t MAX_CONFIDENCE = 16;
+
+private:
+    struct Entry
+    {
+        snort::SfIp ip;
+        uint16_t port;
+        IpProtocol proto;
+        uint8_t confidence;
+        AppId service;
+        uint32_t hits;
+        uint32_t last_learned;
+    };
+
+    unsigned get_set(const snort::SfIp*, uint16_t port, IpProtocol) const;
+
+    static bool matches(const Entry& e, const snort::SfIp* ip, uint16_t port, IpProtocol proto)
+    { return e.confidence and e.port == port and e.proto == proto and e.ip.fast_equals_raw(*ip); }
+
+    bool expired(const Entry& e, time_t now) const
+    { return timeout and (uint32_t)now - e.last_learned > timeout; }
+
+    std::unique_ptr<Entry[]> entries;
+    std::unique_ptr<std::mutex[]> locks;
+    unsigned num_sets = 0;
+    unsigned num_locks = 0;
+    uint8_t threshold = 1;
+    uint32_t timeout = 0;
+};
+
+#endif
@@ -3363,6 +3363,26 @@ int register_detector(lua_State* L)
     return 1;                         /* return methods on the stack */
 }
 
+void register_detector_packet(lua_State* L, const LuaDetectorPacket* packet)
+{
+    if (luaL_loadstring(L, detector_packet_ffi))
+    {
+        appid_log(nullptr, TRACE_ERROR_LEVEL, "appid: can not load DetectorPacket: %s\n",
+            lua_tostring(L, -1));
+        lua_pop(L, 1);
+        return;
+    }
+    lua_pushlightuserdata(L, const_cast<LuaDetectorPacket*>(packet));
+
+    if (lua_pcall(L, 1, 0, 0))
+    {
+        if (init(L))
+            appid_log(nullptr, TRACE_WARNING_LEVEL, "appid: DetectorPacket is not available: %s\n",
+                lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+}
+
 int LuaStateDescriptor::lua_validate(AppIdDiscoveryArgs& args)
 {
     LuaDetectorManager& lua_detector_mgr = odp_thread_local_ctxt->get_lua_detector_mgr();
@@ -3370,36 +3390,42 @@ int LuaStateDescriptor::lua_validate(AppIdDiscoveryArgs& args)
     if (!my_lua_state)
     {
         appid_log(args.pkt, TRACE_ERROR_LEVEL, "lua detector %s: no LUA state\n", package_info.name.c_str());
-        lua_settop(my_lua_state, 0);
         return APPID_ENULL;
     }
 
-    // get the table for this chunk (env)
-    lua_getfield(my_lua_state, LUA_REGISTRYINDEX, package_info.name.c_str());
-    ldp.data = args.data;
-    ldp.size = args.size;
-    ldp.dir = args.dir;
-    ldp.asd = &args.asd;
-    ldp.change_bits = &args.change_bits;
-    ldp.pkt = args.pkt;
-    const char* validateFn = package_info.validateFunctionName.c_str();
-
-    if ((!validateFn) or (validateFn[0] == '\0'))
+    if (validate_ref == LUA_NOREF)
     {
-        ldp.pkt = nullptr;
-        lua_settop(my_lua_state, 0);
-        return APPID_NOMATCH;
+        if (package_info.validateFunctionName.empty())
+            return APPID_NOMATCH;
+
+        appid_log(args.pkt, TRACE_ERROR_LEVEL, "lua detector %s: %s is not a function\n",
+            package_info.name.c_str(), package_info.validateFunctionName.c_str());
+        appid_stats.lua_validate_errors++;
+        return APPID_ENULL;
     }
 
-    lua_getfield(my_lua_state, -1, validateFn); // get the function we want to call
+    Profile profile(lua_detector_perf_stats);
+    appid_stats.lua_validations++;
 
-    if (lua_pcall(my_lua_state, 0, 1, 0))
+    ldp.init(args);
+    LuaDetectorPacket& dp = lua_detector_mgr.packet;
+    set_detector_packet(dp, args.pkt, args.data, args.size, args.dir,
+        appid_stats.processed_packets);
+
+    lua_rawgeti(my_lua_state, LUA_REGISTRYINDEX, validate_ref);
+
+    int status = lua_pcall(my_lua_state, 0, 1, 0);
+    dp.data = nullptr;
+    dp.size = 0;
+
+    if (status)
     {
         // Runtime Lua errors are suppressed in production code since detectors are written for
         // efficiency and with defensive minimum checks. Errors are dealt as exceptions
         // that don't impact processing by other detectors or future packets by the same detector.
         appid_log(args.pkt, TRACE_ERROR_LEVEL, "lua detector %s: error validating %s\n",
             package_info.name.c_str(), lua_tostring(my_lua_state, -1));
+        appid_stats.lua_validate_errors++;
         ldp.pkt = nullptr;
         lua_detector_mgr.free_detector_flow();
         lua_settop(my_lua_state, 0);
@@ -3505,14 +3531,18 @@ LuaServiceObject::LuaServiceObject(AppIdDiscovery* sdm, const std::string& detec
 
 int LuaServiceDetector::validate(AppIdDiscoveryArgs& args)
 {
-    auto my_lua_state = odp_thread_local_ctxt->get_lua_detector_mgr().L;
+    LuaDetectorManager& lua_detector_mgr = odp_thread_local_ctxt->get_lua_detector_mgr();
+    auto my_lua_state = lua_detector_mgr.L;
     if (lua_gettop(my_lua_state))
-    appid_log(args.pkt, TRACE_WARNING_LEVEL, "appid: leak of %d lua stack elements before service validate\n",
-        lua_gettop(my_lua_state));
+        appid_log(args.pkt, TRACE_WARNING_LEVEL, "appid: leak of %d lua stack elements before service validate\n",
+            lua_gettop(my_lua_state));
 
-    std::string name = this->name + "_";
-    lua_getglobal(my_lua_state, name.c_str());
-    auto& ud = *UserData<LuaServiceObject>::check(my_lua_state, DETECTOR, 1);
+    LuaObject* ud = lua_detector_mgr.get_lua_object(this);
+    if (!ud)
+    {
+        appid_log(args.pkt, TRACE_ERROR_LEVEL, "lua detector %s: not activated\n", name.c_str());
+        return APPID_ENULL;
+    }
     return ud->lsd.lua_validate(args);
 }
 
@@ -3581,13 +3611,17 @@ LuaStateDescriptor* LuaObject::validate_lua_state(bool packet_context)
 
 int LuaClientDetector::validate(AppIdDiscoveryArgs& args)
 {
-    auto my_lua_state = odp_thread_local_ctxt->get_lua_detector_mgr().L;
+    LuaDetectorManager& lua_detector_mgr = odp_thread_local_ctxt->get_lua_detector_mgr();
+    auto my_lua_state = lua_detector_mgr.L;
     if (lua_gettop(my_lua_state))
         appid_log(args.pkt, TRACE_WARNING_LEVEL, "appid: leak of %d lua stack elements before client validate\n",
             lua_gettop(my_lua_state));
 
-    std::string name = this->name + "_";
-    lua_getglobal(my_lua_state, name.c_str());
-    auto& ud = *UserData<LuaClientObject>::check(my_lua_state, DETECTOR, 1);
+    LuaObject* ud = lua_detector_mgr.get_lua_object(this);
+    if (!ud)
+    {
+        appid_log(args.pkt, TRACE_ERROR_LEVEL, "lua detector %s: not activated\n", name.c_str());
+        return APPID_ENULL;
+    }
     return ud->lsd.lua_validate(args);
 }
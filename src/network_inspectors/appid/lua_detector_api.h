@@ -27,6 +27,8 @@
 #include <cstdint>
 #include <string>
 
+#include <lua.hpp>
+
 #include "appid_types.h"
 #include "client_plugins/client_detector.h"
 #include "service_plugins/service_detector.h"
@@ -35,9 +37,9 @@ namespace snort
 {
 struct Packet;
 }
-struct lua_State;
 class AppIdSession;
 class AppInfoTableEntry;
+struct LuaDetectorPacket;
 
 #define DETECTOR "Detector"
 #define DETECTORFLOW "DetectorFlow"
@@ -80,6 +82,7 @@ public:
     LuaDetectorParameters ldp;
     DetectorPackageInfo package_info;
     AppId service_id = APP_ID_UNKNOWN;
+    int validate_ref = LUA_NOREF;   // registry reference of the validate function
     int lua_validate(AppIdDiscoveryArgs&);
 };
 
@@ -158,6 +161,7 @@ public:
 typedef std::unordered_map<AppId, CHPApp*> CHPGlossary;
 
 int register_detector(lua_State*);
+void register_detector_packet(lua_State*, const LuaDetectorPacket*);
 void init_chp_glossary();
 int init(lua_State*, int result=0);
 void free_current_chp_glossary();
@@ -157,6 +157,8 @@ LuaDetectorManager::LuaDetectorManager(AppIdContext& ctxt, bool is_control) :
     allocated_objects.clear();
     cb_detectors.clear();
     L = create_lua_state(ctxt.config, is_control);
+    if (L)
+        register_detector_packet(L, &packet);
     if (is_control)
         init_chp_glossary();
 }
@@ -199,6 +201,7 @@ LuaDetectorManager::~LuaDetectorManager()
         free_detector_flow();
     allocated_objects.clear();
     cb_detectors.clear(); // do not free Lua objects in cb_detectors
+    lua_objects.clear();
 }
 
 void LuaDetectorManager::initialize(const SnortConfig* sc, AppIdContext& ctxt, bool is_control,
@@ -639,9 +642,22 @@ void LuaDetectorManager::activate_lua_detectors(const SnortConfig* sc)
 
         lua_getfield(L, LUA_REGISTRYINDEX, lsd->package_info.name.c_str());
         set_lua_tracker_size(L, lua_tracker_size);
+
+        // resolve the validate function once instead of by name on every packet
+        lua_getfield(L, -1, lsd->package_info.validateFunctionName.c_str());
+        if (lua_isfunction(L, -1))
+            lsd->validate_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+        if ((*lo)->get_detector())
+            lua_objects[(*lo)->get_detector()] = *lo;
+
         lua_settop(L, 0);
         ++lo;
     }
+
+    // the init functions leave garbage behind that would otherwise be held by
+    // every thread's state until the collector gets to it
+    lua_gc(L, LUA_GCCOLLECT, 0);
 }
 
 void LuaDetectorManager::list_lua_detectors()
@@ -26,6 +26,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 #include <lua.hpp>
 #include <lua/lua.h>
@@ -35,6 +36,7 @@
 #include "protocols/protocol_ids.h"
 
 #include "application_ids.h"
+#include "lua_detector_packet.h"
 
 namespace snort
 {
@@ -78,9 +80,16 @@ public:
 
     void free_detector_flow();
     lua_State* L;
+    LuaDetectorPacket packet = { };
     bool insert_cb_detector(AppId app_id, LuaObject* ud);
     LuaObject* get_cb_detector(AppId app_id);
 
+    LuaObject* get_lua_object(const AppIdDetector* detector)
+    {
+        auto it = lua_objects.find(detector);
+        return it != lua_objects.end() ? it->second : nullptr;
+    }
+
 private:
     void initialize_lua_detectors(bool is_control, bool reload = false);
     void activate_lua_detectors(const snort::SnortConfig*);
@@ -94,6 +103,7 @@ private:
     std::list<LuaObject*> allocated_objects;
     size_t num_odp_detectors = 0;
     std::map<AppId, LuaObject*> cb_detectors;
+    std::unordered_map<const AppIdDetector*, LuaObject*> lua_objects;
     DetectorFlow* detector_flow = nullptr;
     bool ignore_chp_cleanup = false;
 };
@@ -0,0 +1,97 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// lua_detector_packet.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "lua_detector_packet.h"
+
+#include <cstring>
+
+#include "protocols/packet.h"
+
+using namespace snort;
+
+// DetectorPacket gives detectors the fields of the packet being validated
+// without going through the stack API, eg DetectorPacket.size or
+// DetectorPacket.data[i].  It is nil if the ffi is not available.
+const char* detector_packet_ffi =
+    "local ffi = require('ffi')\n"
+    "ffi.cdef[[\n"
+    "struct LuaDetectorPacket\n"
+    "{\n"
+    "    const uint8_t* data;\n"
+    "    uint16_t size;\n"
+    "    uint8_t dir;\n"
+    "    uint8_t proto;\n"
+    "    uint16_t src_port;\n"
+    "    uint16_t dst_port;\n"
+    "    uint32_t src_addr;\n"
+    "    uint32_t dst_addr;\n"
+    "    uint64_t count;\n"
+    "    uint8_t ip_ver;\n"
+    "    uint8_t src_ip[16];\n"
+    "    uint8_t dst_ip[16];\n"
+    "};\n"
+    "]]\n"
+    "DetectorPacket = ffi.cast('const struct LuaDetectorPacket*', ...)\n";
+
+void set_detector_packet(LuaDetectorPacket& dp, const Packet* p,
+    const uint8_t* data, uint16_t size, uint8_t dir, uint64_t count)
+{
+    dp.data = data;
+    dp.size = size;
+    dp.dir = dir;
+    dp.count = count;
+
+    if (p and p->has_ip())
+    {
+        const SfIp* src = p->ptrs.ip_api.get_src();
+        const SfIp* dst = p->ptrs.ip_api.get_dst();
+
+        dp.proto = (uint8_t)p->get_ip_proto_next();
+        dp.src_port = p->ptrs.sp;
+        dp.dst_port = p->ptrs.dp;
+
+        if (src->is_ip4())
+        {
+            dp.ip_ver = 4;
+            dp.src_addr = src->get_ip4_value();
+            dp.dst_addr = dst->get_ip4_value();
+        }
+        else
+        {
+            dp.ip_ver = 6;
+            dp.src_addr = dp.dst_addr = 0;
+        }
+        memcpy(dp.src_ip, src->get_ip6_ptr(), sizeof(dp.src_ip));
+        memcpy(dp.dst_ip, dst->get_ip6_ptr(), sizeof(dp.dst_ip));
+    }
+    else
+    {
+        dp.proto = 0;
+        dp.src_port = dp.dst_port = 0;
+        dp.src_addr = dp.dst_addr = 0;
+        dp.ip_ver = 0;
+        memset(dp.src_ip, 0, sizeof(dp.src_ip));
+        memset(dp.dst_ip, 0, sizeof(dp.dst_ip));
+    }
+}
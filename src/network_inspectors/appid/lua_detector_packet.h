@@ -0,0 +1,59 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// lua_detector_packet.h author Cisco
+
+#ifndef LUA_DETECTOR_PACKET_H
+#define LUA_DETECTOR_PACKET_H
+
+// fields of the packet being validated, read by detectors through the LuaJIT
+// ffi as DetectorPacket instead of a C API call per field
+
+#include <cstdint>
+
+namespace snort
+{
+struct Packet;
+}
+
+// the layout must match the cdef in detector_packet_ffi; new fields go at the
+// end so existing offsets don't move
+struct LuaDetectorPacket
+{
+    const uint8_t* data;
+    uint16_t size;
+    uint8_t dir;
+    uint8_t proto;
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint32_t src_addr;      // IPv4 only, network order; 0 for IPv6
+    uint32_t dst_addr;      // IPv4 only, network order; 0 for IPv6
+    uint64_t count;
+    uint8_t ip_ver;         // 4, 6, or 0 if the packet has no IP layer
+    uint8_t src_ip[16];     // network order, IPv4 is mapped as ::ffff:a.b.c.d
+    uint8_t dst_ip[16];
+};
+
+// loaded as a chunk which takes the LuaDetectorPacket* as its argument and
+// sets the DetectorPacket global
+extern const char* detector_packet_ffi;
+
+void set_detector_packet(LuaDetectorPacket&, const snort::Packet*,
+    const uint8_t* data, uint16_t size, uint8_t dir, uint64_t count);
+
+#endif
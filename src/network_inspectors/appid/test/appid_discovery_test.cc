@@ -291,6 +291,16 @@ HostAppIdsVal* HostPortCache::find_on_first_pkt(const SfIp*, uint16_t, IpProtoco
     return nullptr;
 }
 
+AppId LearnedAppCache::find(const SfIp*, uint16_t, IpProtocol, time_t)
+{
+    return APP_ID_NONE;
+}
+
+bool LearnedAppCache::learn(const SfIp*, uint16_t, IpProtocol, time_t, AppId)
+{
+    return false;
+}
+
 void AppIdServiceState::check_reset(AppIdSession&, const SfIp*, uint16_t,
     int16_t, uint32_t) {}
 bool do_tp_discovery(ThirdPartyAppIdContext& , AppIdSession&, IpProtocol,
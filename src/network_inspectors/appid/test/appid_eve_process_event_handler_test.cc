@@ -96,7 +96,8 @@ void AppIdModule::reset_stats() { }
 void AppIdDebug::activate(snort::Flow const*, AppIdSession const*, bool) { }
 
 void AppIdSession::update_encrypted_app_id(AppId) {}
-void HttpPatternMatchers::identify_user_agent(const char*, int, AppId&, AppId& client, char**)
+void HttpPatternMatchers::identify_user_agent(const char*, int, AppId&, AppId& client, char**,
+    const ChpMatchDescriptor*)
 {
     client = APPID_UT_ID;
 }
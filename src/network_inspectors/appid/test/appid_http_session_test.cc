@@ -86,7 +86,8 @@ void HttpPatternMatchers::get_server_vendor_version(const char*, int, char**,
 {
 }
 
-void HttpPatternMatchers::identify_user_agent(const char*, int, AppId&, AppId&, char**)
+void HttpPatternMatchers::identify_user_agent(const char*, int, AppId&, AppId&, char**,
+    const ChpMatchDescriptor*)
 {
 }
 
@@ -95,7 +96,8 @@ int HttpPatternMatchers::get_appid_by_pattern(const char*, unsigned, char**)
     return 0;
 }
 
-AppId HttpPatternMatchers::get_appid_by_content_type(const char*, int)
+AppId HttpPatternMatchers::get_appid_by_content_type(const char*, int,
+    const ChpMatchDescriptor*)
 {
     return 0;
 }
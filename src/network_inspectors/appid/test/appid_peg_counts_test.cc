@@ -0,0 +1,196 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// appid_peg_counts_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/appid/appid_peg_counts.cc"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+static std::vector<std::string> lines;
+
+namespace snort
+{
+void LogLabel(const char*, FILE*) { }
+void LogText(const char* s, FILE*) { lines.emplace_back(s); }
+}
+
+class AppIdPegCountsTest
+{
+public:
+    static std::shared_ptr<const void> thread_index()
+    { return AppIdPegCounts::thread_pegs->peg_index; }
+
+    static size_t thread_index_size()
+    { return AppIdPegCounts::thread_pegs->peg_index->size(); }
+
+    static std::shared_ptr<const void> current_index()
+    { return AppIdPegCounts::get_peg_index(); }
+};
+
+// get the printed counts of an app, "" if it isn't printed
+static std::string printed(const char* app)
+{
+    lines.clear();
+    AppIdPegCounts::print();
+
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "%25.25s:", app);
+
+    for ( auto& s : lines )
+    {
+        if ( !s.compare(0, strlen(prefix), prefix) )
+            return s.substr(strlen(prefix));
+    }
+    return "";
+}
+
+static std::string counts(unsigned svc, unsigned cli, unsigned usr, unsigned pay)
+{
+    AppIdPegCounts::AppIdDynamicPeg peg;
+    peg.stats[AppIdPegCounts::SERVICE_DETECTS] = svc;
+    peg.stats[AppIdPegCounts::CLIENT_DETECTS] = cli;
+    peg.stats[AppIdPegCounts::USER_DETECTS] = usr;
+    peg.stats[AppIdPegCounts::PAYLOAD_DETECTS] = pay;
+
+    char buf[120];
+    peg.print("x", buf, sizeof(buf));
+
+    std::string s(buf);
+    return s.substr(s.find(':') + 1);
+}
+
+TEST_GROUP(appid_peg_counts)
+{
+    void setup() override
+    {
+        AppIdPegCounts::cleanup_peg_info();
+        AppIdPegCounts::cleanup_dynamic_sum();
+        AppIdPegCounts::add_app_peg_info("app a", 10);
+        AppIdPegCounts::add_app_peg_info("app b", 20);
+    }
+
+    void teardown() override
+    {
+        AppIdPegCounts::cleanup_pegs();
+        AppIdPegCounts::cleanup_peg_info();
+        AppIdPegCounts::cleanup_dynamic_sum();
+    }
+};
+
+// every thread counts into the same rows through the shared index
+TEST(appid_peg_counts, shared_index)
+{
+    const unsigned num_threads = 4;
+    std::vector<std::thread> threads;
+    std::shared_ptr<const void> index[num_threads];
+    size_t size[num_threads];
+
+    for ( unsigned t = 0; t < num_threads; ++t )
+    {
+        threads.emplace_back([t, &index, &size]
+        {
+            AppIdPegCounts::init_pegs();
+            index[t] = AppIdPegCountsTest::thread_index();
+            size[t] = AppIdPegCountsTest::thread_index_size();
+
+            for ( unsigned i = 0; i < 100; ++i )
+            {
+                AppIdPegCounts::inc_service_count(10);
+                AppIdPegCounts::inc_client_count(20);
+            }
+            AppIdPegCounts::sum_stats();
+            AppIdPegCounts::cleanup_pegs();
+        });
+    }
+    for ( auto& t : threads )
+        t.join();
+
+    for ( unsigned t = 0; t < num_threads; ++t )
+    {
+        CHECK(index[t] == index[0]);
+        CHECK(size[t] == 2);
+    }
+
+    CHECK_EQUAL(counts(400, 0, 0, 0), printed("app_a"));
+    CHECK_EQUAL(counts(0, 400, 0, 0), printed("app_b"));
+    CHECK_EQUAL("", printed("unknown"));
+}
+
+// apps missing from the index are counted as unknown
+TEST(appid_peg_counts, unknown_app)
+{
+    AppIdPegCounts::init_pegs();
+
+    AppIdPegCounts::inc_payload_count(10);
+    AppIdPegCounts::inc_payload_count(999);
+    AppIdPegCounts::inc_user_count(999);
+    AppIdPegCounts::sum_stats();
+
+    CHECK_EQUAL(counts(0, 0, 0, 1), printed("app_a"));
+    CHECK_EQUAL(counts(0, 0, 1, 1), printed("unknown"));
+}
+
+// a reload builds a new index; threads keep the old one until they swap
+TEST(appid_peg_counts, reload_swap)
+{
+    AppIdPegCounts::init_pegs();
+    auto old_index = AppIdPegCountsTest::thread_index();
+
+    AppIdPegCounts::cleanup_peg_info();
+    AppIdPegCounts::add_app_peg_info("app c", 30);
+    AppIdPegCounts::add_app_peg_info("app a", 10);
+
+    // still on the old index
+    AppIdPegCounts::inc_service_count(30);
+    CHECK(AppIdPegCountsTest::thread_index() == old_index);
+
+    // the swap done by each packet thread
+    AppIdPegCounts::cleanup_pegs();
+    AppIdPegCounts::cleanup_dynamic_sum();
+    AppIdPegCounts::init_pegs();
+
+    auto new_index = AppIdPegCountsTest::thread_index();
+    CHECK(new_index != old_index);
+    CHECK(new_index == AppIdPegCountsTest::current_index());
+    CHECK(AppIdPegCountsTest::thread_index_size() == 2);
+
+    AppIdPegCounts::inc_service_count(30);
+    AppIdPegCounts::inc_service_count(10);
+    AppIdPegCounts::inc_service_count(20);
+    AppIdPegCounts::sum_stats();
+
+    CHECK_EQUAL(counts(1, 0, 0, 0), printed("app_c"));
+    CHECK_EQUAL(counts(1, 0, 0, 0), printed("app_a"));
+    CHECK_EQUAL("", printed("app_b"));
+    CHECK_EQUAL(counts(1, 0, 0, 0), printed("unknown"));
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
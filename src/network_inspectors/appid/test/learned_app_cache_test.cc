@@ -0,0 +1,146 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/appid/learned_app_cache.cc"
+
+#include <cassert>
+
+#include "utils/util.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+namespace snort
+{
+char* snort_strdup(const char* str)
+{
+    assert(str);
+    size_t n = strlen(str) + 1;
+    char* p = (char*)snort_alloc(n);
+    memcpy(p, str, n);
+    return p;
+}
+}
+
+static SfIp make_ip(const char* s)
+{
+    SfIp ip;
+    ip.set(s);
+    return ip;
+}
+
+TEST_GROUP(learned_app_cache)
+{
+    LearnedAppCache cache;
+};
+
+TEST(learned_app_cache, disabled)
+{
+    SfIp ip = make_ip("10.1.1.1");
+    cache.configure(0, 1, 0);
+    CHECK_FALSE(cache.enabled());
+    CHECK_FALSE(cache.learn(&ip, 443, IpProtocol::TCP, 1, 1122));
+    CHECK_EQUAL(APP_ID_NONE, cache.find(&ip, 443, IpProtocol::TCP, 1));
+}
+
+TEST(learned_app_cache, confidence)
+{
+    SfIp ip = make_ip("10.1.1.1");
+    cache.configure(4096, 3, 0);
+    CHECK_TRUE(cache.enabled());
+
+    CHECK_TRUE(cache.learn(&ip, 443, IpProtocol::TCP, 1, 1122));
+    CHECK_EQUAL(APP_ID_NONE, cache.find(&ip, 443, IpProtocol::TCP, 1));
+
+    CHECK_FALSE(cache.learn(&ip, 443, IpProtocol::TCP, 2, 1122));
+    CHECK_EQUAL(APP_ID_NONE, cache.find(&ip, 443, IpProtocol::TCP, 2));
+
+    CHECK_FALSE(cache.learn(&ip, 443, IpProtocol::TCP, 3, 1122));
+    CHECK_EQUAL(1122, cache.find(&ip, 443, IpProtocol::TCP, 3));
+
+    CHECK_EQUAL(APP_ID_NONE, cache.find(&ip, 443, IpProtocol::UDP, 3));
+    CHECK_EQUAL(APP_ID_NONE, cache.find(&ip, 8443, IpProtocol::TCP, 3));
+}
+
+TEST(learned_app_cache, conflict)
+{
+    SfIp ip = make_ip("2001:db8::1");
+    cache.configure(4096, 2, 0);
+
+    cache.learn(&ip, 22, IpProtocol::TCP, 1, 846);
+    cache.learn(&ip, 22, IpProtocol::TCP, 1, 846);
+    CHECK_EQUAL(846, cache.find(&ip, 22, IpProtocol::TCP, 1));
+
+    // one disagreement drops below the threshold, another replaces the service
+    cache.learn(&ip, 22, IpProtocol::TCP, 1, 676);
+    CHECK_EQUAL(APP_ID_NONE, cache.find(&ip, 22, IpProtocol::TCP, 1));
+    cache.learn(&ip, 22, IpProtocol::TCP, 1, 676);
+    cache.learn(&ip, 22, IpProtocol::TCP, 1, 676);
+    CHECK_EQUAL(676, cache.find(&ip, 22, IpProtocol::TCP, 1));
+}
+
+TEST(learned_app_cache, timeout)
+{
+    SfIp ip = make_ip("10.1.1.1");
+    cache.configure(4096, 1, 60);
+
+    cache.learn(&ip, 53, IpProtocol::UDP, 100, 617);
+    CHECK_EQUAL(617, cache.find(&ip, 53, IpProtocol::UDP, 160));
+    CHECK_EQUAL(APP_ID_NONE, cache.find(&ip, 53, IpProtocol::UDP, 161));
+
+    // an expired entry starts over
+    CHECK_TRUE(cache.learn(&ip, 53, IpProtocol::UDP, 200, 617));
+    CHECK_EQUAL(617, cache.find(&ip, 53, IpProtocol::UDP, 200));
+}
+
+TEST(learned_app_cache, eviction)
+{
+    // one set so every server competes for the same ways
+    cache.configure(LearnedAppCache::WAYS * 64, 1, 0);
+    SfIp ips[LearnedAppCache::WAYS + 1];
+
+    for ( unsigned i = 0; i <= LearnedAppCache::WAYS; i++ )
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "10.1.1.%u", i + 1);
+        ips[i] = make_ip(buf);
+    }
+
+    for ( unsigned i = 0; i < LearnedAppCache::WAYS; i++ )
+        CHECK_TRUE(cache.learn(&ips[i], 80, IpProtocol::TCP, 1, 676));
+
+    // all but the last are popular
+    for ( unsigned i = 0; i < LearnedAppCache::WAYS - 1; i++ )
+        CHECK_EQUAL(676, cache.find(&ips[i], 80, IpProtocol::TCP, 1));
+
+    CHECK_TRUE(cache.learn(&ips[LearnedAppCache::WAYS], 80, IpProtocol::TCP, 1, 676));
+    CHECK_EQUAL(APP_ID_NONE, cache.find(&ips[LearnedAppCache::WAYS - 1], 80, IpProtocol::TCP, 1));
+
+    for ( unsigned i = 0; i < LearnedAppCache::WAYS - 1; i++ )
+        CHECK_EQUAL(676, cache.find(&ips[i], 80, IpProtocol::TCP, 1));
+    CHECK_EQUAL(676, cache.find(&ips[LearnedAppCache::WAYS], 80, IpProtocol::TCP, 1));
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,220 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// lua_detector_packet_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/appid/lua_detector_packet.cc"
+
+#include <arpa/inet.h>
+#include <cstddef>
+#include <lua.hpp>
+
+#include "protocols/ipv4.h"
+#include "protocols/ipv6.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+// Mocks
+
+namespace snort
+{
+Packet::Packet(bool) { }
+Packet::~Packet() = default;
+
+namespace ip
+{
+void IpApi::reset()
+{
+    type = IAT_NONE;
+    iph = nullptr;
+    src.clear();
+    dst.clear();
+}
+
+void IpApi::set(const IP4Hdr* h4)
+{
+    iph = (const void*)h4;
+    type = IAT_4;
+    src.set(&h4->ip_src, AF_INET);
+    dst.set(&h4->ip_dst, AF_INET);
+}
+
+void IpApi::set(const IP6Hdr* h6)
+{
+    iph = (const void*)h6;
+    type = IAT_6;
+    src.set(&h6->ip6_src, AF_INET6);
+    dst.set(&h6->ip6_dst, AF_INET6);
+}
+}
+}
+
+// evaluate a Lua expression with DetectorPacket set
+static double eval(lua_State* L, const char* expr)
+{
+    std::string chunk = "return tonumber(";
+    chunk += expr;
+    chunk += ")";
+
+    if (luaL_dostring(L, chunk.c_str()))
+    {
+        FAIL(lua_tostring(L, -1));
+        lua_pop(L, 1);
+        return -1;
+    }
+    double d = lua_tonumber(L, -1);
+    lua_pop(L, 1);
+    return d;
+}
+
+static lua_State* L = nullptr;
+static LuaDetectorPacket dp;
+static const uint8_t payload[] = { 0x16, 0x03, 0x01 };
+
+TEST_GROUP(lua_detector_packet)
+{
+    void setup() override
+    {
+        L = luaL_newstate();
+        luaL_openlibs(L);
+        dp = { };
+
+        CHECK_EQUAL(0, luaL_loadstring(L, detector_packet_ffi));
+        lua_pushlightuserdata(L, &dp);
+        CHECK_EQUAL(0, lua_pcall(L, 1, 0, 0));
+    }
+
+    void teardown() override
+    {
+        lua_close(L);
+        L = nullptr;
+    }
+};
+
+#define CHECK_OFFSET(f) \
+    CHECK_EQUAL((double)offsetof(LuaDetectorPacket, f), \
+        eval(L, "require('ffi').offsetof('struct LuaDetectorPacket', '" #f "')"))
+
+TEST(lua_detector_packet, layout)
+{
+    CHECK_EQUAL((double)sizeof(LuaDetectorPacket),
+        eval(L, "require('ffi').sizeof('struct LuaDetectorPacket')"));
+
+    CHECK_OFFSET(data);
+    CHECK_OFFSET(size);
+    CHECK_OFFSET(dir);
+    CHECK_OFFSET(proto);
+    CHECK_OFFSET(src_port);
+    CHECK_OFFSET(dst_port);
+    CHECK_OFFSET(src_addr);
+    CHECK_OFFSET(dst_addr);
+    CHECK_OFFSET(count);
+    CHECK_OFFSET(ip_ver);
+    CHECK_OFFSET(src_ip);
+    CHECK_OFFSET(dst_ip);
+}
+
+TEST(lua_detector_packet, ip4)
+{
+    ip::IP4Hdr h4 = { };
+    inet_pton(AF_INET, "10.1.2.3", &h4.ip_src);
+    inet_pton(AF_INET, "192.168.0.4", &h4.ip_dst);
+
+    Packet p;
+    p.ptrs.ip_api.set(&h4);
+    p.ip_proto_next = IpProtocol::TCP;
+    p.ptrs.sp = 40000;
+    p.ptrs.dp = 443;
+
+    set_detector_packet(dp, &p, payload, sizeof(payload), 1, 1234567890123ULL);
+
+    CHECK_EQUAL(3, eval(L, "DetectorPacket.size"));
+    CHECK_EQUAL(0x16, eval(L, "DetectorPacket.data[0]"));
+    CHECK_EQUAL(1, eval(L, "DetectorPacket.data[2]"));
+    CHECK_EQUAL(1, eval(L, "DetectorPacket.dir"));
+    CHECK_EQUAL(6, eval(L, "DetectorPacket.proto"));
+    CHECK_EQUAL(40000, eval(L, "DetectorPacket.src_port"));
+    CHECK_EQUAL(443, eval(L, "DetectorPacket.dst_port"));
+    CHECK_EQUAL(1234567890123.0, eval(L, "DetectorPacket.count"));
+    CHECK_EQUAL(4, eval(L, "DetectorPacket.ip_ver"));
+    CHECK_EQUAL((double)h4.ip_src, eval(L, "DetectorPacket.src_addr"));
+    CHECK_EQUAL((double)h4.ip_dst, eval(L, "DetectorPacket.dst_addr"));
+
+    // IPv4 is mapped into the 16 byte addresses
+    CHECK_EQUAL(0, eval(L, "DetectorPacket.src_ip[0]"));
+    CHECK_EQUAL(0xff, eval(L, "DetectorPacket.src_ip[10]"));
+    CHECK_EQUAL(0xff, eval(L, "DetectorPacket.src_ip[11]"));
+    CHECK_EQUAL(10, eval(L, "DetectorPacket.src_ip[12]"));
+    CHECK_EQUAL(3, eval(L, "DetectorPacket.src_ip[15]"));
+    CHECK_EQUAL(192, eval(L, "DetectorPacket.dst_ip[12]"));
+    CHECK_EQUAL(4, eval(L, "DetectorPacket.dst_ip[15]"));
+}
+
+TEST(lua_detector_packet, ip6)
+{
+    ip::IP6Hdr h6 = { };
+    inet_pton(AF_INET6, "2001:db8::1", &h6.ip6_src);
+    inet_pton(AF_INET6, "fe80::2", &h6.ip6_dst);
+
+    Packet p;
+    p.ptrs.ip_api.set(&h6);
+    p.ip_proto_next = IpProtocol::UDP;
+    p.ptrs.sp = 5353;
+    p.ptrs.dp = 53;
+
+    set_detector_packet(dp, &p, payload, sizeof(payload), 0, 1);
+
+    CHECK_EQUAL(17, eval(L, "DetectorPacket.proto"));
+    CHECK_EQUAL(6, eval(L, "DetectorPacket.ip_ver"));
+    CHECK_EQUAL(0, eval(L, "DetectorPacket.src_addr"));
+    CHECK_EQUAL(0, eval(L, "DetectorPacket.dst_addr"));
+
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        std::string src = "DetectorPacket.src_ip[" + std::to_string(i) + "]";
+        std::string dst = "DetectorPacket.dst_ip[" + std::to_string(i) + "]";
+        CHECK_EQUAL(h6.ip6_src.u6_addr8[i], eval(L, src.c_str()));
+        CHECK_EQUAL(h6.ip6_dst.u6_addr8[i], eval(L, dst.c_str()));
+    }
+}
+
+TEST(lua_detector_packet, no_ip)
+{
+    Packet p;
+    p.ptrs.ip_api.reset();
+
+    set_detector_packet(dp, &p, payload, sizeof(payload), 0, 2);
+    CHECK_EQUAL(0, eval(L, "DetectorPacket.ip_ver"));
+    CHECK_EQUAL(0, eval(L, "DetectorPacket.proto"));
+    CHECK_EQUAL(0, eval(L, "DetectorPacket.src_ip[10]"));
+
+    set_detector_packet(dp, nullptr, nullptr, 0, 0, 3);
+    CHECK_EQUAL(0, eval(L, "DetectorPacket.size"));
+    CHECK_EQUAL(0, eval(L, "DetectorPacket.ip_ver"));
+    CHECK_EQUAL(3, eval(L, "DetectorPacket.count"));
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -51,6 +51,8 @@ static const PegInfo bind_pegs[] =
     { CountType::SUM, "assistant_inspectors", "flow assistant inspector requests handled" },
     { CountType::SUM, "new_standby_flows", "new HA flows evaluated" },
     { CountType::SUM, "no_match", "binding evaluations that had no matches" },
+    { CountType::SUM, "binding_checks", "bindings checked after selection by the binding table" },
+    { CountType::MAX, "max_binding_checks", "maximum bindings checked for a single evaluation" },
     { CountType::SUM, "resets", "reset actions bound" },
     { CountType::SUM, "blocks", "block actions bound" },
     { CountType::SUM, "allows", "allow actions bound" },
@@ -38,6 +38,8 @@ struct BindStats
     PegCount assistant_inspectors;
     PegCount new_standby_flows;
     PegCount no_match;
+    PegCount binding_checks;
+    PegCount max_binding_checks;
     PegCount verdicts[BindUse::BA_MAX];
 };
 
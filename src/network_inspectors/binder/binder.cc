@@ -37,11 +37,15 @@
 
 #include "bind_module.h"
 #include "binding.h"
+#include "binding_table.h"
 
 using namespace snort;
 
 THREAD_LOCAL ProfileStats bindPerfStats;
 
+// scratch space for binding table selections
+static THREAD_LOCAL BindingTable::Set* candidates = nullptr;
+
 //-------------------------------------------------------------------------
 // helpers
 //-------------------------------------------------------------------------
@@ -310,6 +314,14 @@ static std::string to_string(const BindUse& bu)
     return use;
 }
 
+static inline void count_checks(PegCount checks)
+{
+    bstats.binding_checks += checks;
+
+    if (checks > bstats.max_binding_checks)
+        bstats.max_binding_checks = checks;
+}
+
 //-------------------------------------------------------------------------
 // stuff stuff
 //-------------------------------------------------------------------------
@@ -501,6 +513,8 @@ private:
 private:
     std::vector<Binding> bindings;
     std::vector<Binding> policy_bindings;
+    BindingTable binding_table;
+    BindingTable policy_binding_table;
     Inspector* default_ssn_inspectors[to_utype(PktType::MAX)]{};
 };
 
@@ -612,6 +626,9 @@ bool Binder::configure(SnortConfig* sc)
     for (Binding& b : policy_bindings)
         b.configure(sc);
 
+    binding_table.compile(bindings);
+    policy_binding_table.compile(policy_bindings);
+
     // Grab default session inspectors if they exist for this policy
     for (int proto = to_utype(PktType::NONE); proto < to_utype(PktType::MAX); proto++)
     {
@@ -687,6 +704,7 @@ void Binder::remove_inspector_binding(SnortConfig*, const char* name)
         if (!strcmp(key, name))
         {
             bindings.erase(it);
+            binding_table.compile(bindings);
             return;
         }
     }
@@ -861,12 +879,20 @@ void Binder::get_policy_bindings(Flow& flow, const char* service)
     // FIXIT-L This will select the first policy ID of each type that it finds and ignore the rest.
     //          It gets potentially hairy if people start specifying overlapping policy types in
     //          overlapping rules.
-    for (const Binding& b : policy_bindings)
+    BindingTable::Set& cand = *candidates;
+    policy_binding_table.select(flow, service, cand);
+    PegCount checks = 0;
+
+    for (unsigned i = policy_binding_table.first(cand); i < policy_binding_table.size();
+        i = policy_binding_table.next(cand, i))
     {
+        const Binding& b = policy_bindings[i];
+
         // Skip any rules that don't contain an ID for a policy type we haven't set yet.
         if ((!b.use.inspection_index || inspection_index) && (!b.use.ips_index || ips_index))
             continue;
 
+        ++checks;
         if (!b.check_all(flow, service))
             continue;
 
@@ -877,6 +903,8 @@ void Binder::get_policy_bindings(Flow& flow, const char* service)
             ips_index = b.use.ips_index;
     }
 
+    count_checks(checks);
+
     if (inspection_index)
     {
         set_inspection_policy(inspection_index);
@@ -901,12 +929,20 @@ void Binder::get_policy_bindings(Packet* p)
     // FIXIT-L This will select the first policy ID of each type that it finds and ignore the rest.
     //          It gets potentially hairy if people start specifying overlapping policy types in
     //          overlapping rules.
-    for (const Binding& b : policy_bindings)
+    BindingTable::Set& cand = *candidates;
+    policy_binding_table.select(p, cand);
+    PegCount checks = 0;
+
+    for (unsigned i = policy_binding_table.first(cand); i < policy_binding_table.size();
+        i = policy_binding_table.next(cand, i))
     {
+        const Binding& b = policy_bindings[i];
+
         // Skip any rules that don't contain an ID for a policy type we haven't set yet.
         if ((!b.use.inspection_index || inspection_index) && (!b.use.ips_index || ips_index))
             continue;
 
+        ++checks;
         if (!b.check_all(p))
             continue;
 
@@ -917,6 +953,8 @@ void Binder::get_policy_bindings(Packet* p)
             ips_index = b.use.ips_index;
     }
 
+    count_checks(checks);
+
     if (inspection_index)
     {
         set_inspection_policy(inspection_index);
@@ -931,8 +969,7 @@ void Binder::get_policy_bindings(Packet* p)
     }
 }
 
-// FIXIT-P this is a simple linear search until functionality is nailed
-// down.  performance should be the focus of the next iteration.
+// only bindings selected by the table are checked, in configuration order
 void Binder::get_bindings(Flow& flow, Stuff& stuff, const char* service)
 {
     // Evaluate policy ID bindings first
@@ -952,15 +989,27 @@ void Binder::get_bindings(Flow& flow, Stuff& stuff, const char* service)
     // Initialize the session inspector for both client and server to the default for this policy.
     stuff.client = stuff.server = default_ssn_inspectors[to_utype(flow.pkt_type)];
 
-    for (const Binding& b : bindings)
+    BindingTable::Set& cand = *candidates;
+    binding_table.select(flow, service, cand);
+    PegCount checks = 0;
+
+    for (unsigned i = binding_table.first(cand); i < binding_table.size();
+        i = binding_table.next(cand, i))
     {
+        const Binding& b = bindings[i];
+
+        ++checks;
         if (!b.check_all(flow, service))
             continue;
 
         if (stuff.update(b))
+        {
+            count_checks(checks);
             return;
+        }
     }
 
+    count_checks(checks);
     bstats.no_match++;
 }
 
@@ -983,15 +1032,27 @@ void Binder::get_bindings(Packet* p, Stuff& stuff)
     // Initialize the session inspector for both client and server to the default for this policy.
     stuff.client = stuff.server = default_ssn_inspectors[to_utype(p->type())];
 
-    for (const Binding& b : bindings)
+    BindingTable::Set& cand = *candidates;
+    binding_table.select(p, cand);
+    PegCount checks = 0;
+
+    for (unsigned i = binding_table.first(cand); i < binding_table.size();
+        i = binding_table.next(cand, i))
     {
+        const Binding& b = bindings[i];
+
+        ++checks;
         if (!b.check_all(p))
             continue;
 
         if (stuff.update(b))
+        {
+            count_checks(checks);
             return;
+        }
     }
 
+    count_checks(checks);
     bstats.no_match++;
 }
 
@@ -1041,6 +1102,17 @@ static void bind_dtor(Inspector* p)
     delete p;
 }
 
+static void bind_tinit()
+{
+    candidates = new BindingTable::Set;
+}
+
+static void bind_tterm()
+{
+    delete candidates;
+    candidates = nullptr;
+}
+
 static const InspectApi bind_api =
 {
     {
@@ -1061,8 +1133,8 @@ static const InspectApi bind_api =
     nullptr, // service
     nullptr, // pinit
     nullptr, // pterm
-    nullptr, // tinit
-    nullptr, // tterm
+    bind_tinit,
+    bind_tterm,
     bind_ctor,
     bind_dtor,
     nullptr, // ssn
@@ -0,0 +1,556 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "binding_table.h"
+
+#include <strings.h>
+
+#include <map>
+
+#include "flow/flow.h"
+#include "flow/flow_key.h"
+#include "protocols/packet.h"
+
+#ifdef UNIT_TEST
+#include <cstring>
+#include <set>
+
+#include "catch/snort_catch.h"
+#include "parser/parse_ip.h"
+#include "sfip/sf_ipvar.h"
+#endif
+
+using namespace snort;
+
+#define NUM_PORTS 65536
+#define NUM_VLANS 4096
+
+static inline void set_bit(BindingTable::Set& s, unsigned i)
+{ s[i / 64] |= (uint64_t)1 << (i % 64); }
+
+static inline void intersect(BindingTable::Set& s, const BindingTable::Set& t)
+{
+    for ( unsigned i = 0; i < s.size(); ++i )
+        s[i] &= t[i];
+}
+
+static inline void intersect(BindingTable::Set& s, const BindingTable::Set& t,
+    const BindingTable::Set& u)
+{
+    for ( unsigned i = 0; i < s.size(); ++i )
+        s[i] &= (t[i] | u[i]);
+}
+
+static bool accepts_server_port(const BindWhen& w, unsigned port)
+{
+    if ( w.has_criteria(BindWhen::BWC_PORTS) and w.role == BindWhen::BR_SERVER and
+        !w.src_ports.test(port) )
+        return false;
+
+    if ( w.has_criteria(BindWhen::BWC_SPLIT_PORTS) and !w.dst_ports.test(port) )
+        return false;
+
+    return true;
+}
+
+static bool accepts_client_port(const BindWhen& w, unsigned port)
+{
+    if ( w.has_criteria(BindWhen::BWC_PORTS) and w.role == BindWhen::BR_CLIENT and
+        !w.src_ports.test(port) )
+        return false;
+
+    if ( w.has_criteria(BindWhen::BWC_SPLIT_PORTS) and !w.src_ports.test(port) )
+        return false;
+
+    return true;
+}
+
+// either port must be accepted so this is checked against both ports
+static bool accepts_either_port(const BindWhen& w, unsigned port)
+{
+    if ( w.has_criteria(BindWhen::BWC_PORTS) and w.role == BindWhen::BR_EITHER )
+        return w.src_ports.test(port);
+
+    return true;
+}
+
+static bool accepts_vlan(const BindWhen& w, unsigned vlan)
+{
+    return !w.has_criteria(BindWhen::BWC_VLANS) or w.vlans.test(vlan);
+}
+
+// the class map is only built when some binding is selective in this
+// dimension; values accepted by the same bindings share a class
+template <typename Accept>
+void BindingTable::build(ClassMap& cm, unsigned num_values, const std::vector<Binding>& bv,
+    Accept accept)
+{
+    cm.classes.clear();
+    cm.sets.clear();
+
+    Set any(num_words, 0);
+    std::vector<unsigned> selective;
+
+    for ( unsigned i = 0; i < num_bindings; ++i )
+    {
+        unsigned v = 0;
+
+        while ( v < num_values and accept(bv[i].when, v) )
+            ++v;
+
+        if ( v < num_values )
+            selective.emplace_back(i);
+        else
+            set_bit(any, i);
+    }
+
+    if ( selective.empty() )
+        return;
+
+    std::map<Set, uint16_t> known;
+    cm.classes.resize(num_values);
+
+    for ( unsigned v = 0; v < num_values; ++v )
+    {
+        Set s(any);
+
+        for ( auto i : selective )
+        {
+            if ( accept(bv[i].when, v) )
+                set_bit(s, i);
+        }
+
+        auto it = known.find(s);
+
+        if ( it == known.end() )
+        {
+            it = known.emplace(s, (uint16_t)cm.sets.size()).first;
+            cm.sets.emplace_back(std::move(s));
+        }
+        cm.classes[v] = it->second;
+    }
+}
+
+void BindingTable::compile(const std::vector<Binding>& bv)
+{
+    num_bindings = bv.size();
+    num_words = (num_bindings + 63) / 64;
+
+    // packet type, including the implied tcp / udp of port criteria
+    for ( unsigned t = 0; t < to_utype(PktType::MAX); ++t )
+    {
+        protos[t].assign(num_words, 0);
+
+        for ( unsigned i = 0; i < num_bindings; ++i )
+        {
+            const BindWhen& w = bv[i].when;
+
+            // no proto bit for PktType::NONE; leave it to check_all
+            if ( t != to_utype(PktType::NONE) )
+            {
+                if ( w.has_criteria(BindWhen::BWC_PROTO) and !(w.protos & (1u << (t - 1))) )
+                    continue;
+
+                if ( (w.has_criteria(BindWhen::BWC_PORTS) or
+                    w.has_criteria(BindWhen::BWC_SPLIT_PORTS)) and
+                    t != to_utype(PktType::TCP) and t != to_utype(PktType::UDP) )
+                    continue;
+            }
+            set_bit(protos[t], i);
+        }
+    }
+
+    // service
+    no_service.assign(num_words, 0);
+    services.clear();
+
+    for ( unsigned i = 0; i < num_bindings; ++i )
+    {
+        const BindWhen& w = bv[i].when;
+
+        if ( !w.has_criteria(BindWhen::BWC_SVC) )
+            set_bit(no_service, i);
+
+        else
+        {
+            Set& s = services[w.svc];
+            s.resize(num_words, 0);
+            set_bit(s, i);
+        }
+    }
+
+    build(vlans, NUM_VLANS, bv, accepts_vlan);
+    build(server_ports, NUM_PORTS, bv, accepts_server_port);
+    build(client_ports, NUM_PORTS, bv, accepts_client_port);
+    build(either_ports, NUM_PORTS, bv, accepts_either_port);
+
+    // address spaces and tenants
+    use_addr_spaces = use_tenants = false;
+    any_addr_space.assign(num_words, 0);
+    any_tenant.assign(num_words, 0);
+    addr_spaces.clear();
+    tenants.clear();
+
+    for ( unsigned i = 0; i < num_bindings; ++i )
+    {
+        const BindWhen& w = bv[i].when;
+
+        if ( w.has_criteria(BindWhen::BWC_ADDR_SPACES) )
+        {
+            use_addr_spaces = true;
+
+            for ( auto as : w.addr_spaces )
+                addr_spaces[as].resize(num_words, 0);
+        }
+        if ( w.has_criteria(BindWhen::BWC_TENANTS) )
+        {
+            use_tenants = true;
+
+            for ( auto t : w.tenants )
+                tenants[t].resize(num_words, 0);
+        }
+    }
+
+    for ( unsigned i = 0; i < num_bindings; ++i )
+    {
+        const BindWhen& w = bv[i].when;
+
+        if ( !w.has_criteria(BindWhen::BWC_ADDR_SPACES) )
+        {
+            set_bit(any_addr_space, i);
+
+            for ( auto& as : addr_spaces )
+                set_bit(as.second, i);
+        }
+        else
+        {
+            for ( auto as : w.addr_spaces )
+                set_bit(addr_spaces[as], i);
+        }
+
+        if ( !w.has_criteria(BindWhen::BWC_TENANTS) )
+        {
+            set_bit(any_tenant, i);
+
+            for ( auto& t : tenants )
+                set_bit(t.second, i);
+        }
+        else
+        {
+            for ( auto t : w.tenants )
+                set_bit(tenants[t], i);
+        }
+    }
+}
+
+void BindingTable::select(const Key& key, const char* explicit_service, Set& s) const
+{
+    s = protos[to_utype(key.type) < to_utype(PktType::MAX) ? to_utype(key.type) : 0];
+
+    if ( explicit_service )
+    {
+        // explicit service lookups only match bindings for that service
+        auto it = services.find(explicit_service);
+
+        if ( it == services.end() )
+        {
+            s.assign(num_words, 0);
+            return;
+        }
+        intersect(s, it->second);
+    }
+    else
+    {
+        auto it = key.service ? services.find(key.service) : services.end();
+
+        if ( it == services.end() )
+            intersect(s, no_service);
+        else
+            intersect(s, no_service, it->second);
+    }
+
+    if ( !vlans.empty() and key.vlan < NUM_VLANS )
+        intersect(s, vlans.get(key.vlan));
+
+    if ( !server_ports.empty() )
+        intersect(s, server_ports.get(key.server_port));
+
+    if ( !client_ports.empty() )
+        intersect(s, client_ports.get(key.client_port));
+
+    if ( !either_ports.empty() )
+        intersect(s, either_ports.get(key.client_port), either_ports.get(key.server_port));
+
+    if ( use_addr_spaces )
+    {
+        auto it = addr_spaces.find(key.addr_space);
+        intersect(s, it == addr_spaces.end() ? any_addr_space : it->second);
+    }
+
+    if ( use_tenants )
+    {
+        auto it = tenants.find(key.tenant);
+        intersect(s, it == tenants.end() ? any_tenant : it->second);
+    }
+}
+
+void BindingTable::select(const Flow& flow, const char* service, Set& s) const
+{
+    Key key;
+
+    key.type = flow.pkt_type;
+    key.service = flow.service;
+    key.vlan = flow.key->vlan_tag;
+    key.client_port = flow.client_port;
+    key.server_port = flow.server_port;
+    key.addr_space = flow.key->addressSpaceId;
+    key.tenant = flow.tenant;
+
+    select(key, service, s);
+}
+
+void BindingTable::select(const Packet* p, Set& s) const
+{
+    Key key;
+
+    key.type = p->type();
+    key.service = nullptr;
+    key.vlan = p->get_flow_vlan_id();
+    key.client_port = p->ptrs.sp;
+    key.server_port = p->ptrs.dp;
+    key.addr_space = p->pkth->address_space_id;
+    key.tenant = p->pkth->tenant_id;
+
+    select(key, nullptr, s);
+}
+
+unsigned BindingTable::next(const Set& s, unsigned i, bool inclusive) const
+{
+    if ( !inclusive )
+        ++i;
+
+    unsigned w = i / 64;
+
+    if ( w >= s.size() )
+        return num_bindings;
+
+    uint64_t bits = s[w] & (~(uint64_t)0 << (i % 64));
+
+    while ( !bits )
+    {
+        if ( ++w >= s.size() )
+            return num_bindings;
+
+        bits = s[w];
+    }
+    return w * 64 + ffsll(bits) - 1;
+}
+
+
+#ifdef UNIT_TEST
+// overlapping bindings, each selective in one or two dimensions, with
+// wildcards so that several bindings usually match and order matters
+static void make_bindings(std::vector<Binding>& bv)
+{
+    bv.resize(14);
+
+    // 0: client or server in 10.1/16, server port 80
+    bv[0].when.src_nets = sfip_var_from_string("10.1.0.0/16", "test");
+    bv[0].when.add_criteria(BindWhen::BWC_NETS);
+    bv[0].when.src_ports.reset();
+    bv[0].when.src_ports.set(80);
+    bv[0].when.role = BindWhen::BR_SERVER;
+    bv[0].when.add_criteria(BindWhen::BWC_PORTS);
+
+    // 1: vlan 100
+    bv[1].when.vlans.set(100);
+    bv[1].when.add_criteria(BindWhen::BWC_VLANS);
+
+    // 2: zone 5 on either side
+    bv[2].when.src_groups.insert(5);
+    bv[2].when.add_criteria(BindWhen::BWC_GROUPS);
+
+    // 3: http service
+    bv[3].when.svc = "http";
+    bv[3].when.add_criteria(BindWhen::BWC_SVC);
+
+    // 4: any client port to server port 443
+    bv[4].when.dst_ports.reset();
+    bv[4].when.dst_ports.set(443);
+    bv[4].when.add_criteria(BindWhen::BWC_SPLIT_PORTS);
+
+    // 5: tcp on either port in 8000-8100
+    bv[5].when.protos = PROTO_BIT__TCP;
+    bv[5].when.add_criteria(BindWhen::BWC_PROTO);
+    bv[5].when.src_ports.reset();
+    for ( unsigned p = 8000; p <= 8100; ++p )
+        bv[5].when.src_ports.set(p);
+    bv[5].when.add_criteria(BindWhen::BWC_PORTS);
+
+    // 6: client in 10/8, server in 192.168/16, vlans 100-200
+    bv[6].when.src_nets = sfip_var_from_string("10.0.0.0/8", "test");
+    bv[6].when.dst_nets = sfip_var_from_string("192.168.0.0/16", "test");
+    bv[6].when.add_criteria(BindWhen::BWC_SPLIT_NETS);
+    for ( unsigned v = 100; v <= 200; ++v )
+        bv[6].when.vlans.set(v);
+    bv[6].when.add_criteria(BindWhen::BWC_VLANS);
+
+    // 7: client zone 5 to any server zone, http
+    bv[7].when.src_groups.insert(5);
+    bv[7].when.add_criteria(BindWhen::BWC_SPLIT_GROUPS);
+    bv[7].when.svc = "http";
+    bv[7].when.add_criteria(BindWhen::BWC_SVC);
+
+    // 8: address space 3
+    bv[8].when.addr_spaces.insert(3);
+    bv[8].when.add_criteria(BindWhen::BWC_ADDR_SPACES);
+
+    // 9: tenant 7, udp
+    bv[9].when.tenants.insert(7);
+    bv[9].when.add_criteria(BindWhen::BWC_TENANTS);
+    bv[9].when.protos = PROTO_BIT__UDP;
+    bv[9].when.add_criteria(BindWhen::BWC_PROTO);
+
+    // 10: ftp service on client port 1234
+    bv[10].when.svc = "ftp";
+    bv[10].when.add_criteria(BindWhen::BWC_SVC);
+    bv[10].when.src_ports.reset();
+    bv[10].when.src_ports.set(1234);
+    bv[10].when.role = BindWhen::BR_CLIENT;
+    bv[10].when.add_criteria(BindWhen::BWC_PORTS);
+
+    // 11: server zone 6, vlan 300
+    bv[11].when.dst_groups.insert(6);
+    bv[11].when.add_criteria(BindWhen::BWC_SPLIT_GROUPS);
+    bv[11].when.vlans.set(300);
+    bv[11].when.add_criteria(BindWhen::BWC_VLANS);
+
+    // 12: server in 192.168/16
+    bv[12].when.src_nets = sfip_var_from_string("192.168.0.0/16", "test");
+    bv[12].when.role = BindWhen::BR_SERVER;
+    bv[12].when.add_criteria(BindWhen::BWC_NETS);
+
+    // 13: wildcard
+}
+
+static unsigned linear_first(const std::vector<Binding>& bv, const Flow& flow, const char* svc)
+{
+    unsigned i = 0;
+
+    while ( i < bv.size() and !bv[i].check_all(flow, svc) )
+        ++i;
+
+    return i;
+}
+
+static unsigned indexed_first(const BindingTable& bt, const std::vector<Binding>& bv,
+    const Flow& flow, const char* svc)
+{
+    BindingTable::Set cand;
+    bt.select(flow, svc, cand);
+
+    unsigned i = bt.first(cand);
+
+    while ( i < bt.size() and !bv[i].check_all(flow, svc) )
+        i = bt.next(cand, i);
+
+    return i;
+}
+
+static void set_ip(SfIp& ip, const char* s)
+{ REQUIRE(ip.set(s) == SFIP_SUCCESS); }
+
+TEST_CASE("binding table matches the linear walk", "[binder]")
+{
+    std::vector<Binding> base;
+    make_bindings(base);
+
+    const char* addrs[] = { "10.1.1.1", "10.2.2.2", "192.168.1.1" };
+    const uint16_t client_ports[] = { 1234, 8050 };
+    const uint16_t server_ports[] = { 22, 80, 443, 8050 };
+    const uint16_t vlans[] = { 0, 100, 150, 300 };
+    const int16_t groups[] = { 0, 5, 6 };
+    const char* services[] = { nullptr, "http", "ftp" };
+    const PktType types[] = { PktType::TCP, PktType::UDP, PktType::ICMP };
+    const uint32_t spaces[] = { 0, 3 };
+    const uint32_t tenants[] = { 0, 7 };
+
+    // every binding is the first match of some flow in some order
+    std::set<unsigned> firsts;
+
+    // rotate the bindings so the overlaps are resolved differently
+    for ( unsigned r = 0; r < base.size(); r += 3 )
+    {
+        std::vector<Binding> bv(base.begin() + r, base.end());
+        bv.insert(bv.end(), base.begin(), base.begin() + r);
+
+        BindingTable bt;
+        bt.compile(bv);
+        REQUIRE(bt.size() == bv.size());
+
+        FlowKey key;
+        memset(&key, 0, sizeof(key));
+
+        Flow flow;
+        flow.key = &key;
+
+        for ( auto cip : addrs )
+        for ( auto sip : addrs )
+        for ( auto cp : client_ports )
+        for ( auto sp : server_ports )
+        for ( auto vlan : vlans )
+        for ( auto cg : groups )
+        for ( auto sg : groups )
+        for ( auto svc : services )
+        for ( auto type : types )
+        for ( auto as : spaces )
+        for ( auto tenant : tenants )
+        {
+            set_ip(flow.client_ip, cip);
+            set_ip(flow.server_ip, sip);
+            flow.client_port = cp;
+            flow.server_port = sp;
+            key.vlan_tag = vlan;
+            flow.client_group = cg;
+            flow.server_group = sg;
+            flow.service = svc;
+            flow.pkt_type = type;
+            key.addressSpaceId = as;
+            flow.tenant = tenant;
+
+            unsigned first = linear_first(bv, flow, nullptr);
+            CHECK(indexed_first(bt, bv, flow, nullptr) == first);
+            if ( first < bv.size() )
+                firsts.insert((first + r) % bv.size());
+
+            // explicit service lookups only consider bindings for the service
+            if ( svc )
+                CHECK(indexed_first(bt, bv, flow, svc) == linear_first(bv, flow, svc));
+        }
+        flow.key = nullptr;
+    }
+    CHECK(firsts.size() == base.size());
+
+    for ( auto& b : base )
+        b.clear();
+}
+#endif
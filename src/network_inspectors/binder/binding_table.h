@@ -0,0 +1,119 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef BINDING_TABLE_H
+#define BINDING_TABLE_H
+
+// BindingTable is compiled from a vector of bindings at configure time and
+// narrows a flow or packet down to the bindings that can possibly match it.
+// Each indexed dimension (packet type, service, vlan, ports, address space,
+// tenant) maps a value to a bit set of bindings accepting that value; the
+// intersection is returned in binding order.  Candidates must still be
+// confirmed with Binding::check_all so results are identical to a linear
+// scan while non-matching bindings are skipped wholesale.
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "framework/decode_data.h"
+#include "protocols/protocol_ids.h"
+
+#include "binding.h"
+
+namespace snort
+{
+class Flow;
+struct Packet;
+}
+
+class BindingTable
+{
+public:
+    typedef std::vector<uint64_t> Set;
+
+    void compile(const std::vector<Binding>&);
+
+    // get the candidate bindings for the flow or packet
+    void select(const snort::Flow&, const char* service, Set&) const;
+    void select(const snort::Packet*, Set&) const;
+
+    // iterate candidates: for ( i = first(s); i < size(); i = next(s, i) )
+    unsigned first(const Set& s) const
+    { return next(s, 0, true); }
+
+    unsigned next(const Set& s, unsigned i, bool inclusive = false) const;
+
+    unsigned size() const
+    { return num_bindings; }
+
+private:
+    // value -> equivalence class -> bindings accepting that value
+    struct ClassMap
+    {
+        std::vector<uint16_t> classes;
+        std::vector<Set> sets;
+
+        bool empty() const
+        { return sets.empty(); }
+
+        const Set& get(unsigned value) const
+        { return sets[classes[value]]; }
+    };
+
+    struct Key
+    {
+        PktType type;
+        const char* service;
+        unsigned vlan;
+        uint16_t client_port;
+        uint16_t server_port;
+        uint32_t addr_space;
+        uint32_t tenant;
+    };
+
+    template <typename Accept>
+    void build(ClassMap&, unsigned num_values, const std::vector<Binding>&, Accept);
+
+    void select(const Key&, const char* explicit_service, Set&) const;
+
+    unsigned num_bindings = 0;
+    unsigned num_words = 0;
+
+    Set protos[to_utype(PktType::MAX)];
+
+    Set no_service;
+    std::unordered_map<std::string, Set> services;
+
+    ClassMap vlans;
+    ClassMap client_ports;
+    ClassMap server_ports;
+    ClassMap either_ports;
+
+    Set any_addr_space;
+    std::unordered_map<uint32_t, Set> addr_spaces;
+    bool use_addr_spaces = false;
+
+    Set any_tenant;
+    std::unordered_map<uint32_t, Set> tenants;
+    bool use_tenants = false;
+};
+
+#endif
+
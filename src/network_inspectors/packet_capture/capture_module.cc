@@ -49,6 +49,15 @@ static const Parameter s_capture[] =
     { "group", Parameter::PT_INT, "-1:32767", "-1",
       "group filter to use for the packet dump" },
 
+    { "snaplen", Parameter::PT_INT, "0:65535", "0",
+      "maximum bytes of each packet to dump (0 is all)" },
+
+    { "sample", Parameter::PT_INT, "1:max32", "1",
+      "dump 1 of this many packets matching the filter" },
+
+    { "ring_size", Parameter::PT_INT, "0:maxSZ", "1048576",
+      "bytes of packets each packet thread can queue for the log writer thread" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -74,6 +83,8 @@ static const PegInfo cap_names[] =
 {
     { CountType::SUM, "processed", "packets processed against filter" },
     { CountType::SUM, "captured", "packets matching dumped after matching filter" },
+    { CountType::SUM, "skipped", "packets matching the filter not dumped due to sampling" },
+    { CountType::SUM, "dropped", "packets not dumped because the capture ring was full" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -140,6 +151,9 @@ CaptureModule::CaptureModule() :
 {
     config.enabled = false;
     config.group = -1;
+    config.snaplen = 0;
+    config.sample = 1;
+    config.ring_size = 1048576;
 }
 
 bool CaptureModule::set(const char*, Value& v, SnortConfig*)
@@ -153,6 +167,15 @@ bool CaptureModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("group") )
         config.group = v.get_int16();
 
+    else if ( v.is("snaplen") )
+        config.snaplen = v.get_uint16();
+
+    else if ( v.is("sample") )
+        config.sample = v.get_uint32();
+
+    else if ( v.is("ring_size") )
+        config.ring_size = v.get_size();
+
     return true;
 }
 
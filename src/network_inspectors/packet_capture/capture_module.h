@@ -31,12 +31,17 @@ struct CaptureConfig
     bool enabled;
     int16_t group;
     std::string filter;
+    unsigned snaplen;
+    unsigned sample;
+    size_t ring_size;
 };
 
 struct CaptureStats
 {
     PegCount checked;
     PegCount matched;
+    PegCount skipped;
+    PegCount dropped;
 };
 
 class CaptureModule : public snort::Module
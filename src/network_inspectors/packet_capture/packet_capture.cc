@@ -28,6 +28,8 @@
 
 #include "framework/inspector.h"
 #include "log/messages.h"
+#include "log/pcap_stream.h"
+#include "packet_io/sfdaq.h"
 #include "protocols/packet.h"
 
 #ifdef UNIT_TEST
@@ -39,7 +41,7 @@
 using namespace snort;
 using namespace std;
 
-#define FILE_NAME "packet_capture.pcap"
+#define FILE_NAME "packet_capture.pcapng"
 #define SNAP_LEN 65535
 
 // -----------------------------------------------------------------------------
@@ -48,28 +50,24 @@ using namespace std;
 
 static CaptureConfig config;
 
-static THREAD_LOCAL pcap_t* pcap = nullptr;
-static THREAD_LOCAL pcap_dumper_t* dumper = nullptr;
+// packets are copied to the stream's ring and written by the log writer
+static THREAD_LOCAL PcapStream* capture = nullptr;
 static THREAD_LOCAL struct bpf_program bpf;
+static THREAD_LOCAL unsigned sample_count = 0;
 
 // -----------------------------------------------------------------------------
 // static functions
 // -----------------------------------------------------------------------------
 
 static inline bool capture_initialized()
-{ return dumper != nullptr; }
+{ return capture != nullptr; }
 
 static void _capture_term()
 {
-    if ( dumper )
+    if ( capture )
     {
-        pcap_dump_close(dumper);
-        dumper = nullptr;
-    }
-    if ( pcap )
-    {
-        free(pcap);
-        pcap = nullptr;
+        delete capture;
+        capture = nullptr;
     }
     pcap_freecode(&bpf);
 }
@@ -96,13 +94,20 @@ static bool open_pcap_dumper()
     string fname;
     get_instance_file(fname, FILE_NAME);
 
-    pcap = pcap_open_dead(DLT_EN10MB, SNAP_LEN);
-    dumper = pcap ? pcap_dump_open(pcap, fname.c_str()) : nullptr;
+    unsigned snaplen = config.snaplen ? config.snaplen : SNAP_LEN;
+
+    capture = new PcapStream(DLT_EN10MB, snaplen, true, SFDAQ::get_input_spec(),
+        config.ring_size, false);
 
-    if (dumper)
+    if ( capture->open(fname, false) )
+    {
+        sample_count = 0;
         return true;
-    else
-        WarningMessage("Could not initialize dump file\n");
+    }
+
+    delete capture;
+    capture = nullptr;
+    WarningMessage("Could not initialize dump file\n");
 
     return false;
 }
@@ -204,6 +209,10 @@ void PacketCapture::show(const SnortConfig*) const
     ConfigLogger::log_flag("enable", config.enabled);
     if ( config.enabled )
         ConfigLogger::log_value("filter", config.filter.c_str());
+
+    ConfigLogger::log_value("snaplen", config.snaplen);
+    ConfigLogger::log_value("sample", config.sample);
+    ConfigLogger::log_value("ring_size", config.ring_size);
 }
 
 void PacketCapture::eval(Packet* p)
@@ -226,7 +235,11 @@ void PacketCapture::eval(Packet* p)
         if ( !bpf.bf_insns || bpf_filter(bpf.bf_insns, p->pkt,
                 p->pktlen, p->pkth->pktlen) )
         {
-            write_packet(p);
+            if ( !(sample_count++ % config.sample) )
+                write_packet(p);
+            else
+                cap_count_stats.skipped++;
+
             cap_count_stats.matched++;
         }
 
@@ -238,12 +251,8 @@ void PacketCapture::eval(Packet* p)
 
 void PacketCapture::write_packet(Packet* p)
 {
-    struct pcap_pkthdr pcaphdr;
-    pcaphdr.ts = p->pkth->ts;
-    pcaphdr.caplen = p->pktlen;
-    pcaphdr.len = p->pkth->pktlen;
-    pcap_dump((unsigned char*)dumper, &pcaphdr, p->pkt);
-    pcap_dump_flush(dumper);
+    if ( !capture->write(p->pkth->ts, p->pkt, p->pktlen, p->pkth->pktlen) )
+        cap_count_stats.dropped++;
 }
 
 //-------------------------------------------------------------------------
@@ -337,7 +346,7 @@ protected:
     {
         if (bpf_compile_and_validate())
         {
-            dumper = (pcap_dumper_t*)1;
+            capture = (PcapStream*)1;
             return true;
         }
         _packet_capture_disable();
@@ -347,7 +356,7 @@ protected:
 
     void capture_term() override
     {
-        dumper = nullptr;
+        capture = nullptr;
         PacketCapture::capture_term();
     }
 };
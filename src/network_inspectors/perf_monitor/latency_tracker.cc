@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// latency_tracker.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "latency_tracker.h"
+
+#include "latency/stage_latency.h"
+
+#define TRACKER_NAME PERF_NAME "_latency"
+
+// stages are known before the packet threads start so there is a section
+// for every inspector
+LatencyTracker::LatencyTracker(PerfConfig* perf) :
+    PerfTracker(perf, TRACKER_NAME), stages(StageLatency::get_num_stages())
+{
+    for ( unsigned i = 0; i < stages.size(); ++i )
+    {
+        Stage& s = stages[i];
+
+        formatter->register_section(StageLatency::get_name(i));
+        formatter->register_field("count", &s.count);
+        formatter->register_field("p50_ns", &s.p50);
+        formatter->register_field("p99_ns", &s.p99);
+        formatter->register_field("p999_ns", &s.p999);
+        formatter->register_field("max_ns", &s.max);
+    }
+    formatter->finalize_fields();
+}
+
+void LatencyTracker::reset()
+{
+    for ( unsigned i = 0; i < stages.size(); ++i )
+    {
+        const LatencyHistogram* h = StageLatency::get_histogram(i);
+
+        if ( h )
+            stages[i].last = *h;
+        else
+            stages[i].last.reset();
+    }
+}
+
+void LatencyTracker::process(bool)
+{
+    for ( unsigned i = 0; i < stages.size(); ++i )
+    {
+        Stage& s = stages[i];
+        const LatencyHistogram* h = StageLatency::get_histogram(i);
+
+        if ( !h )
+        {
+            s.count = s.p50 = s.p99 = s.p999 = s.max = 0;
+            continue;
+        }
+
+        // the histograms may have been reset by a command
+        if ( h->get_count() < s.last.get_count() )
+            s.last.reset();
+
+        LatencyHistogram delta = *h;
+        delta -= s.last;
+        s.last = *h;
+
+        s.count = delta.get_count();
+        s.p50 = StageLatency::to_nsecs(delta.get_percentile(50.0));
+        s.p99 = StageLatency::to_nsecs(delta.get_percentile(99.0));
+        s.p999 = StageLatency::to_nsecs(delta.get_percentile(99.9));
+        s.max = StageLatency::to_nsecs(delta.get_max());
+    }
+    write();
+}
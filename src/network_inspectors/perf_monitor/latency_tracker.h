@@ -0,0 +1,55 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// latency_tracker.h author Cisco
+
+#ifndef LATENCY_TRACKER_H
+#define LATENCY_TRACKER_H
+
+// LatencyTracker reports the packet thread's stage latency percentiles for
+// each interval.  It requires latency.packet.histograms.
+
+#include <vector>
+
+#include "latency/latency_histogram.h"
+
+#include "perf_tracker.h"
+
+class LatencyTracker : public PerfTracker
+{
+public:
+    LatencyTracker(PerfConfig*);
+    void reset() override;
+    void process(bool) override;
+
+private:
+    struct Stage
+    {
+        LatencyHistogram last;
+
+        PegCount count;
+        PegCount p50;
+        PegCount p99;
+        PegCount p999;
+        PegCount max;
+    };
+
+    std::vector<Stage> stages;
+};
+
+#endif
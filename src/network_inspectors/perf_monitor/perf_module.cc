@@ -67,6 +67,9 @@ static const Parameter s_params[] =
     { "flow_ip", Parameter::PT_BOOL, nullptr, "false",
       "enable statistics on host pairs" },
 
+    { "latency", Parameter::PT_BOOL, nullptr, "false",
+      "enable stage latency percentiles (requires latency.packet.histograms)" },
+
     { "packets", Parameter::PT_INT, "0:max32", "10000",
       "minimum packets to report" },
 
@@ -251,6 +254,11 @@ bool PerfMonModule::set(const char*, Value& v, SnortConfig*)
         if ( v.get_bool() )
             config->perf_flags |= PERF_CPU;
     }
+    else if ( v.is("latency") )
+    {
+        if ( v.get_bool() )
+            config->perf_flags |= PERF_LATENCY;
+    }
     else if ( v.is("flow") )
     {
         if ( v.get_bool() )
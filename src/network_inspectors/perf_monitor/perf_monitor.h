@@ -28,6 +28,7 @@
 #include "cpu_tracker.h"
 #include "flow_ip_tracker.h"
 #include "flow_tracker.h"
+#include "latency_tracker.h"
 #include "perf_module.h"
 
 class FlowIPDataHandler;
@@ -28,14 +28,27 @@
 #include "log/messages.h"
 #include "managers/inspector_manager.h"
 #include "profiler/profiler.h"
+#include "protocols/ipv4.h"
+#include "protocols/ipv6.h"
+#include "protocols/packet.h"
 #include "utils/util.h"
 #include "utils/util_cstring.h"
 
+#include "time/packet_time.h"
+
 #include "ps_inspect.h"
+#include "ps_merge.h"
 #include "ps_module.h"
 
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
+// bound the work each packet does for the global view
+#define PS_MAX_CANDIDATE_EVALS 16
+
 THREAD_LOCAL PsPegStats spstats;
 THREAD_LOCAL ProfileStats psPerfStats;
 
@@ -265,9 +278,8 @@ static void PortscanAlertIcmp(Packet*, PS_PROTO* proto)
     }
 }
 
-static void PortscanAlert(PS_PKT* ps_pkt, PS_PROTO* proto, int proto_type)
+static void PortscanAlert(Packet* p, PS_PROTO* proto, int proto_type)
 {
-    Packet* p = ps_pkt->pkt;
     make_port_scan_info(p, proto);
 
     switch (proto_type)
@@ -290,6 +302,97 @@ static void PortscanAlert(PS_PKT* ps_pkt, PS_PROTO* proto, int proto_type)
     }
 }
 
+// a merged alert gets an ip header with the scanner and scanned addresses
+// of its trackers; an unknown address is left unspecified
+static void set_merged_ips(ip::IpApi& api, uint8_t* buf, const PS_ALERT_RECORD& rec)
+{
+    const SfIp* src = rec.scanner_key.protocol ? &rec.scanner_key.scanner : nullptr;
+    const SfIp* dst = rec.scanned_key.protocol ? &rec.scanned_key.scanned : nullptr;
+    bool ip4 = (!src or src->is_ip4()) and (!dst or dst->is_ip4());
+    IpProtocol proto;
+
+    switch ( rec.protocol )
+    {
+    case PS_PROTO_TCP:
+        proto = IpProtocol::TCP;
+        break;
+
+    case PS_PROTO_UDP:
+        proto = IpProtocol::UDP;
+        break;
+
+    case PS_PROTO_ICMP:
+        proto = ip4 ? IpProtocol::ICMPV4 : IpProtocol::ICMPV6;
+        break;
+
+    default:
+        proto = IpProtocol::RESERVED;
+        break;
+    }
+
+    if ( ip4 )
+    {
+        ip::IP4Hdr* h4 = reinterpret_cast<ip::IP4Hdr*>(buf);
+        memset(h4, 0, sizeof(*h4));
+
+        h4->ip_verhl = 0x40 | (ip::IP4_HEADER_LEN >> 2);
+        h4->ip_len = htons(ip::IP4_HEADER_LEN);
+        h4->ip_proto = proto;
+
+        if ( src )
+            h4->ip_src = src->get_ip4_value();
+
+        if ( dst )
+            h4->ip_dst = dst->get_ip4_value();
+
+        api.set(h4);
+    }
+    else
+    {
+        ip::IP6Hdr* h6 = reinterpret_cast<ip::IP6Hdr*>(buf);
+        memset(h6, 0, sizeof(*h6));
+
+        h6->ip6_vtf = htonl(0x60000000);
+        h6->ip6_next = proto;
+
+        if ( src )
+            memcpy(&h6->ip6_src, src->get_ip6_ptr(), sizeof(h6->ip6_src));
+
+        if ( dst )
+            memcpy(&h6->ip6_dst, dst->get_ip6_ptr(), sizeof(h6->ip6_dst));
+
+        api.set(h6);
+    }
+}
+
+// the current packet is unrelated to a merged alert so the event is
+// raised on a pseudo packet without a flow or payload
+static void PortscanMergedAlert(Packet* p, const PS_ALERT_RECORD& rec, PS_PROTO* proto)
+{
+    Packet* pp = DetectionEngine::set_next_packet(p);
+    DetectionEngine de;
+
+    DAQ_PktHdr_t* ph = pp->context->pkth;
+    memset(ph, 0, sizeof(*ph));
+    ph->ts = p->pkth->ts;
+
+    pp->pktlen = 0;
+    pp->data = nullptr;
+    pp->dsize = 0;
+
+    pp->packet_flags |= PKT_PSEUDO;
+    pp->pseudo_type = PSEUDO_PKT_IP;
+    pp->proto_bits |= PROTO_BIT__IP;
+    pp->ptrs.set_pkt_type(PktType::IP);
+
+    pp->user_inspection_policy_id = p->user_inspection_policy_id;
+    pp->user_ips_policy_id = p->user_ips_policy_id;
+    pp->user_network_policy_id = p->user_network_policy_id;
+
+    set_merged_ips(pp->ptrs.ip_api, const_cast<uint8_t*>(pp->pkt), rec);
+    PortscanAlert(pp, proto, rec.protocol);
+}
+
 static std::string get_protos(int ds)
 {
     std::string protos;
@@ -399,6 +502,10 @@ static void portscan_config_show(const PortscanConfig* config)
 
     ConfigLogger::log_flag("alert_all", config->alert_all);
     ConfigLogger::log_flag("include_midstream", config->include_midstream);
+    ConfigLogger::log_flag("sketch", config->sketch);
+
+    if ( config->sketch )
+        ConfigLogger::log_value("merge_interval", config->merge_interval);
 
     ConfigLogger::log_value("tcp_window", config->tcp_window);
     ConfigLogger::log_value("udp_window", config->udp_window);
@@ -415,15 +522,35 @@ PortScan::PortScan(PortScanModule* mod)
 
 PortScan::~PortScan()
 {
+    delete merger;
+
     if ( config )
         delete config;
 }
 
+bool PortScan::configure(SnortConfig*)
+{
+    if ( config->sketch and !merger )
+        merger = new PortScanMerger(config);
+
+    return true;
+}
+
 void PortScan::tinit()
-{ ps_init_hash(config->memcap); }
+{
+    if ( config->sketch )
+        ps_init_sketch(config->memcap, config->merge_interval);
+    else
+        ps_init_hash(config->memcap);
+}
 
 void PortScan::tterm()
-{ ps_cleanup(); }
+{
+    if ( merger )
+        ps_publish_sketch(merger, packet_time(), true);
+
+    ps_cleanup();
+}
 
 void PortScan::show(const SnortConfig*) const
 {
@@ -445,16 +572,53 @@ void PortScan::eval(Packet* p)
 
     ps_detect(&ps_pkt);
 
+    if ( merger )
+    {
+        ps_publish_sketch(merger, packet_time());
+        ps_merged_alerts(p);
+        return;
+    }
+
     if (ps_pkt.scanner and ps_pkt.scanner->proto.alerts and
         (ps_pkt.scanner->proto.alerts != PS_ALERT_GENERATED))
     {
-        PortscanAlert(&ps_pkt, &ps_pkt.scanner->proto, ps_pkt.proto);
+        PortscanAlert(p, &ps_pkt.scanner->proto, ps_pkt.proto);
     }
 
     if (ps_pkt.scanned and ps_pkt.scanned->proto.alerts and
         (ps_pkt.scanned->proto.alerts != PS_ALERT_GENERATED))
     {
-        PortscanAlert(&ps_pkt, &ps_pkt.scanned->proto, ps_pkt.proto);
+        PortscanAlert(p, &ps_pkt.scanned->proto, ps_pkt.proto);
+    }
+}
+
+// the alert logic runs here on the packet thread; the merger only ensures
+// that a tracker alerts once per window across all threads
+void PortScan::ps_merged_alerts(Packet* p)
+{
+    PS_ALERT_RECORD rec;
+
+    for ( unsigned i = 0; i < PS_MAX_CANDIDATE_EVALS and merger->get_candidate(rec); i++ )
+    {
+        PS_PROTO* scanner = rec.has_scanner ? &rec.scanner : nullptr;
+        PS_PROTO* scanned = rec.has_scanned ? &rec.scanned : nullptr;
+
+        if ( !ps_alert(rec.protocol, scanner, scanned) )
+            continue;
+
+        if ( scanner and scanner->alerts and scanner->alerts != PS_ALERT_GENERATED and
+            (config->alert_all or merger->claim(rec.scanner_key, scanner->window)) )
+        {
+            ++spstats.merged_alerts;
+            PortscanMergedAlert(p, rec, scanner);
+        }
+
+        if ( scanned and scanned->alerts and scanned->alerts != PS_ALERT_GENERATED and
+            (config->alert_all or merger->claim(rec.scanned_key, scanned->window)) )
+        {
+            ++spstats.merged_alerts;
+            PortscanMergedAlert(p, rec, scanned);
+        }
     }
 }
 
@@ -521,3 +685,66 @@ const BaseApi* nin_port_scan[] =
     nullptr
 };
 
+
+#ifdef UNIT_TEST
+static void make_key(PS_HASH_KEY& key, const char* scanner, const char* scanned)
+{
+    memset(&key, 0, sizeof(key));
+    key.protocol = PS_PROTO_TCP;
+
+    if ( scanner )
+        REQUIRE(key.scanner.set(scanner) == SFIP_SUCCESS);
+
+    if ( scanned )
+        REQUIRE(key.scanned.set(scanned) == SFIP_SUCCESS);
+}
+
+static std::string ip_str(const SfIp* ip)
+{
+    SfIpString s;
+    return ip->ntop(s);
+}
+
+TEST_CASE("merged alert addresses", "[port_scan]")
+{
+    PS_ALERT_RECORD rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.protocol = PS_PROTO_TCP;
+
+    uint8_t buf[ip::IP6_HEADER_LEN];
+    ip::IpApi api;
+
+    SECTION("ip4")
+    {
+        make_key(rec.scanner_key, "10.1.1.1", nullptr);
+        make_key(rec.scanned_key, nullptr, "10.2.2.2");
+        set_merged_ips(api, buf, rec);
+
+        REQUIRE(api.is_ip4());
+        CHECK(ip_str(api.get_src()) == "10.1.1.1");
+        CHECK(ip_str(api.get_dst()) == "10.2.2.2");
+        CHECK(api.proto() == IpProtocol::TCP);
+    }
+    SECTION("ip6")
+    {
+        make_key(rec.scanner_key, "2001:db8::1", nullptr);
+        make_key(rec.scanned_key, nullptr, "2001:db8::2");
+        rec.protocol = PS_PROTO_ICMP;
+        set_merged_ips(api, buf, rec);
+
+        REQUIRE(api.is_ip6());
+        CHECK(ip_str(api.get_src()) == "2001:db8::1");
+        CHECK(ip_str(api.get_dst()) == "2001:db8::2");
+        CHECK(api.proto() == IpProtocol::ICMPV6);
+    }
+    SECTION("unknown scanner")
+    {
+        make_key(rec.scanned_key, nullptr, "10.2.2.2");
+        set_merged_ips(api, buf, rec);
+
+        REQUIRE(api.is_ip4());
+        CHECK(ip_str(api.get_src()) == "0.0.0.0");
+        CHECK(ip_str(api.get_dst()) == "10.2.2.2");
+    }
+}
+#endif
@@ -33,6 +33,9 @@
 
 #include "ps_detect.h"
 
+#include <cmath>
+#include <vector>
+
 #include "hash/hash_defs.h"
 #include "hash/xhash.h"
 #include "log/messages.h"
@@ -45,21 +48,14 @@
 #include "utils/stats.h"
 
 #include "ps_inspect.h"
+#include "ps_merge.h"
 #include "ps_pegs.h"
 
-using namespace snort;
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
 
-PADDING_GUARD_BEGIN
-struct PS_HASH_KEY
-{
-    int protocol;
-    SfIp scanner;
-    int16_t group;
-    SfIp scanned;
-    uint16_t pad;
-    uint32_t asid;
-};
-PADDING_GUARD_END
+using namespace snort;
 
 class PortScanCache : public XHash
 {
@@ -89,6 +85,221 @@ public:
 static THREAD_LOCAL PortScanCache* portscan_hash = nullptr;
 extern THREAD_LOCAL PsPegStats spstats;
 
+//-------------------------------------------------------------------------
+// sketch mode
+//-------------------------------------------------------------------------
+
+// A fixed size, direct mapped table of trackers replaces the hash.  A new
+// key takes over the slot of an old one; if the old tracker changed since
+// the last merge its record is queued first so nothing is lost.  The global
+// view, not this table, decides whether to alert.
+struct PS_SKETCH_NODE
+{
+    PS_HASH_KEY key;
+    PS_TRACKER tracker;
+    PS_DISTINCT distinct;
+    bool used;
+    bool dirty;
+};
+
+class PortScanSketch
+{
+public:
+    PortScanSketch(unsigned rows, unsigned merge_interval);
+    ~PortScanSketch();
+
+    PS_TRACKER* get(const PS_HASH_KEY*);
+    void publish(PortScanMerger*, time_t now, bool force);
+
+    unsigned get_rows() const
+    { return mask + 1; }
+
+private:
+    void add_record(PS_SKETCH_NODE&);
+
+    PS_SKETCH_NODE* nodes;
+    unsigned mask;
+    unsigned merge_interval;
+    time_t next_merge = 0;
+
+    std::vector<unsigned> dirty;
+    std::vector<PS_RECORD> records;
+};
+
+static THREAD_LOCAL PortScanSketch* portscan_sketch = nullptr;
+
+static inline uint64_t ps_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+static uint64_t ps_hash_key(const PS_HASH_KEY* key)
+{
+    const uint64_t* w = (const uint64_t*)key;
+    uint64_t h = 0;
+
+    for ( unsigned i = 0; i < sizeof(*key) / sizeof(*w); i++ )
+        h = ps_mix(h ^ w[i]);
+
+    return h;
+}
+
+static inline uint64_t ps_hash_ip(const SfIp* ip)
+{
+    const uint64_t* w = (const uint64_t*)ip->get_ip6_ptr();
+    return ps_mix(w[0] ^ ps_mix(w[1]));
+}
+
+// the leading bits of the hash pick a register which keeps the longest
+// run of leading zeros seen in the rest
+void ps_distinct_add(uint8_t* regs, uint64_t hash)
+{
+    unsigned idx = hash >> (64 - PS_HLL_BITS);
+    uint64_t w = hash << PS_HLL_BITS;
+    uint8_t rank = w ? __builtin_clzll(w) + 1 : 64 - PS_HLL_BITS + 1;
+
+    if ( rank > regs[idx] )
+        regs[idx] = rank;
+}
+
+// linear counting covers the small counts that matter for scan thresholds
+unsigned ps_distinct_count(const uint8_t* regs)
+{
+    const double m = PS_HLL_REGS;
+    double sum = 0;
+    unsigned zeros = 0;
+
+    for ( unsigned i = 0; i < PS_HLL_REGS; i++ )
+    {
+        sum += ldexp(1.0, -regs[i]);
+
+        if ( !regs[i] )
+            zeros++;
+    }
+
+    double est = 0.709 * m * m / sum;
+
+    if ( est <= 2.5 * m and zeros )
+        est = m * log(m / zeros);
+
+    return (unsigned)(est + 0.5);
+}
+
+PortScanSketch::PortScanSketch(unsigned rows, unsigned interval)
+{
+    mask = rows - 1;
+    merge_interval = interval;
+    nodes = new PS_SKETCH_NODE[rows];
+    memset(nodes, 0, rows * sizeof(*nodes));
+}
+
+PortScanSketch::~PortScanSketch()
+{
+    delete[] nodes;
+}
+
+void PortScanSketch::add_record(PS_SKETCH_NODE& node)
+{
+    records.emplace_back();
+    PS_RECORD& rec = records.back();
+
+    rec.key = node.key;
+    rec.proto = node.tracker.proto;
+    rec.distinct = node.distinct;
+
+    node.distinct.connection_delta = 0;
+    node.distinct.priority_delta = 0;
+}
+
+PS_TRACKER* PortScanSketch::get(const PS_HASH_KEY* key)
+{
+    unsigned idx = ps_hash_key(key) & mask;
+    PS_SKETCH_NODE& node = nodes[idx];
+
+    if ( !node.used or memcmp(&node.key, key, sizeof(*key)) )
+    {
+        if ( node.used )
+        {
+            ++spstats.alloc_prunes;
+
+            if ( node.dirty )
+                add_record(node);
+        }
+        memset(&node.tracker, 0, sizeof(node.tracker));
+        memset(&node.distinct, 0, sizeof(node.distinct));
+        node.key = *key;
+        node.tracker.distinct = &node.distinct;
+        node.used = true;
+        ++spstats.trackers;
+    }
+
+    if ( !node.dirty )
+    {
+        node.dirty = true;
+        dirty.emplace_back(idx);
+    }
+    return &node.tracker;
+}
+
+void PortScanSketch::publish(PortScanMerger* merger, time_t now, bool force)
+{
+    if ( now < next_merge and !force )
+        return;
+
+    next_merge = now + merge_interval;
+
+    for ( auto idx : dirty )
+    {
+        add_record(nodes[idx]);
+        nodes[idx].dirty = false;
+    }
+    dirty.clear();
+
+    if ( records.empty() )
+        return;
+
+    for ( auto& rec : records )
+        rec.pkt_time = now;
+
+    spstats.sketch_records += records.size();
+    merger->publish(records);
+    records.clear();
+}
+
+unsigned ps_sketch_node_size()
+{ return sizeof(PS_SKETCH_NODE); }
+
+void ps_init_sketch(unsigned long memcap, unsigned merge_interval)
+{
+    unsigned rows = 16;
+
+    while ( (unsigned long)rows * 2 * ps_sketch_node_size() <= memcap )
+        rows *= 2;
+
+    if ( portscan_sketch and portscan_sketch->get_rows() == rows )
+        return;
+
+    if ( portscan_hash )
+    {
+        delete portscan_hash;
+        portscan_hash = nullptr;
+    }
+
+    delete portscan_sketch;
+    portscan_sketch = new PortScanSketch(rows, merge_interval);
+}
+
+void ps_publish_sketch(PortScanMerger* merger, time_t now, bool force)
+{
+    if ( portscan_sketch )
+        portscan_sketch->publish(merger, now, force);
+}
+
 PS_PKT::PS_PKT(Packet* p)
 {
     pkt = p;
@@ -120,6 +331,12 @@ void ps_cleanup()
         delete portscan_hash;
         portscan_hash = nullptr;
     }
+
+    if ( portscan_sketch )
+    {
+        delete portscan_sketch;
+        portscan_sketch = nullptr;
+    }
 }
 
 unsigned ps_node_size()
@@ -127,6 +344,12 @@ unsigned ps_node_size()
 
 bool ps_init_hash(unsigned long memcap)
 {
+    if ( portscan_sketch )
+    {
+        delete portscan_sketch;
+        portscan_sketch = nullptr;
+    }
+
     if ( portscan_hash )
     {
         bool need_pruning = (memcap < portscan_hash->get_mem_used());
@@ -304,6 +527,9 @@ bool PortScan::ps_filter_ignore(PS_PKT* ps_pkt)
 */
 static PS_TRACKER* ps_tracker_get(PS_HASH_KEY* key)
 {
+    if ( portscan_sketch )
+        return portscan_sketch->get(key);
+
     PS_TRACKER* ht = (PS_TRACKER*)portscan_hash->get_user_data((void*)key);
 
     if ( ht )
@@ -362,6 +588,8 @@ bool PortScan::ps_tracker_lookup(
         *scanned = ps_tracker_get(&key);
     }
 
+    PS_HASH_KEY scanned_key = key;
+
     //  Let's lookup the host that is scanning.
     if (config->detect_scan_type &
         (PS_TYPE_PORTSWEEP | PS_TYPE_PORTSCAN | PS_TYPE_DECOYSCAN | PS_TYPE_DISTPORTSCAN))
@@ -382,6 +610,12 @@ bool PortScan::ps_tracker_lookup(
         *scanner = ps_tracker_get(&key);
     }
 
+    if ( *scanner and *scanned and (*scanner)->distinct )
+    {
+        (*scanned)->distinct->peer = key;
+        (*scanner)->distinct->peer = scanned_key;
+    }
+
     return *scanner or *scanned;
 }
 
@@ -461,20 +695,23 @@ void PortScan::ps_proto_update_window(unsigned interval, PS_PROTO* proto, time_t
 }
 
 /*
-**  This function updates the PS_PROTO structure.
+**  This function updates the PS_PROTO structure of a tracker.
 **
-**  @param PS_PROTO pointer to structure to update
+**  @param PS_TRACKER pointer to tracker to update
 **  @param int      number to increment portscan counter
 **  @param u_long   IP address of other host
 **  @param unsigned short  port/ip_proto to track
 **  @param time_t   time the packet was received. update windows.
 */
-int PortScan::ps_proto_update(PS_PROTO* proto, int ps_cnt, int pri_cnt,
+int PortScan::ps_proto_update(PS_TRACKER* tracker, int ps_cnt, int pri_cnt,
     unsigned window, const SfIp* ip, unsigned short port, time_t pkt_time)
 {
-    if (!proto)
+    if (!tracker)
         return 0;
 
+    PS_PROTO* proto = &tracker->proto;
+    PS_DISTINCT* distinct = tracker->distinct;
+
     /*
     **  If the ps_cnt is negative, that means we are just taking off
     **  for valid connection, and we don't want to do anything else,
@@ -486,6 +723,9 @@ int PortScan::ps_proto_update(PS_PROTO* proto, int ps_cnt, int pri_cnt,
         if (proto->connection_count < 0)
             proto->connection_count = 0;
 
+        if (distinct)
+            distinct->connection_delta += ps_cnt;
+
         return 0;
     }
 
@@ -501,6 +741,9 @@ int PortScan::ps_proto_update(PS_PROTO* proto, int ps_cnt, int pri_cnt,
         if (proto->priority_count < 0)
             proto->priority_count = 0;
 
+        if (distinct)
+            distinct->priority_delta += pri_cnt;
+
         return 0;
     }
 
@@ -508,8 +751,20 @@ int PortScan::ps_proto_update(PS_PROTO* proto, int ps_cnt, int pri_cnt,
     **  Do time check first before we update the counters, so if
     **  we need to reset them we do it before we update them.
     */
+    if (distinct and pkt_time > proto->window)
+    {
+        memset(distinct->ips, 0, sizeof(distinct->ips));
+        memset(distinct->ports, 0, sizeof(distinct->ports));
+    }
     ps_proto_update_window(window, proto, pkt_time);
 
+    if (distinct)
+    {
+        distinct->connection_delta += ps_cnt;
+        ps_distinct_add(distinct->ips, ps_hash_ip(ip));
+        ps_distinct_add(distinct->ports, ps_mix(port + 1));
+    }
+
     //  Update ps counter
     proto->connection_count += ps_cnt;
     if (proto->connection_count < 0)
@@ -639,13 +894,13 @@ void PortScan::ps_tracker_update_tcp(PS_PKT* ps_pkt, PS_TRACKER* scanner,
         {
             if (scanned)
             {
-                ps_proto_update(&scanned->proto, 1, 0, win,
+                ps_proto_update(scanned, 1, 0, win,
                     p->ptrs.ip_api.get_src(), p->ptrs.dp, packet_time());
             }
 
             if (scanner)
             {
-                ps_proto_update(&scanner->proto, 1, 0, win,
+                ps_proto_update(scanner, 1, 0, win,
                     p->ptrs.ip_api.get_dst(), p->ptrs.dp, packet_time());
             }
         }
@@ -654,12 +909,12 @@ void PortScan::ps_tracker_update_tcp(PS_PKT* ps_pkt, PS_TRACKER* scanner,
         {
             if (scanned)
             {
-                ps_proto_update(&scanned->proto, -1, 0, win, &cleared, 0, 0);
+                ps_proto_update(scanned, -1, 0, win, &cleared, 0, 0);
             }
 
             if (scanner)
             {
-                ps_proto_update(&scanner->proto, -1, 0, win, &cleared, 0, 0);
+                ps_proto_update(scanner, -1, 0, win, &cleared, 0, 0);
             }
         }
         //  RST packet on unestablished streams
@@ -670,13 +925,13 @@ void PortScan::ps_tracker_update_tcp(PS_PKT* ps_pkt, PS_TRACKER* scanner,
         {
             if (scanned)
             {
-                ps_proto_update(&scanned->proto, 0, 1, win, &cleared, 0, 0);
+                ps_proto_update(scanned, 0, 1, win, &cleared, 0, 0);
                 scanned->priority_node = 1;
             }
 
             if (scanner)
             {
-                ps_proto_update(&scanner->proto, 0, 1, win, &cleared, 0, 0);
+                ps_proto_update(scanner, 0, 1, win, &cleared, 0, 0);
                 scanner->priority_node = 1;
             }
         }
@@ -705,13 +960,13 @@ void PortScan::ps_tracker_update_tcp(PS_PKT* ps_pkt, PS_TRACKER* scanner,
         */
         if (scanned)
         {
-            ps_proto_update(&scanned->proto, 1, 0, win,
+            ps_proto_update(scanned, 1, 0, win,
                 p->ptrs.ip_api.get_src(), p->ptrs.dp, packet_time());
         }
 
         if (scanner)
         {
-            ps_proto_update(&scanner->proto, 1, 0, win,
+            ps_proto_update(scanner, 1, 0, win,
                 p->ptrs.ip_api.get_dst(), p->ptrs.dp, packet_time());
         }
     }
@@ -724,12 +979,12 @@ void PortScan::ps_tracker_update_tcp(PS_PKT* ps_pkt, PS_TRACKER* scanner,
     {
         if (scanned)
         {
-            ps_proto_update(&scanned->proto, -1, 0, win, &cleared, 0, 0);
+            ps_proto_update(scanned, -1, 0, win, &cleared, 0, 0);
         }
 
         if (scanner)
         {
-            ps_proto_update(&scanner->proto, -1, 0, win, &cleared, 0, 0);
+            ps_proto_update(scanner, -1, 0, win, &cleared, 0, 0);
         }
     }
     /*
@@ -740,13 +995,13 @@ void PortScan::ps_tracker_update_tcp(PS_PKT* ps_pkt, PS_TRACKER* scanner,
     {
         if (scanned)
         {
-            ps_proto_update(&scanned->proto, 0, 1, win, &cleared, 0, 0);
+            ps_proto_update(scanned, 0, 1, win, &cleared, 0, 0);
             scanned->priority_node = 1;
         }
 
         if (scanner)
         {
-            ps_proto_update(&scanner->proto, 0, 1, win, &cleared, 0, 0);
+            ps_proto_update(scanner, 0, 1, win, &cleared, 0, 0);
             scanner->priority_node = 1;
         }
     }
@@ -755,13 +1010,13 @@ void PortScan::ps_tracker_update_tcp(PS_PKT* ps_pkt, PS_TRACKER* scanner,
     {
         if (scanned)
         {
-            ps_proto_update(&scanned->proto, 0, 1, win, &cleared, 0, 0);
+            ps_proto_update(scanned, 0, 1, win, &cleared, 0, 0);
             scanned->priority_node = 1;
         }
 
         if (scanner)
         {
-            ps_proto_update(&scanner->proto, 0, 1, win, &cleared, 0, 0);
+            ps_proto_update(scanner, 0, 1, win, &cleared, 0, 0);
             scanner->priority_node = 1;
         }
     }
@@ -785,12 +1040,12 @@ void PortScan::ps_tracker_update_ip(PS_PKT* ps_pkt, PS_TRACKER* scanner,
         {
             if (scanned)
             {
-                ps_proto_update(&scanned->proto, 0, 1, win, &cleared, 0, 0);
+                ps_proto_update(scanned, 0, 1, win, &cleared, 0, 0);
                 scanned->priority_node = 1;
             }
             if(scanner)
             {
-                ps_proto_update(&scanner->proto, 0, 1, win, &cleared, 0, 0);
+                ps_proto_update(scanner, 0, 1, win, &cleared, 0, 0);
                 scanner->priority_node = 1;
             }
         }
@@ -801,12 +1056,12 @@ void PortScan::ps_tracker_update_ip(PS_PKT* ps_pkt, PS_TRACKER* scanner,
     {
         if (scanned)
         {
-            ps_proto_update(&scanned->proto, 1, 0, win, p->ptrs.ip_api.get_src(),
+            ps_proto_update(scanned, 1, 0, win, p->ptrs.ip_api.get_src(),
                 (unsigned short)p->get_ip_proto_next(), packet_time());
         }
         if (scanner)
         {
-            ps_proto_update(&scanner->proto, 1, 0, win, p->ptrs.ip_api.get_dst(),
+            ps_proto_update(scanner, 1, 0, win, p->ptrs.ip_api.get_dst(),
                 (unsigned short)p->get_ip_proto_next(), packet_time());
         }
     }
@@ -825,13 +1080,13 @@ void PortScan::ps_tracker_update_udp(
     {
         if (scanned)
         {
-            ps_proto_update(&scanned->proto, 0, 1, win, &cleared, 0, 0);
+            ps_proto_update(scanned, 0, 1, win, &cleared, 0, 0);
             scanned->priority_node = 1;
         }
 
         if (scanner)
         {
-            ps_proto_update(&scanner->proto, 0, 1, win, &cleared, 0, 0);
+            ps_proto_update(scanner, 0, 1, win, &cleared, 0, 0);
             scanner->priority_node = 1;
         }
     }
@@ -845,23 +1100,23 @@ void PortScan::ps_tracker_update_udp(
             {
                 if (scanned)
                 {
-                    ps_proto_update(&scanned->proto, 1, 0, win,
+                    ps_proto_update(scanned, 1, 0, win,
                         p->ptrs.ip_api.get_src(), p->ptrs.dp, packet_time());
                 }
 
                 if (scanner)
                 {
-                    ps_proto_update(&scanner->proto, 1, 0, win,
+                    ps_proto_update(scanner, 1, 0, win,
                         p->ptrs.ip_api.get_dst(), p->ptrs.dp, packet_time());
                 }
             }
             else if (direction == PKT_FROM_SERVER)
             {
                 if (scanned)
-                    ps_proto_update(&scanned->proto, -1, 0, win, &cleared, 0, 0);
+                    ps_proto_update(scanned, -1, 0, win, &cleared, 0, 0);
 
                 if (scanner)
-                    ps_proto_update(&scanner->proto, -1, 0, win, &cleared, 0, 0);
+                    ps_proto_update(scanner, -1, 0, win, &cleared, 0, 0);
             }
         }
     }
@@ -883,7 +1138,7 @@ void PortScan::ps_tracker_update_icmp(
         case ICMP_INFO_REQUEST:
             if (scanner)
             {
-                ps_proto_update(&scanner->proto, 1, 0, win,
+                ps_proto_update(scanner, 1, 0, win,
                     p->ptrs.ip_api.get_dst(), 0, packet_time());
             }
             break;
@@ -894,7 +1149,7 @@ void PortScan::ps_tracker_update_icmp(
                 SfIp cleared;
                 cleared.clear();
 
-                ps_proto_update(&scanner->proto, 0, 1, win, &cleared, 0, 0);
+                ps_proto_update(scanner, 0, 1, win, &cleared, 0, 0);
                 scanner->priority_node = 1;
             }
             break;
@@ -1200,24 +1455,24 @@ void PortScan::ps_alert_icmp(PS_PROTO* scanner, PS_PROTO* scanned)
 bool PortScan::ps_tracker_alert(
     PS_PKT* ps_pkt, PS_TRACKER* scanner, PS_TRACKER* scanned)
 {
-    PS_PROTO* scanner_proto = nullptr;
-    PS_PROTO* scanned_proto = nullptr;
+    return ps_alert(ps_pkt->proto, scanner ? &scanner->proto : nullptr,
+        scanned ? &scanned->proto : nullptr);
+}
 
-    if ( scanner )
+// also called on candidates from the global view so this must only depend
+// on the config and the given protos
+bool PortScan::ps_alert(int proto, PS_PROTO* scanner_proto, PS_PROTO* scanned_proto)
+{
+    if ( config->alert_all )
     {
-        if ( config->alert_all )
-            scanner->proto.alerts = 0;
-        scanner_proto = &scanner->proto;
-    }
+        if ( scanner_proto )
+            scanner_proto->alerts = 0;
 
-    if ( scanned )
-    {
-        if ( config->alert_all )
-            scanned->proto.alerts = 0;
-        scanned_proto = &scanned->proto;
+        if ( scanned_proto )
+            scanned_proto->alerts = 0;
     }
 
-    switch (ps_pkt->proto)
+    switch (proto)
     {
     case PS_PROTO_TCP:
         ps_alert_tcp(scanner_proto, scanned_proto);
@@ -1282,7 +1537,8 @@ int PortScan::ps_detect(PS_PKT* ps_pkt)
         if ( !ps_tracker_update(ps_pkt, scanner, scanned) )
             return 0;
 
-        if ( !ps_tracker_alert(ps_pkt, scanner, scanned) )
+        // in sketch mode alerts come from the global view
+        if ( !config->sketch and !ps_tracker_alert(ps_pkt, scanner, scanned) )
             return 0;
 
         /* This is added to address the case of no
@@ -1307,3 +1563,81 @@ int PortScan::ps_detect(PS_PKT* ps_pkt)
     return 1;
 }
 
+#ifdef UNIT_TEST
+// the standard error with 64 registers is 1.04 / 8 = 13%
+TEST_CASE("distinct count estimate", "[port_scan]")
+{
+    const unsigned sizes[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 5000 };
+    const unsigned trials = 50;
+
+    for ( auto n : sizes )
+    {
+        double sum_sq = 0;
+
+        for ( unsigned t = 0; t < trials; t++ )
+        {
+            uint8_t regs[PS_HLL_REGS] = { };
+
+            for ( unsigned i = 0; i < n; i++ )
+                ps_distinct_add(regs, ps_mix(((uint64_t)t << 32) + i + 1));
+
+            double err = ((double)ps_distinct_count(regs) - n) / n;
+            CHECK(fabs(err) <= 0.6);
+            sum_sq += err * err;
+        }
+        CHECK(sqrt(sum_sq / trials) <= 0.2);
+    }
+}
+
+TEST_CASE("distinct count small and repeated", "[port_scan]")
+{
+    uint8_t regs[PS_HLL_REGS] = { };
+    CHECK(ps_distinct_count(regs) == 0);
+
+    ps_distinct_add(regs, ps_mix(80));
+    CHECK(ps_distinct_count(regs) == 1);
+
+    // repeats don't change the registers
+    uint8_t copy[PS_HLL_REGS];
+    memcpy(copy, regs, sizeof(regs));
+
+    for ( unsigned i = 0; i < 100; i++ )
+        ps_distinct_add(regs, ps_mix(80));
+
+    CHECK(!memcmp(copy, regs, sizeof(regs)));
+
+    // addresses are hashed the same way as by the trackers
+    uint8_t ips[PS_HLL_REGS] = { };
+    SfIp ip;
+
+    for ( unsigned i = 0; i < 30; i++ )
+    {
+        uint32_t addr = htonl(0x0a000001 + i);
+        REQUIRE(ip.set(&addr, AF_INET) == SFIP_SUCCESS);
+        ps_distinct_add(ips, ps_hash_ip(&ip));
+        ps_distinct_add(ips, ps_hash_ip(&ip));
+    }
+    CHECK(ps_distinct_count(ips) >= 24);
+    CHECK(ps_distinct_count(ips) <= 36);
+}
+
+// merging by register maximum gives the registers of the union
+TEST_CASE("distinct count merge", "[port_scan]")
+{
+    uint8_t a[PS_HLL_REGS] = { };
+    uint8_t b[PS_HLL_REGS] = { };
+    uint8_t u[PS_HLL_REGS] = { };
+
+    for ( unsigned i = 0; i < 300; i++ )
+    {
+        uint64_t h = ps_mix(i + 1);
+        ps_distinct_add((i % 3) ? a : b, h);
+        ps_distinct_add(u, h);
+    }
+
+    for ( unsigned i = 0; i < PS_HLL_REGS; i++ )
+        a[i] = std::max(a[i], b[i]);
+
+    CHECK(!memcmp(a, u, sizeof(u)));
+}
+#endif
@@ -25,6 +25,7 @@
 #include <ctime>
 
 #include "sfip/sf_ip.h"
+#include "utils/cpp_macros.h"
 #include "ipobj.h"
 
 namespace snort
@@ -86,6 +87,9 @@ struct PortscanConfig
 
     bool alert_all;
     bool logfile;
+    bool sketch;
+
+    unsigned merge_interval;
 
     unsigned tcp_window;
     unsigned udp_window;
@@ -140,11 +144,50 @@ struct PS_PROTO
     time_t window;
 };
 
+PADDING_GUARD_BEGIN
+struct PS_HASH_KEY
+{
+    int protocol;
+    snort::SfIp scanner;
+    int16_t group;
+    snort::SfIp scanned;
+    uint16_t pad;
+    uint32_t asid;
+};
+PADDING_GUARD_END
+
+// In sketch mode each tracker also estimates the distinct addresses and
+// ports of its connection attempts with a small HyperLogLog and counts the
+// changes since it was last merged into the global view.
+#define PS_HLL_BITS 6
+#define PS_HLL_REGS (1 << PS_HLL_BITS)
+
+struct PS_DISTINCT
+{
+    uint8_t ips[PS_HLL_REGS];
+    uint8_t ports[PS_HLL_REGS];
+
+    PS_HASH_KEY peer;       // tracker of the other end of the last attempt
+
+    int connection_delta;
+    int priority_delta;
+};
+
 struct PS_TRACKER
 {
     int priority_node;
     int protocol;
     PS_PROTO proto;
+    PS_DISTINCT* distinct;  // sketch mode only
+};
+
+// what a packet thread hands to the global view for one tracker
+struct PS_RECORD
+{
+    PS_HASH_KEY key;
+    PS_PROTO proto;
+    PS_DISTINCT distinct;
+    time_t pkt_time;
 };
 
 struct PS_PKT
@@ -169,5 +212,14 @@ bool ps_init_hash(unsigned long);
 bool ps_prune_hash(unsigned);
 int ps_detect(PS_PKT*);
 
+class PortScanMerger;
+
+unsigned ps_sketch_node_size();
+void ps_init_sketch(unsigned long memcap, unsigned merge_interval);
+void ps_publish_sketch(PortScanMerger*, time_t now, bool force = false);
+
+void ps_distinct_add(uint8_t* regs, uint64_t hash);
+unsigned ps_distinct_count(const uint8_t* regs);
+
 #endif
 
@@ -45,9 +45,12 @@ public:
     void show(const snort::SnortConfig*) const override;
     void eval(snort::Packet*) override;
 
+    bool configure(snort::SnortConfig*) override;
     void tinit() override;
     void tterm() override;
 
+    bool ps_alert(int proto, PS_PROTO* scanner, PS_PROTO* scanned);
+
 private:
     void ps_parse(snort::SnortConfig*, char*);
 
@@ -57,6 +60,7 @@ private:
     bool ps_filter_ignore(PS_PKT*);
     int ps_get_proto(PS_PKT*, int* proto);
     int ps_detect(PS_PKT*);
+    void ps_merged_alerts(snort::Packet*);
 
     bool ps_tracker_lookup(PS_PKT*, PS_TRACKER** scanner, PS_TRACKER** scanned);
     bool ps_tracker_update(PS_PKT*, PS_TRACKER* scanner, PS_TRACKER* scanned);
@@ -64,7 +68,7 @@ private:
 
     void ps_proto_update_window(unsigned window, PS_PROTO*, time_t pkt_time);
 
-    int ps_proto_update( PS_PROTO*, int ps_cnt, int pri_cnt, unsigned window, const snort::SfIp* ip,
+    int ps_proto_update(PS_TRACKER*, int ps_cnt, int pri_cnt, unsigned window, const snort::SfIp* ip,
         unsigned short port, time_t pkt_time);
 
     void ps_tracker_update_ip(PS_PKT*, PS_TRACKER* scanner, PS_TRACKER* scanned);
@@ -79,6 +83,7 @@ private:
 
 private:
     PortscanConfig* config;
+    PortScanMerger* merger = nullptr;
 };
 
 #endif
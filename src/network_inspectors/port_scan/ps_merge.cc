@@ -0,0 +1,537 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ps_merge.h"
+
+#include <cstring>
+
+#ifdef UNIT_TEST
+#include <chrono>
+
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+// bound the candidates waiting for a packet; further candidates are dropped
+// until the trackers change again
+#define PS_MAX_CANDIDATES 4096
+
+size_t PortScanMerger::KeyHash::operator()(const PS_HASH_KEY& key) const
+{
+    const uint64_t* w = (const uint64_t*)&key;
+    uint64_t h = 0;
+
+    for ( unsigned i = 0; i < sizeof(key) / sizeof(*w); i++ )
+        h = (h ^ w[i]) * 0x9E3779B97F4A7C15ull;
+
+    return h ^ (h >> 32);
+}
+
+bool PortScanMerger::KeyEqual::operator()(const PS_HASH_KEY& a, const PS_HASH_KEY& b) const
+{ return !memcmp(&a, &b, sizeof(a)); }
+
+PortScanMerger::PortScanMerger(const PortscanConfig* pc) : config(pc)
+{
+    max_nodes = config->memcap / (sizeof(PS_HASH_KEY) + sizeof(Node) + 4 * sizeof(void*));
+    thread = new std::thread(&PortScanMerger::worker, this);
+}
+
+PortScanMerger::~PortScanMerger()
+{
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        running = false;
+    }
+    cv.notify_one();
+
+    thread->join();
+    delete thread;
+}
+
+void PortScanMerger::publish(std::vector<PS_RECORD>& records)
+{
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        pending.emplace_back(std::move(records));
+    }
+    cv.notify_one();
+}
+
+bool PortScanMerger::get_candidate(PS_ALERT_RECORD& rec)
+{
+    if ( !num_candidates.load(std::memory_order_relaxed) )
+        return false;
+
+    std::lock_guard<std::mutex> lk(mutex);
+
+    if ( candidates.empty() )
+        return false;
+
+    rec = candidates.front();
+    candidates.pop_front();
+    num_candidates = candidates.size();
+
+    auto it = rec.has_scanner ? claimed.find(rec.scanner_key) : claimed.end();
+
+    if ( it != claimed.end() and it->second == rec.scanner.window )
+        rec.scanner.alerts = PS_ALERT_GENERATED;
+
+    it = rec.has_scanned ? claimed.find(rec.scanned_key) : claimed.end();
+
+    if ( it != claimed.end() and it->second == rec.scanned.window )
+        rec.scanned.alerts = PS_ALERT_GENERATED;
+
+    return true;
+}
+
+bool PortScanMerger::claim(const PS_HASH_KEY& key, time_t window)
+{
+    std::lock_guard<std::mutex> lk(mutex);
+    auto it = claimed.find(key);
+
+    if ( it == claimed.end() )
+    {
+        claimed.emplace(key, window);
+        return true;
+    }
+    if ( it->second == window )
+        return false;
+
+    it->second = window;
+    return true;
+}
+
+unsigned PortScanMerger::get_window(int protocol) const
+{
+    switch ( protocol )
+    {
+    case PS_PROTO_TCP:
+        return config->tcp_window;
+    case PS_PROTO_UDP:
+        return config->udp_window;
+    case PS_PROTO_ICMP:
+        return config->icmp_window;
+    default:
+        return config->ip_window;
+    }
+}
+
+PortScanMerger::Node* PortScanMerger::merge(const PS_RECORD& rec)
+{
+    auto it = nodes.find(rec.key);
+
+    if ( it == nodes.end() )
+    {
+        if ( nodes.size() >= max_nodes )
+        {
+            for ( auto del = nodes.begin(); del != nodes.end(); )
+            {
+                if ( del->second.proto.window < rec.pkt_time )
+                    del = nodes.erase(del);
+                else
+                    ++del;
+            }
+            if ( nodes.size() >= max_nodes )
+                return nullptr;
+        }
+        it = nodes.emplace(rec.key, Node()).first;
+        memset(&it->second, 0, sizeof(it->second));
+    }
+
+    merge(it->second, rec, get_window(rec.key.protocol));
+    return &it->second;
+}
+
+void PortScanMerger::merge(Node& node, const PS_RECORD& rec, unsigned window)
+{
+    PS_PROTO& proto = node.proto;
+    const PS_PROTO& add = rec.proto;
+
+    // the same window check as ps_proto_update_window
+    if ( rec.pkt_time > proto.window )
+    {
+        memset(&node, 0, sizeof(node));
+        proto.window = rec.pkt_time + window;
+    }
+
+    proto.connection_count += rec.distinct.connection_delta;
+    if ( proto.connection_count < 0 )
+        proto.connection_count = 0;
+
+    proto.priority_count += rec.distinct.priority_delta;
+    if ( proto.priority_count < 0 )
+        proto.priority_count = 0;
+
+    for ( unsigned i = 0; i < PS_HLL_REGS; i++ )
+    {
+        if ( rec.distinct.ips[i] > node.ips[i] )
+            node.ips[i] = rec.distinct.ips[i];
+
+        if ( rec.distinct.ports[i] > node.ports[i] )
+            node.ports[i] = rec.distinct.ports[i];
+    }
+    proto.u_ip_count = ps_distinct_count(node.ips);
+    proto.u_port_count = ps_distinct_count(node.ports);
+
+    if ( add.low_ip.is_set() and (!proto.low_ip.is_set() or proto.low_ip.greater_than(add.low_ip)) )
+        proto.low_ip = add.low_ip;
+
+    if ( add.high_ip.is_set() and (!proto.high_ip.is_set() or proto.high_ip.less_than(add.high_ip)) )
+        proto.high_ip = add.high_ip;
+
+    if ( add.low_p and (!proto.low_p or proto.low_p > add.low_p) )
+        proto.low_p = add.low_p;
+
+    if ( add.high_p > proto.high_p )
+        proto.high_p = add.high_p;
+
+    if ( add.u_ips.is_set() )
+    {
+        proto.u_ips = add.u_ips;
+        proto.u_ports = add.u_ports;
+    }
+
+    for ( unsigned i = 0; i < add.open_ports_cnt; i++ )
+    {
+        unsigned j = 0;
+
+        while ( j < proto.open_ports_cnt and proto.open_ports[j] != add.open_ports[i] )
+            j++;
+
+        if ( j == proto.open_ports_cnt and j < PS_OPEN_PORTS - 1 )
+            proto.open_ports[proto.open_ports_cnt++] = add.open_ports[i];
+    }
+
+    if ( rec.distinct.peer.protocol )
+        node.peer = rec.distinct.peer;
+}
+
+// pair the tracker with its peer from the last attempt as ps_detect()
+// pairs the scanner and scanned trackers of a packet
+bool PortScanMerger::get_candidate(const PS_HASH_KEY& key, PS_ALERT_RECORD& rec)
+{
+    auto it = nodes.find(key);
+
+    if ( it == nodes.end() )
+        return false;
+
+    const Node& node = it->second;
+    const Node* peer = nullptr;
+
+    if ( node.peer.protocol )
+    {
+        auto pit = nodes.find(node.peer);
+
+        if ( pit != nodes.end() )
+            peer = &pit->second;
+    }
+
+    memset(&rec, 0, sizeof(rec));
+    rec.protocol = key.protocol;
+
+    const Node* scanner;
+    const Node* scanned;
+
+    if ( key.scanned.is_set() )
+    {
+        rec.scanned_key = key;
+        rec.scanner_key = node.peer;
+        scanner = peer;
+        scanned = &node;
+    }
+    else
+    {
+        rec.scanner_key = key;
+        rec.scanned_key = node.peer;
+        scanner = &node;
+        scanned = peer;
+    }
+
+    if ( scanner )
+    {
+        rec.scanner = scanner->proto;
+        rec.scanner.alerts = 0;
+        rec.has_scanner = true;
+    }
+    if ( scanned )
+    {
+        rec.scanned = scanned->proto;
+        rec.scanned.alerts = 0;
+        rec.has_scanned = true;
+    }
+    return true;
+}
+
+void PortScanMerger::worker()
+{
+    std::unique_lock<std::mutex> lk(mutex);
+
+    while ( true )
+    {
+        cv.wait(lk, [this] { return !running or !pending.empty(); });
+
+        if ( pending.empty() )
+            break;
+
+        std::vector<std::vector<PS_RECORD>> batch;
+        batch.swap(pending);
+        lk.unlock();
+
+        std::unordered_set<PS_HASH_KEY, KeyHash, KeyEqual> touched;
+
+        for ( const auto& records : batch )
+        {
+            for ( const auto& rec : records )
+            {
+                if ( merge(rec) )
+                    touched.emplace(rec.key);
+            }
+        }
+
+        // trackers may have been pruned by a later merge
+        std::vector<PS_ALERT_RECORD> found;
+        PS_ALERT_RECORD cand;
+
+        for ( const auto& key : touched )
+        {
+            if ( get_candidate(key, cand) )
+                found.emplace_back(cand);
+        }
+
+        lk.lock();
+
+        for ( const auto& rec : found )
+        {
+            if ( candidates.size() < PS_MAX_CANDIDATES )
+                candidates.emplace_back(rec);
+        }
+        num_candidates = candidates.size();
+
+        // claims only matter while their tracker is in the same window
+        if ( claimed.size() > max_nodes )
+        {
+            for ( auto it = claimed.begin(); it != claimed.end(); )
+            {
+                auto n = nodes.find(it->first);
+
+                if ( n == nodes.end() or n->second.proto.window != it->second )
+                    it = claimed.erase(it);
+                else
+                    ++it;
+            }
+        }
+    }
+}
+
+#ifdef UNIT_TEST
+static uint64_t test_hash(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    return h ^ (h >> 33);
+}
+
+static void make_record(PS_RECORD& rec, unsigned first, unsigned num, time_t now)
+{
+    memset(&rec, 0, sizeof(rec));
+    rec.key.protocol = PS_PROTO_TCP;
+    rec.pkt_time = now;
+
+    for ( unsigned i = first; i < first + num; i++ )
+    {
+        ps_distinct_add(rec.distinct.ips, test_hash(i + 1));
+        ps_distinct_add(rec.distinct.ports, test_hash(i + 0x10000));
+    }
+
+    uint32_t low = htonl(0x0a000000 + first);
+    uint32_t high = htonl(0x0a000000 + first + num - 1);
+    rec.proto.low_ip.set(&low, AF_INET);
+    rec.proto.high_ip.set(&high, AF_INET);
+    rec.proto.low_p = 1000 + first;
+    rec.proto.high_p = 1000 + first + num - 1;
+
+    rec.proto.open_ports[0] = 22;
+    rec.proto.open_ports[1] = 1000 + first;
+    rec.proto.open_ports_cnt = 2;
+
+    rec.distinct.connection_delta = num;
+}
+
+static bool same_view(const PortScanMerger::Node& a, const PortScanMerger::Node& b)
+{
+    return !memcmp(a.ips, b.ips, sizeof(a.ips)) and !memcmp(a.ports, b.ports, sizeof(a.ports))
+        and a.proto.u_ip_count == b.proto.u_ip_count
+        and a.proto.u_port_count == b.proto.u_port_count
+        and a.proto.low_ip.equals(b.proto.low_ip) and a.proto.high_ip.equals(b.proto.high_ip)
+        and a.proto.low_p == b.proto.low_p and a.proto.high_p == b.proto.high_p
+        and a.proto.open_ports_cnt == b.proto.open_ports_cnt
+        and a.proto.window == b.proto.window;
+}
+
+TEST_CASE("merge is idempotent", "[port_scan]")
+{
+    PS_RECORD rec;
+    make_record(rec, 0, 40, 100);
+
+    PortScanMerger::Node once, twice;
+    memset(&once, 0, sizeof(once));
+    memset(&twice, 0, sizeof(twice));
+
+    PortScanMerger::merge(once, rec, 60);
+    PortScanMerger::merge(twice, rec, 60);
+    PortScanMerger::merge(twice, rec, 60);
+
+    CHECK(same_view(once, twice));
+    CHECK(once.proto.u_ip_count >= 30);
+    CHECK(once.proto.u_ip_count <= 50);
+    CHECK(once.proto.open_ports_cnt == 2);
+    CHECK(once.proto.window == 160);
+
+    // the counts are deltas
+    CHECK(once.proto.connection_count == 40);
+    CHECK(twice.proto.connection_count == 80);
+}
+
+TEST_CASE("merge order doesn't matter", "[port_scan]")
+{
+    PS_RECORD a, b;
+    make_record(a, 0, 30, 100);
+    make_record(b, 20, 30, 101);
+
+    PortScanMerger::Node ab, ba;
+    memset(&ab, 0, sizeof(ab));
+    memset(&ba, 0, sizeof(ba));
+
+    PortScanMerger::merge(ab, a, 60);
+    PortScanMerger::merge(ab, b, 60);
+    PortScanMerger::merge(ba, b, 60);
+    PortScanMerger::merge(ba, a, 60);
+
+    // only the window depends on which record came first
+    ba.proto.window = ab.proto.window;
+    CHECK(same_view(ab, ba));
+    CHECK(ab.proto.connection_count == ba.proto.connection_count);
+
+    CHECK(ab.proto.low_p == 1000);
+    CHECK(ab.proto.high_p == 1049);
+    CHECK(ab.proto.open_ports_cnt == 3);
+
+    // the union of 50 distinct values, not the sum of 60
+    CHECK(ab.proto.u_ip_count >= 35);
+    CHECK(ab.proto.u_ip_count <= 65);
+}
+
+TEST_CASE("merge starts over after the window", "[port_scan]")
+{
+    PS_RECORD a, b;
+    make_record(a, 0, 30, 100);
+    make_record(b, 100, 5, 200);
+
+    PortScanMerger::Node node, fresh;
+    memset(&node, 0, sizeof(node));
+    memset(&fresh, 0, sizeof(fresh));
+
+    PortScanMerger::merge(node, a, 60);
+    PortScanMerger::merge(node, b, 60);
+    PortScanMerger::merge(fresh, b, 60);
+
+    CHECK(same_view(node, fresh));
+    CHECK(node.proto.connection_count == 5);
+    CHECK(node.proto.window == 260);
+}
+
+static bool wait_candidate(PortScanMerger& merger, PS_ALERT_RECORD& rec)
+{
+    for ( unsigned i = 0; i < 1000; i++ )
+    {
+        if ( merger.get_candidate(rec) )
+            return true;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+TEST_CASE("merged candidates carry the tracker addresses", "[port_scan]")
+{
+    PortscanConfig config;
+    config.memcap = 1024 * 1024;
+    config.tcp_window = 60;
+
+    PortScanMerger merger(&config);
+
+    // a scanner and scanned tracker pair from one thread
+    std::vector<PS_RECORD> records(2);
+    PS_RECORD& scanner = records[0];
+    PS_RECORD& scanned = records[1];
+
+    make_record(scanner, 0, 10, 100);
+    make_record(scanned, 0, 10, 100);
+
+    REQUIRE(scanner.key.scanner.set("10.1.1.1") == SFIP_SUCCESS);
+    REQUIRE(scanned.key.scanned.set("10.2.2.2") == SFIP_SUCCESS);
+
+    scanner.distinct.peer = scanned.key;
+    scanned.distinct.peer = scanner.key;
+
+    // publish takes the records
+    PS_RECORD again = scanner;
+    merger.publish(records);
+
+    for ( unsigned n = 0; n < 2; n++ )
+    {
+        PS_ALERT_RECORD rec;
+        REQUIRE(wait_candidate(merger, rec));
+
+        CHECK(rec.protocol == PS_PROTO_TCP);
+        CHECK(rec.has_scanner);
+        CHECK(rec.has_scanned);
+
+        SfIpString s;
+        CHECK(std::string(rec.scanner_key.scanner.ntop(s)) == "10.1.1.1");
+        CHECK(!rec.scanner_key.scanned.is_set());
+        CHECK(std::string(rec.scanned_key.scanned.ntop(s)) == "10.2.2.2");
+        CHECK(!rec.scanned_key.scanner.is_set());
+
+        CHECK(rec.scanner.window == 160);
+        CHECK(rec.scanner.alerts == 0);
+    }
+
+    // only the first claim in a window alerts and later candidates know it
+    CHECK(merger.claim(again.key, 160));
+    CHECK(!merger.claim(again.key, 160));
+
+    std::vector<PS_RECORD> more(1, again);
+    merger.publish(more);
+
+    PS_ALERT_RECORD rec;
+    REQUIRE(wait_candidate(merger, rec));
+    CHECK(rec.scanner.alerts == PS_ALERT_GENERATED);
+    CHECK(rec.scanned.alerts == 0);
+
+    // a new window can alert again
+    CHECK(merger.claim(again.key, 260));
+}
+#endif
@@ -0,0 +1,114 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef PS_MERGE_H
+#define PS_MERGE_H
+
+// PortScanMerger keeps the global view of port scan trackers in sketch
+// mode.  Packet threads periodically publish the trackers they changed and
+// a background thread merges them: counts are summed, the distinct address
+// and port estimates are merged register by register and the result is
+// handed back to the packet threads as candidates.  The usual alert logic
+// runs on the packet thread that takes a candidate and the first thread to
+// claim a tracker for its window raises the event.
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ps_detect.h"
+
+// a merged tracker paired with its peer as ps_detect() pairs the scanner
+// and scanned trackers of a packet.  The keys give the addresses of the
+// alert; a key with a zero protocol is unknown and a proto is only valid
+// if its tracker is in the global view.
+struct PS_ALERT_RECORD
+{
+    PS_HASH_KEY scanner_key;
+    PS_HASH_KEY scanned_key;
+    PS_PROTO scanner;
+    PS_PROTO scanned;
+    bool has_scanner;
+    bool has_scanned;
+    int protocol;
+};
+
+class PortScanMerger
+{
+public:
+    PortScanMerger(const PortscanConfig*);
+    ~PortScanMerger();
+
+    // takes the records
+    void publish(std::vector<PS_RECORD>&);
+
+    // the alerts of trackers already claimed for their window are set to
+    // PS_ALERT_GENERATED
+    bool get_candidate(PS_ALERT_RECORD&);
+
+    // true for the first claim of the tracker in this window
+    bool claim(const PS_HASH_KEY&, time_t window);
+
+    struct Node
+    {
+        PS_PROTO proto;
+        uint8_t ips[PS_HLL_REGS];
+        uint8_t ports[PS_HLL_REGS];
+        PS_HASH_KEY peer;
+    };
+
+    // merge a record into a zeroed or previously merged node; window is the
+    // tracking window of the record's protocol.  Everything but the
+    // connection and priority counts, which are deltas, merges idempotently.
+    static void merge(Node&, const PS_RECORD&, unsigned window);
+
+private:
+    struct KeyHash
+    { size_t operator()(const PS_HASH_KEY&) const; };
+
+    struct KeyEqual
+    { bool operator()(const PS_HASH_KEY&, const PS_HASH_KEY&) const; };
+
+    void worker();
+    Node* merge(const PS_RECORD&);
+    bool get_candidate(const PS_HASH_KEY&, PS_ALERT_RECORD&);
+    unsigned get_window(int protocol) const;
+
+    const PortscanConfig* config;
+    size_t max_nodes;
+
+    // only accessed by the worker
+    std::unordered_map<PS_HASH_KEY, Node, KeyHash, KeyEqual> nodes;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::vector<PS_RECORD>> pending;
+    std::deque<PS_ALERT_RECORD> candidates;
+    std::unordered_map<PS_HASH_KEY, time_t, KeyHash, KeyEqual> claimed;
+    std::atomic<unsigned> num_candidates { 0 };
+    bool running = true;
+    std::thread* thread;
+};
+
+#endif
+
@@ -85,6 +85,12 @@ static const Parameter ps_params[] =
     { "include_midstream", Parameter::PT_BOOL, nullptr, "false",
       "list of CIDRs with optional ports" },
 
+    { "sketch", Parameter::PT_BOOL, nullptr, "false",
+      "track scans in fixed size per thread tables merged into a global view by a background thread" },
+
+    { "merge_interval", Parameter::PT_INT, "1:60", "1",
+      "seconds between merges of per thread trackers in sketch mode" },
+
     { "tcp_ports", Parameter::PT_TABLE, scan_params, nullptr,
       "TCP port scan configuration (one-to-one)" },
 
@@ -263,6 +269,12 @@ bool PortScanModule::set(const char* fqn, Value& v, SnortConfig*)
     else if ( v.is("include_midstream") )
         config->include_midstream = v.get_bool();
 
+    else if ( v.is("sketch") )
+        config->sketch = v.get_bool();
+
+    else if ( v.is("merge_interval") )
+        config->merge_interval = v.get_uint32();
+
     else if ( v.is("watch_ip") )
     {
         IPSET*& ips = config->watch_ip;
@@ -329,7 +341,8 @@ bool PortScanModule::set(const char* fqn, Value& v, SnortConfig*)
 
 bool PortScanModule::end(const char* fqn, int, SnortConfig* sc)
 {
-    if ( Snort::is_reloading() && strcmp(fqn, "port_scan") == 0 )
+    // the sketch is resized by tinit and needs no gradual pruning
+    if ( Snort::is_reloading() && strcmp(fqn, "port_scan") == 0 && !config->sketch )
         sc->register_reload_handler(new PortScanReloadTuner(config->memcap));
     return true;
 }
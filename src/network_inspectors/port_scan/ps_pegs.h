@@ -31,6 +31,8 @@ static const PegInfo ps_module_pegs[] =
     { CountType::SUM, "alloc_prunes", "number of trackers pruned on allocation of new tracking" },
     { CountType::SUM, "reload_prunes", "number of trackers pruned on reload due to reduced memcap" },
     { CountType::NOW, "bytes_in_use", "number of bytes currently used by portscan" },
+    { CountType::SUM, "sketch_records", "number of changed trackers sent to the global view" },
+    { CountType::SUM, "merged_alerts", "number of alerts raised from the global view" },
     { CountType::END, nullptr, nullptr },
 };
 
@@ -41,6 +43,8 @@ struct PsPegStats
     PegCount alloc_prunes;
     PegCount reload_prunes;
     PegCount bytes_in_use;
+    PegCount sketch_records;
+    PegCount merged_alerts;
 };
 
 #endif
@@ -23,6 +23,10 @@
 
 #include "reputation_commands.h"
 
+#include <atomic>
+
+#include <lua.hpp>
+
 #include "control/control.h"
 #include "log/messages.h"
 #include "main/analyzer_command.h"
@@ -30,6 +34,9 @@
 
 #include "reputation_common.h"
 #include "reputation_inspect.h"
+#include "reputation_overlay.h"
+#include "reputation_parse.h"
+#include "reputation_table.h"
 
 using namespace snort;
 
@@ -55,6 +62,7 @@ ReputationReload::ReputationReload(ControlConn* conn, Reputation& ins)
     : AnalyzerCommand(conn), ins(ins)
 {
     ins.add_global_ref();
+    ins.begin_reload();
     log_message(".. reputation reloading\n");
     data = ins.load_data();
 }
@@ -62,6 +70,7 @@ ReputationReload::ReputationReload(ControlConn* conn, Reputation& ins)
 ReputationReload::~ReputationReload()
 {
     ins.swap_data(data);
+    ins.end_reload();
     log_message("== Reputation reload complete\n");
     ins.rem_global_ref();
 }
@@ -83,8 +92,115 @@ static int reload(lua_State* L)
     return 0;
 }
 
+// the overlay replaced by a delta update is freed once every packet thread
+// has executed this command and so can no longer be referencing it; the
+// entries are counted by the first packet thread to execute it since the
+// pegs are per thread and summed
+class ReputationDelta : public AnalyzerCommand
+{
+public:
+    ReputationDelta(ControlConn* conn, const ReputationOverlay* retired, int num_entries)
+        : AnalyzerCommand(conn), retired(retired), num_entries(num_entries)
+    { }
+    ~ReputationDelta() override
+    { delete retired; }
+
+    bool execute(Analyzer&, void**) override
+    {
+        if (!counted.exchange(true))
+            reputationstats.delta_entries += num_entries;
+        return true;
+    }
+
+    const char* stringify() override
+    { return "REPUTATION_DELTA"; }
+
+protected:
+    const ReputationOverlay* retired;
+    int num_entries;
+    std::atomic<bool> counted { false };
+};
+
+static int delta(lua_State* L)
+{
+    ControlConn* ctrlcon = ControlConn::query_from_lua(L);
+    const char* file = luaL_optstring(L, 1, nullptr);
+
+    if (!file)
+    {
+        AnalyzerCommand::log_message(ctrlcon, "Usage: reputation.delta(file_name)\n");
+        return 0;
+    }
+
+    Reputation* ins = static_cast<Reputation*>(InspectorManager::get_inspector(REPUTATION_NAME));
+    if (!ins)
+    {
+        AnalyzerCommand::log_message(ctrlcon, "No reputation instance configured to update\n");
+        return 0;
+    }
+
+    // the reload replaces the data this delta would be applied to
+    if (ins->is_reloading())
+    {
+        AnalyzerCommand::log_message(ctrlcon,
+            "== reputation delta refused, reload in progress; retry when it completes\n");
+        return 0;
+    }
+
+    ReputationData& data = ins->get_data();
+    const ReputationOverlay* current = data.overlay.load(std::memory_order_acquire);
+    ReputationOverlay* next = current ? new ReputationOverlay(*current) : new ReputationOverlay;
+
+    int num_entries = ReputationParser::load_delta(file, ins->get_config(), data, *next);
+    if (num_entries < 0)
+    {
+        delete next;
+        AnalyzerCommand::log_message(ctrlcon, "== reputation delta failed, can't read %s\n", file);
+        return 0;
+    }
+
+    current = data.overlay.exchange(next, std::memory_order_acq_rel);
+
+    AnalyzerCommand::log_message(ctrlcon, "== reputation delta applied %d entries from %s, "
+        "%zu delta entries in use\n", num_entries, file, next->size());
+
+    main_broadcast_command(new ReputationDelta(ctrlcon, current, num_entries), ctrlcon);
+    return 0;
+}
+
+static int save(lua_State* L)
+{
+    ControlConn* ctrlcon = ControlConn::query_from_lua(L);
+    const char* file = luaL_optstring(L, 1, nullptr);
+
+    if (!file)
+    {
+        AnalyzerCommand::log_message(ctrlcon, "Usage: reputation.save(file_name)\n");
+        return 0;
+    }
+
+    Reputation* ins = static_cast<Reputation*>(InspectorManager::get_inspector(REPUTATION_NAME));
+    if (!ins)
+        AnalyzerCommand::log_message(ctrlcon, "No reputation instance configured to save\n");
+    else if (ReputationTable::save(file, ins->get_data()))
+        AnalyzerCommand::log_message(ctrlcon, "== reputation table saved to %s\n", file);
+    else
+        AnalyzerCommand::log_message(ctrlcon, "== reputation table save to %s failed\n", file);
+
+    return 0;
+}
+
+static const Parameter file_params[] =
+{
+    { "file_name", Parameter::PT_STRING, nullptr, nullptr, "file name" },
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 const Command reputation_cmds[] =
 {
     {"reload", reload, nullptr, "reload reputation data"},
+    {"delta", delta, file_params, "add and remove addresses listed in file without a reload; "
+        "refused while a reload is in progress and dropped by the next reload"},
+    {"save", save, file_params, "save the compiled reputation table to file for table_file"},
     {nullptr, nullptr, nullptr, nullptr}
 };
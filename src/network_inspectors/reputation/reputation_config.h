@@ -81,12 +81,14 @@ struct ReputationConfig
 {
     uint32_t memcap = 500;
     bool scanlocal = false;
+    bool lookup_trie = false;
     IPdecision priority = TRUSTED;
     NestedIP nested_ip = INNER;
     AllowAction allow_action = DO_NOT_BLOCK;
     std::string blocklist_path;
     std::string allowlist_path;
     std::string list_dir;
+    std::string table_file;
 };
 
 struct IPrepInfo
@@ -105,6 +107,8 @@ struct ReputationStats
     PegCount aux_ip_blocked;
     PegCount aux_ip_trusted;
     PegCount aux_ip_monitored;
+    PegCount overlay_hits;
+    PegCount delta_entries;
 };
 
 extern const PegInfo reputation_peg_names[];
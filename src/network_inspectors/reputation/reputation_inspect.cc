@@ -25,6 +25,8 @@
 
 #include "reputation_inspect.h"
 
+#include <sys/mman.h>
+
 #include "detection/detect.h"
 #include "detection/detection_engine.h"
 #include "events/event_queue.h"
@@ -40,7 +42,9 @@
 #include "pub_sub/reputation_events.h"
 #include "utils/util.h"
 
+#include "reputation_overlay.h"
 #include "reputation_parse.h"
+#include "reputation_table.h"
 
 using namespace snort;
 
@@ -59,12 +63,14 @@ const PegInfo reputation_peg_names[] =
 { CountType::SUM, "aux_ip_blocked", "number of auxiliary ip packets blocked" },
 { CountType::SUM, "aux_ip_trusted", "number of auxiliary ip packets trusted" },
 { CountType::SUM, "aux_ip_monitored", "number of auxiliary ip packets monitored" },
+{ CountType::SUM, "overlay_hits", "number of lookups decided by delta updates" },
+{ CountType::SUM, "delta_entries", "number of addresses added or removed by delta updates" },
 { CountType::END, nullptr, nullptr }
 };
 
 #define MANIFEST_FILENAME "interface.info"
 
-static inline IPrepInfo* reputation_lookup(const ReputationConfig& config,
+static inline const IPrepInfo* reputation_lookup(const ReputationConfig& config,
     ReputationData& data, const SfIp* ip)
 {
     if (!config.scanlocal)
@@ -73,11 +79,53 @@ static inline IPrepInfo* reputation_lookup(const ReputationConfig& config,
             return nullptr;
     }
 
-    return (IPrepInfo*)sfrt_flat_dir8x_lookup(ip, data.ip_list);
+    return (const IPrepInfo*)sfrt_flat_dir8x_lookup(ip, data.ip_list);
+}
+
+// the overlay of delta updates takes precedence over the compiled table
+static inline const ReputationOverlayEntry* overlay_lookup(const ReputationConfig& config,
+    ReputationData& data, const SfIp* ip)
+{
+    const ReputationOverlay* overlay = data.overlay.load(std::memory_order_acquire);
+
+    if (!overlay or (!config.scanlocal and ip->is_private()))
+        return nullptr;
+
+    return overlay->lookup(ip);
+}
+
+// look up both addresses at once so the table walks overlap; addresses
+// decided by the overlay skip the table walk
+static inline void reputation_lookup(const ReputationConfig& config, ReputationData& data,
+    const SfIp* src, const SfIp* dst, const ReputationOverlayEntry* entries[2],
+    const IPrepInfo* results[2])
+{
+    entries[0] = overlay_lookup(config, data, src);
+    entries[1] = overlay_lookup(config, data, dst);
+
+    bool check_src = !entries[0] and (config.scanlocal or !src->is_private());
+    bool check_dst = !entries[1] and (config.scanlocal or !dst->is_private());
+
+    results[0] = results[1] = nullptr;
+
+    if (check_src and check_dst)
+    {
+        const SfIp* ips[2] = { src, dst };
+        GENERIC found[2];
+
+        sfrt_flat_dir8x_lookup(ips, found, 2, data.ip_list);
+        results[0] = (const IPrepInfo*)found[0];
+        results[1] = (const IPrepInfo*)found[1];
+    }
+    else if (check_src)
+        results[0] = (const IPrepInfo*)sfrt_flat_dir8x_lookup(src, data.ip_list);
+
+    else if (check_dst)
+        results[1] = (const IPrepInfo*)sfrt_flat_dir8x_lookup(dst, data.ip_list);
 }
 
 static inline IPdecision get_reputation(const ReputationConfig& config, ReputationData& data,
-    IPrepInfo* rep_info, uint32_t& listid, uint32_t ingress_intf, uint32_t egress_intf)
+    const IPrepInfo* rep_info, uint32_t& listid, uint32_t ingress_intf, uint32_t egress_intf)
 {
     IPdecision decision = DECISION_NULL;
 
@@ -115,23 +163,59 @@ static inline IPdecision get_reputation(const ReputationConfig& config, Reputati
 
         if (!rep_info->next)
             break;
-        rep_info = (IPrepInfo*)(&base[rep_info->next]);
+        rep_info = (const IPrepInfo*)(&base[rep_info->next]);
     }
 
     return decision;
 }
 
+static inline IPdecision get_reputation(const ReputationOverlayEntry& entry, uint32_t& listid,
+    uint32_t ingress_intf, uint32_t egress_intf)
+{
+    if (entry.list_type == DECISION_NULL or entry.list_type == TRUSTED_DO_NOT_BLOCK)
+        return DECISION_NULL;
+
+    if (entry.list and !entry.list->all_intfs_enabled and
+        !entry.list->intfs.count(ingress_intf) and !entry.list->intfs.count(egress_intf))
+        return DECISION_NULL;
+
+    listid = entry.list_id;
+    return entry.list_type;
+}
+
+// returns true if the address is listed, an overlay entry
+// takes precedence over the compiled table result
+static inline bool lookup_reputation(const ReputationConfig& config, ReputationData& data,
+    const ReputationOverlayEntry* entry, const IPrepInfo* result, IPdecision& decision,
+    uint32_t& listid, uint32_t ingress_intf, uint32_t egress_intf)
+{
+    if (entry)
+    {
+        ++reputationstats.overlay_hits;
+        decision = get_reputation(*entry, listid, ingress_intf, egress_intf);
+        return entry->list_type != DECISION_NULL;
+    }
+
+    if (!result)
+        return false;
+
+    decision = get_reputation(config, data, result, listid, ingress_intf, egress_intf);
+    return true;
+}
+
 static bool decision_per_layer(const ReputationConfig& config, ReputationData& data,
     uint32_t& iplist_id, uint32_t ingress_intf, uint32_t egress_intf, const ip::IpApi& ip_api,
     IPdecision* decision_final)
 {
-    const SfIp* ip = ip_api.get_src();
-    IPrepInfo* result = reputation_lookup(config, data, ip);
-    if (result)
-    {
-        IPdecision decision = get_reputation(config, data, result, iplist_id, ingress_intf,
-            egress_intf);
+    IPdecision decision = DECISION_NULL;
+    const ReputationOverlayEntry* entries[2];
+    const IPrepInfo* results[2];
 
+    reputation_lookup(config, data, ip_api.get_src(), ip_api.get_dst(), entries, results);
+
+    if (lookup_reputation(config, data, entries[0], results[0], decision, iplist_id,
+        ingress_intf, egress_intf))
+    {
         if (decision == BLOCKED)
             *decision_final = BLOCKED_SRC;
         else if (decision == MONITORED)
@@ -145,13 +229,9 @@ static bool decision_per_layer(const ReputationConfig& config, ReputationData& d
             return true;
     }
 
-    ip = ip_api.get_dst();
-    result = reputation_lookup(config, data, ip);
-    if (result)
+    if (lookup_reputation(config, data, entries[1], results[1], decision, iplist_id,
+        ingress_intf, egress_intf))
     {
-        IPdecision decision = get_reputation(config, data, result, iplist_id, ingress_intf,
-            egress_intf);
-
         if (decision == BLOCKED)
             *decision_final = BLOCKED_DST;
         else if (decision == MONITORED)
@@ -251,13 +331,12 @@ static IPdecision snort_reputation_aux_ip(const ReputationConfig& config, Reputa
             egress_intf = p->pkth->egress_index;
     }
 
-    IPrepInfo* result = reputation_lookup(config, data, ip);
-    if (result)
-    {
-        uint32_t iplist_id;
-        decision = get_reputation(config, data, result, iplist_id, ingress_intf,
-            egress_intf);
+    uint32_t iplist_id;
+    const ReputationOverlayEntry* entry = overlay_lookup(config, data, ip);
 
+    if (lookup_reputation(config, data, entry, entry ? nullptr : reputation_lookup(config, data, ip),
+        decision, iplist_id, ingress_intf, egress_intf))
+    {
         if (decision == BLOCKED)
         {
             // Prior to IPRep logging, IPS policy must be set to the default policy,
@@ -518,9 +597,13 @@ void AuxiliaryIpRepHandler::handle(DataEvent& event, Flow*)
 
 ReputationData::~ReputationData()
 {
-    if (reputation_segment)
+    if (table_map)
+        munmap(table_map, table_map_size);
+    else if (reputation_segment)
         snort_free(reputation_segment);
 
+    delete overlay.load();
+
     for (auto& file : list_files)
         delete file;
 }
@@ -534,6 +617,18 @@ Reputation::~Reputation()
 ReputationData* Reputation::load_data()
 {
     ReputationData* data = new ReputationData();
+
+    if (!config.table_file.empty())
+    {
+        if (ReputationTable::load(config.table_file.c_str(), config, *data))
+        {
+            reputationstats.memory_allocated = data->segment_size;
+            return data;
+        }
+        ParseWarning(WARN_CONF, "reputation: can't load table %s; using IP lists",
+            config.table_file.c_str());
+    }
+
     if (!config.list_dir.empty())
         ReputationParser::read_manifest(MANIFEST_FILENAME, config, *data);
 
@@ -573,6 +668,8 @@ void Reputation::show(const SnortConfig*) const
 {
     ConfigLogger::log_value("blocklist", config.blocklist_path.c_str());
     ConfigLogger::log_value("list_dir", config.list_dir.c_str());
+    ConfigLogger::log_value("table_file", config.table_file.c_str());
+    ConfigLogger::log_value("lookup_table", config.lookup_trie ? "trie" : "dir");
     ConfigLogger::log_value("memcap", config.memcap);
     ConfigLogger::log_value("nested_ip", to_string(config.nested_ip));
     ConfigLogger::log_value("priority", to_string(config.priority));
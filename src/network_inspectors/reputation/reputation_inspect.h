@@ -19,11 +19,15 @@
 #ifndef REPUTATION_INSPECT_H
 #define REPUTATION_INSPECT_H
 
+#include <atomic>
+
 #include "framework/inspector.h"
 
 #include "reputation_module.h"
 
 struct table_flat_t;
+class ReputationOverlay;
+
 class ReputationData
 {
 public:
@@ -32,7 +36,11 @@ public:
 
     ListFiles list_files;
     uint8_t* reputation_segment = nullptr;
+    size_t segment_size = 0;
+    void* table_map = nullptr;      // set if the segment is mapped from a table file
+    size_t table_map_size = 0;
     table_flat_t* ip_list = nullptr;
+    std::atomic<const ReputationOverlay*> overlay { nullptr };
     int num_entries = 0;
     bool memcap_reached = false;
 };
@@ -61,9 +69,19 @@ public:
     void swap_thread_data(ReputationData*);
     void swap_data(ReputationData*);
 
+    // a delta applied to the current data while a reputation.reload() is
+    // swapping in new data would be lost so deltas are refused meanwhile
+    void begin_reload()
+    { ++pending_reloads; }
+    void end_reload()
+    { --pending_reloads; }
+    bool is_reloading() const
+    { return pending_reloads != 0; }
+
 private:
     ReputationConfig config;
     ReputationData* rep_data;
+    unsigned pending_reloads = 0;
 };
 
 #endif
@@ -59,6 +59,10 @@ static const Parameter s_params[] =
     { "list_dir", Parameter::PT_STRING, nullptr, nullptr,
       "directory for IP lists and manifest file" },
 
+    { "lookup_table", Parameter::PT_ENUM, "dir|trie", "dir",
+      "look up addresses in the DIR tables built from the lists or in compressed tries "
+      "compiled from them" },
+
     { "memcap", Parameter::PT_INT, "1:4095", "500",
       "maximum total MB of memory allocated" },
 
@@ -77,6 +81,9 @@ static const Parameter s_params[] =
     { "allowlist", Parameter::PT_STRING, nullptr, nullptr,
       "allowlist file name with IP lists" },
 
+    { "table_file", Parameter::PT_STRING, nullptr, nullptr,
+      "compiled table saved with reputation.save(); mapped instead of loading the IP lists" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -131,6 +138,9 @@ bool ReputationModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("list_dir") )
         conf->list_dir = v.get_string();
 
+    else if ( v.is("lookup_table") )
+        conf->lookup_trie = (v.get_uint8() == 1);
+
     else if ( v.is("memcap") )
         conf->memcap = v.get_uint32();
 
@@ -149,6 +159,9 @@ bool ReputationModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("allowlist") )
         conf->allowlist_path = v.get_string();
 
+    else if ( v.is("table_file") )
+        conf->table_file = v.get_string();
+
     return true;
 }
 
@@ -0,0 +1,149 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "reputation_overlay.h"
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <functional>
+
+#include "sfip/sf_cidr.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+ReputationOverlay::Key ReputationOverlay::make_key(const uint32_t* ip6, unsigned bits)
+{
+    Key k;
+    k.hi = ((uint64_t)ntohl(ip6[0]) << 32) | ntohl(ip6[1]);
+    k.lo = ((uint64_t)ntohl(ip6[2]) << 32) | ntohl(ip6[3]);
+    k.bits = bits;
+
+    if ( bits <= 64 )
+    {
+        k.hi = bits ? k.hi & (~0ull << (64 - bits)) : 0;
+        k.lo = 0;
+    }
+    else if ( bits < 128 )
+        k.lo &= ~0ull << (128 - bits);
+
+    return k;
+}
+
+void ReputationOverlay::set(const SfCidr& cidr, const ReputationOverlayEntry& entry)
+{
+    unsigned bits = cidr.get_bits();
+    entries[make_key(cidr.get_addr()->get_ip6_ptr(), bits)] = entry;
+
+    if ( std::find(prefixes.begin(), prefixes.end(), bits) == prefixes.end() )
+    {
+        prefixes.emplace_back(bits);
+        std::sort(prefixes.begin(), prefixes.end(), std::greater<uint8_t>());
+    }
+}
+
+const ReputationOverlayEntry* ReputationOverlay::lookup(const SfIp* ip) const
+{
+    for ( auto bits : prefixes )
+    {
+        auto it = entries.find(make_key(ip->get_ip6_ptr(), bits));
+
+        if ( it != entries.end() )
+            return &it->second;
+    }
+    return nullptr;
+}
+
+#ifdef UNIT_TEST
+static void set_entry(ReputationOverlay& overlay, const char* cidr, IPdecision type,
+    uint32_t id)
+{
+    SfCidr c;
+    REQUIRE(c.set(cidr) == SFIP_SUCCESS);
+    overlay.set(c, { type, id, nullptr });
+}
+
+static const ReputationOverlayEntry* get_entry(const ReputationOverlay& overlay,
+    const char* addr)
+{
+    SfIp ip;
+    REQUIRE(ip.set(addr) == SFIP_SUCCESS);
+    return overlay.lookup(&ip);
+}
+
+static bool check_entry(const ReputationOverlay& overlay, const char* addr, IPdecision type,
+    uint32_t id)
+{
+    const ReputationOverlayEntry* e = get_entry(overlay, addr);
+    return e and e->list_type == type and e->list_id == id;
+}
+
+TEST_CASE("overlay longest prefix match", "[reputation]")
+{
+    ReputationOverlay overlay;
+
+    set_entry(overlay, "10.0.0.0/8", BLOCKED, 1);
+    set_entry(overlay, "10.1.0.0/16", TRUSTED, 2);
+    set_entry(overlay, "10.1.2.0/24", DECISION_NULL, 0);
+    set_entry(overlay, "10.1.2.3", MONITORED, 3);
+    set_entry(overlay, "2001:db8::/32", BLOCKED, 4);
+    set_entry(overlay, "2001:db8:1::/48", DECISION_NULL, 0);
+
+    CHECK(overlay.size() == 6);
+
+    CHECK(check_entry(overlay, "10.200.0.1", BLOCKED, 1));
+    CHECK(check_entry(overlay, "10.1.200.1", TRUSTED, 2));
+    CHECK(check_entry(overlay, "10.1.2.4", DECISION_NULL, 0));
+    CHECK(check_entry(overlay, "10.1.2.3", MONITORED, 3));
+    CHECK(check_entry(overlay, "2001:db8:2::1", BLOCKED, 4));
+    CHECK(check_entry(overlay, "2001:db8:1::1", DECISION_NULL, 0));
+
+    CHECK(get_entry(overlay, "11.0.0.1") == nullptr);
+    CHECK(get_entry(overlay, "2001:db9::1") == nullptr);
+
+    // an IPv4 prefix doesn't cover IPv6 addresses with the same leading bits
+    CHECK(get_entry(overlay, "a01:203::") == nullptr);
+}
+
+TEST_CASE("overlay replace and copy", "[reputation]")
+{
+    ReputationOverlay overlay;
+    set_entry(overlay, "192.168.0.0/16", BLOCKED, 1);
+
+    ReputationOverlay next(overlay);
+    set_entry(next, "192.168.0.0/16", MONITORED, 2);
+    set_entry(next, "192.168.1.0/24", DECISION_NULL, 0);
+
+    CHECK(next.size() == 2);
+    CHECK(check_entry(next, "192.168.2.1", MONITORED, 2));
+    CHECK(check_entry(next, "192.168.1.1", DECISION_NULL, 0));
+
+    // the published overlay is unchanged
+    CHECK(overlay.size() == 1);
+    CHECK(check_entry(overlay, "192.168.2.1", BLOCKED, 1));
+    CHECK(check_entry(overlay, "192.168.1.1", BLOCKED, 1));
+}
+#endif
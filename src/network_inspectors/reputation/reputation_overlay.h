@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef REPUTATION_OVERLAY_H
+#define REPUTATION_OVERLAY_H
+
+// ReputationOverlay holds the CIDRs added or removed by delta updates on top
+// of the compiled reputation table.  An overlay is never modified once it is
+// published to the packet threads; each delta builds a new overlay from a
+// copy of the current one and the old one is released after all packet
+// threads have moved past it.  An overlay entry takes precedence over the
+// compiled table for every address it covers.  Entries with list_type
+// DECISION_NULL mask the compiled table (removed addresses).
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "reputation_config.h"
+
+namespace snort
+{
+struct SfCidr;
+struct SfIp;
+}
+
+struct ReputationOverlayEntry
+{
+    IPdecision list_type;
+    uint32_t list_id;
+    const ListFile* list;   // interface filter; all interfaces if null
+};
+
+class ReputationOverlay
+{
+public:
+    void set(const snort::SfCidr&, const ReputationOverlayEntry&);
+
+    // longest prefix match
+    const ReputationOverlayEntry* lookup(const snort::SfIp*) const;
+
+    size_t size() const
+    { return entries.size(); }
+
+private:
+    struct Key
+    {
+        uint64_t hi;
+        uint64_t lo;
+        uint8_t bits;
+
+        bool operator==(const Key& k) const
+        { return hi == k.hi and lo == k.lo and bits == k.bits; }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& k) const
+        { return std::hash<uint64_t>()(k.hi ^ (k.lo * 0x9E3779B97F4A7C15ull) ^ k.bits); }
+    };
+
+    static Key make_key(const uint32_t* ip6, unsigned bits);
+
+    std::unordered_map<Key, ReputationOverlayEntry, KeyHash> entries;
+    std::vector<uint8_t> prefixes;  // distinct prefix lengths, longest first
+};
+
+#endif
+
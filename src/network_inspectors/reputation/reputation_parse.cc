@@ -39,6 +39,13 @@
 
 #include "reputation_config.h"
 #include "reputation_inspect.h"
+#include "reputation_overlay.h"
+
+#ifdef UNIT_TEST
+#include <unistd.h>
+
+#include "catch/snort_catch.h"
+#endif
 
 using namespace snort;
 using namespace std;
@@ -55,6 +62,7 @@ enum
 #define MAX_ADDR_LINE_LENGTH    8192
 
 #define MANIFEST_SEPARATORS         ",\r\n"
+#define DELTA_SEPARATORS            ", \t\r\n"
 #define MIN_MANIFEST_COLUMNS         3
 
 static char block_info[] = "blocklist";
@@ -67,11 +75,7 @@ static char monitor_info[] = "monitorlist";
 #define TRUST_TYPE_KEYWORD       "trust"
 #define BLOCK_TYPE_KEYWORD       "block"
 #define MONITOR_TYPE_KEYWORD     "monitor"
-
-#define UNKNOWN_LIST    0
-#define MONITOR_LIST    1
-#define BLOCK_LIST      2
-#define ALLOW_LIST      3
+#define DELTA_REMOVE_KEYWORD     "remove"
 
 #define MAX_MSGS_TO_PRINT      20
 
@@ -654,23 +658,34 @@ void ReputationParser::ip_list_init(uint32_t max_entries, const ReputationConfig
         for (size_t i = 0; i < data.list_files.size(); i++)
         {
             data.list_files[i]->list_index = (uint8_t)i + 1;
-            if (data.list_files[i]->file_type == ALLOW_LIST)
-            {
-                if (config.allow_action == DO_NOT_BLOCK)
-                    data.list_files[i]->list_type = TRUSTED_DO_NOT_BLOCK;
-                else
-                    data.list_files[i]->list_type = TRUSTED;
-            }
-            else if (data.list_files[i]->file_type == BLOCK_LIST)
-                data.list_files[i]->list_type = BLOCKED;
-            else if (data.list_files[i]->file_type == MONITOR_LIST)
-                data.list_files[i]->list_type = MONITORED;
-
+            data.list_files[i]->list_type = get_list_type(data.list_files[i]->file_type, config);
             load_list_file(data.list_files[i], config, data);
         }
+
+        if (config.lookup_trie and !table.sfrt_flat_compile())
+            ErrorMessage("reputation: memcap %u Mbytes too small to compile lookup tries, "
+                "using DIR tables\n", config.memcap);
+
+        data.segment_size = table.segment_used();
     }
 }
 
+uint8_t ReputationParser::get_list_type(int file_type, const ReputationConfig& config)
+{
+    switch (file_type)
+    {
+    case ALLOW_LIST:
+        return (config.allow_action == DO_NOT_BLOCK) ? TRUSTED_DO_NOT_BLOCK : TRUSTED;
+    case BLOCK_LIST:
+        return BLOCKED;
+    case MONITOR_LIST:
+        return MONITORED;
+    default:
+        break;
+    }
+    return DECISION_NULL;
+}
+
 static int num_lines_in_file(char* fname)
 {
     FILE* fp;
@@ -954,3 +969,185 @@ void ReputationParser::read_manifest(const char* manifest_file, const Reputation
     fs.close();
 }
 
+
+// Each line of a delta file is:
+//    action address[/bits] [list_id]
+// where action is one of trust | white | block | monitor | remove.
+// Added addresses inherit the interfaces of the configured list with the
+// same action and list id, if there is one, else they apply to all
+// interfaces.  Removed addresses no longer match any list.
+
+static const ListFile* find_list(const ReputationData& data, int file_type, uint32_t list_id)
+{
+    for (auto list : data.list_files)
+    {
+        if (list->file_type == file_type and list->list_id == list_id)
+            return list;
+    }
+    return nullptr;
+}
+
+static bool process_line_in_delta(const char* delta, char* line, int line_number,
+    const ReputationConfig& config, const ReputationData& data, ReputationOverlay& overlay)
+{
+    char* next_ptr = line;
+    char* action = strtok_r(next_ptr, DELTA_SEPARATORS, &next_ptr);
+
+    if (!action)
+        return false;
+
+    char* addr = strtok_r(next_ptr, DELTA_SEPARATORS, &next_ptr);
+    char* id = strtok_r(next_ptr, DELTA_SEPARATORS, &next_ptr);
+
+    SfCidr cidr;
+    if (!addr or snort_pton(addr, &cidr) < 1)
+    {
+        ErrorMessage("%s(%d) => Invalid address: '%s'\n", delta, line_number,
+            addr ? addr : "");
+        return false;
+    }
+
+    ReputationOverlayEntry entry = { DECISION_NULL, 0, nullptr };
+
+    if (strncasecmp(action, DELTA_REMOVE_KEYWORD, strlen(DELTA_REMOVE_KEYWORD)) != 0)
+    {
+        int file_type = get_file_type(action);
+        if (UNKNOWN_LIST == file_type)
+        {
+            ErrorMessage("%s(%d) => Unknown action specified (%s)."
+                " Please specify a value: %s | %s | %s | %s | %s.\n", delta, line_number, action,
+                WHITE_TYPE_KEYWORD, TRUST_TYPE_KEYWORD, BLOCK_TYPE_KEYWORD,
+                MONITOR_TYPE_KEYWORD, DELTA_REMOVE_KEYWORD);
+            return false;
+        }
+
+        if (id)
+        {
+            char* end_str;
+            long list_id = SnortStrtol(id, &end_str, 10);
+            end_str = ignore_start_space(end_str);
+
+            if (*end_str or list_id < 0 or list_id > MAX_LIST_ID or errno == ERANGE)
+            {
+                ErrorMessage("%s(%d) => Bad value (%s) specified for listID. "
+                    "Please specify an integer between 0 and %u.\n",
+                    delta, line_number, id, MAX_LIST_ID);
+                return false;
+            }
+            entry.list_id = (uint32_t)list_id;
+        }
+        entry.list_type = (IPdecision)ReputationParser::get_list_type(file_type, config);
+        entry.list = find_list(data, file_type, entry.list_id);
+    }
+
+    overlay.set(cidr, entry);
+    return true;
+}
+
+int ReputationParser::load_delta(const char* delta_file, const ReputationConfig& config,
+    const ReputationData& data, ReputationOverlay& overlay)
+{
+    char full_path_filename[PATH_MAX+1];
+    update_path_to_file(full_path_filename, PATH_MAX, delta_file);
+
+    std::fstream fs;
+    fs.open(full_path_filename, std::fstream::in);
+
+    if (!fs.good())
+    {
+        ErrorMessage("Can't open file: %s\n", full_path_filename);
+        return -1;
+    }
+
+    int line_number = 0;
+    int num_applied = 0;
+    std::string line;
+
+    while (std::getline(fs, line))
+    {
+        line_number++;
+
+        /* remove comments */
+        size_t pos = line.find_first_of('#');
+        if (pos != line.npos)
+           line.resize(pos);
+
+        if (process_line_in_delta(delta_file, &line[0], line_number, config, data, overlay))
+            num_applied++;
+    }
+
+    fs.close();
+    return num_applied;
+}
+
+#ifdef UNIT_TEST
+static const ReputationOverlayEntry* get_entry(const ReputationOverlay& overlay,
+    const char* addr)
+{
+    SfIp ip;
+    REQUIRE(ip.set(addr) == SFIP_SUCCESS);
+    return overlay.lookup(&ip);
+}
+
+TEST_CASE("delta file parsing", "[reputation]")
+{
+    char name[] = "/tmp/reputation_delta_XXXXXX";
+    int fd = mkstemp(name);
+    REQUIRE(fd >= 0);
+
+    const char* text =
+        "# comment\n"
+        "block 10.0.0.0/8 5\n"
+        "white 10.1.0.0/16\n"
+        "monitor 2001:db8::/32, 7  # trailing comment\n"
+        "remove 10.1.2.0/24\n"
+        "\n"
+        "bogus 1.2.3.4\n"
+        "block not_an_address\n"
+        "block 1.2.3.4 abc\n"
+        "block 1.2.3.4 -1\n";
+
+    REQUIRE(write(fd, text, strlen(text)) == (ssize_t)strlen(text));
+    close(fd);
+
+    ReputationConfig config;
+    ReputationData data;
+
+    ListFile* list = new ListFile;
+    list->file_type = BLOCK_LIST;
+    list->list_id = 5;
+    list->intfs.emplace(3);
+    data.list_files.emplace_back(list);
+
+    ReputationOverlay overlay;
+    CHECK(ReputationParser::load_delta(name, config, data, overlay) == 4);
+    unlink(name);
+
+    CHECK(overlay.size() == 4);
+
+    const ReputationOverlayEntry* e = get_entry(overlay, "10.9.9.9");
+    REQUIRE(e);
+    CHECK(e->list_type == BLOCKED);
+    CHECK(e->list_id == 5);
+    CHECK(e->list == list);
+
+    e = get_entry(overlay, "10.1.9.9");
+    REQUIRE(e);
+    CHECK(e->list_type == TRUSTED_DO_NOT_BLOCK);
+    CHECK(e->list_id == 0);
+    CHECK(e->list == nullptr);
+
+    e = get_entry(overlay, "2001:db8::1");
+    REQUIRE(e);
+    CHECK(e->list_type == MONITORED);
+    CHECK(e->list_id == 7);
+
+    e = get_entry(overlay, "10.1.2.3");
+    REQUIRE(e);
+    CHECK(e->list_type == DECISION_NULL);
+
+    CHECK(get_entry(overlay, "1.2.3.4") == nullptr);
+
+    CHECK(ReputationParser::load_delta(name, config, data, overlay) == -1);
+}
+#endif
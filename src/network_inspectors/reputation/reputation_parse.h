@@ -24,10 +24,16 @@
 
 #include "sfrt/sfrt_flat.h"
 
+#define UNKNOWN_LIST    0
+#define MONITOR_LIST    1
+#define BLOCK_LIST      2
+#define ALLOW_LIST      3
+
 struct IPrepInfo;
 struct ListFile;
 struct ReputationConfig;
 class ReputationData;
+class ReputationOverlay;
 
 class ReputationParser
 {
@@ -35,6 +41,12 @@ public:
     static void read_manifest(const char* filename, const ReputationConfig&, ReputationData&);
     static void add_block_allow_List(const ReputationConfig&, ReputationData&);
     static void estimate_num_entries(ReputationData&);
+    static uint8_t get_list_type(int file_type, const ReputationConfig&);
+
+    // add the entries of a delta file to the overlay, returns the number
+    // of entries added or -1 if the file can't be read
+    static int load_delta(const char* file, const ReputationConfig&, const ReputationData&,
+        ReputationOverlay&);
 
     void load_list_file(ListFile* list_info, const ReputationConfig& config,
         ReputationData& data);
@@ -0,0 +1,409 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "reputation_table.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "log/messages.h"
+#include "utils/util.h"
+
+#include "reputation_inspect.h"
+#include "reputation_parse.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+// file layout:
+//    TableHeader
+//    num_lists x { ListRecord, num_intfs x uint32_t, name_len chars }
+//    zero padding to segment_offset (page aligned)
+//    segment_size bytes of sfrt_flat segment
+
+#define TABLE_MAGIC "SNORTREP"
+#define TABLE_VERSION 2
+#define TABLE_BYTE_ORDER 0x01020304
+
+struct TableHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t num_lists;
+    int32_t num_entries;
+    uint64_t segment_offset;
+    uint64_t segment_size;
+};
+
+struct ListRecord
+{
+    uint32_t list_id;
+    int32_t file_type;
+    uint32_t all_intfs_enabled;
+    uint32_t num_intfs;
+    uint32_t name_len;
+};
+
+static bool write_all(FILE* fp, const void* buf, size_t len)
+{ return fwrite(buf, 1, len, fp) == len; }
+
+bool ReputationTable::save(const char* file, const ReputationData& data)
+{
+    if ( !data.ip_list or (uint8_t*)data.ip_list != data.reputation_segment or
+        !data.segment_size )
+    {
+        ErrorMessage("reputation: no table to save\n");
+        return false;
+    }
+
+    std::string tmp = std::string(file) + ".tmp";
+    FILE* fp = fopen(tmp.c_str(), "wb");
+
+    if ( !fp )
+    {
+        ErrorMessage("reputation: can't open %s: %s\n", tmp.c_str(), get_error(errno));
+        return false;
+    }
+
+    TableHeader hdr = { };
+    memcpy(hdr.magic, TABLE_MAGIC, sizeof(hdr.magic));
+    hdr.version = TABLE_VERSION;
+    hdr.byte_order = TABLE_BYTE_ORDER;
+    hdr.num_lists = data.list_files.size();
+    hdr.num_entries = data.num_entries;
+    hdr.segment_size = data.segment_size;
+
+    uint64_t offset = sizeof(hdr);
+
+    for ( auto list : data.list_files )
+        offset += sizeof(ListRecord) + list->intfs.size() * sizeof(uint32_t) +
+            list->file_name.size();
+
+    uint64_t page = sysconf(_SC_PAGESIZE);
+    hdr.segment_offset = (offset + page - 1) & ~(page - 1);
+
+    bool ok = write_all(fp, &hdr, sizeof(hdr));
+
+    for ( auto list : data.list_files )
+    {
+        ListRecord rec = { };
+        rec.list_id = list->list_id;
+        rec.file_type = list->file_type;
+        rec.all_intfs_enabled = list->all_intfs_enabled;
+        rec.num_intfs = list->intfs.size();
+        rec.name_len = list->file_name.size();
+
+        ok = ok and write_all(fp, &rec, sizeof(rec));
+
+        for ( auto intf : list->intfs )
+        {
+            uint32_t id = intf;
+            ok = ok and write_all(fp, &id, sizeof(id));
+        }
+        ok = ok and write_all(fp, list->file_name.c_str(), rec.name_len);
+    }
+
+    static const uint8_t zeros[64] = { };
+
+    while ( ok and offset < hdr.segment_offset )
+    {
+        size_t n = std::min<uint64_t>(sizeof(zeros), hdr.segment_offset - offset);
+        ok = write_all(fp, zeros, n);
+        offset += n;
+    }
+
+    ok = ok and write_all(fp, data.reputation_segment, data.segment_size);
+    ok = (fflush(fp) == 0) and ok;
+    ok = (fsync(fileno(fp)) == 0) and ok;
+    fclose(fp);
+
+    if ( !ok or rename(tmp.c_str(), file) )
+    {
+        ErrorMessage("reputation: can't write %s: %s\n", file, get_error(errno));
+        unlink(tmp.c_str());
+        return false;
+    }
+
+    LogMessage("reputation: saved %u lists, %zu bytes of table to %s\n",
+        hdr.num_lists, data.segment_size, file);
+
+    return true;
+}
+
+static bool check_table(const uint8_t* seg, size_t size)
+{
+    if ( size < sizeof(table_flat_t) )
+        return false;
+
+    const table_flat_t* table = (const table_flat_t*)seg;
+
+    return table->data < size and table->rt < size and table->rt6 < size and
+        table->list_info < size and table->mbt < size and table->mbt6 < size and
+        table->max_size <= size / sizeof(INFO);
+}
+
+bool ReputationTable::load(const char* file, const ReputationConfig& config,
+    ReputationData& data)
+{
+    int fd = open(file, O_RDONLY);
+
+    if ( fd < 0 )
+    {
+        ErrorMessage("reputation: can't open %s: %s\n", file, get_error(errno));
+        return false;
+    }
+
+    struct stat st;
+
+    if ( fstat(fd, &st) or (size_t)st.st_size < sizeof(TableHeader) )
+    {
+        ErrorMessage("reputation: %s is not a reputation table\n", file);
+        close(fd);
+        return false;
+    }
+
+    size_t map_size = st.st_size;
+    void* map = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if ( map == MAP_FAILED )
+    {
+        ErrorMessage("reputation: can't map %s: %s\n", file, get_error(errno));
+        return false;
+    }
+
+    const uint8_t* base = (const uint8_t*)map;
+    const TableHeader* hdr = (const TableHeader*)base;
+
+    if ( memcmp(hdr->magic, TABLE_MAGIC, sizeof(hdr->magic)) or
+        hdr->version != TABLE_VERSION or hdr->byte_order != TABLE_BYTE_ORDER or
+        hdr->segment_offset > map_size or hdr->segment_size > map_size - hdr->segment_offset or
+        hdr->num_lists > UINT8_MAX or
+        !check_table(base + hdr->segment_offset, hdr->segment_size) )
+    {
+        ErrorMessage("reputation: %s is not a compatible reputation table\n", file);
+        munmap(map, map_size);
+        return false;
+    }
+
+    size_t offset = sizeof(TableHeader);
+    ListFiles lists;
+    bool ok = true;
+
+    for ( uint32_t i = 0; ok and i < hdr->num_lists; i++ )
+    {
+        ListRecord rec;
+
+        if ( offset + sizeof(rec) > hdr->segment_offset )
+        {
+            ok = false;
+            break;
+        }
+        memcpy(&rec, base + offset, sizeof(rec));
+        offset += sizeof(rec);
+
+        if ( rec.num_intfs > (hdr->segment_offset - offset) / sizeof(uint32_t) or
+            offset + rec.num_intfs * sizeof(uint32_t) + rec.name_len > hdr->segment_offset )
+        {
+            ok = false;
+            break;
+        }
+
+        ListFile* list = new ListFile;
+        list->list_id = rec.list_id;
+        list->file_type = rec.file_type;
+        list->all_intfs_enabled = rec.all_intfs_enabled;
+        list->list_index = (uint8_t)i + 1;
+        list->list_type = ReputationParser::get_list_type(rec.file_type, config);
+
+        for ( uint32_t j = 0; j < rec.num_intfs; j++ )
+        {
+            uint32_t id;
+            memcpy(&id, base + offset, sizeof(id));
+            list->intfs.emplace(id);
+            offset += sizeof(id);
+        }
+        list->file_name.assign((const char*)base + offset, rec.name_len);
+        offset += rec.name_len;
+
+        lists.emplace_back(list);
+    }
+
+    if ( !ok )
+    {
+        ErrorMessage("reputation: %s has corrupt list information\n", file);
+
+        for ( auto list : lists )
+            delete list;
+
+        munmap(map, map_size);
+        return false;
+    }
+
+    table_flat_t* table = (table_flat_t*)(base + hdr->segment_offset);
+
+    if ( !config.lookup_trie and (table->mbt or table->mbt6) )
+    {
+        // the segment is page aligned so only the page holding the table
+        // root becomes a private copy; the tries are left unused
+        if ( mprotect(table, sizeof(*table), PROT_READ | PROT_WRITE) )
+        {
+            ErrorMessage("reputation: can't disable trie lookups in %s: %s\n",
+                file, get_error(errno));
+
+            for ( auto list : lists )
+                delete list;
+
+            munmap(map, map_size);
+            return false;
+        }
+        table->mbt = table->mbt6 = 0;
+        mprotect(table, sizeof(*table), PROT_READ);
+    }
+    else if ( config.lookup_trie and !table->mbt and !table->mbt6 )
+        WarningMessage("reputation: %s has no compiled trie; using dir lookups\n", file);
+
+    madvise(map, map_size, MADV_WILLNEED);
+
+    data.list_files.swap(lists);
+    data.table_map = map;
+    data.table_map_size = map_size;
+    data.reputation_segment = (uint8_t*)map + hdr->segment_offset;
+    data.segment_size = hdr->segment_size;
+    data.ip_list = (table_flat_t*)data.reputation_segment;
+    data.num_entries = hdr->num_entries;
+
+    return true;
+}
+
+#ifdef UNIT_TEST
+static int get_list_index(const char* addr, table_flat_t* table)
+{
+    SfIp ip;
+    REQUIRE(ip.set(addr) == SFIP_SUCCESS);
+
+    const IPrepInfo* info = (const IPrepInfo*)sfrt_flat_dir8x_lookup(&ip, table);
+    return info ? info->list_indexes[0] : 0;
+}
+
+static void save_and_load(const char* list_file, bool save_trie, bool load_trie)
+{
+    ReputationConfig config;
+    config.memcap = 16;
+    config.blocklist_path = list_file;
+    config.lookup_trie = save_trie;
+
+    ReputationData data;
+    ReputationParser::add_block_allow_List(config, data);
+    ReputationParser::estimate_num_entries(data);
+
+    ReputationParser parser;
+    parser.ip_list_init(data.num_entries + 1, config, data);
+    REQUIRE(data.ip_list);
+
+    char name[] = "/tmp/reputation_table_XXXXXX";
+    int fd = mkstemp(name);
+    REQUIRE(fd >= 0);
+    close(fd);
+
+    REQUIRE(ReputationTable::save(name, data));
+
+    config.lookup_trie = load_trie;
+    ReputationData loaded;
+    bool ok = ReputationTable::load(name, config, loaded);
+    unlink(name);
+    REQUIRE(ok);
+
+    REQUIRE(loaded.list_files.size() == 1);
+    CHECK(loaded.list_files[0]->file_type == BLOCK_LIST);
+    CHECK(loaded.list_files[0]->list_type == BLOCKED);
+    CHECK(loaded.list_files[0]->all_intfs_enabled);
+    CHECK(loaded.list_files[0]->file_name == list_file);
+    CHECK(loaded.num_entries == data.num_entries);
+
+    // the table file keeps its tries only if both sides want them
+    bool tries = loaded.ip_list->mbt or loaded.ip_list->mbt6;
+    CHECK(tries == (save_trie and load_trie));
+
+    const char* addrs[] =
+    {
+        "10.1.2.3", "10.255.255.255", "11.0.0.1", "192.168.1.1", "192.168.1.2",
+        "2001:db8::1", "2001:db8:ffff::1", "2001:db9::1", "::1"
+    };
+
+    for ( auto addr : addrs )
+        CHECK(get_list_index(addr, loaded.ip_list) == get_list_index(addr, data.ip_list));
+
+    CHECK(get_list_index("10.1.2.3", loaded.ip_list) == 1);
+    CHECK(get_list_index("11.0.0.1", loaded.ip_list) == 0);
+}
+
+TEST_CASE("table file save and load", "[reputation]")
+{
+    char list_file[] = "/tmp/reputation_list_XXXXXX";
+    int fd = mkstemp(list_file);
+    REQUIRE(fd >= 0);
+
+    const char* text = "10.0.0.0/8\n192.168.1.1\n2001:db8::/32\n";
+    REQUIRE(write(fd, text, strlen(text)) == (ssize_t)strlen(text));
+    close(fd);
+
+    save_and_load(list_file, false, false);
+    save_and_load(list_file, false, true);
+    save_and_load(list_file, true, false);
+    save_and_load(list_file, true, true);
+
+    unlink(list_file);
+}
+
+TEST_CASE("table file rejects other files", "[reputation]")
+{
+    char name[] = "/tmp/reputation_table_XXXXXX";
+    int fd = mkstemp(name);
+    REQUIRE(fd >= 0);
+
+    char junk[4096];
+    memset(junk, 'x', sizeof(junk));
+    REQUIRE(write(fd, junk, sizeof(junk)) == (ssize_t)sizeof(junk));
+    close(fd);
+
+    ReputationConfig config;
+    ReputationData data;
+
+    CHECK_FALSE(ReputationTable::load(name, config, data));
+    CHECK(data.ip_list == nullptr);
+
+    unlink(name);
+    CHECK_FALSE(ReputationTable::load(name, config, data));
+}
+#endif
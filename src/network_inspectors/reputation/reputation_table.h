@@ -0,0 +1,39 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef REPUTATION_TABLE_H
+#define REPUTATION_TABLE_H
+
+// ReputationTable saves the compiled reputation lookup table to a file and
+// maps it back read-only.  The sfrt_flat segment only holds offsets so it
+// is written as is, page aligned, after a header and the list information.
+// Loading a table file skips parsing the IP lists altogether and the pages
+// are shared by all processes mapping the same file.
+
+struct ReputationConfig;
+class ReputationData;
+
+class ReputationTable
+{
+public:
+    static bool save(const char* file, const ReputationData&);
+    static bool load(const char* file, const ReputationConfig&, ReputationData&);
+};
+
+#endif
+
@@ -0,0 +1,88 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// batch_tuner.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "batch_tuner.h"
+
+#include <algorithm>
+
+BatchTuner::BatchTuner(unsigned max, unsigned latency_usecs, unsigned max_backoff_usecs) :
+    max_size(max ? max : 1), size(max_size), latency_nsecs((uint64_t)latency_usecs * 1000),
+    max_backoff(max_backoff_usecs)
+{ }
+
+void BatchTuner::update(unsigned requested, unsigned received, uint64_t nsecs)
+{
+    if ( !received )
+        return;
+
+    backoff_usecs = 0;
+    empty_polls = 0;
+
+    // moving average with a weight of 1/8 for the new batch
+    int64_t per_msg = nsecs / received;
+
+    if ( !msg_nsecs )
+        msg_nsecs = per_msg;
+    else
+        msg_nsecs += (per_msg - (int64_t)msg_nsecs) / 8;
+
+    unsigned limit = max_size;
+
+    if ( msg_nsecs and latency_nsecs / msg_nsecs < limit )
+        limit = std::max((unsigned)(latency_nsecs / msg_nsecs), 1u);
+
+    if ( received >= requested )
+        size = std::min(size * 2, limit);
+
+    else
+        size = std::min(std::max(received, size / 2), limit);
+
+    if ( !size )
+        size = 1;
+}
+
+unsigned BatchTuner::backoff()
+{
+    if ( !max_backoff or ++empty_polls <= busy_polls )
+        return 0;
+
+    backoff_usecs = backoff_usecs ? std::min(backoff_usecs * 2, max_backoff) : 1;
+    return backoff_usecs;
+}
+
+unsigned BatchTuner::get_bin(unsigned n)
+{
+    if ( n < 2 )
+        return 0;
+
+    if ( n < 4 )
+        return 1;
+
+    unsigned bin = 2;
+
+    for ( n >>= 4; n and bin < num_bins - 1; n >>= 2 )
+        ++bin;
+
+    return bin;
+}
@@ -0,0 +1,68 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// batch_tuner.h author Cisco
+
+#ifndef BATCH_TUNER_H
+#define BATCH_TUNER_H
+
+// BatchTuner picks the receive batch size for daq.adaptive_batch.  A full
+// batch means messages are queued so the size doubles; a partial batch means
+// the queue was drained so the size drops toward what was received.  The
+// size is capped so a batch is processed within the latency target at the
+// average per message service time.  After a run of empty nonblocking
+// receives the analyzer sleeps for an exponentially increasing backoff.
+
+#include <cstdint>
+
+class BatchTuner
+{
+public:
+    BatchTuner(unsigned max_size, unsigned latency_usecs, unsigned max_backoff_usecs);
+
+    unsigned get_size() const
+    { return size; }
+
+    // after each receive; nsecs is the time to process the received messages
+    void update(unsigned requested, unsigned received, uint64_t nsecs);
+
+    // after an empty nonblocking receive; returns the usecs to sleep
+    unsigned backoff();
+
+    uint64_t get_message_nsecs() const
+    { return msg_nsecs; }
+
+    // the receive size pegs are 1, 2-3, 4-15, 16-63, 64-255, and 256+
+    static const unsigned num_bins = 6;
+    static unsigned get_bin(unsigned size);
+
+    // empty receives before backing off
+    static const unsigned busy_polls = 64;
+
+private:
+    unsigned max_size;
+    unsigned size;
+    uint64_t latency_nsecs;
+    uint64_t msg_nsecs = 0;
+
+    unsigned max_backoff;
+    unsigned backoff_usecs = 0;
+    unsigned empty_polls = 0;
+};
+
+#endif
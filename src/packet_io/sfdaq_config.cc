@@ -67,6 +67,9 @@ SFDAQConfig::SFDAQConfig()
     batch_size = BATCH_SIZE_UNSET;
     mru_size = SNAPLEN_UNSET;
     timeout = TIMEOUT_DEFAULT;
+    adaptive_batch = false;
+    batch_latency = BATCH_LATENCY_DEFAULT;
+    max_backoff = MAX_BACKOFF_DEFAULT;
 }
 
 SFDAQConfig::~SFDAQConfig()
@@ -72,6 +72,9 @@ struct SFDAQConfig
     uint32_t batch_size;
     int mru_size;
     unsigned int timeout;
+    bool adaptive_batch;
+    unsigned batch_latency;
+    unsigned max_backoff;
     std::vector<SFDAQModuleConfig*> module_configs;
 
     /* Constants */
@@ -80,6 +83,8 @@ struct SFDAQConfig
     static constexpr uint32_t BATCH_SIZE_DEFAULT = 64;
     static constexpr int SNAPLEN_DEFAULT = 1518;
     static constexpr unsigned TIMEOUT_DEFAULT = 1000;
+    static constexpr unsigned BATCH_LATENCY_DEFAULT = 500;
+    static constexpr unsigned MAX_BACKOFF_DEFAULT = 100;
 };
 
 #endif
@@ -27,9 +27,11 @@
 #include <cassert>
 
 #include "log/messages.h"
+#include "main/retry_queue.h"
 #include "main/snort_config.h"
 
 #include "active.h"
+#include "batch_tuner.h"
 #include "sfdaq.h"
 #include "sfdaq_config.h"
 #include "trough.h"
@@ -78,6 +80,12 @@ static const Parameter s_params[] =
     { "inputs", Parameter::PT_LIST, input_list_param, nullptr, "input sources" },
     { "snaplen", Parameter::PT_INT, "0:65535", "1518", "set snap length (same as -s)" },
     { "batch_size", Parameter::PT_INT, "1:", "64", "set receive batch size (same as --daq-batch-size)" },
+    { "adaptive_batch", Parameter::PT_BOOL, nullptr, "false",
+      "adjust the receive batch size up to batch_size from queue occupancy and service time" },
+    { "batch_latency", Parameter::PT_INT, "1:max32", "500",
+      "target time to process a receive batch with adaptive_batch (usec)" },
+    { "max_backoff", Parameter::PT_INT, "0:max32", "100",
+      "maximum sleep after empty nonblocking receives with adaptive_batch (usec, 0 = busy poll)" },
     { "modules", Parameter::PT_LIST, daq_module_param, nullptr, "DAQ modules to use" },
 
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
@@ -122,6 +130,18 @@ bool SFDAQModule::set(const char* fqn, Value& v, SnortConfig*)
     {
         config->set_batch_size(v.get_uint32());
     }
+    else if (!strcmp(fqn, "daq.adaptive_batch"))
+    {
+        config->adaptive_batch = v.get_bool();
+    }
+    else if (!strcmp(fqn, "daq.batch_latency"))
+    {
+        config->batch_latency = v.get_uint32();
+    }
+    else if (!strcmp(fqn, "daq.max_backoff"))
+    {
+        config->max_backoff = v.get_uint32();
+    }
     else if (!strcmp(fqn, "daq.modules.name"))
     {
         module_config->name = v.get_string();
@@ -171,6 +191,10 @@ bool SFDAQModule::end(const char* fqn, int idx, SnortConfig* sc)
 }
 
 static_assert(MAX_DAQ_VERDICT == 6, "Verdict peg counts must align with MAX_DAQ_VERDICT");
+static_assert(sizeof(DAQStats::receive_sizes) / sizeof(PegCount) == BatchTuner::num_bins,
+    "Receive size peg counts must align with BatchTuner::num_bins");
+static_assert(sizeof(DAQStats::retry_waits) / sizeof(PegCount) == RetryQueue::num_bins,
+    "Retry wait peg counts must align with RetryQueue::num_bins");
 const PegInfo daq_names[] =
 {
     { CountType::MAX, "pcaps", "total files and interfaces processed" },
@@ -206,6 +230,23 @@ const PegInfo daq_names[] =
     { CountType::SUM, "sof_messages", "start of flow messages received from DAQ" },
     { CountType::SUM, "eof_messages", "end of flow messages received from DAQ" },
     { CountType::SUM, "other_messages", "messages received from DAQ with unrecognized message type" },
+
+    // Must align with BatchTuner::num_bins (one for each, in order)
+    { CountType::SUM, "receives_1", "receives with a batch size of 1" },
+    { CountType::SUM, "receives_2_3", "receives with a batch size of 2 to 3" },
+    { CountType::SUM, "receives_4_15", "receives with a batch size of 4 to 15" },
+    { CountType::SUM, "receives_16_63", "receives with a batch size of 16 to 63" },
+    { CountType::SUM, "receives_64_255", "receives with a batch size of 64 to 255" },
+    { CountType::SUM, "receives_256", "receives with a batch size of 256 or more" },
+    { CountType::SUM, "backoffs", "sleeps after empty nonblocking receives" },
+    { CountType::SUM, "retries_released", "flows with queued retries released when their decision was made" },
+
+    // Must align with RetryQueue::num_bins (one for each, in order)
+    { CountType::SUM, "retry_waits_1ms", "retries processed after waiting less than 1 ms" },
+    { CountType::SUM, "retry_waits_10ms", "retries processed after waiting 1 to 10 ms" },
+    { CountType::SUM, "retry_waits_100ms", "retries processed after waiting 10 to 100 ms" },
+    { CountType::SUM, "retry_waits_1s", "retries processed after waiting 100 ms to 1 s" },
+    { CountType::SUM, "retry_waits_max", "retries processed after waiting 1 s or more" },
     { CountType::END, nullptr, nullptr }
 };
 
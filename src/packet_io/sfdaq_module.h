@@ -79,6 +79,10 @@ struct DAQStats
     PegCount sof_messages;
     PegCount eof_messages;
     PegCount other_messages;
+    PegCount receive_sizes[6];
+    PegCount backoffs;
+    PegCount retries_released;
+    PegCount retry_waits[5];
 };
 
 extern THREAD_LOCAL DAQStats daq_stats;
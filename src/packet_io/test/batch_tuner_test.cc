@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// batch_tuner_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/snort_catch.h"
+#include "packet_io/batch_tuner.h"
+
+TEST_CASE("batch tuner bins", "[BatchTuner]")
+{
+    CHECK(0 == BatchTuner::get_bin(1));
+    CHECK(1 == BatchTuner::get_bin(2));
+    CHECK(1 == BatchTuner::get_bin(3));
+    CHECK(2 == BatchTuner::get_bin(4));
+    CHECK(2 == BatchTuner::get_bin(15));
+    CHECK(3 == BatchTuner::get_bin(16));
+    CHECK(3 == BatchTuner::get_bin(63));
+    CHECK(4 == BatchTuner::get_bin(64));
+    CHECK(4 == BatchTuner::get_bin(255));
+    CHECK(5 == BatchTuner::get_bin(256));
+    CHECK(5 == BatchTuner::get_bin(100000));
+}
+
+TEST_CASE("batch tuner sizing", "[BatchTuner]")
+{
+    // 1 ms target
+    BatchTuner bt(256, 1000, 100);
+    CHECK(256 == bt.get_size());
+
+    SECTION("partial batches shrink toward the queue depth")
+    {
+        for ( int i = 0; i < 10; ++i )
+            bt.update(256, 3, 3000);
+
+        CHECK(3 == bt.get_size());
+
+        SECTION("full batches grow")
+        {
+            bt.update(3, 3, 3000);
+            CHECK(6 == bt.get_size());
+            bt.update(6, 6, 6000);
+            CHECK(12 == bt.get_size());
+        }
+    }
+
+    SECTION("service time caps the size")
+    {
+        // 20 usecs per message allows 50 per ms
+        for ( int i = 0; i < 40; ++i )
+            bt.update(bt.get_size(), bt.get_size(), bt.get_size() * 20000ull);
+
+        CHECK(50 == bt.get_size());
+        CHECK(20000 == bt.get_message_nsecs());
+
+        SECTION("a message slower than the target still gets a batch of 1")
+        {
+            for ( int i = 0; i < 40; ++i )
+                bt.update(bt.get_size(), bt.get_size(), bt.get_size() * 5000000ull);
+
+            CHECK(1 == bt.get_size());
+        }
+    }
+
+    SECTION("nothing received leaves the size")
+    {
+        bt.update(256, 0, 0);
+        CHECK(256 == bt.get_size());
+    }
+}
+
+TEST_CASE("batch tuner backoff", "[BatchTuner]")
+{
+    BatchTuner bt(64, 1000, 100);
+
+    for ( unsigned i = 0; i < BatchTuner::busy_polls; ++i )
+        CHECK(0 == bt.backoff());
+
+    CHECK(1 == bt.backoff());
+    CHECK(2 == bt.backoff());
+    CHECK(4 == bt.backoff());
+
+    for ( int i = 0; i < 10; ++i )
+        bt.backoff();
+
+    CHECK(100 == bt.backoff());
+
+    // anything received goes back to busy polling
+    bt.update(64, 1, 1000);
+    CHECK(0 == bt.backoff());
+
+    SECTION("no backoff")
+    {
+        BatchTuner poll(64, 1000, 0);
+
+        for ( unsigned i = 0; i < 2 * BatchTuner::busy_polls; ++i )
+            CHECK(0 == poll.backoff());
+    }
+}
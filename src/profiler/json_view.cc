@@ -64,6 +64,13 @@ static void print_single_entry(ControlConn* ctrlcon, const rule_stats::View& v,
     json.put("timeouts", v.timeouts());
     json.put("suspends", v.suspends());
     json.put("ruleTimePercentage", v.rule_time_per(total_time_usec), PRECISION);
+
+    if ( v.counts().is_active() )
+    {
+        json.put("ipc", v.counts().ipc(), PRECISION);
+        json.put("cacheMissesPerCheck", v.counts().per(PerfCounts::CACHE_MISSES, v.checks()), PRECISION);
+        json.put("branchMissesPerCheck", v.counts().per(PerfCounts::BRANCH_MISSES, v.checks()), PRECISION);
+    }
     json.close();
 
 
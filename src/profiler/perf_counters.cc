@@ -0,0 +1,301 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// perf_counters.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include "log/messages.h"
+#include "utils/util.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+THREAD_LOCAL bool PerfCounters::enabled = false;
+
+#ifdef __linux__
+
+// PERF_COUNT_HW_CACHE_MISSES is last level cache misses on most cpus
+static const uint64_t hw_events[PerfCounts::MAX] =
+{
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+struct Counter
+{
+    int fd;
+    const volatile perf_event_mmap_page* page;
+};
+
+static THREAD_LOCAL Counter counters[PerfCounts::MAX];
+static THREAD_LOCAL bool use_rdpmc = false;
+static size_t page_size = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+static inline uint64_t rdpmc(uint32_t c)
+{
+    uint32_t lo, hi;
+    asm volatile("rdpmc" : "=a" (lo), "=d" (hi) : "c" (c));
+    return lo | (uint64_t)hi << 32;
+}
+
+// the seqlock protocol from linux/perf_event.h; index is 0 while the
+// counter is not on a pmu and then offset holds the count
+static inline uint64_t read_mapped(const volatile perf_event_mmap_page* pc)
+{
+    uint32_t seq;
+    uint64_t count;
+
+    do
+    {
+        seq = pc->lock;
+        std::atomic_signal_fence(std::memory_order_acquire);
+
+        uint32_t idx = pc->index;
+        count = pc->offset;
+
+        if ( idx )
+        {
+            unsigned shift = 64 - pc->pmc_width;
+            count += (uint64_t)((int64_t)(rdpmc(idx - 1) << shift) >> shift);
+        }
+        std::atomic_signal_fence(std::memory_order_acquire);
+    }
+    while ( pc->lock != seq );
+
+    return count;
+}
+#endif
+
+static void close_counters()
+{
+    for ( auto& c : counters )
+    {
+        if ( c.page )
+            munmap((void*)c.page, page_size);
+
+        if ( c.fd >= 0 )
+            close(c.fd);
+
+        c.fd = -1;
+        c.page = nullptr;
+    }
+    use_rdpmc = false;
+}
+
+static bool open_counters()
+{
+    page_size = sysconf(_SC_PAGESIZE);
+
+    for ( auto& c : counters )
+    {
+        c.fd = -1;
+        c.page = nullptr;
+    }
+
+    use_rdpmc = true;
+
+    for ( unsigned i = 0; i < PerfCounts::MAX; ++i )
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = hw_events[i];
+        attr.disabled = (i == 0);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+
+        int group = i ? counters[0].fd : -1;
+        int fd = syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+
+        if ( fd < 0 )
+        {
+            int err = errno;
+            close_counters();
+            errno = err;
+            return false;
+        }
+        counters[i].fd = fd;
+
+        void* p = mmap(nullptr, page_size, PROT_READ, MAP_SHARED, fd, 0);
+
+        if ( p == MAP_FAILED )
+            use_rdpmc = false;
+        else
+        {
+            counters[i].page = (const volatile perf_event_mmap_page*)p;
+
+            if ( !counters[i].page->cap_user_rdpmc )
+                use_rdpmc = false;
+        }
+    }
+
+#if !defined(__x86_64__) && !defined(__i386__)
+    use_rdpmc = false;
+#endif
+
+    ioctl(counters[0].fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counters[0].fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    return true;
+}
+
+void PerfCounters::read(PerfCounts& pc)
+{
+    if ( !enabled )
+        return;
+
+#if defined(__x86_64__) || defined(__i386__)
+    if ( use_rdpmc )
+    {
+        for ( unsigned i = 0; i < PerfCounts::MAX; ++i )
+            pc.value[i] = read_mapped(counters[i].page);
+        return;
+    }
+#endif
+
+    struct
+    {
+        uint64_t nr;
+        uint64_t values[PerfCounts::MAX];
+    } group;
+
+    if ( ::read(counters[0].fd, &group, sizeof(group)) == (ssize_t)sizeof(group) )
+        memcpy(pc.value, group.values, sizeof(pc.value));
+}
+
+#else
+
+static bool open_counters()
+{
+    errno = ENOTSUP;
+    return false;
+}
+
+static void close_counters()
+{ }
+
+void PerfCounters::read(PerfCounts&)
+{ }
+
+#endif
+
+bool PerfCounters::start()
+{
+    if ( enabled )
+        stop();
+
+    if ( !open_counters() )
+    {
+        // one warning is enough for all the packet threads
+        static std::atomic_flag warned = ATOMIC_FLAG_INIT;
+
+        if ( !warned.test_and_set() )
+            WarningMessage("profiler: hardware counters are not available: %s\n",
+                get_error(errno));
+
+        return false;
+    }
+    enabled = true;
+    return true;
+}
+
+void PerfCounters::stop()
+{
+    if ( !enabled )
+        return;
+
+    close_counters();
+    enabled = false;
+}
+
+#ifdef UNIT_TEST
+
+TEST_CASE("perf counts", "[profiler][perf_counters]")
+{
+    PerfCounts a;
+    a.value[PerfCounts::CYCLES] = 200;
+    a.value[PerfCounts::INSTRUCTIONS] = 300;
+    a.value[PerfCounts::CACHE_MISSES] = 4;
+
+    CHECK( a.is_active() );
+    CHECK( a.ipc() == 1.5 );
+    CHECK( a.per(PerfCounts::CACHE_MISSES, 2) == 2.0 );
+    CHECK( a.per(PerfCounts::CACHE_MISSES, 0) == 0.0 );
+
+    PerfCounts b = a;
+    b += a;
+    CHECK( b.value[PerfCounts::CYCLES] == 400 );
+
+    b -= a;
+    CHECK( b.value[PerfCounts::INSTRUCTIONS] == 300 );
+
+    b.reset();
+    CHECK_FALSE( b.is_active() );
+    CHECK( b.ipc() == 0.0 );
+}
+
+TEST_CASE("perf counters", "[profiler][perf_counters]")
+{
+    // counters may not be available so this just checks they degrade
+    PerfCounts before, after;
+
+    if ( PerfCounters::start() )
+    {
+        PerfCounters::read(before);
+
+        for ( volatile int i = 0; i < 100000; i = i + 1 );
+
+        PerfCounters::read(after);
+        CHECK( after.value[PerfCounts::INSTRUCTIONS] > before.value[PerfCounts::INSTRUCTIONS] );
+        PerfCounters::stop();
+    }
+    CHECK_FALSE( PerfCounters::is_enabled() );
+
+    CounterWatch cw;
+    cw.start();
+    CHECK( cw.active() );
+    CHECK_FALSE( cw.get().is_active() );
+}
+
+#endif
@@ -0,0 +1,132 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// perf_counters.h author Cisco
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// PerfCounters reads hardware event counters for the module and rule
+// profilers.  Each packet thread opens a group of perf_event counters on
+// itself for user space only.  Reads use rdpmc when the kernel allows it,
+// else one read of the group.  If the counters can't be opened the
+// profilers only report time.
+
+#include <cstdint>
+
+#include "main/snort_types.h"
+#include "main/thread.h"
+
+struct PerfCounts
+{
+    enum Event { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, MAX };
+
+    uint64_t value[MAX] = { };
+
+    PerfCounts& operator+=(const PerfCounts& rhs)
+    {
+        for ( unsigned i = 0; i < MAX; ++i )
+            value[i] += rhs.value[i];
+        return *this;
+    }
+
+    PerfCounts& operator-=(const PerfCounts& rhs)
+    {
+        for ( unsigned i = 0; i < MAX; ++i )
+            value[i] -= rhs.value[i];
+        return *this;
+    }
+
+    void reset()
+    { *this = PerfCounts(); }
+
+    bool is_active() const
+    { return value[CYCLES] != 0; }
+
+    double ipc() const
+    { return value[CYCLES] ? double(value[INSTRUCTIONS]) / value[CYCLES] : 0.0; }
+
+    double per(Event e, uint64_t n) const
+    { return n ? double(value[e]) / n : 0.0; }
+};
+
+class SO_PUBLIC PerfCounters
+{
+public:
+    // packet thread; returns false if the counters can't be opened
+    static bool start();
+    static void stop();
+
+    static bool is_enabled()
+    { return enabled; }
+
+    static void read(PerfCounts&);
+
+private:
+    static THREAD_LOCAL bool enabled;
+};
+
+// accumulates counts between start and stop like a Stopwatch
+class CounterWatch
+{
+public:
+    void start()
+    {
+        if ( running )
+            return;
+
+        PerfCounters::read(begin);
+        running = used = true;
+    }
+
+    void stop()
+    {
+        if ( !running )
+            return;
+
+        PerfCounts now;
+        PerfCounters::read(now);
+        now -= begin;
+        total += now;
+        running = false;
+    }
+
+    // start again only if started before
+    void resume()
+    {
+        if ( used )
+            start();
+    }
+
+    bool active() const
+    { return used; }
+
+    const PerfCounts& get()
+    {
+        stop();
+        return total;
+    }
+
+private:
+    PerfCounts begin;
+    PerfCounts total;
+    bool running = false;
+    bool used = false;
+};
+
+#endif
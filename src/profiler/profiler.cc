@@ -34,9 +34,11 @@
 
 #include "memory_context.h"
 #include "memory_profiler.h"
+#include "perf_counters.h"
 #include "profiler_nodes.h"
 #include "rule_profiler.h"
 #include "time_profiler.h"
+#include "time_sampler.h"
 
 #ifdef UNIT_TEST
 #include "catch/snort_catch.h"
@@ -51,6 +53,7 @@ THREAD_LOCAL TimeContext* ProfileContext::curr_time = nullptr;
 THREAD_LOCAL Stopwatch<SnortClock>* run_timer = nullptr;
 THREAD_LOCAL uint64_t first_pkt_num = 0;
 THREAD_LOCAL bool consolidated_once = false;
+static THREAD_LOCAL PerfCounts* run_counts = nullptr;
 
 static ProfilerNodeMap s_profiler_nodes;
 
@@ -81,6 +84,18 @@ void Profiler::start()
     run_timer = new Stopwatch<SnortClock>;
     run_timer->start();
     consolidated_once = false;
+
+    const SnortConfig* sc = SnortConfig::get_conf();
+    const ProfilerConfig* config = sc ? sc->get_profiler() : nullptr;
+    bool sample = config and config->time.sample_rate and TimeProfilerStats::is_enabled();
+
+    TimeProfilerStats::set_sampled(sample and TimeSampler::start(config->time));
+
+    if ( config and config->counters and PerfCounters::start() )
+    {
+        run_counts = new PerfCounts;
+        PerfCounters::read(*run_counts);
+    }
 }
 
 void Profiler::stop(uint64_t checks)
@@ -94,10 +109,29 @@ void Profiler::stop(uint64_t checks)
         delete run_timer;
         run_timer = nullptr;
     }
+
+    // sampled module times are cpu time so the total is too
+    if ( TimeSampler::is_running() )
+        totalPerfStats.time.elapsed = TimeSampler::stop();
+
+    if ( run_counts )
+    {
+        PerfCounts now;
+        PerfCounters::read(now);
+        now -= *run_counts;
+        totalPerfStats.time.counts = now;
+
+        delete run_counts;
+        run_counts = nullptr;
+    }
+    PerfCounters::stop();
 }
 
 void Profiler::consolidate_stats(snort::ProfilerType type)
 {
+    if ( type != snort::PROFILER_TYPE_MEMORY )
+        TimeSampler::consolidate(s_profiler_nodes);
+
     if ( !consolidated_once and type == snort::PROFILER_TYPE_TIME )
     {
         s_profiler_nodes.accumulate_nodes(snort::PROFILER_TYPE_TIME);
@@ -130,6 +164,9 @@ void Profiler::reset_stats(snort::ProfilerType type)
         otherPerfStats.reset();
     }
 
+    if ( type != snort::PROFILER_TYPE_MEMORY )
+        TimeSampler::reset();
+
     s_profiler_nodes.reset_nodes(type);
 }
 
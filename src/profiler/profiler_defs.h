@@ -45,6 +45,9 @@ struct ProfilerConfig
     TimeProfilerConfig time;
     RuleProfilerConfig rule;
     MemoryProfilerConfig memory;
+
+    // read hardware counters in module and rule contexts
+    bool counters = false;
 };
 
 struct SO_PUBLIC ProfileStats
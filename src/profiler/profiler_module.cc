@@ -399,6 +399,13 @@ static const Parameter profiler_time_params[] =
     { "max_depth", Parameter::PT_INT, "-1:255", "-1",
       "limit depth to max_depth (-1 = no limit)" },
 
+    { "sample_rate", Parameter::PT_INT, "0:10000", "0",
+      "estimate time from this many samples per second of packet thread cpu time "
+      "instead of timing every check (0 = time every check)" },
+
+    { "folded", Parameter::PT_BOOL, nullptr, "false",
+      "write sampled module stacks to module_profile.folded for flame graphs" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -447,6 +454,10 @@ static const Parameter profiler_params[] =
     { "rules", Parameter::PT_TABLE, profiler_rule_params, nullptr,
       "rule time profiling" },
 
+    { "counters", Parameter::PT_BOOL, nullptr, "false",
+      "count cycles, instructions, cache misses, and branch misses of profiled modules "
+      "and rules with perf_event (modules only when sample_rate is 0)" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -489,6 +500,21 @@ static bool s_profiler_module_set_max_depth(T& config, Value& v)
 static bool s_profiler_module_set_max_depth(RuleProfilerConfig&, Value&)
 { return false; }
 
+template<typename T>
+static bool s_profiler_module_set_sampling(T&, Value&)
+{ return false; }
+
+static bool s_profiler_module_set_sampling(TimeProfilerConfig& config, Value& v)
+{
+    if ( v.is("sample_rate") )
+        config.sample_rate = v.get_uint32();
+
+    else
+        config.folded = v.get_bool();
+
+    return true;
+}
+
 template<typename T>
 static bool s_profiler_module_set(T& config, Value& v)
 {
@@ -504,6 +530,9 @@ static bool s_profiler_module_set(T& config, Value& v)
     else if ( v.is("max_depth") )
         return s_profiler_module_set_max_depth(config, v);
 
+    else if ( v.is("sample_rate") or v.is("folded") )
+        return s_profiler_module_set_sampling(config, v);
+
     else
         return false;
 
@@ -528,7 +557,13 @@ bool ProfilerModule::set(const char* fqn, Value& v, SnortConfig* sc)
     else if ( !strncmp(fqn, spr, strlen(spr)) )
         return s_profiler_module_set(sc->profiler->rule, v);
 
-    return false;
+    else if ( v.is("counters") )
+        sc->profiler->counters = v.get_bool();
+
+    else
+        return false;
+
+    return true;
 }
 
 bool ProfilerModule::end(const char* fqn, int, SnortConfig* sc)
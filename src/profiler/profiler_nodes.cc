@@ -108,6 +108,9 @@ void ProfilerNode::set(Module* m)
 void ProfilerNode::set(get_profile_stats_fn fn)
 { getter = std::make_shared<GetProfileFromFunction>(name, fn); }
 
+ProfileStats* ProfilerNode::get_local_stats() const
+{ return is_set() ? (*getter)() : nullptr; }
+
 void ProfilerNode::accumulate(snort::ProfilerType type)
 {
     if ( is_set() )
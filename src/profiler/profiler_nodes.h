@@ -46,6 +46,9 @@ public:
     bool is_set() const
     { return bool(getter); }
 
+    // thread local call
+    snort::ProfileStats* get_local_stats() const;
+
     // thread local call
     void accumulate(snort::ProfilerType = snort::PROFILER_TYPE_BOTH);
 
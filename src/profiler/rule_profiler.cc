@@ -211,6 +211,9 @@ void RuleContext::stop(bool match)
 
     finished = true;
     stats.update(sw.get(), match);
+
+    if ( cw.active() )
+        stats.counts += cw.get();
 }
 
 void RuleContext::set_start_time(const struct timeval &time)
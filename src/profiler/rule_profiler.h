@@ -79,6 +79,9 @@ struct View
     uint64_t suspends() const
     { return state.latency_suspends; }
 
+    const PerfCounts& counts() const
+    { return state.counts; }
+
     hr_duration time_per(hr_duration d, uint64_t v) const
     {
         if ( v  == 0 )
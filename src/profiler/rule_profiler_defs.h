@@ -24,6 +24,8 @@
 #include "time/clock_defs.h"
 #include "time/stopwatch.h"
 
+#include "perf_counters.h"
+
 struct dot_node_state_t;
 
 enum OutType
@@ -61,10 +63,18 @@ public:
     { stop(); }
 
     void start()
-    { if ( enabled ) sw.start(); }
+    {
+        if ( !enabled )
+            return;
+
+        sw.start();
+
+        if ( PerfCounters::is_enabled() )
+            cw.start();
+    }
 
     void pause()
-    { if ( enabled ) sw.stop(); }
+    { if ( enabled ) { sw.stop(); cw.stop(); } }
 
     void stop(bool = false);
 
@@ -94,6 +104,7 @@ public:
 private:
     dot_node_state_t& stats;
     Stopwatch<SnortClock> sw;
+    CounterWatch cw;
     bool finished = false;
 
     static THREAD_LOCAL bool enabled;
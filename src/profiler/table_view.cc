@@ -24,6 +24,7 @@
 
 #include "table_view.h"
 
+#include <algorithm>
 #include <sstream>
 #include <vector>
 
@@ -57,9 +58,32 @@ const StatsTable::Field fields[] =
     { nullptr, 0, '\0', 0, std::ios_base::fmtflags() }
 };
 
+// with hardware counters
+const StatsTable::Field counter_fields[] =
+{
+    { "#", 5, '\0', 0, std::ios_base::left },
+    { "gid", 6, '\0', 0, std::ios_base::fmtflags() },
+    { "sid", 6, '\0', 0, std::ios_base::fmtflags() },
+    { "rev", 4, '\0', 0, std::ios_base::fmtflags() },
+    { "checks", 10, '\0', 0, std::ios_base::fmtflags() },
+    { "matches", 8, '\0', 0, std::ios_base::fmtflags() },
+    { "alerts", 7, '\0', 0, std::ios_base::fmtflags() },
+    { "time (us)", 10, '\0', 0, std::ios_base::fmtflags() },
+    { "avg/check", 10, '\0', 1, std::ios_base::fmtflags() },
+    { "avg/match", 10, '\0', 1, std::ios_base::fmtflags() },
+    { "avg/non-match", 14, '\0', 1, std::ios_base::fmtflags() },
+    { "timeouts", 9, '\0', 0, std::ios_base::fmtflags() },
+    { "suspends", 9, '\0', 0, std::ios_base::fmtflags() },
+    { "rule_time (%)", 14, '\0', 5, std::ios_base::fmtflags() },
+    { "ipc", 6, '\0', 2, std::ios_base::fmtflags() },
+    { "llc_miss/check", 15, '\0', 2, std::ios_base::fmtflags() },
+    { "br_miss/check", 14, '\0', 2, std::ios_base::fmtflags() },
+    { nullptr, 0, '\0', 0, std::ios_base::fmtflags() }
+};
+
 // FIXIT-L logic duplicated from ProfilerPrinter
 static void print_single_entry(ControlConn* ctrlcon, const rule_stats::View& v, unsigned n,
-    double total_time_usec)
+    double total_time_usec, bool counters)
 {
     using std::chrono::duration_cast;
     using std::chrono::microseconds;
@@ -67,7 +91,7 @@ static void print_single_entry(ControlConn* ctrlcon, const rule_stats::View& v,
     std::ostringstream ss;
 
     {
-        StatsTable table(fields, ss);
+        StatsTable table(counters ? counter_fields : fields, ss);
 
         table << StatsTable::ROW;
 
@@ -89,6 +113,13 @@ static void print_single_entry(ControlConn* ctrlcon, const rule_stats::View& v,
         table << v.timeouts();
         table << v.suspends();
         table << v.rule_time_per(total_time_usec);
+
+        if ( counters )
+        {
+            table << v.counts().ipc();
+            table << v.counts().per(PerfCounts::CACHE_MISSES, v.checks());
+            table << v.counts().per(PerfCounts::BRANCH_MISSES, v.checks());
+        }
     }
 
     LogRespond(ctrlcon, "%s", ss.str().c_str());
@@ -104,7 +135,10 @@ void print_entries(ControlConn* ctrlcon, std::vector<rule_stats::View>& entries,
     double total_time_usec =
         RuleContext::get_total_time()->tv_sec * 1000000.0 + RuleContext::get_total_time()->tv_usec;
 
-    StatsTable table(fields, ss);
+    bool counters = std::any_of(entries.begin(), entries.end(),
+        [](const rule_stats::View& v) { return v.counts().is_active(); });
+
+    StatsTable table(counters ? counter_fields : fields, ss);
 
     table << StatsTable::SEP;
 
@@ -130,6 +164,6 @@ void print_entries(ControlConn* ctrlcon, std::vector<rule_stats::View>& entries,
         std::partial_sort(entries.begin(), entries.begin() + count, entries.end(), sort);
 
     for ( unsigned i = 0; i < count; ++i )
-        print_single_entry(ctrlcon, entries[i], i + 1, total_time_usec);
+        print_single_entry(ctrlcon, entries[i], i + 1, total_time_usec, counters);
 
 }
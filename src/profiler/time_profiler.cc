@@ -29,7 +29,9 @@
 #include "profiler_printer.h"
 #include "profiler_stats_table.h"
 #include "time_profiler_defs.h"
+#include "time_sampler.h"
 #include "control/control.h"
+#include "main/snort_config.h"
 
 #ifdef UNIT_TEST
 #include "catch/snort_catch.h"
@@ -38,6 +40,7 @@
 using namespace snort;
 
 #define s_time_table_title "module profile"
+#define s_folded_file "module_profile.folded"
 
 // enabled is not in SnortConfig to avoid that ugly dependency
 // enabled is not in TimeContext because declaring it SO_PUBLIC made TimeContext visible
@@ -60,6 +63,23 @@ static const StatsTable::Field fields[] =
     { nullptr, 0, '\0', 0, std::ios_base::fmtflags() }
 };
 
+// with hardware counters
+static const StatsTable::Field counter_fields[] =
+{
+    { "#", 5, ' ', 0, std::ios_base::left },
+    { "module", 24, ' ', 0, std::ios_base::fmtflags() },
+    { "layer", 6, ' ', 0, std::ios_base::fmtflags() },
+    { "checks", 21, ' ', 0, std::ios_base::fmtflags() },
+    { "time(us)", 21, ' ', 0, std::ios_base::fmtflags() },
+    { "avg/check", 21, ' ', 1, std::ios_base::fmtflags() },
+    { "ipc", 6, ' ', 2, std::ios_base::fmtflags() },
+    { "llc_miss/check", 15, ' ', 1, std::ios_base::fmtflags() },
+    { "br_miss/check", 14, ' ', 1, std::ios_base::fmtflags() },
+    { "%/caller", 10, ' ', 2, std::ios_base::fmtflags() },
+    { "%/total", 9, ' ', 2, std::ios_base::fmtflags() },
+    { nullptr, 0, '\0', 0, std::ios_base::fmtflags() }
+};
+
 struct View
 {
     std::string name;
@@ -141,6 +161,17 @@ static void print_fn(StatsTable& t, const View& v)
     t << clock_usecs(TO_USECS(v.avg_check()));
 }
 
+static void print_counters_fn(StatsTable& t, const View& v)
+{
+    print_fn(t, v);
+
+    const PerfCounts& c = v.stats.counts;
+
+    t << c.ipc();
+    t << c.per(PerfCounts::CACHE_MISSES, v.checks());
+    t << c.per(PerfCounts::BRANCH_MISSES, v.checks());
+}
+
 struct s_print_table
 {
     ControlConn* ctrlcon;
@@ -161,8 +192,21 @@ void show_time_profiler_stats(ProfilerNodeMap& nodes, const TimeProfilerConfig&
     print_time_profiler_stats(nodes, config, nullptr);
 }
 
+static void write_folded_stacks(ControlConn* ctrlcon)
+{
+    const SnortConfig* sc = SnortConfig::get_conf();
+    std::string file = !sc->log_dir.empty() ? sc->log_dir : ".";
+    file += "/" s_folded_file;
+
+    if ( TimeSampler::write_folded(file) )
+        LogRespond(ctrlcon, "sampled module stacks written to %s\n", file.c_str());
+}
+
 void print_time_profiler_stats(ProfilerNodeMap& nodes, const TimeProfilerConfig& config, ControlConn* ctrlcon)
 {
+    if ( config.sample_rate and config.folded )
+        write_folded_stacks(ctrlcon);
+
     ProfilerBuilder<time_stats::View> builder(time_stats::include_fn);
     auto root = builder.build(nodes.get_root());
 
@@ -172,6 +216,15 @@ void print_time_profiler_stats(ProfilerNodeMap& nodes, const TimeProfilerConfig&
     const auto& sorter = time_stats::sorters[config.sort];
     const auto& printer_t = time_stats::s_print_table(ctrlcon);
 
+    // the total has counts if any thread had counters
+    if ( root.view.stats.counts.is_active() )
+    {
+        ProfilerPrinter<time_stats::View> printer(time_stats::counter_fields,
+            time_stats::print_counters_fn, sorter, printer_t);
+        printer.print_table(s_time_table_title, root, config.count, config.max_depth);
+        return;
+    }
+
     ProfilerPrinter<time_stats::View> printer(time_stats::fields, time_stats::print_fn, sorter, printer_t);
     printer.print_table(s_time_table_title, root, config.count, config.max_depth);
 }
@@ -21,10 +21,15 @@
 #ifndef TIME_PROFILER_DEFS_H
 #define TIME_PROFILER_DEFS_H
 
+#include <atomic>
+
 #include "main/snort_types.h"
+#include "main/thread.h"
 #include "time/clock_defs.h"
 #include "time/stopwatch.h"
 
+#include "perf_counters.h"
+
 struct TimeProfilerConfig
 {
     enum Sort
@@ -38,6 +43,10 @@ struct TimeProfilerConfig
     bool show = false;
     unsigned count = 0;
     int max_depth = -1;
+
+    // samples per second of packet thread cpu time; 0 times every check
+    unsigned sample_rate = 0;
+    bool folded = false;
 };
 
 namespace snort
@@ -46,8 +55,10 @@ struct SO_PUBLIC TimeProfilerStats
 {
     hr_duration elapsed;
     uint64_t checks;
+    PerfCounts counts;
     mutable unsigned int ref_count;
     static THREAD_LOCAL bool enabled;
+    static THREAD_LOCAL bool sampled;
 
     static void set_enabled(bool b)
     { enabled = b; }
@@ -55,11 +66,18 @@ struct SO_PUBLIC TimeProfilerStats
     static bool is_enabled()
     { return enabled; }
 
+    // elapsed is charged by the sampler instead of read from the clock
+    static void set_sampled(bool b)
+    { sampled = b; }
+
+    static bool is_sampled()
+    { return sampled; }
+
     void update(hr_duration delta)
     { elapsed += delta; ++checks; }
 
     void reset()
-    { elapsed = 0_ticks; checks = 0; }
+    { elapsed = 0_ticks; checks = 0; counts.reset(); }
 
     bool is_active() const
     { return ( elapsed > CLOCK_ZERO ) || checks; }
@@ -88,43 +106,100 @@ inline TimeProfilerStats& operator+=(TimeProfilerStats& lhs, const TimeProfilerS
 {
     lhs.elapsed += rhs.elapsed;
     lhs.checks += rhs.checks;
+    lhs.counts += rhs.counts;
     return lhs;
 }
 
+// the stats of the active contexts when time is sampled; the sampler's
+// signal is handled on the same thread so the stack isn't locked
+struct SO_PUBLIC TimeSampleStack
+{
+    static const unsigned max_depth = 32;
+
+    static THREAD_LOCAL TimeProfilerStats* frames[max_depth];
+    static THREAD_LOCAL unsigned depth;
+
+    static int push(TimeProfilerStats& stats)
+    {
+        unsigned d = depth;
+
+        if ( d < max_depth )
+            frames[d] = &stats;
+
+        std::atomic_signal_fence(std::memory_order_release);
+        depth = d + 1;
+        return d;
+    }
+
+    static void pop(int d)
+    { depth = d; }
+};
+
 class TimeContext
 {
 public:
     TimeContext(TimeProfilerStats& stats) :
         stats(stats)
     {
-        if ( stats.is_enabled() and stats.enter() )
+        if ( !stats.is_enabled() )
+            return;
+
+        if ( stats.is_sampled() )
+        {
+            if ( stats.enter() )
+                ++stats.checks;
+
+            sample_depth = TimeSampleStack::push(stats);
+        }
+        else if ( stats.enter() )
+        {
             sw.start();
+
+            if ( PerfCounters::is_enabled() )
+                cw.start();
+        }
     }
 
     ~TimeContext()
     {
-        if ( stats.is_enabled() )
+        if ( stats.is_enabled() or sample_depth >= 0 )
             stop();
     }
 
     // Use this for finer grained control of the TimeContext "lifetime"
     void stop()
     {
-        if ( !stats.is_enabled() or stopped_once )
+        if ( stopped_once )
             return; // stop() should only be executed once per context
 
+        if ( sample_depth >= 0 )
+        {
+            stopped_once = true;
+            TimeSampleStack::pop(sample_depth);
+            stats.exit();
+            return;
+        }
+
+        if ( !stats.is_enabled() )
+            return;
+
         stopped_once = true;
 
         // don't bother updating time if context is reentrant
         if ( stats.exit() )
+        {
             stats.update(sw.get());
+
+            if ( cw.active() )
+                stats.counts += cw.get();
+        }
     }
 
     void pause()
-    { sw.stop(); }
+    { sw.stop(); cw.stop(); }
 
     void resume()
-    { sw.start(); }
+    { sw.start(); cw.resume(); }
 
     bool active() const
     { return !stopped_once; }
@@ -132,6 +207,8 @@ public:
 private:
     TimeProfilerStats& stats;
     Stopwatch<SnortClock> sw;
+    CounterWatch cw;
+    int sample_depth = -1;
     bool stopped_once = false;
 };
 
@@ -150,6 +227,7 @@ public:
             return;
         ctx.stop();
         stats.elapsed -= tmp.elapsed;
+        stats.counts -= tmp.counts;
     }
 
 private:
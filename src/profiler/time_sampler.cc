@@ -0,0 +1,359 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// time_sampler.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "time_sampler.h"
+
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include "log/messages.h"
+#include "main/thread.h"
+#include "utils/util.h"
+
+#include "profiler_nodes.h"
+#include "time_profiler_defs.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+#define SAMPLE_SIGNAL SIGPROF
+
+// deeper stacks are truncated in the folded output
+#define FOLDED_DEPTH 16
+#define FOLDED_SLOTS 1024
+#define FOLDED_PROBES 16
+
+THREAD_LOCAL bool TimeProfilerStats::sampled = false;
+THREAD_LOCAL TimeProfilerStats* TimeSampleStack::frames[TimeSampleStack::max_depth];
+THREAD_LOCAL unsigned TimeSampleStack::depth = 0;
+
+struct FoldedStack
+{
+    uint64_t count;
+    unsigned depth;
+    const TimeProfilerStats* frames[FOLDED_DEPTH];
+};
+
+struct FoldedTable
+{
+    FoldedStack stacks[FOLDED_SLOTS];
+    uint64_t lost;
+};
+
+static THREAD_LOCAL bool running = false;
+static THREAD_LOCAL hr_duration period;
+static THREAD_LOCAL uint64_t samples = 0;
+static THREAD_LOCAL FoldedTable* folded_table = nullptr;
+
+#ifdef __linux__
+static THREAD_LOCAL timer_t timer;
+#endif
+
+static std::mutex folded_mutex;
+static std::map<std::string, uint64_t> folded_stacks;
+
+//-------------------------------------------------------------------------
+// signal context
+//-------------------------------------------------------------------------
+
+static void add_folded(FoldedTable* t, TimeProfilerStats* const* frames, unsigned n)
+{
+    n = std::min(n, (unsigned)FOLDED_DEPTH);
+    uint64_t h = 0xcbf29ce484222325ull;
+
+    for ( unsigned i = 0; i < n; ++i )
+        h = (h ^ (uintptr_t)frames[i]) * 0x100000001b3ull;
+
+    for ( unsigned p = 0; p < FOLDED_PROBES; ++p )
+    {
+        FoldedStack& fs = t->stacks[(h + p) % FOLDED_SLOTS];
+
+        if ( !fs.count )
+        {
+            fs.depth = n;
+            std::copy(frames, frames + n, fs.frames);
+            fs.count = 1;
+            return;
+        }
+        if ( fs.depth == n and std::equal(frames, frames + n, fs.frames) )
+        {
+            ++fs.count;
+            return;
+        }
+    }
+    ++t->lost;
+}
+
+void TimeSampler::sample()
+{
+    if ( !running )
+        return;
+
+    std::atomic_signal_fence(std::memory_order_acquire);
+
+    unsigned n = std::min(TimeSampleStack::depth, TimeSampleStack::max_depth);
+    TimeProfilerStats* const* frames = TimeSampleStack::frames;
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        // charge reentered contexts once
+        unsigned j = 0;
+
+        while ( j < i and frames[j] != frames[i] )
+            ++j;
+
+        if ( j == i )
+            frames[i]->elapsed += period;
+    }
+    ++samples;
+
+    if ( folded_table )
+        add_folded(folded_table, frames, n);
+}
+
+static void on_signal(int)
+{ TimeSampler::sample(); }
+
+//-------------------------------------------------------------------------
+// packet thread
+//-------------------------------------------------------------------------
+
+#ifdef __linux__
+static bool start_timer(unsigned rate)
+{
+    static std::once_flag once;
+    std::call_once(once, []()
+    {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = on_signal;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SAMPLE_SIGNAL, &sa, nullptr);
+    });
+
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SAMPLE_SIGNAL;
+    sev.sigev_notify_thread_id = syscall(SYS_gettid);
+
+    if ( timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &timer) )
+        return false;
+
+    long nsecs = 1000000000L / rate;
+
+    struct itimerspec its;
+    its.it_interval.tv_sec = nsecs / 1000000000L;
+    its.it_interval.tv_nsec = nsecs % 1000000000L;
+    its.it_value = its.it_interval;
+
+    if ( timer_settime(timer, 0, &its, nullptr) )
+    {
+        timer_delete(timer);
+        return false;
+    }
+    return true;
+}
+
+static void stop_timer()
+{ timer_delete(timer); }
+
+#else
+static bool start_timer(unsigned)
+{ return false; }
+
+static void stop_timer()
+{ }
+#endif
+
+bool TimeSampler::start(const TimeProfilerConfig& config)
+{
+    if ( running )
+        stop();
+
+    period = TO_DURATION(period, clock_ticks(1000000L / config.sample_rate));
+    samples = 0;
+    TimeSampleStack::depth = 0;
+
+    if ( config.folded )
+    {
+        if ( !folded_table )
+            folded_table = new FoldedTable;
+
+        memset(folded_table, 0, sizeof(*folded_table));
+    }
+
+    running = true;
+
+    if ( !start_timer(config.sample_rate) )
+    {
+        running = false;
+        WarningMessage("profiler: can't start the sample timer: %s; timing every check\n",
+            get_error(errno));
+        return false;
+    }
+    return true;
+}
+
+hr_duration TimeSampler::stop()
+{
+    if ( running )
+    {
+        stop_timer();
+        running = false;
+    }
+    return hr_duration(period * samples);
+}
+
+bool TimeSampler::is_running()
+{ return running; }
+
+void TimeSampler::consolidate(ProfilerNodeMap& nodes)
+{
+    if ( !folded_table )
+        return;
+
+    // the thread local stats of each node are only known on this thread
+    std::unordered_map<const TimeProfilerStats*, const std::string*> names;
+
+    for ( const auto& it : nodes )
+    {
+        const ProfileStats* ps = it.second.get_local_stats();
+
+        if ( ps )
+            names[&ps->time] = &it.second.name;
+    }
+
+    std::lock_guard<std::mutex> lock(folded_mutex);
+
+    for ( const auto& fs : folded_table->stacks )
+    {
+        if ( !fs.count )
+            continue;
+
+        // contexts that aren't registered nodes are left out
+        std::string key = ROOT_NODE;
+
+        for ( unsigned i = 0; i < fs.depth; ++i )
+        {
+            auto n = names.find(fs.frames[i]);
+
+            if ( n != names.end() )
+                key += ";" + *n->second;
+        }
+        folded_stacks[key] += fs.count;
+    }
+
+    if ( folded_table->lost )
+        folded_stacks[ROOT_NODE ";[lost]"] += folded_table->lost;
+
+    delete folded_table;
+    folded_table = nullptr;
+}
+
+void TimeSampler::reset()
+{
+    std::lock_guard<std::mutex> lock(folded_mutex);
+    folded_stacks.clear();
+}
+
+bool TimeSampler::write_folded(const std::string& file)
+{
+    std::lock_guard<std::mutex> lock(folded_mutex);
+    std::ofstream out(file);
+
+    for ( const auto& fs : folded_stacks )
+        out << fs.first << ' ' << fs.second << '\n';
+
+    out.close();
+
+    if ( !out )
+    {
+        ErrorMessage("profiler: can't write %s\n", file.c_str());
+        return false;
+    }
+    return true;
+}
+
+#ifdef UNIT_TEST
+
+TEST_CASE( "time sample stack", "[profiler][time_sampler]" )
+{
+    TimeProfilerStats a, b;
+    TimeProfilerStats::set_enabled(true);
+    TimeProfilerStats::set_sampled(true);
+
+    period = TO_DURATION(period, clock_ticks(1000));
+    running = true;
+
+    {
+        TimeContext ca(a);
+        {
+            TimeContext cb(b);
+            {
+                TimeContext ca2(a);
+                CHECK( TimeSampleStack::depth == 3 );
+                TimeSampler::sample();
+            }
+            CHECK( TimeSampleStack::depth == 2 );
+            TimeSampler::sample();
+        }
+        TimeSampler::sample();
+    }
+    CHECK( TimeSampleStack::depth == 0 );
+    TimeSampler::sample();
+
+    // a is charged once per sample while reentered
+    CHECK( (a.elapsed == 3 * period) );
+    CHECK( (b.elapsed == 2 * period) );
+
+    CHECK( a.checks == 1 );
+    CHECK( b.checks == 1 );
+    CHECK( a.ref_count == 0 );
+
+    running = false;
+    CHECK( (TimeSampler::stop() == 4 * period) );
+
+    TimeProfilerStats::set_sampled(false);
+    TimeProfilerStats::set_enabled(false);
+}
+
+#endif
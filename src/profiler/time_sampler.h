@@ -0,0 +1,58 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// time_sampler.h author Cisco
+
+#ifndef TIME_SAMPLER_H
+#define TIME_SAMPLER_H
+
+// TimeSampler estimates module time from a per thread cpu time timer.  Each
+// signal charges one period to the stats of every context on the thread's
+// TimeSampleStack and, if folded stacks are enabled, counts the stack in a
+// fixed size per thread table which is resolved to module names when the
+// thread's stats are consolidated.
+
+#include <string>
+
+#include "time/clock_defs.h"
+
+class ProfilerNodeMap;
+struct TimeProfilerConfig;
+
+class TimeSampler
+{
+public:
+    // packet thread; returns false if the timer can't be started
+    static bool start(const TimeProfilerConfig&);
+
+    // returns the sampled run time
+    static hr_duration stop();
+
+    static bool is_running();
+
+    // packet thread, after stop
+    static void consolidate(ProfilerNodeMap&);
+
+    static void reset();
+    static bool write_folded(const std::string& file);
+
+    // the signal handler
+    static void sample();
+};
+
+#endif
@@ -29,6 +29,7 @@
 #include "codecs/codec_module.h"
 #include "codecs/ip/checksum.h"
 #include "detection/detection_engine.h"
+#include "latency/stage_latency.h"
 #include "log/text_log.h"
 #include "main/snort_config.h"
 #include "packet_io/active.h"
@@ -215,6 +216,7 @@ void PacketManager::decode(
     Packet* p, const DAQ_PktHdr_t* pkthdr, const uint8_t* pkt, uint32_t pktlen, bool cooked, bool retry)
 {
     Profile profile(decodePerfStats);
+    StageLatency::Context stage_latency_ctx(StageLatency::DECODE);
 
     DecodeData unsure_encap_ptrs;
 
@@ -25,6 +25,7 @@
 #include "sfrt/sfrt_flat.h"
 
 #include "sfip/sf_cidr.h"
+#include "sfrt/sfrt_flat_mbt.h"
 
 using namespace snort;
 
@@ -92,6 +93,8 @@ void RtTable::sfrt_flat_new(char table_flat_type, char ip_type,  long data_size,
     /* This will point to the actual table lookup algorithm */
     table->rt = 0;
     table->rt6 = 0;
+    table->mbt = 0;
+    table->mbt6 = 0;
 
     /* index 0 will be used for failed lookups, so set this to 1 */
     table->num_ent = 1;
@@ -221,6 +224,10 @@ return_codes RtTable::sfrt_flat_insert(SfCidr* cidr, unsigned char len, INFO ptr
         return RT_INSERT_FAILURE;
     }
 
+    /* Compiled tries no longer match, fall back to DIR lookups */
+    table->mbt = 0;
+    table->mbt6 = 0;
+
     const SfIp* ip = cidr->get_addr();
     TABLE_PTR rt;
     int numAddrDwords;
@@ -334,6 +341,61 @@ uint32_t RtTable::sfrt_flat_usage() const
 /* Perform a lookup on value contained in "ip"
  * For performance reason, we use this simplified version instead of sfrt_lookup
  * Note: this only applied to table setting: DIR_8x16 (DIR_16_8_4x2 for IPV4), DIR_8x4*/
+static inline INFO mbt_leaf(const uint8_t* base, const mbt_flat_t* mbt,
+    const mbt_node_flat_t* node, const uint64_t* key, unsigned off)
+{
+    const INFO* leaves = (const INFO*)&base[mbt->leaves];
+    uint64_t below = (2ull << mbt_key_bits(key, off, MBT_STRIDE)) - 1;
+    return leaves[node->base0 + mbt_popcount(node->leafvec & below) - 1];
+}
+
+// returns the next node or nullptr if the key ends at a leaf in this node
+static inline const mbt_node_flat_t* mbt_next(const uint8_t* base, const mbt_flat_t* mbt,
+    const mbt_node_flat_t* node, const uint64_t* key, unsigned off)
+{
+    uint64_t bit = 1ull << mbt_key_bits(key, off, MBT_STRIDE);
+
+    if ( !(node->vector & bit) )
+        return nullptr;
+
+    const mbt_node_flat_t* nodes = (const mbt_node_flat_t*)&base[mbt->nodes];
+    return &nodes[node->base1 + mbt_popcount(node->vector & ((bit << 1) - 1)) - 1];
+}
+
+static inline INFO mbt_lookup(const uint8_t* base, const mbt_flat_t* mbt, const SfIp* ip)
+{
+    uint64_t key[2];
+    mbt_make_key(ip, key);
+
+    const uint32_t* direct = (const uint32_t*)&base[mbt->direct];
+    uint32_t d = direct[key[0] >> (64 - MBT_DIRECT_BITS)];
+    INFO index;
+
+    if ( d & MBT_LEAF )
+        index = d & ~MBT_LEAF;
+    else
+    {
+        const mbt_node_flat_t* nodes = (const mbt_node_flat_t*)&base[mbt->nodes];
+        const mbt_node_flat_t* node = &nodes[d];
+        unsigned off = MBT_DIRECT_BITS;
+
+        while ( const mbt_node_flat_t* next = mbt_next(base, mbt, node, key, off) )
+        {
+            node = next;
+            off += MBT_STRIDE;
+        }
+        index = mbt_leaf(base, mbt, node, key, off);
+    }
+    return index;
+}
+
+static inline const mbt_flat_t* get_mbt(const uint8_t* base, const table_flat_t* table,
+    const SfIp* ip)
+{
+    TABLE_PTR mbt = ip->is_ip4() ? table->mbt : table->mbt6;
+    return mbt ? (const mbt_flat_t*)&base[mbt] : nullptr;
+}
+
 GENERIC sfrt_flat_dir8x_lookup(const SfIp* ip, table_flat_t* table)
 {
     dir_sub_table_flat_t* subtable;
@@ -344,6 +406,12 @@ GENERIC sfrt_flat_dir8x_lookup(const SfIp* ip, table_flat_t* table)
     int index;
     INFO* data = (INFO*)(&base[table->data]);
 
+    if ( const mbt_flat_t* mbt = get_mbt(base, table, ip) )
+    {
+        INFO mbt_index = mbt_lookup(base, mbt, ip);
+        return data[mbt_index] ? (GENERIC)&base[data[mbt_index]] : nullptr;
+    }
+
     if (ip->is_ip4())
     {
         rt = (dir_table_flat_t*)(&base[table->rt]);
@@ -416,6 +484,102 @@ GENERIC sfrt_flat_dir8x_lookup(const SfIp* ip, table_flat_t* table)
     return nullptr;
 }
 
+void sfrt_flat_dir8x_lookup(const SfIp* const ips[], GENERIC results[], unsigned n,
+    table_flat_t* table)
+{
+    for ( ; n > SFRT_MAX_BATCH; n -= SFRT_MAX_BATCH )
+    {
+        sfrt_flat_dir8x_lookup(ips, results, SFRT_MAX_BATCH, table);
+        ips += SFRT_MAX_BATCH;
+        results += SFRT_MAX_BATCH;
+    }
+
+    struct Walk
+    {
+        const mbt_flat_t* mbt;
+        const mbt_node_flat_t* node;
+        uint64_t key[2];
+        unsigned off;
+        INFO index;
+    } walks[SFRT_MAX_BATCH];
+
+    const uint8_t* base = (const uint8_t*)table;
+    const INFO* data = (const INFO*)&base[table->data];
+    unsigned pending = 0;
+
+    for ( unsigned i = 0; i < n; i++ )
+    {
+        Walk& w = walks[i];
+        w.mbt = get_mbt(base, table, ips[i]);
+        w.node = nullptr;
+
+        if ( !w.mbt )
+        {
+            results[i] = sfrt_flat_dir8x_lookup(ips[i], table);
+            continue;
+        }
+        mbt_make_key(ips[i], w.key);
+        const uint32_t* direct = (const uint32_t*)&base[w.mbt->direct];
+        __builtin_prefetch(&direct[w.key[0] >> (64 - MBT_DIRECT_BITS)]);
+    }
+
+    for ( unsigned i = 0; i < n; i++ )
+    {
+        Walk& w = walks[i];
+
+        if ( !w.mbt )
+            continue;
+
+        const uint32_t* direct = (const uint32_t*)&base[w.mbt->direct];
+        uint32_t d = direct[w.key[0] >> (64 - MBT_DIRECT_BITS)];
+
+        if ( d & MBT_LEAF )
+            w.index = d & ~MBT_LEAF;
+        else
+        {
+            const mbt_node_flat_t* nodes = (const mbt_node_flat_t*)&base[w.mbt->nodes];
+            w.node = &nodes[d];
+            w.off = MBT_DIRECT_BITS;
+            __builtin_prefetch(w.node);
+            pending++;
+        }
+    }
+
+    // step the walks in turn so their cache misses overlap
+    while ( pending )
+    {
+        for ( unsigned i = 0; i < n; i++ )
+        {
+            Walk& w = walks[i];
+
+            if ( !w.node )
+                continue;
+
+            if ( const mbt_node_flat_t* next = mbt_next(base, w.mbt, w.node, w.key, w.off) )
+            {
+                __builtin_prefetch(next);
+                w.node = next;
+                w.off += MBT_STRIDE;
+            }
+            else
+            {
+                w.index = mbt_leaf(base, w.mbt, w.node, w.key, w.off);
+                w.node = nullptr;
+                pending--;
+            }
+        }
+    }
+
+    for ( unsigned i = 0; i < n; i++ )
+    {
+        if ( walks[i].mbt )
+        {
+            INFO index = walks[i].index;
+            results[i] = data[index] ? (GENERIC)&base[data[index]] : nullptr;
+        }
+    }
+}
+
 /***************************************************************************
  * allocate memory block from segment
  * todo:currently, we only allocate memory continuously. Need to reuse freed
@@ -64,11 +64,19 @@ struct table_flat_t
     TABLE_PTR rt;           // Actual "routing" table
     TABLE_PTR rt6;          // Actual "routing" table
     TABLE_PTR list_info;    // List file information table (entry information)
+    TABLE_PTR mbt;          // Compressed trie compiled from rt, if any
+    TABLE_PTR mbt6;         // Compressed trie compiled from rt6, if any
 };
 /*******************************************************************/
 
 GENERIC sfrt_flat_dir8x_lookup(const snort::SfIp* ip, table_flat_t* table);
 
+// look up n addresses at once, interleaving the memory accesses of each
+// lookup; results[i] is set to the result for ips[i]
+#define SFRT_MAX_BATCH 8
+void sfrt_flat_dir8x_lookup(const snort::SfIp* const ips[], GENERIC results[], unsigned n,
+    table_flat_t* table);
+
 struct IPLOOKUP;
 struct RtTable
 {
@@ -78,6 +86,12 @@ struct RtTable
     return_codes sfrt_flat_insert(snort::SfCidr* cidr, unsigned char len, INFO ptr, int behavior,
         updateEntryInfoFunc, void* update_entry_info_data);
     unsigned sfrt_flat_usage() const;
+
+    // build compressed tries for lookups once all entries are inserted;
+    // lookups use the DIR tables for any family that can't be compiled
+    // and inserting again drops the tries
+    bool sfrt_flat_compile();
+
     unsigned sfrt_flat_num_entries() const;
     table_flat_t* get_table() const
     { return table; }
@@ -90,12 +104,18 @@ struct RtTable
     }
     MEM_OFFSET segment_snort_calloc(size_t num, size_t size);
 
+    // bytes of the segment in use; the segment is position independent
+    // so [base, base + used) can be saved and mapped elsewhere
+    size_t segment_used() const
+    { return unused_ptr; }
+
 protected:
     TABLE_PTR sfrt_dir_flat_new(uint32_t mem_cap, int count, ...);
     tuple_flat_t sfrt_dir_flat_lookup(const uint32_t* addr, int numAddrDwords, TABLE_PTR table_ptr);
     return_codes sfrt_dir_flat_insert(const uint32_t* addr, int numAddrDwords, int len, word data_index,
         int behavior, TABLE_PTR, updateEntryInfoFunc updateEntry, void* update_entry_info_data, INFO *data);
     uint32_t sfrt_dir_flat_usage(TABLE_PTR) const;
+    TABLE_PTR sfrt_mbt_flat_new(TABLE_PTR rt);
     TABLE_PTR _sub_table_flat_new(dir_table_flat_t* root, uint32_t dimension, uint32_t prefill, uint32_t bit_length);
     return_codes _dir_sub_insert(IPLOOKUP* ip, int length, int cur_len, INFO ptr,
         int current_depth, int behavior, SUB_TABLE_PTR sub_ptr, dir_table_flat_t* root_table,
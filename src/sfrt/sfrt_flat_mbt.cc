@@ -0,0 +1,306 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "sfrt/sfrt_flat_mbt.h"
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "sfrt/sfrt_flat.h"
+
+// The builder asks of each child of a node whether the DIR table maps
+// every address under it to the same data index.  If so the child is a
+// leaf, else it is a node and is built in turn.  A cursor tracks the
+// deepest DIR sub table that covers the current prefix so that each probe
+// only looks at the entries under that prefix.
+
+#define MBT_MIXED UINT32_MAX
+
+class MbtBuilder
+{
+public:
+    MbtBuilder(const uint8_t* base, const dir_table_flat_t* rt) : base(base), rt(rt)
+    { }
+
+    void build();
+
+    std::vector<uint32_t> direct;
+    std::vector<mbt_node_flat_t> nodes;
+    std::vector<INFO> leaves;
+
+private:
+    struct Cursor
+    {
+        MEM_OFFSET sub;
+        int level;
+        unsigned start;
+    };
+
+    const DIR_Entry* get_entries(MEM_OFFSET sub) const
+    {
+        const dir_sub_table_flat_t* t = (const dir_sub_table_flat_t*)&base[sub];
+        return (const DIR_Entry*)&base[t->entries];
+    }
+
+    static bool is_leaf(const DIR_Entry& e)
+    { return !e.value or e.length; }
+
+    static void set_key_bits(uint64_t* key, unsigned off, unsigned n, unsigned v);
+
+    uint32_t uniform(MEM_OFFSET sub, int level);
+    uint32_t uniform(MEM_OFFSET sub, int level, unsigned first, unsigned count);
+    uint32_t probe(const uint64_t* key, unsigned len, Cursor);
+    Cursor advance(const uint64_t* key, unsigned len, Cursor) const;
+    void build_node(uint32_t node, const uint64_t* key, unsigned off, Cursor);
+
+    const uint8_t* base;
+    const dir_table_flat_t* rt;
+    std::unordered_map<MEM_OFFSET, uint32_t> memo;
+};
+
+void MbtBuilder::set_key_bits(uint64_t* key, unsigned off, unsigned n, unsigned v)
+{
+    for ( unsigned i = 0; i < n and off + i < 128; i++ )
+    {
+        unsigned b = off + i;
+
+        if ( v & (1u << (n - 1 - i)) )
+            key[b / 64] |= 1ull << (63 - b % 64);
+    }
+}
+
+// the data index of all entries in the sub table or MBT_MIXED
+uint32_t MbtBuilder::uniform(MEM_OFFSET sub, int level)
+{
+    auto it = memo.find(sub);
+
+    if ( it != memo.end() )
+        return it->second;
+
+    uint32_t val = uniform(sub, level, 0, 1u << rt->dimensions[level]);
+    memo[sub] = val;
+    return val;
+}
+
+uint32_t MbtBuilder::uniform(MEM_OFFSET sub, int level, unsigned first, unsigned count)
+{
+    const DIR_Entry* entries = get_entries(sub);
+    uint32_t val = MBT_MIXED;
+
+    for ( unsigned i = first; i < first + count; i++ )
+    {
+        uint32_t v;
+
+        if ( is_leaf(entries[i]) )
+            v = entries[i].value;
+
+        else if ( level + 1 >= rt->dim_size )
+            return MBT_MIXED;
+
+        else
+            v = uniform(entries[i].value, level + 1);
+
+        if ( v == MBT_MIXED or (val != MBT_MIXED and v != val) )
+            return MBT_MIXED;
+
+        val = v;
+    }
+    return val;
+}
+
+// the data index of all addresses starting with the first len bits of key
+// or MBT_MIXED
+uint32_t MbtBuilder::probe(const uint64_t* key, unsigned len, Cursor c)
+{
+    while ( c.level < rt->dim_size )
+    {
+        unsigned width = rt->dimensions[c.level];
+
+        if ( len <= c.start )
+            return uniform(c.sub, c.level);
+
+        if ( len < c.start + width )
+        {
+            unsigned fixed = len - c.start;
+            unsigned first = mbt_key_bits(key, c.start, fixed) << (width - fixed);
+            return uniform(c.sub, c.level, first, 1u << (width - fixed));
+        }
+
+        const DIR_Entry& e = get_entries(c.sub)[mbt_key_bits(key, c.start, width)];
+
+        if ( is_leaf(e) )
+            return e.value;
+
+        c.sub = e.value;
+        c.start += width;
+        c.level++;
+    }
+    return MBT_MIXED;
+}
+
+// move down to the deepest sub table covering the first len bits of key
+MbtBuilder::Cursor MbtBuilder::advance(const uint64_t* key, unsigned len, Cursor c) const
+{
+    while ( c.level + 1 < rt->dim_size )
+    {
+        unsigned width = rt->dimensions[c.level];
+
+        if ( c.start + width > len )
+            break;
+
+        const DIR_Entry& e = get_entries(c.sub)[mbt_key_bits(key, c.start, width)];
+
+        if ( is_leaf(e) )
+            break;
+
+        c.sub = e.value;
+        c.start += width;
+        c.level++;
+    }
+    return c;
+}
+
+void MbtBuilder::build_node(uint32_t node, const uint64_t* key, unsigned off, Cursor c)
+{
+    const unsigned fanout = 1u << MBT_STRIDE;
+    uint32_t vals[fanout];
+    uint64_t child_key[fanout][2];
+
+    c = advance(key, off, c);
+
+    uint64_t vector = 0;
+    uint64_t leafvec = 0;
+    MEM_OFFSET base0 = leaves.size();
+
+    for ( unsigned v = 0; v < fanout; v++ )
+    {
+        child_key[v][0] = key[0];
+        child_key[v][1] = key[1];
+        set_key_bits(child_key[v], off, MBT_STRIDE, v);
+
+        vals[v] = (off + MBT_STRIDE >= 128) ?
+            probe(child_key[v], 128, c) : probe(child_key[v], off + MBT_STRIDE, c);
+
+        if ( vals[v] == MBT_MIXED )
+            vector |= 1ull << v;
+
+        else if ( leaves.size() == base0 or leaves.back() != vals[v] )
+        {
+            leafvec |= 1ull << v;
+            leaves.emplace_back(vals[v]);
+        }
+    }
+
+    MEM_OFFSET base1 = nodes.size();
+    nodes.resize(base1 + mbt_popcount(vector));
+
+    nodes[node].vector = vector;
+    nodes[node].leafvec = leafvec;
+    nodes[node].base0 = base0;
+    nodes[node].base1 = base1;
+
+    for ( unsigned v = 0; v < fanout; v++ )
+    {
+        if ( vals[v] == MBT_MIXED )
+            build_node(base1++, child_key[v], off + MBT_STRIDE, c);
+    }
+}
+
+void MbtBuilder::build()
+{
+    Cursor root = { rt->sub_table, 0, 0 };
+    direct.resize(1u << MBT_DIRECT_BITS);
+
+    for ( unsigned i = 0; i < direct.size(); i++ )
+    {
+        uint64_t key[2] = { (uint64_t)i << (64 - MBT_DIRECT_BITS), 0 };
+        uint32_t val = probe(key, MBT_DIRECT_BITS, root);
+
+        if ( val != MBT_MIXED )
+        {
+            direct[i] = MBT_LEAF | val;
+            continue;
+        }
+        direct[i] = nodes.size();
+        nodes.emplace_back();
+        build_node(direct[i], key, MBT_DIRECT_BITS, root);
+    }
+}
+
+// segment allocations are not aligned so leave room to align the nodes
+TABLE_PTR RtTable::sfrt_mbt_flat_new(TABLE_PTR rt_ptr)
+{
+    uint8_t* base = (uint8_t*)segment_basePtr();
+    const dir_table_flat_t* rt = (const dir_table_flat_t*)&base[rt_ptr];
+
+    if ( !rt->sub_table )
+        return 0;
+
+    MbtBuilder mb(base, rt);
+    mb.build();
+
+    size_t direct_size = mb.direct.size() * sizeof(uint32_t);
+    size_t nodes_size = mb.nodes.size() * sizeof(mbt_node_flat_t);
+    size_t leaves_size = mb.leaves.size() * sizeof(INFO);
+    size_t total = sizeof(mbt_flat_t) + direct_size + nodes_size + leaves_size + 8;
+
+    if ( total > segment_unusedmem() or mb.nodes.size() >= MBT_LEAF )
+        return 0;
+
+    TABLE_PTR mbt_ptr = segment_snort_alloc(sizeof(mbt_flat_t));
+    MEM_OFFSET nodes = segment_snort_alloc(nodes_size + 8);
+    nodes = (nodes + 7) & ~7u;
+    MEM_OFFSET direct = segment_snort_alloc(direct_size);
+    MEM_OFFSET leaves = segment_snort_alloc(leaves_size);
+
+    mbt_flat_t* mbt = (mbt_flat_t*)&base[mbt_ptr];
+
+    mbt->direct = direct;
+    mbt->nodes = nodes;
+    mbt->leaves = leaves;
+    mbt->num_nodes = mb.nodes.size();
+    mbt->num_leaves = mb.leaves.size();
+
+    memcpy(&base[direct], mb.direct.data(), direct_size);
+    if ( nodes_size )
+        memcpy(&base[nodes], mb.nodes.data(), nodes_size);
+    if ( leaves_size )
+        memcpy(&base[leaves], mb.leaves.data(), leaves_size);
+
+    table->allocated += total;
+    return mbt_ptr;
+}
+
+bool RtTable::sfrt_flat_compile()
+{
+    if ( !table or !table->rt )
+        return false;
+
+    table->mbt = sfrt_mbt_flat_new(table->rt);
+
+    if ( table->rt6 )
+        table->mbt6 = sfrt_mbt_flat_new(table->rt6);
+
+    return table->mbt and (!table->rt6 or table->mbt6);
+}
+
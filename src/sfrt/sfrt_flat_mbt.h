@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef SFRT_FLAT_MBT_H
+#define SFRT_FLAT_MBT_H
+
+// Compressed multibit trie (poptrie) compiled from a DIR-n-m table.  The
+// top MBT_DIRECT_BITS of the key index a direct table; below that each node
+// covers MBT_STRIDE bits with two bitmaps instead of an array of entries:
+// vector marks the children that are nodes and leafvec marks where a run
+// of identical leaves starts.  Children and leaves of a node are stored
+// contiguously so the popcount of a bitmap gives the offset of the next
+// node or of the leaf.  A node is 24 bytes regardless of the number of
+// prefixes below it, versus 2K for an 8 bit DIR sub table.
+
+#include "sfrt/sfrt.h"
+
+#define MBT_DIRECT_BITS 16
+#define MBT_STRIDE 6
+#define MBT_LEAF 0x80000000
+
+struct mbt_node_flat_t
+{
+    uint64_t vector;    // children that are nodes
+    uint64_t leafvec;   // children that start a new run of leaves
+    MEM_OFFSET base0;   // index of first leaf
+    MEM_OFFSET base1;   // index of first child node
+};
+
+struct mbt_flat_t
+{
+    MEM_OFFSET direct;  // node index or MBT_LEAF | data index
+    MEM_OFFSET nodes;
+    MEM_OFFSET leaves;  // data indexes
+    uint32_t num_nodes;
+    uint32_t num_leaves;
+};
+
+// keys are the address bits in host order, most significant first
+// with IPv4 addresses in the upper 32 bits of key[0]
+inline void mbt_make_key(const snort::SfIp* ip, uint64_t* key)
+{
+    if ( ip->is_ip4() )
+    {
+        key[0] = (uint64_t)ntohl(*ip->get_ip4_ptr()) << 32;
+        key[1] = 0;
+    }
+    else
+    {
+        const uint32_t* a = ip->get_ip6_ptr();
+        key[0] = ((uint64_t)ntohl(a[0]) << 32) | ntohl(a[1]);
+        key[1] = ((uint64_t)ntohl(a[2]) << 32) | ntohl(a[3]);
+    }
+}
+
+// get n <= 32 bits at off, bits past the end of the key are 0
+inline unsigned mbt_key_bits(const uint64_t* key, unsigned off, unsigned n)
+{
+    uint64_t w;
+
+    if ( off == 0 )
+        w = key[0];
+    else if ( off < 64 )
+        w = (key[0] << off) | (key[1] >> (64 - off));
+    else if ( off < 128 )
+        w = key[1] << (off - 64);
+    else
+        w = 0;
+
+    return (unsigned)(w >> (64 - n));
+}
+
+inline unsigned mbt_popcount(uint64_t x)
+{ return __builtin_popcountll(x); }
+
+#endif
+
@@ -0,0 +1,298 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sfrt_flat_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <random>
+#include <set>
+#include <vector>
+
+#include "catch/snort_catch.h"
+#include "sfip/sf_cidr.h"
+#include "sfrt/sfrt_flat.h"
+
+using namespace snort;
+
+// differential test of the compiled tries against the DIR tables they are
+// built from and against a linear longest prefix match
+
+#define TEST_MEMCAP 64   // Mbytes
+
+struct Prefix
+{
+    uint8_t addr[16];
+    unsigned bits;      // of addr, 32 max for IPv4
+    bool ip4;
+    uint32_t id;
+};
+
+// entries are not merged so a lookup gets the longest matching prefix
+static int64_t set_entry(INFO* entry, INFO info, SaveDest, uint8_t*, void*)
+{
+    if ( !*entry )
+        *entry = info;
+    return 0;
+}
+
+static void mask(uint8_t* a, unsigned bytes, unsigned bits)
+{
+    for ( unsigned i = 0; i < bytes; i++ )
+    {
+        if ( bits >= 8 )
+            bits -= 8;
+        else
+        {
+            a[i] &= (uint8_t)(0xff00 >> bits);
+            bits = 0;
+        }
+    }
+}
+
+static bool covers(const Prefix& p, const uint8_t* a)
+{
+    unsigned n = p.bits / 8;
+
+    for ( unsigned i = 0; i < n; i++ )
+        if ( a[i] != p.addr[i] )
+            return false;
+
+    unsigned r = p.bits % 8;
+    return !r or !((a[n] ^ p.addr[n]) & (uint8_t)(0xff00 >> r));
+}
+
+class TestTable : public RtTable
+{
+public:
+    TestTable() : buf(new uint8_t[(size_t)TEST_MEMCAP << 20])
+    {
+        segment_meminit(buf, (size_t)TEST_MEMCAP << 20);
+        sfrt_flat_new(DIR_8x16, IPv6, 100000, TEST_MEMCAP);
+    }
+
+    ~TestTable()
+    { delete[] buf; }
+
+    void add(Prefix& p)
+    {
+        MEM_OFFSET info = segment_snort_calloc(1, sizeof(uint32_t));
+        REQUIRE(info);
+
+        uint8_t* base = (uint8_t*)segment_basePtr();
+        p.id = info;
+        *(uint32_t*)&base[info] = info;
+
+        SfCidr cidr;
+        cidr.set(p.addr, p.ip4 ? AF_INET : AF_INET6);
+        cidr.set_bits(p.ip4 ? p.bits + 96 : p.bits);
+
+        REQUIRE(sfrt_flat_insert(&cidr, (unsigned char)cidr.get_bits(), info, RT_FAVOR_ALL,
+            set_entry, nullptr) == RT_SUCCESS);
+    }
+
+    // id of the matching prefix or 0
+    uint32_t id(GENERIC result) const
+    { return result ? *(uint32_t*)result : 0; }
+
+private:
+    uint8_t* buf;
+};
+
+// random prefixes where about half are nested in an earlier prefix
+static std::vector<Prefix> make_prefixes(std::mt19937& rng, bool ip4, unsigned count)
+{
+    const unsigned size = ip4 ? 4 : 16;
+    const unsigned max_bits = ip4 ? 32 : 128;
+    std::vector<Prefix> prefixes;
+    std::set<std::vector<uint8_t>> seen;
+
+    while ( prefixes.size() < count )
+    {
+        Prefix p = { };
+        p.ip4 = ip4;
+
+        if ( !prefixes.empty() and rng() % 2 )
+        {
+            const Prefix& outer = prefixes[rng() % prefixes.size()];
+
+            if ( outer.bits >= max_bits )
+                continue;
+
+            p = outer;
+            p.bits += 1 + rng() % std::min(24u, max_bits - outer.bits);
+
+            for ( unsigned i = outer.bits / 8; i < size; i++ )
+                p.addr[i] ^= (uint8_t)rng() & (i == outer.bits / 8 ? 0xff >> (outer.bits % 8) : 0xff);
+        }
+        else
+        {
+            for ( unsigned i = 0; i < size; i++ )
+                p.addr[i] = (uint8_t)rng();
+
+            // keep IPv6 prefixes within a few /16s so they overlap
+            if ( !ip4 )
+                p.addr[1] &= 0x3;
+
+            p.bits = ip4 ? 8 + rng() % 25 : 16 + rng() % 49;
+        }
+        mask(p.addr, size, p.bits);
+
+        std::vector<uint8_t> key(p.addr, p.addr + size);
+        key.emplace_back(p.bits);
+
+        if ( seen.insert(key).second )
+            prefixes.emplace_back(p);
+    }
+    return prefixes;
+}
+
+static uint32_t lpm(const std::vector<Prefix>& prefixes, const uint8_t* a)
+{
+    const Prefix* best = nullptr;
+
+    for ( const auto& p : prefixes )
+        if ( covers(p, a) and (!best or p.bits > best->bits) )
+            best = &p;
+
+    return best ? best->id : 0;
+}
+
+// addresses inside, at the edges of, and outside the prefixes
+static std::vector<SfIp> make_addrs(
+    std::mt19937& rng, const std::vector<Prefix>& prefixes, unsigned count)
+{
+    std::vector<SfIp> addrs;
+
+    for ( unsigned i = 0; i < count; i++ )
+    {
+        const Prefix& p = prefixes[rng() % prefixes.size()];
+        const unsigned size = p.ip4 ? 4 : 16;
+        uint8_t a[16];
+
+        memcpy(a, p.addr, size);
+
+        switch ( rng() % 4 )
+        {
+        case 0:    // last address of the prefix
+            for ( unsigned b = p.bits; b < size * 8; b++ )
+                a[b / 8] |= 0x80 >> (b % 8);
+            break;
+        case 1:    // random address anywhere
+            for ( unsigned j = 0; j < size; j++ )
+                a[j] = (uint8_t)rng();
+            break;
+        default:   // random address in the prefix
+            for ( unsigned b = p.bits; b < size * 8; b++ )
+                if ( rng() % 2 )
+                    a[b / 8] |= 0x80 >> (b % 8);
+            break;
+        }
+
+        SfIp ip;
+        ip.set(a, p.ip4 ? AF_INET : AF_INET6);
+        addrs.emplace_back(ip);
+    }
+    return addrs;
+}
+
+static const uint8_t* bytes(const SfIp& ip)
+{
+    return ip.is_ip4() ? (const uint8_t*)ip.get_ip4_ptr() : (const uint8_t*)ip.get_ip6_ptr();
+}
+
+TEST_CASE("sfrt compiled tries match DIR tables", "[sfrt]")
+{
+    std::mt19937 rng(1234);
+    TestTable table;
+
+    std::vector<Prefix> v4 = make_prefixes(rng, true, 3000);
+    std::vector<Prefix> v6 = make_prefixes(rng, false, 300);
+
+    for ( auto& p : v4 )
+        table.add(p);
+
+    for ( auto& p : v6 )
+        table.add(p);
+
+    std::vector<SfIp> addrs = make_addrs(rng, v4, 5000);
+    std::vector<SfIp> addrs6 = make_addrs(rng, v6, 2000);
+    addrs.insert(addrs.end(), addrs6.begin(), addrs6.end());
+    std::shuffle(addrs.begin(), addrs.end(), rng);
+
+    table_flat_t* t = table.get_table();
+    std::vector<uint32_t> dir;
+
+    for ( const auto& ip : addrs )
+    {
+        const std::vector<Prefix>& ref = ip.is_ip4() ? v4 : v6;
+        dir.emplace_back(table.id(sfrt_flat_dir8x_lookup(&ip, t)));
+        CHECK(dir.back() == lpm(ref, bytes(ip)));
+    }
+
+    REQUIRE(table.sfrt_flat_compile());
+    REQUIRE(t->mbt);
+    REQUIRE(t->mbt6);
+
+    for ( unsigned i = 0; i < addrs.size(); i++ )
+        CHECK(table.id(sfrt_flat_dir8x_lookup(&addrs[i], t)) == dir[i]);
+
+    // batches of every size, including more than SFRT_MAX_BATCH
+    for ( unsigned n = 1; n <= 2 * SFRT_MAX_BATCH + 1; n++ )
+    {
+        for ( unsigned i = 0; i + n <= addrs.size(); i += 97 )
+        {
+            const SfIp* ips[2 * SFRT_MAX_BATCH + 1];
+            GENERIC results[2 * SFRT_MAX_BATCH + 1];
+
+            for ( unsigned j = 0; j < n; j++ )
+                ips[j] = &addrs[i + j];
+
+            sfrt_flat_dir8x_lookup(ips, results, n, t);
+
+            for ( unsigned j = 0; j < n; j++ )
+                CHECK(table.id(results[j]) == dir[i + j]);
+        }
+    }
+}
+
+TEST_CASE("sfrt insert after compile drops the tries", "[sfrt]")
+{
+    std::mt19937 rng(99);
+    TestTable table;
+
+    std::vector<Prefix> v4 = make_prefixes(rng, true, 100);
+
+    for ( auto& p : v4 )
+        table.add(p);
+
+    REQUIRE(table.sfrt_flat_compile());
+
+    Prefix host = v4[0];
+    host.bits = 32;
+    table.add(host);
+
+    table_flat_t* t = table.get_table();
+    CHECK(!t->mbt);
+    CHECK(!t->mbt6);
+
+    SfIp ip;
+    ip.set(host.addr, AF_INET);
+    CHECK(table.id(sfrt_flat_dir8x_lookup(&ip, t)) == host.id);
+}
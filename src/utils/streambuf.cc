@@ -283,6 +283,22 @@ const char* ostreambuf_infl::take_data(streamsize& n)
     return d;
 }
 
+void ostreambuf_infl::discard(streamsize n)
+{
+    auto base = pbase();
+    auto ptr = pptr();
+    auto len = ptr - base;
+
+    n = max(0, n);
+    n = min(n, len);
+
+    if (n == 0)
+        return;
+
+    memmove(base, base + n, len - n);
+    pbump(-n);
+}
+
 streambuf* ostreambuf_infl::setbuf(char* s, streamsize n)
 {
     n = min(n, size_limit);
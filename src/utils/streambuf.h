@@ -83,6 +83,9 @@ public:
     const char* take_data();
     const char* take_data(std::streamsize& n);
 
+    // drops n bytes from the beginning of the buffer, keeping the rest
+    void discard(std::streamsize n);
+
     const char* data() const
     { return pbase(); }
 
@@ -2111,3 +2111,55 @@ TEST_CASE("output stream - large data", "[Stream buffers]")
         EOF_OUT(s, exp, 1 << 20);
     }
 }
+
+TEST_CASE("output stream - discard", "[Stream buffers]")
+{
+    const char* src = "12345678";
+    const int src_len = strlen(src);
+
+    ostreambuf_infl b;
+    ostream s(&b);
+
+    s.write(src, src_len);
+
+    SECTION("nothing")
+    {
+        const char* exp = "12345678";
+        const int exp_len = strlen(exp);
+
+        b.discard(0);
+
+        EXP_OUT(s, exp, exp_len);
+    }
+
+    SECTION("head")
+    {
+        const char* exp = "5678";
+        const int exp_len = strlen(exp);
+
+        b.discard(4);
+
+        EXP_OUT(s, exp, exp_len);
+    }
+
+    SECTION("all")
+    {
+        const char* exp = "";
+        const int exp_len = strlen(exp);
+
+        b.discard(src_len + 1);
+
+        EXP_OUT(s, exp, exp_len);
+    }
+
+    SECTION("head and write")
+    {
+        const char* exp = "78ABC";
+        const int exp_len = strlen(exp);
+
+        b.discard(6);
+        s.write("ABC", 3);
+
+        EXP_OUT(s, exp, exp_len);
+    }
+}
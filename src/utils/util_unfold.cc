@@ -24,6 +24,9 @@
 
 #include "util_unfold.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace snort
 {
 /* Given a string, removes header folding (\r\n followed by linear whitespace)
@@ -120,12 +123,23 @@ int sf_strip_CRLF(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
     outbuf_ptr = outbuf;
     while ((cursor < endofinbuf) && (n < outbuf_size))
     {
-        if ((*cursor != '\n') && (*cursor != '\r'))
+        if ((*cursor == '\n') || (*cursor == '\r'))
         {
-            *outbuf_ptr++ = *cursor;
-            n++;
+            cursor++;
+            continue;
         }
-        cursor++;
+
+        /* copy the whole line at once */
+        const uint8_t* run = cursor + 1;
+        const uint8_t* run_end = cursor + std::min((uint32_t)(endofinbuf - cursor), outbuf_size - n);
+
+        while ((run < run_end) && (*run != '\n') && (*run != '\r'))
+            run++;
+
+        memmove(outbuf_ptr, cursor, run - cursor);
+        outbuf_ptr += run - cursor;
+        n += run - cursor;
+        cursor = run;
     }
 
     if (output_bytes)